@@ -115,6 +115,46 @@ void CommandBuffer::CopyImageToBuffer(const Image &src_image,
                                   /*regionCount=*/1, &region);
 }
 
+void CommandBuffer::CopyImage(const Image &src_image, VkOffset3D src_offset,
+                              const Image &dst_image, VkOffset3D dst_offset,
+                              VkExtent3D extent) {
+  VkImageCopy region = {};
+  region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.srcSubresource.mipLevel = 0;
+  region.srcSubresource.baseArrayLayer = 0;
+  region.srcSubresource.layerCount = 1;
+  region.srcOffset = src_offset;
+  region.dstSubresource = region.srcSubresource;
+  region.dstOffset = dst_offset;
+  region.extent = extent;
+
+  symbols_.vkCmdCopyImage(command_buffer_, src_image.image(),
+                          VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                          dst_image.image(),
+                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                          /*regionCount=*/1, &region);
+}
+
+void CommandBuffer::BlitImage(const Image &src_image, const Image &dst_image,
+                              VkExtent3D extent) {
+  VkImageBlit region = {};
+  region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  region.srcSubresource.mipLevel = 0;
+  region.srcSubresource.baseArrayLayer = 0;
+  region.srcSubresource.layerCount = 1;
+  region.srcOffsets[1] = {static_cast<int32_t>(extent.width),
+                          static_cast<int32_t>(extent.height),
+                          static_cast<int32_t>(extent.depth)};
+  region.dstSubresource = region.srcSubresource;
+  region.dstOffsets[1] = region.srcOffsets[1];
+
+  symbols_.vkCmdBlitImage(command_buffer_, src_image.image(),
+                          VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                          dst_image.image(),
+                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                          /*regionCount=*/1, &region, VK_FILTER_NEAREST);
+}
+
 static absl::Status GetImageMemoryBarrier(VkImage image, VkImageLayout from_layout, VkImageLayout to_layout,
   VkImageMemoryBarrier& barrier, VkPipelineStageFlags& src_stage, VkPipelineStageFlags& dst_stage) {
   barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -185,6 +225,34 @@ static absl::Status GetImageMemoryBarrier(VkImage image, VkImageLayout from_layo
 
     src_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
     dst_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  } else if (from_layout == VK_IMAGE_LAYOUT_GENERAL &&
+             to_layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) {
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    src_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    dst_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  } else if ((from_layout == VK_IMAGE_LAYOUT_GENERAL || from_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) &&
+             to_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+    barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    src_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    dst_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  } else if (from_layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL &&
+             to_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    src_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dst_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+  } else if (from_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL &&
+             to_layout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) {
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    src_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dst_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
   } else {
     return absl::UnimplementedError(absl::StrCat(
         "image layout transition from ", GetVkImageLayoutName(from_layout), " to ", GetVkImageLayoutName(to_layout)));
@@ -354,7 +422,7 @@ void CommandBuffer::DispatchBarrier() {
   VkMemoryBarrier barrier = {};
   barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
   barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
 
   symbols_.vkCmdPipelineBarrier(command_buffer_,
                                 VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
@@ -362,5 +430,18 @@ void CommandBuffer::DispatchBarrier() {
                                 &barrier, 0, nullptr, 0, nullptr);
 }
 
+void CommandBuffer::EndBarrier() {
+  VkMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT |
+                          VK_ACCESS_MEMORY_WRITE_BIT | VK_ACCESS_HOST_READ_BIT;
+
+  symbols_.vkCmdPipelineBarrier(
+      command_buffer_, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 1,
+      &barrier, 0, nullptr, 0, nullptr);
+}
+
 }  // namespace vulkan
 }  // namespace uvkc
@@ -71,6 +71,21 @@ class CommandBuffer {
   void CopyImageToBuffer(const Image &src_image, VkExtent3D image_dimensions,
                          const Buffer &dst_buffer, size_t dst_offset);
 
+  // Records a command to copy a region of |extent| size at |src_offset| of the
+  // |src_image| to |dst_offset| of the |dst_image|. The |src_image| should be of
+  // VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL and the |dst_image| should be of
+  // VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL.
+  void CopyImage(const Image &src_image, VkOffset3D src_offset,
+                 const Image &dst_image, VkOffset3D dst_offset,
+                 VkExtent3D extent);
+
+  // Records a command to blit the whole |src_image| of |extent| size to the
+  // |dst_image| of the same size, converting between their formats. The
+  // |src_image| should be of VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL and the
+  // |dst_image| should be of VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL.
+  void BlitImage(const Image &src_image, const Image &dst_image,
+                 VkExtent3D extent);
+
   // Performs image layout transition from |image current layout| to |to_layout| of the
   // given |image|.
   absl::Status TransitionImageLayout(Image &image,
@@ -115,10 +130,15 @@ class CommandBuffer {
   // Records a dispatch command.
   void Dispatch(uint32_t x, uint32_t y, uint32_t z);
 
-  // Records a pipeline barrier that synchronizes shader read from a compute
-  // shader with shader write from a previous compute shader.
+  // Records a pipeline barrier that synchronizes shader read and write from a
+  // compute shader with shader write from a previous compute shader.
   void DispatchBarrier();
 
+  // Records a pipeline barrier that makes shader writes from previous compute
+  // shaders available to all later commands, including the ones of later
+  // submissions, and to the host.
+  void EndBarrier();
+
  private:
   VkCommandBuffer command_buffer_;
 
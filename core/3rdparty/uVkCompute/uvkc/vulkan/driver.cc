@@ -14,7 +14,9 @@
 
 #include "uvkc/vulkan/driver.h"
 
+#include <cstring>
 #include <memory>
+#include <vector>
 
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
@@ -171,6 +173,28 @@ absl::StatusOr<std::unique_ptr<Device>> Driver::CreateDevice(
   device_create_info.ppEnabledExtensionNames = nullptr;
   device_create_info.pEnabledFeatures = nullptr;
 
+  // Calibrated timestamps let traces place GPU timestamps on the CPU clock.
+  const char *calibrated_timestamps = VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME;
+  auto enumerate_extensions =
+      reinterpret_cast<PFN_vkEnumerateDeviceExtensionProperties>(
+          symbols_.vkGetInstanceProcAddr(
+              instance_, "vkEnumerateDeviceExtensionProperties"));
+  uint32_t extension_count = 0;
+  if (enumerate_extensions &&
+      enumerate_extensions(physical_device.handle, nullptr, &extension_count,
+                           nullptr) == VK_SUCCESS) {
+    std::vector<VkExtensionProperties> extensions(extension_count);
+    enumerate_extensions(physical_device.handle, nullptr, &extension_count,
+                         extensions.data());
+    for (const auto &extension : extensions) {
+      if (strcmp(extension.extensionName, calibrated_timestamps) == 0) {
+        device_create_info.enabledExtensionCount = 1;
+        device_create_info.ppEnabledExtensionNames = &calibrated_timestamps;
+        break;
+      }
+    }
+  }
+
   VkDevice device;
   VK_RETURN_IF_ERROR(symbols_.vkCreateDevice(physical_device.handle,
                                              &device_create_info,
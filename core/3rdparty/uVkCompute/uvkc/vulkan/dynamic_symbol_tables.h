@@ -71,7 +71,7 @@ namespace vulkan {
   DEV_PFN(EXCLUDED, vkCmdCopyAccelerationStructureNV)                   \
   DEV_PFN(REQUIRED, vkCmdCopyBuffer)                                    \
   DEV_PFN(REQUIRED, vkCmdCopyBufferToImage)                             \
-  DEV_PFN(EXCLUDED, vkCmdCopyImage)                                     \
+  DEV_PFN(REQUIRED, vkCmdCopyImage)                                     \
   DEV_PFN(REQUIRED, vkCmdCopyImageToBuffer)                             \
   DEV_PFN(EXCLUDED, vkCmdCopyQueryPoolResults)                          \
   DEV_PFN(EXCLUDED, vkCmdDebugMarkerBeginEXT)                           \
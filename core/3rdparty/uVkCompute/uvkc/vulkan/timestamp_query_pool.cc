@@ -74,6 +74,16 @@ absl::StatusOr<double> TimestampQueryPool::CalculateElapsedSecondsBetween(
   return seconds;
 }
 
+absl::StatusOr<uint64_t> TimestampQueryPool::GetTimestamp(int index) {
+  uint64_t timestamp = 0;
+  VK_RETURN_IF_ERROR(symbols_.vkGetQueryPoolResults(
+      device_, query_pool_, index, /*queryCount=*/1,
+      /*dataSize=*/sizeof(uint64_t), /*pData=*/&timestamp,
+      /*stride=*/sizeof(uint64_t),
+      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+  return timestamp;
+}
+
 TimestampQueryPool::TimestampQueryPool(VkDevice device, VkQueryPool pool,
                                        uint32_t nanoseconds_per_timestamp_value,
                                        uint32_t query_count,
@@ -42,6 +42,9 @@ class TimestampQueryPool {
   // |start| and |end|.
   absl::StatusOr<double> CalculateElapsedSecondsBetween(int start, int end);
 
+  // Gets the raw value of the query with |index|, in device timestamp ticks.
+  absl::StatusOr<uint64_t> GetTimestamp(int index);
+
  private:
   TimestampQueryPool(VkDevice device, VkQueryPool pool,
                      uint32_t nanoseconds_per_timestamp_value,
@@ -6,11 +6,7 @@ void main()
     ivec3 inSize = imgSize.xyz;
     if (all(lessThan(pos, inSize)))
     {
-        #ifdef INPUT_TEXTURE_2D
-        vec4 sum = imageLoad(uInput0, ivec2(pos.x, pos.y)) + imageLoad(uInput1, ivec2(pos.x, pos.y));
-        #else
-        vec4 sum = imageLoad(uInput0, pos) + imageLoad(uInput1, pos);
-        #endif
+        vec4 sum = LOAD_uInput0(pos) + LOAD_uInput1(pos);
         #ifdef RELU
         sum = max(sum, vec4(0));
         #endif
@@ -29,10 +25,6 @@ void main()
         #ifdef SILU
         sum    = sum  * vec4(1.0f)/(vec4(1.0f)+ exp(-sum));
         #endif   
-        #ifdef OUTPUT_TEXTURE_2D
-        imageStore(uOutput, ivec2(pos.x, pos.y), sum);
-        #else
-        imageStore(uOutput, pos, sum);
-        #endif
+        STORE_uOutput(pos, sum);
     }
 }
@@ -20,18 +20,10 @@ void main()
         {
             for (int fx=sfxy.x; fx<efxy.x; ++fx)
             {
-                #ifdef INPUT_TEXTURE_2D
-                color += imageLoad(uInput, ivec2(spos.x+fx, spos.y+fy));
-                #else
-                color += imageLoad(uInput, ivec3(spos.x+fx, spos.y+fy, pos.z));
-                #endif
+                color += LOAD_uInput(ivec3(spos.x+fx, spos.y+fy, pos.z));
                 num += vec4(1.0);
             }
         }
-        #ifdef OUTPUT_TEXTURE_2D
-        imageStore(uOutput, ivec2(pos.x, pos.y), color/num);
-        #else
-        imageStore(uOutput, pos, color/num);
-        #endif
+        STORE_uOutput(pos, color/num);
     }
 }
@@ -52,17 +52,10 @@ void main()
                     
                     mat4 k = mat4(k0, k1, k2, k3);
                     
-                    #ifdef INPUT_TEXTURE_2D
-                    color  += k*imageLoad(uInput, ivec2(sx1, sy)) * m1;
-                    color2 += k*imageLoad(uInput, ivec2(sx2, sy)) * m2;
-                    color3 += k*imageLoad(uInput, ivec2(sx3, sy)) * m3;
-                    color4 += k*imageLoad(uInput, ivec2(sx4, sy)) * m4;       
-                    #else
-                    color  += k*imageLoad(uInput, ivec3(sx1, sy, fz)) * m1;
-                    color2 += k*imageLoad(uInput, ivec3(sx2, sy, fz)) * m2;
-                    color3 += k*imageLoad(uInput, ivec3(sx3, sy, fz)) * m3;
-                    color4 += k*imageLoad(uInput, ivec3(sx4, sy, fz)) * m4;
-                    #endif  
+                    color  += k*LOAD_uInput(ivec3(sx1, sy, fz)) * m1;
+                    color2 += k*LOAD_uInput(ivec3(sx2, sy, fz)) * m2;
+                    color3 += k*LOAD_uInput(ivec3(sx3, sy, fz)) * m3;
+                    color4 += k*LOAD_uInput(ivec3(sx4, sy, fz)) * m4;
         }
         #ifdef USE_BATCH_NORMALIZATION 
         vec4 movingVariance = uVariance.data[pos.z]; 
@@ -112,16 +105,9 @@ void main()
         color3   = color3 * vec4(1.0f)/(vec4(1.0f)+ exp(-color));
         color4   = color4 * vec4(1.0f)/(vec4(1.0f)+ exp(-color));
         #endif                        
-        #ifdef OUTPUT_TEXTURE_2D
-        imageStore(uOutput, ivec2(pos.x+0, pos.y), color);
-        imageStore(uOutput, ivec2(pos.x+1, pos.y), color2);
-        imageStore(uOutput, ivec2(pos.x+2, pos.y), color3);
-        imageStore(uOutput, ivec2(pos.x+3, pos.y), color4);  
-        #else
-        imageStore(uOutput, ivec3(pos.x+0, pos.y, pos.z), color);
-        imageStore(uOutput, ivec3(pos.x+1, pos.y, pos.z), color2);
-        imageStore(uOutput, ivec3(pos.x+2, pos.y, pos.z), color3);
-        imageStore(uOutput, ivec3(pos.x+3, pos.y, pos.z), color4);
-        #endif           
+        STORE_uOutput(ivec3(pos.x+0, pos.y, pos.z), color);
+        STORE_uOutput(ivec3(pos.x+1, pos.y, pos.z), color2);
+        STORE_uOutput(ivec3(pos.x+2, pos.y, pos.z), color3);
+        STORE_uOutput(ivec3(pos.x+3, pos.y, pos.z), color4);
     }
 }
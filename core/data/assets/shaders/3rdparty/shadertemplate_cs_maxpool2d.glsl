@@ -19,17 +19,9 @@ void main()
         {
             for (int fx=sfxy.x; fx<efxy.x; ++fx)
             {
-                #ifdef INPUT_TEXTURE_2D
-                color = max(color, imageLoad(uInput, ivec2(spos.x+fx, spos.y+fy)));
-                #else
-                color = max(color, imageLoad(uInput, ivec3(spos.x+fx, spos.y+fy, pos.z)));
-                #endif  
+                color = max(color, LOAD_uInput(ivec3(spos.x+fx, spos.y+fy, pos.z)));
             }
         }
-        #ifdef OUTPUT_TEXTURE_2D
-        imageStore(uOutput, ivec2(pos.x, pos.y), color);
-        #else
-        imageStore(uOutput, pos, color);
-        #endif  
+        STORE_uOutput(pos, color);
     }
 }
@@ -42,11 +42,7 @@ void main()
             {
                 int sx1 = fx*uDilate.x + s0.x;
                 vec4 k = texelFetch(uKernel, ivec3(pos.z, fx, fy), 0);
-                #ifdef INPUT_TEXTURE_2D
-                color  += k*imageLoad(uInput, ivec2(sx1, sy));    
-                #else
-                color  += k*imageLoad(uInput, ivec3(sx1, sy, pos.z));
-                #endif  
+                color  += k*LOAD_uInput(ivec3(sx1, sy, pos.z));
             }
         }
         #ifdef USE_BATCH_NORMALIZATION 
@@ -76,10 +72,6 @@ void main()
         #ifdef SILU
         color    = color  * vec4(1.0f)/(vec4(1.0f)+ exp(-color));
         #endif
-        #ifdef OUTPUT_TEXTURE_2D
-        imageStore(uOutput, ivec2(pos.x+0, pos.y), color);
-        #else
-        imageStore(uOutput, ivec3(pos.x+0, pos.y, pos.z), color);
-        #endif
+        STORE_uOutput(ivec3(pos.x+0, pos.y, pos.z), color);
     }
 }
@@ -1,3 +1,18 @@
+// Image accessors for the code, that declares uInput and uOutput images itself (e.g. image resizing)
+#ifndef LOAD_uInput
+#ifdef INPUT_TEXTURE_2D
+#define LOAD_uInput(p) imageLoad(uInput, (p).xy)
+#else
+#define LOAD_uInput(p) imageLoad(uInput, (p))
+#endif
+#endif
+#ifndef STORE_uOutput
+#ifdef OUTPUT_TEXTURE_2D
+#define STORE_uOutput(p, v) imageStore(uOutput, (p).xy, v)
+#else
+#define STORE_uOutput(p, v) imageStore(uOutput, (p), v)
+#endif
+#endif
 layout(location=2) uniform ivec4 inImgSize;
 layout(location=3) uniform ivec4 outImgSize;
 layout(location=4) uniform vec2 scale;
@@ -26,27 +41,16 @@ void main()
         srcY = clamp(srcY, 0.0f, float(inputImgSize.y - 1));
         int y11 = int(floor(srcY));
         int y12 = y11 + 1;
-        #ifdef INPUT_TEXTURE_2D
-        vec4 res4 = imageLoad(uInput, ivec2(x11, y12));
-        vec4 res3 = imageLoad(uInput, ivec2(x12, y12));
-        vec4 res1 = imageLoad(uInput, ivec2(x11, y11));
-        vec4 res2 = imageLoad(uInput, ivec2(x12, y11));
-        #else
-        vec4 res4 = imageLoad(uInput, ivec3(x11, y12, pos.z));
-        vec4 res3 = imageLoad(uInput, ivec3(x12, y12, pos.z));
-        vec4 res1 = imageLoad(uInput, ivec3(x11, y11, pos.z));
-        vec4 res2 = imageLoad(uInput, ivec3(x12, y11, pos.z));
-        #endif
+        vec4 res4 = LOAD_uInput(ivec3(x11, y12, pos.z));
+        vec4 res3 = LOAD_uInput(ivec3(x12, y12, pos.z));
+        vec4 res1 = LOAD_uInput(ivec3(x11, y11, pos.z));
+        vec4 res2 = LOAD_uInput(ivec3(x12, y11, pos.z));
         vec4 outValue = res1 * vec4((float(x12) - srcX) * (float(y12) - srcY)) +
         res2 * vec4((srcX - float(x11)) * (float(y12) - srcY)) +
         res3 * vec4((srcX - float(x11)) * (srcY - float(y11))) +
         res4 * vec4((float(x12) - srcX) * (srcY - float(y11)));
         outValue = (outValue - means) * norms;
-        #ifdef OUTPUT_TEXTURE_2D
-        imageStore(uOutput, ivec2(pos.x, pos.y), outValue);
-        #else
-        imageStore(uOutput, pos, outValue);
-        #endif
+        STORE_uOutput(pos, outValue);
     }
     
 }
\ No newline at end of file
@@ -1,3 +1,18 @@
+// Image accessors for the code, that declares uInput and uOutput images itself (e.g. image resizing)
+#ifndef LOAD_uInput
+#ifdef INPUT_TEXTURE_2D
+#define LOAD_uInput(p) imageLoad(uInput, (p).xy)
+#else
+#define LOAD_uInput(p) imageLoad(uInput, (p))
+#endif
+#endif
+#ifndef STORE_uOutput
+#ifdef OUTPUT_TEXTURE_2D
+#define STORE_uOutput(p, v) imageStore(uOutput, (p).xy, v)
+#else
+#define STORE_uOutput(p, v) imageStore(uOutput, (p), v)
+#endif
+#endif
 layout(location=2) uniform ivec4 inImgSize;
 layout(location=3) uniform ivec4 outImgSize;
 layout(location=4) uniform vec2 scale;
@@ -21,18 +36,10 @@ void main()
         float srcY = float(pos.y) * scale.y;
         int y1 = int(floor(srcY));
         int y11 = clamp(y1, 0, inputImgSize.y - 1);
-        #ifdef INPUT_TEXTURE_2D
-        vec4 outValue = imageLoad(uInput, ivec2(x11, y11));
-        #else
-        vec4 outValue = imageLoad(uInput, ivec3(x11, y11, pos.z));
-        #endif
+        vec4 outValue = LOAD_uInput(ivec3(x11, y11, pos.z));
         
         outValue = (outValue - means) * norms;
-        #ifdef OUTPUT_TEXTURE_2D
-        imageStore(uOutput, ivec2(pos.x, pos.y), outValue);
-        #else
-        imageStore(uOutput, pos, outValue);
-        #endif
+        STORE_uOutput(pos, outValue);
     }
     
 }
@@ -0,0 +1,58 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*/
+// Adaptive average pooling: one work group per output pixel and plane. Threads sum the pooling region with a stride
+// of the work group size, then the partial sums are reduced in shared memory, so the shader doesn't depend on the input size.
+layout(location=2) uniform ivec2 uInputSize;
+layout(location=3) uniform ivec2 uOutputSize;
+layout (local_size_x = WORK_X, local_size_y = WORK_Y, local_size_z = WORK_Z) in;
+shared highp vec4 partialSums[WORK_X * WORK_Y];
+void main()
+{
+    ivec3 pos = ivec3(gl_WorkGroupID);
+    ivec2 tid = ivec2(gl_LocalInvocationID.xy);
+    int index = tid.y * WORK_X + tid.x;
+    // PyTorch region: [floor(pos * in / out), ceil((pos + 1) * in / out))
+    ivec2 start = (pos.xy * uInputSize) / uOutputSize;
+    ivec2 end = ((pos.xy + 1) * uInputSize + uOutputSize - 1) / uOutputSize;
+    highp vec4 sum = vec4(0.0);
+    for (int y = start.y + tid.y; y < end.y; y += WORK_Y) {
+        for (int x = start.x + tid.x; x < end.x; x += WORK_X) {
+            #ifdef INPUT_TEXTURE_2D
+            sum += imageLoad(uInput, ivec2(x, y));
+            #else
+            sum += imageLoad(uInput, ivec3(x, y, pos.z));
+            #endif
+        }
+    }
+    partialSums[index] = sum;
+    memoryBarrierShared();
+    barrier();
+    for (int stride = (WORK_X * WORK_Y) / 2; stride > 0; stride /= 2) {
+        if (index < stride) {
+            partialSums[index] += partialSums[index + stride];
+        }
+        memoryBarrierShared();
+        barrier();
+    }
+    if (index == 0) {
+        ivec2 regionSize = end - start;
+        vec4 color = partialSums[0] / float(regionSize.x * regionSize.y);
+        #ifdef OUTPUT_TEXTURE_2D
+        imageStore(uOutput, pos.xy, color);
+        #else
+        imageStore(uOutput, pos, color);
+        #endif
+    }
+}
@@ -0,0 +1,53 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*/
+// Takes the maximal absolute difference of two images in every block of pixels, over all layers and channels
+#ifdef INPUT_ARRAY
+layout(binding=0) uniform PRECISION sampler2DArray uCurrent;
+layout(binding=1) uniform PRECISION sampler2DArray uPrevious;
+#define FETCH(tex, pos, layer) texelFetch(tex, ivec3(pos, layer), 0)
+#else
+layout(binding=0) uniform PRECISION sampler2D uCurrent;
+layout(binding=1) uniform PRECISION sampler2D uPrevious;
+#define FETCH(tex, pos, layer) texelFetch(tex, pos, 0)
+#endif
+// Bits of non-negative floats, that are ordered as the floats
+layout(std430, binding=2) buffer uBlockDiffs { uint maxDiffs[]; };
+
+layout(location=3) uniform ivec3 uImageSize; // width, height, layers
+layout(location=4) uniform ivec3 uBlockSize; // block width, block height, blocks per row
+layout (local_size_x = WORK_X, local_size_y = WORK_Y, local_size_z = WORK_Z) in;
+void main()
+{
+    ivec2 pos = ivec2(gl_GlobalInvocationID.xy);
+    if (pos.x < uImageSize.x && pos.y < uImageSize.y)
+    {
+        float diff = 0.0;
+        #ifdef INPUT_ARRAY
+        for (int layer = 0; layer < uImageSize.z; ++layer)
+        #else
+        int layer = 0;
+        #endif
+        {
+            vec4 d = abs(FETCH(uCurrent, pos, layer) - FETCH(uPrevious, pos, layer));
+            diff = max(diff, max(max(d.x, d.y), max(d.z, d.w)));
+        }
+        // Static pixels skip the atomic
+        if (diff > 0.0)
+        {
+            ivec2 block = pos / uBlockSize.xy;
+            atomicMax(maxDiffs[block.y * uBlockSize.z + block.x], floatBitsToUint(diff));
+        }
+    }
+}
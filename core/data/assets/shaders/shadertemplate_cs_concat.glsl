@@ -22,20 +22,12 @@ void main()
     vec4 outValue1;
     if(pos.z < inImgDepths.x)
     {
-        #ifdef INPUT0_TEXTURE_2D
-        outValue = imageLoad(uInput0, ivec2(pos.x, pos.y));
-        #else
-        outValue = imageLoad(uInput0, ivec3(pos.x, pos.y, pos.z));
-        #endif
+        outValue = LOAD_uInput0(ivec3(pos.x, pos.y, pos.z));
     }
     else
     {
-        #ifdef INPUT1_TEXTURE_2D
-        outValue = imageLoad(uInput1, ivec2(pos.x, pos.y));
-        #else
-        outValue = imageLoad(uInput1, ivec3(pos.x, pos.y, pos.z - inImgDepths.x));
-        #endif
+        outValue = LOAD_uInput1(ivec3(pos.x, pos.y, pos.z - inImgDepths.x));
     }
     
-    imageStore(uOutput, pos, outValue);
+    STORE_uOutput(pos, outValue);
 }
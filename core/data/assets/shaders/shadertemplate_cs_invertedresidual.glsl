@@ -0,0 +1,170 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*/
+// Fused inverted residual block: expand 1x1 -> depthwise KxK -> project 1x1 (-> residual add).
+// Every work group calculates a WORK_X x WORK_Y output tile. Expanded activations of the input tile
+// (with the depthwise halo) are calculated EXPAND_CHUNK slices at a time into the shared memory,
+// then every invocation applies the depthwise kernel to its pixel and accumulates the project convolution
+// for OUTPUTS_PER_LANE output slices, interleaved by WORK_Z.
+#ifdef OUTPUT_TEXTURE_2D
+layout(OUTPUT_FORMAT, binding=3) writeonly uniform PRECISION image2D uOutput;
+#else
+layout(OUTPUT_FORMAT, binding=3) writeonly uniform PRECISION image2DArray uOutput;
+#endif
+#ifdef INPUT_TEXTURE_2D
+layout(OUTPUT_FORMAT, binding=0) readonly uniform PRECISION image2D uInput;
+#define LOAD_INPUT(p, slice) imageLoad(uInput, (p))
+#else
+layout(OUTPUT_FORMAT, binding=0) readonly uniform PRECISION image2DArray uInput;
+#define LOAD_INPUT(p, slice) imageLoad(uInput, ivec3((p), (slice)))
+#endif
+layout(binding=3) readonly buffer weights{
+    vec4 data[];
+} uWeights;
+layout(binding=4) readonly buffer bias{
+    vec4 data[];
+} uBias;
+layout(location=10) uniform ivec3 uOutputSize;
+layout(location=11) uniform ivec3 uInputSize;
+
+#define HALO_X ((WORK_X - 1) * STRIDE + KERNEL_SIZE)
+#define HALO_Y ((WORK_Y - 1) * STRIDE + KERNEL_SIZE)
+#define HALO_SIZE (HALO_X * HALO_Y)
+#define GROUP_SIZE (WORK_X * WORK_Y * WORK_Z)
+#define TAPS (KERNEL_SIZE * KERNEL_SIZE)
+
+shared vec4 sExpanded[EXPAND_CHUNK * HALO_SIZE];
+
+layout (local_size_x = WORK_X, local_size_y = WORK_Y, local_size_z = WORK_Z) in;
+
+vec4 activate(vec4 color, int activation, float leakyReluVal)
+{
+    if (activation == 1) {
+        color = max(color, vec4(0));
+    } else if (activation == 2) {
+        color = clamp(color, vec4(0), vec4(6));
+    } else if (activation == 3) {
+        color = tanh(color);
+    } else if (activation == 4) {
+        color = vec4(1.0f)/(vec4(1.0f)+ exp(-color));
+    } else if (activation == 5) {
+        color = max(color, (color * vec4(leakyReluVal)));
+    } else if (activation == 6) {
+        color = color * vec4(1.0f)/(vec4(1.0f)+ exp(-color));
+    }
+    return color;
+}
+
+void main()
+{
+    ivec2 tileOrigin = ivec2(gl_WorkGroupID.xy) * ivec2(WORK_X, WORK_Y);
+    ivec2 local = ivec2(gl_LocalInvocationID.xy);
+    ivec2 pos = tileOrigin + local;
+    int lane = int(gl_LocalInvocationID.z) + int(gl_WorkGroupID.z) * WORK_Z * OUTPUTS_PER_LANE;
+    int localIndex = int(gl_LocalInvocationIndex);
+    ivec2 haloOrigin = tileOrigin * STRIDE - ivec2(PAD_X, PAD_Y);
+    bool inside = all(lessThan(pos, uOutputSize.xy));
+
+    vec4 acc[OUTPUTS_PER_LANE];
+    for (int j = 0; j < OUTPUTS_PER_LANE; ++j) {
+        int o = lane + j * WORK_Z;
+        acc[j] = (o < OC4) ? uBias.data[2 * EC4 + o] : vec4(0);
+    }
+
+    for (int e0 = 0; e0 < EC4; e0 += EXPAND_CHUNK)
+    {
+        // Expand: calculate the expanded activations of the input tile with the halo.
+        // Pixels outside of the input are the zero padding of the depthwise convolution.
+        for (int item = localIndex; item < EXPAND_CHUNK * HALO_SIZE; item += GROUP_SIZE)
+        {
+            int c = item / HALO_SIZE;
+            int h = item - c * HALO_SIZE;
+            int e = e0 + c;
+            ivec2 p = haloOrigin + ivec2(h % HALO_X, h / HALO_X);
+            vec4 color = vec4(0);
+            if (e < EC4 && all(greaterThanEqual(p, ivec2(0))) && all(lessThan(p, uInputSize.xy)))
+            {
+                color = uBias.data[e];
+                int base = e * IC4 * 4;
+                for (int i = 0; i < IC4; ++i)
+                {
+                    mat4 k = mat4(uWeights.data[base + 0], uWeights.data[base + 1], uWeights.data[base + 2], uWeights.data[base + 3]);
+                    color += k * LOAD_INPUT(p, i);
+                    base += 4;
+                }
+                color = activate(color, EXPAND_ACTIVATION, EXPAND_LEAKY_VAL);
+            }
+            sExpanded[item] = color;
+        }
+        memoryBarrierShared();
+        barrier();
+
+        // Depthwise and project
+        if (inside)
+        {
+            for (int c = 0; c < EXPAND_CHUNK; ++c)
+            {
+                int e = e0 + c;
+                if (e >= EC4) {
+                    break;
+                }
+                vec4 dw = uBias.data[EC4 + e];
+                int tap = DW_WEIGHT_OFFSET + e * TAPS;
+                int row = c * HALO_SIZE + local.y * STRIDE * HALO_X + local.x * STRIDE;
+                for (int fy = 0; fy < KERNEL_SIZE; ++fy)
+                {
+                    for (int fx = 0; fx < KERNEL_SIZE; ++fx)
+                    {
+                        dw += uWeights.data[tap] * sExpanded[row + fx];
+                        tap++;
+                    }
+                    row += HALO_X;
+                }
+                dw = activate(dw, DW_ACTIVATION, DW_LEAKY_VAL);
+                for (int j = 0; j < OUTPUTS_PER_LANE; ++j)
+                {
+                    int o = lane + j * WORK_Z;
+                    if (o < OC4)
+                    {
+                        int base = PROJECT_WEIGHT_OFFSET + (o * EC4 + e) * 4;
+                        mat4 k = mat4(uWeights.data[base + 0], uWeights.data[base + 1], uWeights.data[base + 2], uWeights.data[base + 3]);
+                        acc[j] += k * dw;
+                    }
+                }
+            }
+        }
+        // The shared memory is overwritten by the next chunk
+        barrier();
+    }
+
+    if (inside)
+    {
+        for (int j = 0; j < OUTPUTS_PER_LANE; ++j)
+        {
+            int o = lane + j * WORK_Z;
+            if (o < OC4)
+            {
+                vec4 color = activate(acc[j], PROJECT_ACTIVATION, PROJECT_LEAKY_VAL);
+                #ifdef RESIDUAL
+                color = activate(color + LOAD_INPUT(pos, o), RESIDUAL_ACTIVATION, RESIDUAL_LEAKY_VAL);
+                #endif
+                #ifdef OUTPUT_TEXTURE_2D
+                imageStore(uOutput, pos, color);
+                #else
+                imageStore(uOutput, ivec3(pos, o), color);
+                #endif
+            }
+        }
+    }
+}
@@ -0,0 +1,52 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*/
+// Converts NV12/NV21 (CHROMA_PLANES 1) or I420 (CHROMA_PLANES 2) frame to RGBA, resizes and normalizes it in one pass
+layout(binding=0) uniform PRECISION sampler2D uLuma;
+layout(binding=1) uniform PRECISION sampler2D uChroma;
+#if CHROMA_PLANES == 2
+layout(binding=2) uniform PRECISION sampler2D uChromaV;
+#endif
+layout(OUTPUT_FORMAT, binding=3) writeonly uniform PRECISION image2D uOutput;
+
+layout(location=2) uniform ivec2 uOutputSize;
+layout(location=3) uniform vec4 uDstRect;
+layout(location=4) uniform vec4 uSrcRect;
+layout(location=5) uniform mat4 uYuvToRgba;
+layout(location=9) uniform vec4 uMeans;
+layout(location=10) uniform vec4 uNorms;
+layout(location=11) uniform vec4 uPadColor;
+layout (local_size_x = WORK_X, local_size_y = WORK_Y, local_size_z = WORK_Z) in;
+void main()
+{
+    ivec2 pos = ivec2(gl_GlobalInvocationID.xy);
+    if (pos.x < uOutputSize.x && pos.y < uOutputSize.y)
+    {
+        vec4 value = uPadColor;
+        vec2 t = (vec2(pos) + 0.5 - uDstRect.xy) / uDstRect.zw;
+        if (all(greaterThanEqual(t, vec2(0.0))) && all(lessThan(t, vec2(1.0))))
+        {
+            vec2 texCoords = uSrcRect.xy + t * uSrcRect.zw;
+            vec4 yuv = vec4(texture(uLuma, texCoords).r, 0.0, 0.0, 1.0);
+            #if CHROMA_PLANES == 2
+            yuv.y = texture(uChroma, texCoords).r;
+            yuv.z = texture(uChromaV, texCoords).r;
+            #else
+            yuv.yz = texture(uChroma, texCoords).rg;
+            #endif
+            value = clamp(uYuvToRgba * yuv, 0.0, 255.0);
+        }
+        imageStore(uOutput, pos, (value - uMeans) * uNorms);
+    }
+}
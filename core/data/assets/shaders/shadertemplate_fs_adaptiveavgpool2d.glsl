@@ -0,0 +1,79 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*        http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+*/
+// Adaptive average pooling: every fragment sums its pooling region with a loop, so the shader doesn't depend on the input size.
+// PLANE_COUNT planes, starting from INPUT_LAYER, are written to o_pixel .. o_pixel3.
+precision PRECISION float;
+precision PRECISION sampler2D;
+precision PRECISION sampler2DArray;
+
+layout(location = 0) out vec4 o_pixel;
+#if PLANE_COUNT > 1
+layout(location = 1) out vec4 o_pixel1;
+#endif
+#if PLANE_COUNT > 2
+layout(location = 2) out vec4 o_pixel2;
+#endif
+#if PLANE_COUNT > 3
+layout(location = 3) out vec4 o_pixel3;
+#endif
+
+#ifdef INPUT_TEXTURE_2D
+uniform sampler2D inputTextures;
+#define TEXEL(x, y, layer) texelFetch(inputTextures, ivec2(x, y), 0)
+#else
+uniform sampler2DArray inputTextures;
+#define TEXEL(x, y, layer) texelFetch(inputTextures, ivec3(x, y, layer), 0)
+#endif
+
+uniform ivec2 uInputSize;
+uniform ivec2 uOutputSize;
+
+void main()
+{
+    ivec2 pos = ivec2(gl_FragCoord.xy);
+    // PyTorch region: [floor(pos * in / out), ceil((pos + 1) * in / out))
+    ivec2 start = (pos * uInputSize) / uOutputSize;
+    ivec2 end = ((pos + 1) * uInputSize + uOutputSize - 1) / uOutputSize;
+    highp vec4 s = vec4(0.0);
+    highp vec4 s1 = vec4(0.0);
+    highp vec4 s2 = vec4(0.0);
+    highp vec4 s3 = vec4(0.0);
+    for (int y = start.y; y < end.y; ++y) {
+        for (int x = start.x; x < end.x; ++x) {
+            s += TEXEL(x, y, INPUT_LAYER);
+            #if PLANE_COUNT > 1
+            s1 += TEXEL(x, y, INPUT_LAYER + 1);
+            #endif
+            #if PLANE_COUNT > 2
+            s2 += TEXEL(x, y, INPUT_LAYER + 2);
+            #endif
+            #if PLANE_COUNT > 3
+            s3 += TEXEL(x, y, INPUT_LAYER + 3);
+            #endif
+        }
+    }
+    ivec2 regionSize = end - start;
+    float scale = 1.0 / float(regionSize.x * regionSize.y);
+    o_pixel = s * scale;
+    #if PLANE_COUNT > 1
+    o_pixel1 = s1 * scale;
+    #endif
+    #if PLANE_COUNT > 2
+    o_pixel2 = s2 * scale;
+    #endif
+    #if PLANE_COUNT > 3
+    o_pixel3 = s3 * scale;
+    #endif
+}
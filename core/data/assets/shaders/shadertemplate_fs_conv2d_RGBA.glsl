@@ -55,6 +55,33 @@ layout(binding = 0) uniform sampler2DArray inputTextures;
 #define TEXTURE(t, c) texture((t), (c))
 #endif // end if from line 36
 
+// INPUT_UPSAMPLING_BILINEAR : The input is upsampled on the fly with bilinear interpolation.
+// Coordinates are normalized, so a coordinate in the upsampled input is the same in the input texture.
+// Coordinates outside of the input read zeros, as the border color of the sampler does without upsampling.
+#ifdef INPUT_UPSAMPLING_BILINEAR
+#ifdef INPUT_TEXTURE_2D
+#define FETCH_INPUT(p, layer) texelFetch(inputTextures, (p), 0)
+#else
+#define FETCH_INPUT(p, layer) texelFetch(inputTextures, ivec3((p), (layer)), 0)
+#endif
+FLOAT_PRECISION vec4 upsampleBilinear(highp vec3 coords) {
+    if (any(lessThan(coords.xy, vec2(0.0))) || any(greaterThan(coords.xy, vec2(1.0)))) {
+        return vec4(0.0);
+    }
+    ivec2 size = textureSize(inputTextures, 0).xy;
+    highp vec2 src = clamp(coords.xy * vec2(size) - 0.5, vec2(0.0), vec2(size - 1));
+    ivec2 p0 = ivec2(floor(src));
+    ivec2 p1 = min(p0 + 1, size - 1);
+    highp vec2 f = src - vec2(p0);
+    int layer = int(coords.z);
+    FLOAT_PRECISION vec4 top = mix(FETCH_INPUT(p0, layer), FETCH_INPUT(ivec2(p1.x, p0.y), layer), f.x);
+    FLOAT_PRECISION vec4 bottom = mix(FETCH_INPUT(ivec2(p0.x, p1.y), layer), FETCH_INPUT(p1, layer), f.x);
+    return mix(top, bottom, f.y);
+}
+#undef TEXTURE
+#define TEXTURE(t, c) upsampleBilinear(c)
+#endif
+
 #if NUM_INPUT_PLANES > 4
 #define WEIGHT_SAMPLER sampler2DArray
 #define weightFetch(t, c) texture((t), (c))
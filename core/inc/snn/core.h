@@ -20,6 +20,7 @@
 #include "snn/utils.h"
 #include "snn/deviceTimer.h"
 #include "snn/inferencegraph.h"
+#include "snn/metrics.h"
 #include <memory>
 #include <map>
 #include <string>
@@ -31,6 +32,10 @@ namespace dp {
 class DeviceBackend;
 }
 
+class RenderPass;
+class CompiledModel;
+class WeightCache;
+
 typedef enum class Transition { Backend_CPU_GPU, Backend_GPU_CPU, NOT_DEFINED = 200 } Transition;
 
 // This structure holds a state of a single render stage
@@ -56,13 +61,21 @@ struct RenderStage {
     // 0: input to output binding happens at initialization time. Input is a previous hidden laer output.
     // 1: input to output binding happens at runtime time (delayed). Input is a model input image.
     std::vector<int> delayBindMask;
+    // Render passes of the stage, owned by the execution context
+    std::vector<std::shared_ptr<RenderPass>> renderPasses;
+    // External image, the stage output is bound to in the current run (see RunParameters::outputImages)
+    ImageTexture* outputBinding = nullptr;
+    // True if the stage writes into outputBinding directly, false if its output is converted into outputBinding after the run
+    bool outputAttached = false;
 };
 
 typedef ArrayParamAllocator<RenderStage, GpuContext*> RenderStagesArrayAllocator;
 
 typedef FixedSizeArray<RenderStage, RenderStagesArrayAllocator> RenderStagesArray;
 
-// Main class for SNN inference execution
+// Main class for SNN inference execution.
+// An instance is an execution context of a compiled model: it owns activations, render passes,
+// command buffers, timers and metrics, while programs and weights belong to the CompiledModel.
 class MixedInferenceCore {
 public:
     typedef enum MixedLayerInputType { GL_TEXTURE_OBJECT = 1, FLOAT_VEC = 2 } MixedLayerInputType;
@@ -76,7 +89,14 @@ public:
     struct RunParameters {
         // Input images
         ImageTextureArrayAccessor inputImages;
-        // Output images
+        // Output images, the model writes into. Without requestedOutputs, the first image receives the output
+        // of the last layer, otherwise outputImages[k] receives the output of requestedOutputs[k].
+        // Width, height and depth of an image must match the layer output description (see InferenceGraph::IODesc).
+        // An image of the same color format replaces the output texture of the layer, so the layer renders into it
+        // without a copy. An image of another color format is filled by a conversion pass after the layer has run:
+        // OpenGL blits frame buffers, Vulkan blits images with vkCmdBlitImage(), so both formats need blit support
+        // of the device. An error is logged for formats, that can't be converted.
+        // Images for CPU layers, storage buffer outputs and zero-copy concatenation inputs are not bound.
         ImageTextureArrayAccessor outputImages;
         // Input if located on CPU
         std::vector<std::vector<std::vector<float>>> inputMatrix;
@@ -84,6 +104,10 @@ public:
         std::vector<std::vector<std::vector<float>>> output;
         // Output from special model types
         SNNModelOutput modelOutput;
+        // Names of the layers, whose outputs are needed in this run (see InferenceGraph::matchLayerName).
+        // Only these layers and the layers they depend on are executed. Empty to execute the whole graph.
+        // Outputs are read with getOutputImage(layerName).
+        std::vector<std::string> requestedOutputs = {};
     };
 
     // Runs one inference of a model
@@ -94,6 +118,8 @@ public:
     struct CreationParameters : InferenceGraph {
         uint32_t outputWidth, outputHeight, outputDepth;
         bool dumpOutputs;
+        // Compiled passes of the same model for other input resolutions, whose weights are reused. Optional.
+        std::shared_ptr<WeightCache> weightCache;
     };
 
     // Creates an instance of MixedInferenceCore given creation parameters
@@ -115,19 +141,111 @@ public:
     static std::unique_ptr<MixedInferenceCore> create(GpuContext* context, const std::string& modelFileName,
         const dp::ShaderGenOptions& options, bool dumpOutputs = false);
 
+    // Creates an execution context of a compiled model.
+    // Contexts of one model can run on different threads. With OpenGL, every thread needs its own current context,
+    // sharing objects with the context, the model was compiled on. Vulkan contexts can't run concurrently yet:
+    // they share the command pool and the queue of the device.
+    // params:
+    //  model - compiled model
+    // returns:
+    //  unique pointer to MixedInferenceCore, null if the model is null
+    static std::unique_ptr<MixedInferenceCore> create(std::shared_ptr<const CompiledModel> model);
+
     // Writes timing statistics.
     // Used for profiling and benchmarking.
     // params:
     //  timeArray - a map with keys of layer names and values of timing of successive runs
     void writeTimeStat(std::map<std::string, std::vector<double>>& timeArray);
 
+    // Gets the inference graph, the core was created from. Layers hold their static cost estimates,
+    // that can be combined with writeTimeStat() results into a roofline report (see snn/roofline.h).
+    const InferenceGraph& getInferenceGraph() const { return cp; }
+
+    // This structure holds the result of one pipelined inference
+    struct PipelineResult {
+        uint64_t frameIndex = 0;                // Index of the frame in the submission order
+        SNNModelOutput modelOutput;             // Output from special model types
+        std::vector<std::vector<float>> output; // Output of the last CPU layer
+        double latency = 0.0;                   // Time from submit() to the end of CPU layers, in milliseconds
+    };
+
+    // Behavior of the pipelined execution, when the results, not received yet, fill the result queue
+    enum class ResultOverflow {
+        BLOCK,       // The worker thread waits for receive(). submit() blocks then, as soon as all frames are in flight.
+        DROP_OLDEST, // The oldest result in the queue is discarded (see getDroppedResults())
+    };
+
+    // Starts pipelined execution. The graph is split at the GPU to CPU transition:
+    // GPU layers run on the thread calling submit(), CPU layers run on a worker thread,
+    // so that CPU layers of one frame overlap GPU layers of the next one.
+    // params:
+    //  maxFramesInFlight - number of frames the worker thread can fall behind
+    //  maxResults - capacity of the result queue, read by receive()
+    //  overflow - behavior, when the result queue is full
+    // returns:
+    //  true if success, false if the model does not end with CPU layers
+    bool startPipeline(size_t maxFramesInFlight = 2, size_t maxResults = 2, ResultOverflow overflow = ResultOverflow::BLOCK);
+
+    // Runs GPU layers of one frame and queues its CPU layers to the worker thread.
+    // Blocks, if the worker thread is maxFramesInFlight frames behind.
+    // params:
+    //  rp - parameters, known at runtime. Outputs are delivered through receive().
+    void submit(RunParameters& rp);
+
+    // Gets the result of the oldest submitted frame. Results come in the submission order.
+    // params:
+    //  result - frame result
+    //  wait - flag to wait for the result, if it is not ready yet
+    // returns:
+    //  true if the result is received, false if not
+    bool receive(PipelineResult& result, bool wait = true);
+
+    // Stops the worker thread. Results, not received yet, are discarded.
+    void stopPipeline();
+
+    // Gets the number of results, discarded since startPipeline() because the result queue was full
+    uint64_t getDroppedResults() const;
+
+    // Gets the output image of the last stage.
+    // The image is owned by the inference core and is valid until the next run.
+    // returns:
+    //  reference to the model output image
+    ImageTexture& getOutputImage() {
+        SNN_ASSERT(stages.size() > 0);
+        return stages[stages.size() - 1].stageOutputs[0];
+    }
+
+    // Gets the output of a layer, requested with RunParameters::requestedOutputs: a texture for GPU layers,
+    // or getOutputMat() of the image for CPU layers. The output is not copied: the image is owned by
+    // the inference core and is valid until the next run.
+    // A layer, that writes into a zero-copy concatenation output, returns the concatenation image. List the layer
+    // in ShaderGenOptions::outputLayers to keep its own texture.
+    // params:
+    //  layerName - layer name (see InferenceGraph::matchLayerName)
+    // returns:
+    //  pointer to the layer output image, or nullptr if the graph has no such layer
+    ImageTexture* getOutputImage(const std::string& layerName);
+
+    // Gets the number of stages, skipped in the last run, because the requested outputs didn't depend on them.
+    // The total over all runs is reported by getMetrics().
+    size_t getSkippedStageCount() const { return numSkippedStages; }
+
+    // Gets a snapshot of the runtime metrics. Metrics are collected in all builds,
+    // and the snapshot can be taken from any thread.
+    // returns:
+    //  metrics snapshot
+    InferenceMetrics getMetrics() const { return metrics.snapshot(); }
+
+    // Sets how often GPU time of every stage is queried for the metrics.
+    // Profiling builds query GPU time of the stages on their own schedule.
+    // params:
+    //  interval - number of runs between samples, 0 disables sampling
+    void setGpuSamplingInterval(uint32_t interval) { metrics.setGpuSamplingInterval(interval); }
+
 private:
     GpuContext* context;
-
-    // Flag, indicating that we need to bind model output
-    // to the model output image(s)
-    // Currently we do this for Android only
-    bool bindOutput = true;
+    // Compiled model, the context executes. Keeps programs and weights alive.
+    std::shared_ptr<const CompiledModel> model;
 
     CreationParameters cp;
     RenderStagesArray stages;
@@ -136,13 +254,121 @@ private:
     DeviceTimer* gpuRunTime = NULL;
 
     Timer cpuRunTime = Timer("IC2 Total CPU Runtime");
+    RuntimeMetrics metrics;
+    bool sampleStageTimes = false; // GPU time of the stages is sampled for the metrics in the current run
     // Model output if located on CPU
     std::vector<std::vector<float>> output;
 
+    // Requested outputs, the active stages are selected for
+    std::vector<std::string> activeOutputs;
+    // Flags of the stages, the requested outputs depend on. Empty if the whole graph is executed.
+    std::vector<bool> activeStages;
+    size_t numSkippedStages = 0;
+
+    // State of the pipelined execution
+    struct Pipeline;
+    std::unique_ptr<Pipeline> pipeline;
+
     std::string printTimingStats() const;
     MixedInferenceCore(GpuContext* context_);
 
+    // Runs one GPU stage
+    // params:
+    //  rp - parameters, known at runtime
+    //  i - stage index
+    void runGpuStage(RunParameters& rp, size_t i);
+
+    // Checks if GPU time of every stage is queried in the current run:
+    // in profiling builds, when trace recording is on, or when it is sampled for the metrics
+    bool queryStageTimes();
+
+    // Gets GPU time of the stages, queried in the current run
+    void getStageTimes();
+
+    // Waits for the GPU and records the wait time
+    void syncBackend();
+
+    // Worker thread function of the pipelined execution
+    void pipelineWorker();
+
+    // Selects the stages, the requested outputs depend on, and counts the skipped ones.
+    // The selection is reused, while the same outputs are requested.
+    // params:
+    //  requestedOutputs - names of the requested layers, empty for the whole graph
+    // returns:
+    //  false if a requested layer is not found
+    bool selectActiveStages(const std::vector<std::string>& requestedOutputs);
+
+    // Finds the stage of a layer
+    // returns:
+    //  stage index, or -1 if the graph has no such layer
+    int findStage(const std::string& layerName) const;
+
+    bool isStageActive(size_t i) const { return activeStages.empty() || activeStages[i]; }
+
+    // Binds the stage outputs to RunParameters::outputImages, and restores the own textures of the stages,
+    // that were bound in the previous run, but not in this one
+    // params:
+    //  rp - parameters, known at runtime
+    void bindOutputImages(RunParameters& rp);
+
+    // Checks if an output image can be bound to a stage output
+    // params:
+    //  i - stage index
+    //  image - output image
+    // returns:
+    //  true if the image is valid for the stage
+    bool validateOutputImage(size_t i, ImageTexture& image) const;
+
+    // Attaches stage inputs and aliased stage outputs to the outputs of the stages, they refer to, again.
+    // Called after output textures of some stages have been replaced.
+    void reattachStageOutputs();
+
+    // Converts the stage outputs into the bound output images of other color formats.
+    // Called after the GPU stages have been synced.
+    void convertOutputImages();
+
     bool init(const CreationParameters& cp);
 };
 
+// Execution context of a compiled model
+using ExecutionContext = MixedInferenceCore;
+
+// Immutable part of a model: inference graph, programs and weights.
+// It is shared by all execution contexts of the model, created with MixedInferenceCore::create(model).
+class CompiledModel {
+public:
+    SNN_NO_MOVE(CompiledModel);
+    SNN_NO_COPY(CompiledModel);
+
+    // Compiles a model given creation parameters
+    // params:
+    //  context - GPU context
+    //  cp - creation parameters
+    // returns:
+    //  shared pointer to CompiledModel
+    static std::shared_ptr<const CompiledModel> create(GpuContext* context, const MixedInferenceCore::CreationParameters& cp);
+
+    // Compiles a model given model file name
+    // params:
+    //  context - GPU context
+    //  modelFileName - model file in JSON format
+    //  options - shader generation options
+    //  dumpOutputs - flag to dump layer outputs when running an inference
+    // returns:
+    //  shared pointer to CompiledModel, null if the model can't be loaded
+    static std::shared_ptr<const CompiledModel> create(GpuContext* context, const std::string& modelFileName,
+        const dp::ShaderGenOptions& options, bool dumpOutputs = false);
+
+    GpuContext* getContext() const { return context; }
+
+    const MixedInferenceCore::CreationParameters& getCreationParameters() const { return cp; }
+
+private:
+    GpuContext* context;
+    MixedInferenceCore::CreationParameters cp;
+
+    CompiledModel(GpuContext* context_, const MixedInferenceCore::CreationParameters& cp_): context(context_), cp(cp_) {}
+};
+
 } // namespace snn
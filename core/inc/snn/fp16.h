@@ -0,0 +1,63 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Bulk conversions between 32-bit and 16-bit (IEEE 754 half precision) floating point values,
+// used to pack FP16 weights and to read FP16 results back.
+// F16C (selected at runtime on x86) and NEON (AArch64) are used where available, and every
+// implementation rounds to nearest even, handles denormals and keeps Inf and NaN,
+// so the results are identical on all CPUs and match the conversion of GPUs.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace snn {
+namespace fp16 {
+
+// Converts one float to half float
+uint16_t floatToHalf(float value);
+
+// Converts one half float to float
+float halfToFloat(uint16_t value);
+
+// Rounds one float to the nearest value, representable as half float
+float roundToHalf(float value);
+
+// Converts floats to half floats
+// params:
+//  src - source values
+//  dst - destination values. May be the same memory as src, the conversion goes front to back.
+//  count - number of values
+void floatToHalf(const float* src, uint16_t* dst, size_t count);
+
+// Converts half floats to floats
+// params:
+//  src - source values
+//  dst - destination values, must not overlap src
+//  count - number of values
+void halfToFloat(const uint16_t* src, float* dst, size_t count);
+
+// Rounds floats to the nearest values, representable as half floats
+// params:
+//  src - source values
+//  dst - destination values. May be equal to src.
+//  count - number of values
+void roundToHalf(const float* src, float* dst, size_t count);
+
+inline void roundToHalf(std::vector<float>& values) { roundToHalf(values.data(), values.data(), values.size()); }
+
+} // namespace fp16
+} // namespace snn
@@ -19,6 +19,7 @@
 #pragma once
 
 #include "snn/utils.h"
+#include "snn/fp16.h"
 #include "color.h"
 #include <string>
 #include <vector>
@@ -51,37 +52,8 @@ union FP32 {
         uint32_t sign : 1;
     };
 
-    uint16_t toHalf() const {
-        // https://gist.github.com/rygorous/2156668
-        FP32 infty = {31 << 23};
-        FP32 magic = {15 << 23};
-        FP32 f32;
-        f32.flt  = flt;
-        FP16 o = {0};
-
-        auto sign = f32.sign;
-        f32.sign  = 0;
-
-        // Based on ISPC reference code (with minor modifications)
-        if (f32.exponent == 255) { // Inf or NaN (all exponent bits set)
-            o.exponent = 31;
-            o.mantissa = f32.mantissa ? 0x200 : 0; // NaN->qNaN and Inf->Inf
-        } else                                     // (De)normalized number or zero
-        {
-            f32.u &= ~0xfff; // Make sure we don't get sticky bits
-            f32.flt *= magic.flt;
-
-            f32.u += 0x1000; // Rounding bias
-            if (f32.u > infty.u) {
-                f32.u = infty.u; // Clamp to signed infinity if overflowed
-            }
-
-            o.u = (uint16_t)(f32.u >> 13); // Take the bits!
-        }
-
-        o.sign = sign;
-        return o.u;
-    }
+    // Rounds to nearest even, see snn/fp16.h for bulk conversions
+    uint16_t toHalf() const { return fp16::floatToHalf(flt); }
 
     static uint16_t toHalf(float f32) { return ((FP32*) &f32)->toHalf(); }
 };
@@ -27,6 +27,30 @@ namespace snn {
 
 typedef enum class Backend { Backend_CPU, Backend_GPU, NOT_DEFINED = 200 } Backend;
 
+// Parameters of converting a YUV camera frame into a model input on GPU. See ImageTexture::preprocessYuv().
+struct YuvPreprocessParams {
+    // Region of the frame to use, in pixels. Zero width or height means the rest of the frame.
+    uint32_t cropX      = 0;
+    uint32_t cropY      = 0;
+    uint32_t cropWidth  = 0;
+    uint32_t cropHeight = 0;
+    // true to keep the aspect ratio of the region and to fill the rest of the image with padColor.
+    // false to stretch the region over the whole image.
+    bool letterbox = false;
+    // Color of the letterbox padding in 0..255 range, before normalization
+    std::array<float, 4> padColor {0.0f, 0.0f, 0.0f, 255.0f};
+    // true if the chroma plane holds V before U (NV21). NV21 frames can not be told apart from NV12 frames by their planes.
+    bool swapUV = false;
+    // true for full range (JPEG) YUV. false for BT.601 limited range, which is also used by nv12ToRgba8().
+    bool fullRange = false;
+    // true if using linear filter. false if using nearest-neighbor filter.
+    bool linearFilter = true;
+    // Mean values for 4 channels. Used for normalization: (value - means) * norms, with values in 0..255 range.
+    std::array<float, 4> means {0.0f, 0.0f, 0.0f, 0.0f};
+    // Normalization values for 4 channels (multipliers). Used for normalization.
+    std::array<float, 4> norms {1.0f, 1.0f, 1.0f, 1.0f};
+};
+
 // This class describes an image, located on GPU or CPU
 class ImageTexture {
 protected:
@@ -58,6 +82,30 @@ protected:
     // Clears an image on CPU
     void resetImages();
 
+    // Shader parameters of YUV preprocessing. They are the same for all GPU backends.
+    struct YuvPreprocessUniforms {
+        // Column-major matrix, that converts (y, u, v, 1) texture values to RGBA values in 0..255 range
+        std::array<float, 16> yuvToRgba;
+        // Region of this image, that the frame region is resized to: x, y, width, height in pixels
+        std::array<float, 4> dstRect;
+        // Region of the frame: x, y, width, height in texture coordinates
+        std::array<float, 4> srcRect;
+        std::array<float, 4> means;
+        std::array<float, 4> norms;
+        std::array<float, 4> padColor;
+        // 1 for NV12 and NV21 frames, 2 for I420 frames
+        uint32_t chromaPlanes;
+    };
+
+    // Checks a YUV frame and calculates the shader parameters to preprocess it into this image
+    // params:
+    //  yuv - NV12, NV21 or I420 frame
+    //  params - preprocessing parameters
+    //  uniforms - calculated shader parameters
+    // returns:
+    //  true if the frame and the parameters are valid; false if not.
+    bool getYuvPreprocessUniforms(const RawImage& yuv, const YuvPreprocessParams& params, YuvPreprocessUniforms& uniforms) const;
+
 public:
     virtual ~ImageTexture() = default;
 
@@ -96,6 +144,16 @@ public:
     virtual void resetTexture(const std::array<uint32_t, 4>& /*dims*/, ColorFormat /*format*/, const std::string& /*name*/ = "")
     {}
 
+    // Allocates an empty GPU storage buffer instead of GPU images. The buffer holds the image layers in NC4HW4 layout:
+    // layer by layer, then row by row, then pixel by pixel (see dp::ShaderGenOptions::bufferActivations).
+    // params:
+    //  dims - dimensions
+    //  format - color format
+    //  name - optional image name
+    virtual void resetBuffer(const std::array<uint32_t, 4>& /*dims*/, ColorFormat /*format*/, const std::string& /*name*/ = "") {
+        SNN_RIP("Storage buffer images are not supported by this backend");
+    }
+
     // Loads CPU images from file
     // params:
     //  fileName - image file name
@@ -146,6 +204,81 @@ public:
         return 0;
     }
 
+    // Converts a YUV camera frame to RGBA, crops, resizes and normalizes it on GPU in a single pass,
+    // writing straight into the GPU image of this object, e.g. into the input of a model.
+    // It replaces nv12ToRgba8() or i420ToRgba8(), convertToRGBA32FAndNormalize() and resize().
+    // The GPU image has to be allocated with resetTexture() beforehand, with the dimensions and
+    // the color format (RGBA32F or RGBA16F) of the model input, and a single layer.
+    // Shader programs are kept by this object, so it should be reused for consecutive frames.
+    // params:
+    //  yuv - NV12, NV21 or I420 frame, as described by ImageDesc::nv12() or ImageDesc::i420()
+    //  params - crop, resize and normalization parameters
+    // return:
+    //  true if preprocessing was successful; false if not.
+    virtual bool preprocessYuv(const RawImage& yuv, const YuvPreprocessParams& params) {
+        (void) yuv;
+        (void) params;
+
+        return false;
+    }
+
+    // Copies a rectangular region of another image on GPU. All image layers are copied.
+    // Both images must have compatible color formats.
+    // params:
+    //  src - source image
+    //  srcX - horizontal offset of the region in the source image
+    //  srcY - vertical offset of the region in the source image
+    //  dstX - horizontal offset of the region in this image
+    //  dstY - vertical offset of the region in this image
+    //  regionWidth - width of the region
+    //  regionHeight - height of the region
+    // return:
+    //  true if copying was successful; false if not.
+    virtual bool copyRegionFrom(ImageTexture& src, uint32_t srcX, uint32_t srcY, uint32_t dstX, uint32_t dstY,
+        uint32_t regionWidth, uint32_t regionHeight) {
+        (void) src;
+        (void) srcX;
+        (void) srcY;
+        (void) dstX;
+        (void) dstY;
+        (void) regionWidth;
+        (void) regionHeight;
+
+        return false;
+    }
+
+    // Converts another image into the color format of this one on GPU. All image layers are converted.
+    // Both images must have the same width, height and depth.
+    // Fails, if the backend can't convert between the color formats of the images.
+    // params:
+    //  src - source image
+    // return:
+    //  true if conversion was successful; false if not.
+    virtual bool convertFrom(ImageTexture& src) {
+        (void) src;
+
+        return false;
+    }
+
+    // Compares this image with another one on GPU block by block. All image layers and channels are compared.
+    // Both images must have the same dimensions and color format.
+    // params:
+    //  previous - image to compare with, e.g. the previous video frame
+    //  blockWidth - width of a block in pixels
+    //  blockHeight - height of a block in pixels
+    //  maxDiffs - maximal absolute difference of every block, row by row.
+    //             Resized to DIV_AND_ROUND_UP(width, blockWidth) * DIV_AND_ROUND_UP(height, blockHeight).
+    // return:
+    //  true if comparison was successful; false if not.
+    virtual bool computeBlockDifference(ImageTexture& previous, uint32_t blockWidth, uint32_t blockHeight, std::vector<float>& maxDiffs) {
+        (void) previous;
+        (void) blockWidth;
+        (void) blockHeight;
+        (void) maxDiffs;
+
+        return false;
+    }
+
     // Gets image color format
     // params:
     //  index - index of an image plane
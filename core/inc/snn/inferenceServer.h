@@ -0,0 +1,176 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "snn/defines.h"
+#include "snn/snn.h"
+#include "snn/core.h"
+#include "snn/layeroption.h"
+#include "snn/metrics.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace snn {
+
+// Serves inference requests of any number of caller threads with several execution contexts of one compiled model.
+// Requests go through a lock-free bounded queue. Every worker thread owns an execution context
+// (with its own OpenGL context, sharing programs and weights of the model) and takes the queued requests in batches:
+// after the first request of a batch, it waits up to batchTimeoutMs for more.
+// The model graph has no batch dimension, so a batch is uploaded at once and then run request by request
+// on the same context, without waking the worker up in between.
+class InferenceServer {
+public:
+    // Behavior of submit(), when the queue is full
+    enum class Backpressure {
+        BLOCK,  // Wait for a free queue slot
+        REJECT, // Complete the request immediately with Response::ok = false
+    };
+
+    struct CreationParameters {
+        std::string modelFileName;
+        // Model, compiled already on the context, null to compile modelFileName.
+        // Without modelFileName, null is a failed compilation, and the server isn't created.
+        std::shared_ptr<const CompiledModel> model;
+        // Shader generation options. desiredInput describes the inputs of every request.
+        dp::ShaderGenOptions options;
+        ModelType modelType       = ModelType::OTHER;
+        uint32_t numWorkers       = 2;   // Number of execution contexts. Vulkan uses one: contexts share the device queue.
+        uint32_t maxBatch         = 4;   // Maximal number of requests, a worker takes at once
+        uint32_t maxQueueDepth    = 64;  // Maximal number of queued requests
+        double batchTimeoutMs     = 1.0; // Time, a worker waits for more requests after the first request of a batch
+        Backpressure backpressure = Backpressure::BLOCK;
+    };
+
+    struct Request {
+        // Tightly packed pixels of every model input, in the format and size of ShaderGenOptions::desiredInput
+        std::vector<std::vector<uint8_t>> inputs;
+    };
+
+    struct Response {
+        bool ok = false;                        // False, if the request was rejected, invalid, or the server was stopped
+        SNNModelOutput modelOutput;             // Output from special model types
+        std::vector<std::vector<float>> output; // Output of the last layer, if it runs on CPU
+        std::vector<uint8_t> outputImage;       // Pixels of the last layer output, if it runs on GPU
+        uint32_t batchSize = 0;                 // Number of requests in the batch of this request
+        double queueTime   = 0.0;               // Time from submit() to the start of the batch, in milliseconds
+        double latency     = 0.0;               // Time from submit() to the completion, in milliseconds
+    };
+
+    // Snapshot of the server statistics
+    struct Stats {
+        uint64_t submitted = 0;               // Number of submit() calls
+        uint64_t completed = 0;               // Number of successfully completed requests
+        uint64_t rejected  = 0;               // Number of rejected, invalid and dropped requests
+        uint64_t batches   = 0;               // Number of executed batches
+        LatencyHistogram::Snapshot latency;   // Latency of the completed requests
+        LatencyHistogram::Snapshot queueTime; // Queue time of the completed requests
+
+        double getMeanBatchSize() const { return batches ? (double) completed / batches : 0.0; }
+    };
+
+    ~InferenceServer();
+
+    SNN_NO_MOVE(InferenceServer);
+    SNN_NO_COPY(InferenceServer);
+
+    // Compiles the model and starts the worker threads.
+    // With OpenGL, the context must be current on the calling thread: worker contexts share objects with it.
+    // params:
+    //  context - GPU context
+    //  cp - creation parameters
+    // returns:
+    //  unique pointer to InferenceServer, null if the model can't be compiled
+    static std::unique_ptr<InferenceServer> create(GpuContext* context, const CreationParameters& cp);
+
+    // Queues a request. Can be called from any thread. Requests, submitted during or after stop(), complete with Response::ok = false.
+    // params:
+    //  request - model inputs
+    // returns:
+    //  future of the response
+    std::future<Response> submit(Request request);
+
+    // Stops the worker threads. Queued requests, that didn't start yet, complete with Response::ok = false.
+    void stop();
+
+    Stats getStats() const;
+
+private:
+    struct Task;
+    class TaskQueue;
+    struct Worker;
+
+    GpuContext* context;
+    CreationParameters cp;
+    std::shared_ptr<const CompiledModel> model;
+    std::vector<size_t> inputBytes; // Sizes of the request inputs
+    std::unique_ptr<TaskQueue> queue;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::atomic<bool> stopping {false};
+    std::atomic<uint32_t> queueDepth {0};
+    // Sleeping workers wait for tasks, blocked submit() calls wait for free queue slots.
+    // Mutexes are only taken to sleep and to wake up, the queue itself is lock-free.
+    std::atomic<uint32_t> sleepingWorkers {0};
+    std::atomic<uint32_t> blockedSubmits {0};
+    std::mutex taskMutex;
+    std::condition_variable taskCv;
+    std::mutex slotMutex;
+    std::condition_variable slotCv;
+
+    std::atomic<uint64_t> numSubmitted {0};
+    std::atomic<uint64_t> numCompleted {0};
+    std::atomic<uint64_t> numRejected {0};
+    std::atomic<uint64_t> numBatches {0};
+    LatencyHistogram latency;
+    LatencyHistogram queueTime;
+
+    InferenceServer(GpuContext* context_);
+
+    bool init(const CreationParameters& cp);
+
+    // Reserves a queue slot
+    // returns:
+    //  true if the queue is not full
+    bool tryReserveSlot();
+
+    // Takes the next task from the queue
+    // params:
+    //  deadline - time to wait for a task until, nullptr to wait until a task comes or the server stops
+    // returns:
+    //  task or nullptr
+    Task* takeTask(const std::chrono::steady_clock::time_point* deadline);
+
+    // Worker thread function
+    void workerMain(Worker& worker);
+
+    // Runs a batch of tasks on the execution context of the worker and completes them
+    void runBatch(Worker& worker, const std::vector<Task*>& batch);
+
+    // Completes a task without running it
+    void dropTask(Task* task);
+
+    // Completes all queued tasks without running them
+    void drainQueue();
+};
+
+} // namespace snn
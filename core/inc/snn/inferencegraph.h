@@ -23,6 +23,8 @@
 
 namespace snn {
 
+class RenderPass;
+
 namespace dp {
 class DeviceBackend;
 }
@@ -46,6 +48,12 @@ struct InferenceGraph {
         int index = -1;
     };
 
+    // This structure describes a layer output, that is stored inside of another layer's output image
+    struct OutputAlias {
+        int index = -1;             // index of the layer that owns the output image. -1 if the output is not aliased.
+        uint32_t planeOffset = 0;   // index of the first texture layer (4 channels each) written by this layer
+    };
+
     // This structure describes image shape transformation
     struct Transform {
         bool isFixed = 0;
@@ -67,6 +75,21 @@ struct InferenceGraph {
         static constexpr Transform identity() { return {0, {{1.0f, 1.0f, 0.0f, 0.0f}}}; }
     };
 
+    // This structure describes static cost of one layer execution, estimated from the layer shapes.
+    // Texture bytes respect the texture format (FP16 or FP32) and the number of passes, each of which reads all layer inputs.
+    struct LayerCost {
+        uint64_t macs         = 0; // multiply-accumulate operations
+        uint64_t bytesRead    = 0; // input texture bytes, read by all passes
+        uint64_t weightBytes  = 0; // weights, biases and other parameters
+        uint64_t bytesWritten = 0; // output texture bytes
+        uint32_t numPasses    = 0; // number of render or compute passes
+
+        uint64_t getTotalBytes() const { return bytesRead + weightBytes + bytesWritten; }
+
+        // Arithmetic intensity in FLOPs per byte. One MAC is counted as two FLOPs.
+        double getIntensity() const { return getTotalBytes() ? 2.0 * macs / getTotalBytes() : 0.0; }
+    };
+
     // This structure declares one layer of the inference processing graph at high level.
     struct Layer {
         LayerExecutionType layerLoc; // Location of layer (CPU or GPU)
@@ -76,17 +99,28 @@ struct InferenceGraph {
         bool flattenLayer; // True if layer is fully-connected.
         bool isInputLayer = false;  // True if layer is input layer.
         uint32_t inputIndex = 0;    // The index of this layer in all layers array
+        bool isNoOp = false;        // True if the layer output is fully written by its producers (e.g. zero-copy concatenation)
+        OutputAlias outputAlias;    // Set if the layer writes into a layer range of another layer's output
+        bool bufferOutput = false;  // True if the layer output is an NC4HW4 storage buffer (see ShaderGenOptions::bufferActivations)
+        LayerCost cost;             // Static cost estimate, set up during generateInferenceGraph
+        std::string signature;      // Layer type, shapes and precision. Key of ShaderGenOptions::layerCompute.
 
         // Pointer to run on CPU function 
         using TImageTextureFunc = std::function<void(ImageTextureArray& inputMat, ImageTextureArray& outputMat)>;
         TImageTextureFunc imageTextureFunPtr;
 
-        // Pointer to init function
-        using TInitFunc = std::function<void(snn::dp::DeviceBackend *backend, ImageTextureArray& inputMat, ImageTextureArray& outputMat)>;
+        // Pointer to compile function. Called once per compiled model, before initFunPtr. Returns false on compilation errors.
+        using TCompileFunc = std::function<bool(snn::dp::DeviceBackend *backend)>;
+        TCompileFunc compileFunPtr;
+
+        // Pointer to init function. Creates the render passes of one execution context.
+        using TInitFunc = std::function<void(snn::dp::DeviceBackend *backend, ImageTextureArray& inputMat, ImageTextureArray& outputMat,
+                                             std::vector<std::shared_ptr<RenderPass>>& renderPasses)>;
         TInitFunc initFunPtr;
 
         // Pointer to run function
-        using TRunFunc = std::function<void(snn::dp::DeviceBackend *backend, bool dumpOutputs)>;
+        using TRunFunc = std::function<void(snn::dp::DeviceBackend *backend, const std::vector<std::shared_ptr<RenderPass>>& renderPasses,
+                                            bool dumpOutputs)>;
         TRunFunc runFunPtr;
     };
 
@@ -97,6 +131,20 @@ struct InferenceGraph {
 
     snn::MRTMode mrtMode               = snn::MRTMode::DOUBLE_PLANE;        // set up during generateInferenceGraph. Defaults to SINGLE_PLANE
     snn::WeightAccessMethod weightMode = snn::WeightAccessMethod::TEXTURES; // set up during generateInferenceGraph. Defaults to TEXTURE
+    uint32_t numEliminatedConcats = 0; // number of concatenation layers replaced by aliased producer outputs
+    uint32_t numFusedBlocks       = 0; // number of inverted residual blocks replaced by fused layers
+    uint32_t numFusedUpsamplings  = 0; // number of upsampling layers fused into the consuming convolutions
+    uint32_t numBufferActivations = 0; // number of layer outputs kept in NC4HW4 storage buffers
+
+    // Checks if a layer name matches a name, given by the user: either the full layer name ("model layer [03] Conv2D"),
+    // or its part, starting from the layer index ("[03] Conv2D"), that doesn't depend on the model file name.
+    static bool matchLayerName(const std::string& layerName, const std::string& name) {
+        if (layerName == name) {
+            return true;
+        }
+        size_t pos = layerName.find('[');
+        return pos != std::string::npos && layerName.compare(pos, std::string::npos, name) == 0;
+    }
 };
 
 } // namespace snn
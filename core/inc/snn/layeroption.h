@@ -17,6 +17,8 @@
 #include <snn/snn.h>
 #include <snn/utils.h>
 #include "snn/inferencegraph.h"
+#include <map>
+#include <string>
 #include <vector>
 
 namespace snn {
@@ -37,12 +39,54 @@ struct ShaderGenOptions {
     // Set to true to generate compute shaders
     bool compute = false;
 
+    // Per-layer shader kind overrides of OpenGL layers, keyed by the layer signature (see InferenceGraph::Layer::signature):
+    // true for compute shaders, false for fragment shaders. Layers, that are not listed, use compute.
+    // Usually produced by ShaderPlacement (see snn/shaderPlacement.h).
+    std::map<std::string, bool> layerCompute;
+
     // Set to true to generate Vulkan shaders
     bool vulkan = false;
 
     bool preferrHalfPrecision = false; // prefer 16-bit float when set to true. Otherwise, 32-bit float.
 
+    // Per-layer precision overrides, keyed by the layer index in the model file: true for 16-bit floats, false for 32-bit floats.
+    // Layers, that are not listed, use preferrHalfPrecision. Usually produced by PrecisionPlanner (see snn/precisionPlanner.h).
+    std::map<uint32_t, bool> layerHalfPrecision;
+
     bool ssbo = false; // Set to true to store weights in SSBO.
+
+    // Set to true to let the inputs of a concatenation layer write directly into its output,
+    // when the channel offsets allow that. The concatenation layer itself is not executed then.
+    bool zeroCopyConcat = true;
+
+    // Set to true to read spatial input dimensions from the input textures at runtime instead of
+    // compiling them into shaders. Shader sources then do not depend on the input resolution,
+    // so programs compiled for one resolution are reused for another.
+    bool dynamicShapes = false;
+
+    // Set to true to run MobileNetV2 style inverted residual blocks (expand 1x1 -> depthwise 3x3 -> project 1x1 -> add)
+    // as a single fused compute shader, that keeps the expanded activations on chip.
+    // Used with compute shaders (GL or Vulkan) only.
+    bool fuseInvertedResidual = true;
+
+    // Set to true to remove nearest and bilinear upsampling layers with integer scales, that feed only 2D convolutions,
+    // and let the convolutions sample their low-resolution input through the upsampling index transform instead,
+    // so the upsampled tensor is never written to memory.
+    // Disabled by default: fuseUpsamplingTest compares fused and unfused outputs, and the default is to be changed
+    // only after the test passes with fragment shaders, GL compute shaders and Vulkan on the target devices.
+    bool fuseUpsampling = false;
+
+    // Set to true to keep intermediate activations of GL compute shader layers in NC4HW4 storage buffers
+    // (channel groups of 4, then rows, then columns) instead of textures. Only activations, that are produced
+    // and consumed by layers with buffer compute shaders, are stored in buffers. Graph inputs and outputs stay textures.
+    // Used with GL compute shaders without dynamic shapes only. Vulkan keeps textures: it would need storage buffer
+    // descriptors and SPIR-V variants of the shaders.
+    bool bufferActivations = false;
+
+    // Names of the intermediate layers, that can be requested as run outputs (see MixedInferenceCore::RunParameters::requestedOutputs).
+    // These layers keep their own output textures: they are not fused into inverted residual blocks
+    // and don't write into zero-copy concatenation outputs.
+    std::vector<std::string> outputLayers;
     MRTMode mrtMode; // MRT (Multiple Render Target) mode
     WeightAccessMethod weightMode; // Weights access mode
 };
@@ -0,0 +1,161 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "snn/defines.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace snn {
+
+// Latency histogram with fixed exponential buckets.
+// Bucket i counts values up to 50us * 2^i, the last bucket counts everything above.
+// Updates are lock-free and wait-free, so it can be updated on every inference.
+class LatencyHistogram {
+public:
+    static constexpr size_t NUM_BUCKETS = 20;
+
+    // Copy of the histogram state at some point in time
+    struct Snapshot {
+        uint64_t count   = 0;
+        uint64_t totalNs = 0;
+        uint64_t maxNs   = 0;
+        std::array<uint64_t, NUM_BUCKETS> buckets = {};
+
+        double getMeanMs() const { return count ? totalNs / 1e6 / count : 0.0; }
+
+        // Estimates a percentile as the upper bound of the bucket, containing it
+        // params:
+        //  p - percentile in [0, 1] range
+        // returns:
+        //  percentile in milliseconds
+        double getPercentileMs(double p) const;
+    };
+
+    LatencyHistogram() = default;
+
+    SNN_NO_COPY(LatencyHistogram);
+    SNN_NO_MOVE(LatencyHistogram);
+
+    // Upper bound of the bucket in nanoseconds. UINT64_MAX for the last bucket.
+    static uint64_t getBucketUpperBoundNs(size_t bucket);
+
+    void record(uint64_t ns);
+
+    Snapshot snapshot() const;
+
+private:
+    std::array<std::atomic<uint64_t>, NUM_BUCKETS> _buckets = {};
+    std::atomic<uint64_t> _count {0};
+    std::atomic<uint64_t> _totalNs {0};
+    std::atomic<uint64_t> _maxNs {0};
+};
+
+// Snapshot of the runtime metrics of one inference core
+struct InferenceMetrics {
+    struct StageGpuTime {
+        std::string name;
+        LatencyHistogram::Snapshot time;
+    };
+
+    uint64_t numRuns = 0;                   // Number of run() and submit() calls
+    LatencyHistogram::Snapshot runTime;     // End-to-end time of run() and submit()
+    LatencyHistogram::Snapshot syncTime;    // Time, spent waiting for the GPU in backend sync
+    std::vector<StageGpuTime> stageGpuTime; // GPU time of every GPU stage, sampled every gpuSamplingInterval runs
+    uint32_t gpuSamplingInterval = 0;       // 0 if GPU time sampling is disabled
+    uint64_t readbackBytes       = 0;       // Total size of the GPU outputs, downloaded for CPU layers
+    uint64_t textureBytes        = 0;       // Size of the intermediate textures, owned by the inference core
+    uint64_t skippedStages       = 0;       // Total number of stages, skipped because the requested outputs didn't depend on them
+    uint64_t gpuDispatches       = 0;       // Total number of recorded compute dispatches (Vulkan)
+    uint64_t gpuBarriers         = 0;       // Total number of recorded pipeline barriers, including layout transitions (Vulkan)
+    uint64_t glStateCalls        = 0;       // Total number of issued binding calls of render passes (OpenGL)
+    uint64_t glStateCallsSkipped = 0;       // Total number of skipped redundant binding calls of render passes (OpenGL)
+};
+
+// Always compiled runtime metrics of an inference core.
+// Counters and histograms are updated with relaxed atomic operations, so snapshots can be
+// taken from any thread while inferences are running.
+class RuntimeMetrics {
+public:
+    static constexpr uint32_t DEFAULT_GPU_SAMPLING_INTERVAL = 64;
+
+    RuntimeMetrics() = default;
+
+    SNN_NO_COPY(RuntimeMetrics);
+    SNN_NO_MOVE(RuntimeMetrics);
+
+    // Allocates per-stage GPU time histograms
+    // params:
+    //  stageNames - names of the stages, empty for stages, that are not timed
+    void init(const std::vector<std::string>& stageNames);
+
+    // Starts a new run
+    // returns:
+    //  true, if GPU time of the stages is sampled in this run
+    bool beginRun();
+
+    void endRun(uint64_t ns) { _runTime.record(ns); }
+
+    void recordSync(uint64_t ns) { _syncTime.record(ns); }
+
+    void recordStageGpuTime(size_t stage, uint64_t ns);
+
+    void addReadbackBytes(uint64_t bytes) { _readbackBytes.fetch_add(bytes, std::memory_order_relaxed); }
+
+    void addTextureBytes(uint64_t bytes) { _textureBytes.fetch_add(bytes, std::memory_order_relaxed); }
+
+    // Called, when a texture of the inference core is released
+    void releaseTextureBytes(uint64_t bytes) { _textureBytes.fetch_sub(bytes, std::memory_order_relaxed); }
+
+    void addSkippedStages(uint64_t count) { _skippedStages.fetch_add(count, std::memory_order_relaxed); }
+
+    void addGpuCommands(uint64_t dispatches, uint64_t barriers) {
+        _gpuDispatches.fetch_add(dispatches, std::memory_order_relaxed);
+        _gpuBarriers.fetch_add(barriers, std::memory_order_relaxed);
+    }
+
+    void addGlStateCalls(uint64_t issued, uint64_t skipped) {
+        _glStateCalls.fetch_add(issued, std::memory_order_relaxed);
+        _glStateCallsSkipped.fetch_add(skipped, std::memory_order_relaxed);
+    }
+
+    // Sets how often GPU time of every stage is queried
+    // params:
+    //  interval - number of runs between samples, 0 disables sampling
+    void setGpuSamplingInterval(uint32_t interval) { _gpuSamplingInterval.store(interval, std::memory_order_relaxed); }
+
+    InferenceMetrics snapshot() const;
+
+private:
+    std::atomic<uint64_t> _numRuns {0};
+    std::atomic<uint32_t> _gpuSamplingInterval {DEFAULT_GPU_SAMPLING_INTERVAL};
+    std::atomic<uint64_t> _readbackBytes {0};
+    std::atomic<uint64_t> _textureBytes {0};
+    std::atomic<uint64_t> _skippedStages {0};
+    std::atomic<uint64_t> _gpuDispatches {0};
+    std::atomic<uint64_t> _gpuBarriers {0};
+    std::atomic<uint64_t> _glStateCalls {0};
+    std::atomic<uint64_t> _glStateCallsSkipped {0};
+    LatencyHistogram _runTime;
+    LatencyHistogram _syncTime;
+    std::vector<std::string> _stageNames;
+    std::unique_ptr<LatencyHistogram[]> _stageGpuTime;
+};
+
+} // namespace snn
@@ -0,0 +1,101 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "snn/defines.h"
+#include "snn/snn.h"
+#include "snn/core.h"
+#include "snn/layeroption.h"
+#include <array>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace snn {
+
+// Runs a model on inputs, whose resolution changes at runtime
+// (e.g. camera preview vs capture, portrait vs landscape).
+// Prepared inference cores are kept in a small LRU cache keyed by the input resolution,
+// so switching back to a recent resolution does not prepare the model again.
+// Weight textures and buffers are uploaded once and shared by the cores of all resolutions.
+// Models are generated with ShaderGenOptions::dynamicShapes, so with the program binary cache enabled,
+// preparing a new resolution reuses the GL programs compiled for other resolutions.
+class MultiResolutionInferenceCore {
+public:
+    ~MultiResolutionInferenceCore() = default;
+
+    SNN_NO_MOVE(MultiResolutionInferenceCore);
+    SNN_NO_COPY(MultiResolutionInferenceCore);
+
+    struct CreationParameters {
+        std::string modelFileName;
+        // Shader generation options. Width and height of desiredInput are taken from the input images.
+        dp::ShaderGenOptions options;
+        // Maximum number of prepared resolutions
+        size_t cacheCapacity = 3;
+        // Size limit in bytes of the process-wide GL program binary cache, that lets new resolutions skip
+        // the shader compilation. 0 leaves the cache as is, i.e. disabled, unless enabled elsewhere.
+        size_t programBinaryCacheSize = 0;
+    };
+
+    // Creates an instance of MultiResolutionInferenceCore
+    // params:
+    //  context - GPU context
+    //  cp - creation parameters
+    // returns:
+    //  unique pointer to MultiResolutionInferenceCore
+    static std::unique_ptr<MultiResolutionInferenceCore> create(GpuContext* context, const CreationParameters& cp);
+
+    // Runs one inference of a model, preparing the model for the input resolution if needed
+    // params:
+    //  rp - parameters, known at runtime
+    void run(MixedInferenceCore::RunParameters& rp);
+
+    // Prepares the model for the given input resolution ahead of time
+    // params:
+    //  inputSizes - width and height of every model input
+    // returns:
+    //  true if success, false if not
+    bool prepare(const std::vector<std::array<uint32_t, 2>>& inputSizes);
+
+    // Gets time of the last resolution switch in milliseconds.
+    // Includes preparing the model, if the resolution was not in the cache.
+    double getLastSwitchTime() const { return lastSwitchTime; }
+
+private:
+    struct PreparedCore {
+        std::vector<std::array<uint32_t, 2>> inputSizes;
+        std::unique_ptr<MixedInferenceCore> core;
+    };
+
+    GpuContext* context;
+    CreationParameters cp;
+    // Most recently used core is at the front
+    std::list<PreparedCore> cores;
+    double lastSwitchTime = 0.0;
+
+    MultiResolutionInferenceCore(GpuContext* context_, const CreationParameters& cp_);
+
+    // Weights of the prepared cores, shared across resolutions
+    std::shared_ptr<WeightCache> weightCache;
+
+    // Finds or prepares a core for the given input sizes and moves it to the front of the cache
+    // returns:
+    //  prepared core or nullptr, if the model can not be prepared for the input sizes
+    MixedInferenceCore* acquire(const std::vector<std::array<uint32_t, 2>>& inputSizes);
+};
+
+} // namespace snn
@@ -0,0 +1,87 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "snn/defines.h"
+#include "snn/snn.h"
+#include "snn/imageTexture.h"
+#include "snn/layeroption.h"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace snn {
+
+// Per-layer precision of a model
+struct PrecisionPlan {
+    struct LayerError {
+        uint32_t layerIndex = 0; // Layer index in the model file
+        std::string name;
+        double error = 0.0;      // Output error, when only this layer runs in FP16
+    };
+
+    // Precision of every layer, keyed by the layer index in the model file: true for FP16, false for FP32.
+    // Assign it to ShaderGenOptions::layerHalfPrecision.
+    std::map<uint32_t, bool> layerHalfPrecision;
+    // Errors of the single layer switches, sorted in ascending order
+    std::vector<LayerError> layerErrors;
+    double errorBudget = 0.0; // Error budget, the plan was made for
+    double error       = 0.0; // Output error of the whole plan
+
+    // Writes the plan to a JSON file
+    // params:
+    //  fileName - file name
+    // returns:
+    //  true if success, false if not
+    bool save(const std::string& fileName) const;
+
+    // Reads the plan from a JSON file, written by save()
+    // params:
+    //  fileName - file name
+    // returns:
+    //  true if success, false if not
+    bool load(const std::string& fileName);
+};
+
+// Selects the layers, that can run in FP16, under an error budget.
+// The model is run in FP32 as a reference, then with every layer switched to FP16 alone,
+// and layers are added to the FP16 set in the order of their errors, as long as
+// the measured output error of the whole set stays within the budget.
+// Error is the relative RMS difference of the model outputs: sqrt(sum((y - ref)^2) / sum(ref^2)) over all calibration samples.
+class PrecisionPlanner {
+public:
+    struct CreationParameters {
+        std::string modelFileName;
+        // Shader generation options. Precision options are ignored.
+        dp::ShaderGenOptions options;
+        // Maximal relative RMS error of the model outputs
+        double errorBudget = 1e-3;
+    };
+
+    // Makes a precision plan. Needs about (number of layers + log2(number of layers)) model builds and
+    // as many runs over the calibration samples.
+    // params:
+    //  context - GPU context
+    //  cp - creation parameters
+    //  calibrationInputs - model inputs of every calibration sample
+    //  plan - precision plan
+    // returns:
+    //  true if success, false if not
+    static bool plan(GpuContext* context, const CreationParameters& cp, const std::vector<ImageTextureArrayAccessor>& calibrationInputs,
+                     PrecisionPlan& plan);
+};
+
+} // namespace snn
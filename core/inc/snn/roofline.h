@@ -0,0 +1,63 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "snn/inferencegraph.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace snn {
+
+// One layer of the roofline report
+struct RooflineEntry {
+    std::string name;
+    InferenceGraph::LayerCost cost;
+    double timeMs = 0.0; // Mean measured GPU time, 0 if the layer was not timed
+
+    // Achieved compute throughput, 0 if the layer was not timed
+    double getGflops() const { return timeMs > 0.0 ? 2.0 * cost.macs / (timeMs * 1e6) : 0.0; }
+
+    // Achieved memory throughput, 0 if the layer was not timed
+    double getGbps() const { return timeMs > 0.0 ? cost.getTotalBytes() / (timeMs * 1e6) : 0.0; }
+};
+
+// Device peaks, used to classify layers. 0 if unknown.
+struct RooflinePeaks {
+    double gflops = 0.0;
+    double gbps   = 0.0;
+};
+
+// Matches the static layer costs of the graph with the measured stage times.
+// Works without measurements as well, then only the static part of the report is filled.
+// params:
+//  graph - inference graph, generated by dp::generateInferenceGraph()
+//  timeStat - stage times in milliseconds, as written by MixedInferenceCore::writeTimeStat().
+//             Keys are layer names, optionally followed by "_" and the layer dimensions.
+// returns:
+//  one entry per layer, that runs shaders, in the graph order
+std::vector<RooflineEntry> buildRooflineReport(const InferenceGraph& graph, const std::map<std::string, std::vector<double>>& timeStat = {});
+
+// Formats the roofline report as a text table.
+// With known peaks, every timed layer is classified as compute or bandwidth bound by its arithmetic intensity
+// relative to the ridge point (peak GFLOP/s / peak GB/s), and its achieved fraction of the bounding roof is printed.
+// params:
+//  entries - report entries
+//  peaks - device peaks
+// returns:
+//  report text
+std::string formatRooflineReport(const std::vector<RooflineEntry>& entries, const RooflinePeaks& peaks = {});
+
+} // namespace snn
@@ -0,0 +1,98 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "snn/defines.h"
+#include "snn/snn.h"
+#include "snn/imageTexture.h"
+#include "snn/layeroption.h"
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace snn {
+
+// Measured fragment and compute shader times of OpenGL layers on one GPU
+struct ShaderPlacementTable {
+    struct Entry {
+        double fsMs = 0.0; // Mean GPU time of the fragment shader variant, 0 if not measured
+        double csMs = 0.0; // Mean GPU time of the compute shader variant, 0 if not measured
+    };
+
+    std::string device;                  // GPU, the times were measured on. See ShaderPlacement::getDeviceName().
+    std::map<std::string, Entry> layers; // Times, keyed by the layer signature
+
+    // Gets the faster shader kind of every layer with both times measured
+    // params:
+    //  minGain - relative gain, needed to move a layer away from the default shader kind
+    //  compute - default shader kind: true for compute shaders
+    // returns:
+    //  per-layer shader kinds for ShaderGenOptions::layerCompute
+    std::map<std::string, bool> getLayerCompute(double minGain = 0.05, bool compute = false) const;
+
+    // Adds the entries of another table of the same device. Entries of the other table win.
+    void merge(const ShaderPlacementTable& other);
+
+    // Writes the table to a JSON file
+    // params:
+    //  fileName - file name
+    // returns:
+    //  true if success, false if not
+    bool save(const std::string& fileName) const;
+
+    // Reads the table from a JSON file, written by save()
+    // params:
+    //  fileName - file name
+    // returns:
+    //  true if success, false if not
+    bool load(const std::string& fileName);
+};
+
+// Selects fragment or compute shaders for every OpenGL layer by measurement.
+// The model is built once with fragment shaders and once with compute shaders,
+// and GPU times of every layer are sampled on every run. Layers are identified by their signatures
+// (type, shapes, kernel size and precision), so that a table, measured once per GPU, is reused across
+// models and runs. Layers, that have no compute shader, are only measured as fragment shaders.
+// Textures of both shader kinds share one layout (RGBA 2D arrays with 4 channels per layer),
+// so any mix of them forms a valid graph.
+class ShaderPlacement {
+public:
+    struct CreationParameters {
+        std::string modelFileName;
+        // Shader generation options. compute and layerCompute are ignored.
+        dp::ShaderGenOptions options;
+        uint32_t warmupRuns = 3;  // Runs, excluded from the measurement
+        uint32_t runs       = 20; // Measured runs
+    };
+
+    // Gets the name of the GPU, the tables are keyed by
+    // params:
+    //  context - OpenGL context
+    // returns:
+    //  GPU vendor and renderer
+    static std::string getDeviceName(GpuContext* context);
+
+    // Measures both shader kinds of every layer of the model
+    // params:
+    //  context - OpenGL context
+    //  cp - creation parameters
+    //  inputs - model inputs
+    //  table - measured times are added to this table
+    // returns:
+    //  true if success, false if not
+    static bool measure(GpuContext* context, const CreationParameters& cp, const ImageTextureArrayAccessor& inputs, ShaderPlacementTable& table);
+};
+
+} // namespace snn
@@ -0,0 +1,171 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "snn/defines.h"
+#include "snn/snn.h"
+#include "snn/core.h"
+#include "snn/imageTexture.h"
+#include "snn/layeroption.h"
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace snn {
+
+namespace dp {
+class GenericModelLayer;
+}
+
+// Runs a fully convolutional model over an image of arbitrary size.
+// The image is split into tiles, every tile is extended with a halo of
+// neighbor pixels to cover the receptive field of the model, and only the valid
+// center of every tile output is written to the final output image.
+// GPU memory used by the model intermediates depends on the tile size only.
+// In the incremental mode, used for video streams, a tile is only recomputed if its input, including the halo, has changed
+// since the tile was computed last time. Other tiles keep their output of previous frames in the output image.
+// Every tile keeps a snapshot of the input window, it was computed from, so a skipped tile differs from its input
+// by at most changeThreshold per value, however many frames it is skipped for. Only the threshold of 0 gives
+// exactly the output of computing all tiles. The incremental mode compares images on GPU with OpenGL only.
+class TiledInferenceCore {
+public:
+    ~TiledInferenceCore() = default;
+
+    SNN_NO_MOVE(TiledInferenceCore);
+    SNN_NO_COPY(TiledInferenceCore);
+
+    struct CreationParameters {
+        std::string modelFileName;
+        // Shader generation options. desiredInput[0] describes the model input format,
+        // its width and height are replaced with the tile input size.
+        dp::ShaderGenOptions options;
+        uint32_t tileWidth  = 256; // Width of the valid tile area in input pixels
+        uint32_t tileHeight = 256; // Height of the valid tile area in input pixels
+        int32_t overlap     = -1;  // Halo around every tile in input pixels. -1 uses the model receptive field radius.
+        // Incremental mode for consecutive frames of a video stream. The same output image must be passed to every run().
+        // Not supported with Vulkan: create() fails.
+        bool incremental      = false;
+        float changeThreshold = 0.0f; // Maximal absolute difference of input values, that doesn't make a tile dirty
+    };
+
+    // Tile statistics of the incremental mode since the creation or the last resetStats()
+    struct Stats {
+        uint64_t frames        = 0; // Number of run() calls
+        uint64_t tilesComputed = 0; // Number of tiles, the model ran on
+        uint64_t tilesSkipped  = 0; // Number of tiles, reused from previous frames
+
+        double getSkippedRatio() const { return tilesComputed + tilesSkipped ? (double) tilesSkipped / (tilesComputed + tilesSkipped) : 0.0; }
+    };
+
+    // Creates an instance of TiledInferenceCore
+    // params:
+    //  context - GPU context
+    //  cp - creation parameters
+    // returns:
+    //  unique pointer to TiledInferenceCore or nullptr, if the model can not be tiled
+    static std::unique_ptr<TiledInferenceCore> create(GpuContext* context, const CreationParameters& cp);
+
+    // Creates an instance of TiledInferenceCore for a model, that is built layer by layer, e.g. by unit tests
+    // params:
+    //  context - GPU context
+    //  cp - creation parameters. modelFileName is not used.
+    //  layers - model layers
+    // returns:
+    //  unique pointer to TiledInferenceCore or nullptr, if the model can not be tiled
+    static std::unique_ptr<TiledInferenceCore> create(GpuContext* context, const CreationParameters& cp,
+                                                      std::vector<std::shared_ptr<dp::GenericModelLayer>> layers);
+
+    // Runs the model over the whole input image tile by tile
+    // params:
+    //  input - input image. Its width and height must be a multiple of getAlignment().
+    //  output - output image. It is reallocated to getOutputSize() of the input.
+    // returns:
+    //  true if success, false if not
+    bool run(ImageTexture& input, ImageTexture& output);
+
+    // Makes the next run() compute all tiles, e.g. after a scene cut or a seek in the incremental mode
+    void invalidate() { referenceValid = false; }
+
+    const Stats& getStats() const { return stats; }
+
+    // Gets flags of the tiles, the last run() of the incremental mode computed, row by row
+    const std::vector<bool>& getComputedTiles() const { return computedTiles; }
+
+    void resetStats() { stats = Stats(); }
+
+    // Calculates output image dimensions for the given input image dimensions
+    // params:
+    //  inputWidth - input image width
+    //  inputHeight - input image height
+    // returns:
+    //  output image width and height
+    std::array<uint32_t, 2> getOutputSize(uint32_t inputWidth, uint32_t inputHeight) const;
+
+    // Gets the halo around every tile in input pixels
+    uint32_t getHalo() const { return halo; }
+
+    // Gets the alignment of the tile positions in input pixels. Downscaling models need the tiles to start at
+    // the multiple of the cumulative downscaling factor of every layer, otherwise output pixels do not line up.
+    // That includes models, that upsample back to the input resolution.
+    uint32_t getAlignment() const { return alignment; }
+
+private:
+    GpuContext* context;
+    std::unique_ptr<MixedInferenceCore> core;
+    ImageTextureArray tileInputs;
+
+    uint32_t tileWidth   = 0;
+    uint32_t tileHeight  = 0;
+    uint32_t halo        = 0;
+    uint32_t alignment   = 1;
+    float outputScale    = 1.0f;
+
+    // Incremental mode. Input windows of the tiles, halo included, are gathered into slots of a window image,
+    // row by row. Slots are aligned to the blocks of the change detection, so blocks don't cross tile windows.
+    // Every slot of the reference image holds the window, the tile was computed from last time.
+    bool incremental      = false;
+    float changeThreshold = 0.0f;
+    uint32_t slotWidth    = 0;
+    uint32_t slotHeight   = 0;
+    ImageTextureArray windowInputs;
+    ImageTextureArray referenceInputs;
+    bool referenceValid            = false;
+    const ImageTexture* lastOutput = nullptr;
+    bool differenceWarned          = false;
+    std::vector<float> blockDiffs;
+    std::vector<bool> computedTiles;
+    Stats stats;
+
+    TiledInferenceCore(GpuContext* context_);
+
+    bool init(const CreationParameters& cp, std::vector<std::shared_ptr<dp::GenericModelLayer>> layers);
+
+    // Copies the input windows of all tiles into the slots of the window image
+    // params:
+    //  input - input image
+    // returns:
+    //  true if success, false if not
+    bool gatherTileWindows(ImageTexture& input);
+
+    // Finds tiles, which input window has changed more than the threshold since they were computed
+    // params:
+    //  dirty - dirty flags of the tiles, row by row
+    // returns:
+    //  true if the changes are known, false if all tiles have to be computed
+    bool findDirtyTiles(std::vector<bool>& dirty);
+};
+
+} // namespace snn
@@ -0,0 +1,117 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "snn/defines.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace snn {
+
+// Records a timeline of CPU timers (Timer, ScopedTimer, TraceScope) and GPU timer queries
+// of the selected inference runs, and writes it as Chrome trace_event JSON,
+// that can be opened in chrome://tracing or https://ui.perfetto.dev.
+//
+// Recording is enabled at run time. When it is off, every instrumented point costs one relaxed atomic load.
+//
+// All timestamps are taken from std::chrono::steady_clock. Backends, that can calibrate their GPU timestamps
+// against it (GL_TIMESTAMP in OpenGL, VK_EXT_calibrated_timestamps in Vulkan), pass the GPU begin time of every event.
+// Otherwise a GPU event is placed at the CPU time of its submission, or right after the previous GPU event
+// of the same nesting level, whichever is later.
+class TraceRecorder {
+public:
+    // Run index, returned by beginRun() for the runs, that are not recorded
+    static constexpr uint32_t NO_RUN = UINT32_MAX;
+
+    // Starts recording. Runs are counted by MixedInferenceCore::run() and MixedInferenceCore::submit().
+    // params:
+    //  fileName - output JSON file. It is written, when all selected runs have ended or stop() is called.
+    //  numRuns - number of runs to record
+    //  skipRuns - number of runs to skip before recording, e.g. warmup runs
+    // returns:
+    //  false, if recording is already in progress
+    static bool start(const std::string& fileName, uint32_t numRuns, uint32_t skipRuns = 0);
+
+    // Stops recording and writes the events, recorded so far
+    static void stop();
+
+    static bool isRecording() { return recording.load(std::memory_order_relaxed); }
+
+    // Returns the current time of the trace clock in nanoseconds
+    static int64_t now();
+
+    // Marks the beginning of an inference run
+    // returns:
+    //  index of the run, that is passed to endRun(), NO_RUN if the run is not recorded
+    static uint32_t beginRun();
+
+    // Marks the end of an inference run. Pipelined runs end on the worker thread, after their CPU layers,
+    // so runs may overlap, and events of the worker thread are recorded until all selected runs have ended.
+    // params:
+    //  run - index, returned by beginRun()
+    static void endRun(uint32_t run);
+
+    // Records a complete CPU event on the calling thread
+    // params:
+    //  name - event name
+    //  beginNs, endNs - begin and end time, returned by now()
+    static void recordCpu(const std::string& name, int64_t beginNs, int64_t endNs);
+
+    // Called when a GPU timer query is started. Returns the nesting level of the query.
+    static uint32_t beginGpu();
+
+    // Called when a GPU timer query is stopped
+    static void endGpu();
+
+    // Records a GPU event, when its query result is available
+    // params:
+    //  name - event name
+    //  submitNs - CPU time of the query start, returned by now()
+    //  level - nesting level, returned by beginGpu()
+    //  durationNs - GPU time of the query
+    //  beginNs - GPU begin time, converted to the trace clock, -1 if the backend can't calibrate its timestamps
+    static void recordGpu(const std::string& name, int64_t submitNs, uint32_t level, uint64_t durationNs, int64_t beginNs = -1);
+
+    // Names the calling thread in the trace
+    static void setThreadName(const std::string& name);
+
+private:
+    static std::atomic<bool> recording;
+};
+
+// Records a CPU event for the current scope, if trace recording is on.
+// Unlike ScopedTimer, it does not update the Timer statistics.
+class TraceScope {
+public:
+    SNN_NO_COPY(TraceScope);
+    SNN_NO_MOVE(TraceScope);
+
+    // params:
+    //  name - event name. It must outlive the scope.
+    explicit TraceScope(const char* name): _name(name), _begin(TraceRecorder::isRecording() ? TraceRecorder::now() : -1) {}
+
+    ~TraceScope() {
+        if (_begin >= 0) {
+            TraceRecorder::recordCpu(_name, _begin, TraceRecorder::now());
+        }
+    }
+
+private:
+    const char* _name;
+    int64_t _begin;
+};
+
+} // namespace snn
@@ -132,7 +132,7 @@ enum class LogSeverity {
     VERBOSE,
 };
 
-// Utility functions for half precision floating point
+// Utility functions for half precision floating point. See snn/fp16.h for bulk conversions.
 float convertToMediumPrecision(float in);
 void convertToMediumPrecision(std::vector<float>& in);
 void convertToMediumPrecision(std::vector<double>& in);
@@ -533,6 +533,7 @@ private:
     std::string name;
     int nestedLevel = 0;
     std::chrono::high_resolution_clock::time_point begin = {};
+    int64_t traceBegin = -1; // begin time of the outermost call on the trace clock, if trace recording is on
 
     thread_local static uint64_t counter;
 
@@ -99,7 +99,7 @@ constexpr NativeColorGL NATIVE_COLOR_GL_TABLE[size_t(ColorFormat::NUM_COLOR_FORM
     }, // R16F
     {
         GL_RG8,
-        GL_RED,
+        GL_RG,
         GL_UNSIGNED_BYTE,
     }, // RG8
     {
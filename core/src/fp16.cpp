@@ -0,0 +1,166 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pch.h"
+#include "snn/fp16.h"
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    #include <immintrin.h>
+    // F16C kernels are compiled for their own target and selected at runtime
+    #define SNN_FP16_F16C   1
+    #define SNN_TARGET_F16C __attribute__((target("avx,f16c")))
+#endif
+#if defined(__aarch64__)
+    #include <arm_neon.h>
+    #define SNN_FP16_NEON 1
+#endif
+
+namespace {
+
+uint32_t floatBits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float bitsFloat(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+#ifdef SNN_FP16_F16C
+bool hasF16c() {
+    static const bool ret = __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+    return ret;
+}
+
+SNN_TARGET_F16C size_t floatToHalfF16c(const float* src, uint16_t* dst, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // All 8 source values are loaded before the store, so dst may alias src
+        _mm_storeu_si128((__m128i*) (dst + i), _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+    }
+    return i;
+}
+
+SNN_TARGET_F16C size_t halfToFloatF16c(const uint16_t* src, float* dst, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*) (src + i))));
+    }
+    return i;
+}
+
+SNN_TARGET_F16C size_t roundToHalfF16c(const float* src, float* dst, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT)));
+    }
+    return i;
+}
+#endif
+
+} // namespace
+
+uint16_t snn::fp16::floatToHalf(float value) {
+    // https://gist.github.com/rygorous/2156668, round to nearest even
+    uint32_t bits = floatBits(value);
+    uint16_t sign = (uint16_t) ((bits >> 16) & 0x8000);
+    bits &= 0x7FFFFFFF;
+    if (bits >= 0x7F800000) {
+        // Inf stays Inf, NaN becomes quiet NaN
+        return sign | 0x7C00 | (bits > 0x7F800000 ? (0x200 | ((bits >> 13) & 0x3FF)) : 0);
+    }
+    if (bits >= 0x477FF000) {
+        // Rounds to Inf
+        return sign | 0x7C00;
+    }
+    if (bits < 0x38800000) {
+        // Denormal or zero: adding 0.5 aligns the mantissa to the denormal step 2^-24, and FPU rounds to nearest even
+        return sign | (uint16_t) (floatBits(bitsFloat(bits) + 0.5f) - 0x3F000000);
+    }
+    uint32_t odd = (bits >> 13) & 1;
+    // Rebias the exponent from 127 to 15 and round
+    bits += ((uint32_t) (15 - 127) << 23) + 0xFFF + odd;
+    return sign | (uint16_t) (bits >> 13);
+}
+
+float snn::fp16::halfToFloat(uint16_t value) {
+    uint32_t sign     = (uint32_t) (value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1F;
+    uint32_t mantissa = value & 0x3FF;
+    if (exponent == 0x1F) {
+        return bitsFloat(sign | 0x7F800000 | (mantissa << 13));
+    }
+    if (exponent == 0) {
+        // Denormal or zero: mantissa * 2^-24 is exact
+        return bitsFloat(sign | floatBits((float) mantissa * (1.0f / 16777216.0f)));
+    }
+    return bitsFloat(sign | ((exponent + 127 - 15) << 23) | (mantissa << 13));
+}
+
+float snn::fp16::roundToHalf(float value) { return halfToFloat(floatToHalf(value)); }
+
+void snn::fp16::floatToHalf(const float* src, uint16_t* dst, size_t count) {
+    size_t i = 0;
+#ifdef SNN_FP16_F16C
+    if (hasF16c()) {
+        i = floatToHalfF16c(src, dst, count);
+    }
+#endif
+#ifdef SNN_FP16_NEON
+    for (; i + 4 <= count; i += 4) {
+        vst1_u16(dst + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = floatToHalf(src[i]);
+    }
+}
+
+void snn::fp16::halfToFloat(const uint16_t* src, float* dst, size_t count) {
+    size_t i = 0;
+#ifdef SNN_FP16_F16C
+    if (hasF16c()) {
+        i = halfToFloatF16c(src, dst, count);
+    }
+#endif
+#ifdef SNN_FP16_NEON
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(dst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = halfToFloat(src[i]);
+    }
+}
+
+void snn::fp16::roundToHalf(const float* src, float* dst, size_t count) {
+    size_t i = 0;
+#ifdef SNN_FP16_F16C
+    if (hasF16c()) {
+        i = roundToHalfF16c(src, dst, count);
+    }
+#endif
+#ifdef SNN_FP16_NEON
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(dst + i, vcvt_f32_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = roundToHalf(src[i]);
+    }
+}
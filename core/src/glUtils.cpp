@@ -22,6 +22,9 @@
 #include <algorithm>
 #include <atomic>
 #include <stack>
+#include <list>
+#include <mutex>
+#include <unordered_map>
 
 #ifdef __ANDROID__
     #include <dlfcn.h>
@@ -848,6 +851,16 @@ static std::string addLineCount(const std::string& in) {
 // -----------------------------------------------------------------------------
 //
 GLuint gl::loadShaderFromString(const char* source, size_t length, GLenum shaderType, const char* optionalFilename) {
+    auto shader = submitShader(source, length, shaderType);
+    if (!shader || !checkShader(shader, shaderType, optionalFilename)) {
+        return 0;
+    }
+    return shader;
+}
+
+// -----------------------------------------------------------------------------
+//
+GLuint gl::submitShader(const char* source, size_t length, GLenum shaderType) {
     if (!source) {
         return 0;
     }
@@ -859,47 +872,101 @@ GLuint gl::loadShaderFromString(const char* source, size_t length, GLenum shader
     auto shader   = glCreateShader(shaderType);
     glShaderSource(shader, 1, sources, sizes);
     glCompileShader(shader);
+    return shader;
+}
+
+// -----------------------------------------------------------------------------
+//
+bool gl::checkShader(GLuint shader, GLenum shaderType, const char* optionalFilename) {
     // check for shader compile errors
     GLint success;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
     if (!success) {
         char infoLog[4096 * 16];
         glGetShaderInfoLog(shader, 4096 * 16, NULL, infoLog);
+        GLint sourceLength = 0;
+        glGetShaderiv(shader, GL_SHADER_SOURCE_LENGTH, &sourceLength);
+        std::vector<char> source(std::max(sourceLength, 1), '\0');
+        glGetShaderSource(shader, (GLsizei) source.size(), NULL, source.data());
         glDeleteShader(shader);
         SNN_LOGE("\n================== Failed to compile %s shader '%s' ====================\n"
                  "%s\n"
                  "\n============================= GLSL shader source ===============================\n"
                  "%s\n"
                  "\n================================================================================\n",
-                 shaderType2String(shaderType), optionalFilename ? optionalFilename : "<no-name>", infoLog, addLineCount(source).c_str());
+                 shaderType2String(shaderType), optionalFilename ? optionalFilename : "<no-name>", infoLog, addLineCount(source.data()).c_str());
         // std::cout << std::endl << "================== Failed to compile "<< shaderType2String(shaderType);
         // std::cout <<" shader '" << (optionalFilename ? optionalFilename : "<no-name>") << "' ====================";
         // std::cout << std::endl << infoLog << std::endl << "============================= GLSL shader source ===============================";
         // std::cout << addLineCount(source).c_str() << std::endl;
         // std::cout << "================================================================================" << std::endl;
         SNN_LOGE("");
-        return 0;
+        return false;
     }
-    // done
-    SNN_ASSERT(shader);
-    return shader;
+    return true;
 }
 
 // -----------------------------------------------------------------------------
 //
 GLuint gl::linkProgram(const std::vector<GLuint>& shaders, const char* optionalProgramName) {
-    auto program = glCreateProgram();
+    auto program = submitProgram(shaders);
     for (auto s : shaders) {
         if (s) {
-            glAttachShader(program, s);
+            glDetachShader(program, s);
         }
     }
-    glLinkProgram(program);
+    if (!checkProgram(program, optionalProgramName)) {
+        return 0;
+    }
+    return program;
+}
+
+// -----------------------------------------------------------------------------
+//
+GLuint gl::submitProgram(const std::vector<GLuint>& shaders) {
+    auto program = glCreateProgram();
     for (auto s : shaders) {
         if (s) {
-            glDetachShader(program, s);
+            glAttachShader(program, s);
         }
     }
+    if (isProgramBinaryCacheEnabled()) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(program);
+    return program;
+}
+
+// -----------------------------------------------------------------------------
+//
+bool gl::isProgramComplete(GLuint program) {
+    if (!GLAD_GL_KHR_parallel_shader_compile && !GLAD_GL_ARB_parallel_shader_compile) {
+        return true;
+    }
+    GLint complete = GL_TRUE;
+    // GL_COMPLETION_STATUS_ARB has the same value
+    glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete == GL_TRUE;
+}
+
+// -----------------------------------------------------------------------------
+//
+bool gl::enableParallelShaderCompile() {
+    // 0xFFFFFFFF lets the driver pick the number of compiler threads
+    if (GLAD_GL_KHR_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        return true;
+    }
+    if (GLAD_GL_ARB_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        return true;
+    }
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+//
+bool gl::checkProgram(GLuint program, const char* optionalProgramName) {
     GLint success;
     glGetProgramiv(program, GL_LINK_STATUS, &success);
     if (!success) {
@@ -907,7 +974,7 @@ GLuint gl::linkProgram(const std::vector<GLuint>& shaders, const char* optionalP
         glGetProgramInfoLog(program, 512, NULL, infoLog);
         glDeleteProgram(program);
         SNN_LOGE("Failed to link program %s:\n%s", optionalProgramName ? optionalProgramName : "", infoLog);
-        return 0;
+        return false;
     }
 
     // Enable the following code to dump GL program binary to disk.
@@ -928,14 +995,175 @@ GLuint gl::linkProgram(const std::vector<GLuint>& shaders, const char* optionalP
 
     // done
     SNN_ASSERT(program);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+//
+namespace {
+struct ProgramBinary {
+    GLenum format;
+    std::vector<uint8_t> data;
+};
+
+struct ProgramBinaryCache {
+    std::mutex mutex;
+    std::atomic<size_t> limit {0}; // Maximum size in bytes. 0 disables the cache.
+    size_t size = 0;               // Size of all binaries and their keys in bytes
+    uint64_t hits   = 0;           // Programs loaded from binaries, see ProgramBinaryCacheStats
+    uint64_t misses = 0;           // Programs compiled, because there was no usable binary
+    // Most recently used binary is at the front
+    std::list<std::pair<std::string, ProgramBinary>> binaries;
+    // Key is the driver and the full shader sources, so that a hash collision can never pick a wrong program
+    std::unordered_map<std::string, std::list<std::pair<std::string, ProgramBinary>>::iterator> index;
+
+    static size_t getSize(const std::string& key, const ProgramBinary& binary) { return key.size() + binary.data.size(); }
+
+    void erase(std::list<std::pair<std::string, ProgramBinary>>::iterator iter) {
+        size -= getSize(iter->first, iter->second);
+        index.erase(iter->first);
+        binaries.erase(iter);
+    }
+
+    // Evicts least recently used binaries, until the cache fits into the limit
+    void shrink(size_t maxSize) {
+        while (size > maxSize && !binaries.empty()) {
+            erase(std::prev(binaries.end()));
+        }
+    }
+};
+
+ProgramBinaryCache& programBinaryCache() {
+    static ProgramBinaryCache cache;
+    return cache;
+}
+
+// Binary formats are specific to the driver, so binaries of one driver are never offered to another one,
+// e.g. when a process creates contexts on different GPUs.
+std::string getProgramBinaryKey(const std::string& sources) {
+    auto getString = [](GLenum name) {
+        auto s = reinterpret_cast<const char*>(glGetString(name));
+        return std::string(s ? s : "");
+    };
+    return getString(GL_VENDOR) + '\0' + getString(GL_RENDERER) + '\0' + getString(GL_VERSION) + '\0' + sources;
+}
+} // namespace
+
+void gl::setProgramBinaryCacheLimit(size_t bytes) {
+    auto& cache = programBinaryCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.limit = bytes;
+    cache.shrink(bytes);
+}
+
+bool gl::isProgramBinaryCacheEnabled() {
+    return programBinaryCache().limit > 0;
+}
+
+GLuint gl::loadCachedProgram(const std::string& sources, const char* optionalProgramName) {
+    auto& cache = programBinaryCache();
+    if (!cache.limit) {
+        return 0;
+    }
+    auto key = getProgramBinaryKey(sources);
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    auto found = cache.index.find(key);
+    if (found == cache.index.end()) {
+        cache.misses++;
+        return 0;
+    }
+    auto iter = found->second;
+    cache.binaries.splice(cache.binaries.begin(), cache.binaries, iter);
+    auto program = glCreateProgram();
+    glProgramBinary(program, iter->second.format, iter->second.data.data(), (GLsizei) iter->second.data.size());
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        // Driver binaries might be invalidated at any time, e.g. by a driver update
+        SNN_LOGD("Cached binary of program %s was rejected", optionalProgramName ? optionalProgramName : "");
+        glDeleteProgram(program);
+        cache.erase(iter);
+        cache.misses++;
+        return 0;
+    }
+    cache.hits++;
+    SNN_LOGV("Program %s is loaded from cached binary", optionalProgramName ? optionalProgramName : "");
     return program;
 }
 
+void gl::cacheProgramBinary(const std::string& sources, GLuint program) {
+    auto& cache = programBinaryCache();
+    if (!cache.limit || sources.empty()) {
+        return;
+    }
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    ProgramBinary binary;
+    binary.data.resize(length);
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &binary.format, binary.data.data());
+    if (written <= 0) {
+        return;
+    }
+    binary.data.resize(written);
+    auto key = getProgramBinaryKey(sources);
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (ProgramBinaryCache::getSize(key, binary) > cache.limit) {
+        return;
+    }
+    auto found = cache.index.find(key);
+    if (found != cache.index.end()) {
+        cache.erase(found->second);
+    }
+    cache.shrink(cache.limit - ProgramBinaryCache::getSize(key, binary));
+    cache.size += ProgramBinaryCache::getSize(key, binary);
+    cache.binaries.emplace_front(key, std::move(binary));
+    cache.index.emplace(std::move(key), cache.binaries.begin());
+}
+
+void gl::clearProgramBinaryCache() {
+    auto& cache = programBinaryCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.shrink(0);
+    cache.hits   = 0;
+    cache.misses = 0;
+}
+
+gl::ProgramBinaryCacheStats gl::getProgramBinaryCacheStats() {
+    auto& cache = programBinaryCache();
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    ProgramBinaryCacheStats stats;
+    stats.hits   = cache.hits;
+    stats.misses = cache.misses;
+    stats.size   = cache.size;
+    return stats;
+}
+
+// -----------------------------------------------------------------------------
+//
+bool gl::getTraceClockOffset(int64_t& offset) {
+    GLint64 gpuTime = 0;
+    int64_t before  = snn::TraceRecorder::now();
+    glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+    int64_t after = snn::TraceRecorder::now();
+    if (gpuTime <= 0) {
+        return false;
+    }
+    offset = before + (after - before) / 2 - gpuTime;
+    return true;
+}
+
 // -----------------------------------------------------------------------------
 //
 void gl::GpuTimeElapsedQuery::stop() {
     if (_q.running()) {
         _q.end();
+        if (_traceSubmit >= 0) {
+            snn::TraceRecorder::endGpu();
+        }
     }
 }
 
@@ -944,6 +1172,16 @@ void gl::GpuTimeElapsedQuery::getTime() {
         return;
     }
     _q.getResult(_result);
+    if (_traceSubmit >= 0) {
+        int64_t begin    = -1;
+        uint64_t gpuTime = 0;
+        int64_t offset   = 0;
+        if (_traceBegin.pending() && _traceBegin.getResult(gpuTime) && gpuTime > 0 && getTraceClockOffset(offset)) {
+            begin = (int64_t) gpuTime + offset;
+        }
+        snn::TraceRecorder::recordGpu(name, _traceSubmit, _traceLevel, _result, begin);
+        _traceSubmit = -1;
+    }
 }
 
 // -----------------------------------------------------------------------------
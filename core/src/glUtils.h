@@ -17,6 +17,7 @@
 #include "snn/image.h"
 #include "colorGL.h"
 #include "snn/deviceTimer.h"
+#include "snn/traceRecorder.h"
 #include <memory>
 #include <type_traits>
 #include <vector>
@@ -75,6 +76,55 @@ GLuint loadShaderFromString(const char* source, size_t length, GLenum shaderType
 // the program name parameter is optional and is only used to print link error.
 GLuint linkProgram(const std::vector<GLuint>& shaders, const char* optionalProgramName = nullptr);
 
+// Creates a shader and starts its compilation without waiting for the result.
+// Returns 0, if there is no source.
+GLuint submitShader(const char* source, size_t length, GLenum shaderType);
+
+// Waits for the compilation of a submitted shader. Deletes the shader and prints the error on failure.
+bool checkShader(GLuint shader, GLenum shaderType, const char* optionalFilename = nullptr);
+
+// Creates a program and starts linking it without waiting for the result.
+// The shaders may still be compiling and must be kept until the program is checked.
+GLuint submitProgram(const std::vector<GLuint>& shaders);
+
+// Waits for the link of a submitted program. Deletes the program and prints the error on failure.
+bool checkProgram(GLuint program, const char* optionalProgramName = nullptr);
+
+// Checks without blocking if the driver has finished compiling and linking a submitted program.
+// Always true without KHR_parallel_shader_compile.
+bool isProgramComplete(GLuint program);
+
+// Lets the driver compile and link submitted shaders on its own threads, if KHR_parallel_shader_compile
+// (or the ARB variant) is supported. Returns false if it is not.
+bool enableParallelShaderCompile();
+
+// Enables the process-wide program binary cache and bounds the size of the cached binaries in bytes.
+// Least recently used binaries are evicted first. 0 disables the cache and releases all binaries.
+// The cache is disabled by default, because retrieving the binary of every linked program is not free.
+void setProgramBinaryCacheLimit(size_t bytes);
+
+bool isProgramBinaryCacheEnabled();
+
+// Creates a program from the binary of a program linked earlier by the same driver from the same shader sources.
+// Returns 0, if the cache is disabled, there is no such binary or the driver does not accept it anymore.
+GLuint loadCachedProgram(const std::string& sources, const char* optionalProgramName = nullptr);
+
+// Stores the binary of a linked program, so that the next program with the same sources skips compilation.
+// Does nothing, if the cache is disabled.
+void cacheProgramBinary(const std::string& sources, GLuint program);
+
+// Releases all cached program binaries and resets the statistics.
+void clearProgramBinaryCache();
+
+// Statistics of the program binary cache since it was last cleared
+struct ProgramBinaryCacheStats {
+    uint64_t hits   = 0; // Programs created from cached binaries
+    uint64_t misses = 0; // Programs without a usable cached binary, that are compiled from the sources
+    size_t size     = 0; // Size of the cached binaries and their keys in bytes
+};
+
+ProgramBinaryCacheStats getProgramBinaryCacheStats();
+
 // a utility function to upload uniform values
 template<typename T>
 void updateUniformValue(GLint location, const T& value) {
@@ -694,6 +744,8 @@ struct FullScreenQuad {
 
 class SimpleGlslProgram {
     GLuint _program = 0;
+    std::vector<std::pair<AutoShader, GLenum>> _shaders; // Submitted shaders, that are not checked yet
+    std::string _sources;                                 // Program binary cache key of the submitted shaders
 
 public:
     // optional program name (for debug log)
@@ -714,7 +766,12 @@ public:
 
     ~SimpleGlslProgram() { cleanup(); }
 
-    bool loadVsPs(const char* vscode, const char* pscode) {
+    bool loadVsPs(const char* vscode, const char* pscode) { return submitVsPs(vscode, pscode) && finish(); }
+
+    bool loadCs(const char* code) { return submitCs(code) && finish(); }
+
+    // Starts compiling and linking a vertex and a fragment shader. The program is usable after finish().
+    bool submitVsPs(const char* vscode, const char* pscode) {
 #ifdef _DEBUG
         if (vscode) {
             vsSource = vscode;
@@ -724,34 +781,86 @@ public:
         }
 #endif
         cleanup();
-        AutoShader vs = loadShaderFromString(vscode, 0, GL_VERTEX_SHADER, name.c_str());
-        AutoShader ps = loadShaderFromString(pscode, 0, GL_FRAGMENT_SHADER, name.c_str());
-        if ((vscode && !vs) || (pscode && !ps)) {
-            return false;
+        if (isProgramBinaryCacheEnabled()) {
+            _sources = std::string(vscode ? vscode : "") + '\0' + (pscode ? pscode : "");
+            _program = loadCachedProgram(_sources, name.c_str());
+            if (_program) {
+                _sources.clear();
+                return true;
+            }
         }
-        _program = linkProgram({vs, ps}, name.c_str());
-        return _program != 0;
+        _shaders.emplace_back(submitShader(vscode, 0, GL_VERTEX_SHADER), GL_VERTEX_SHADER);
+        _shaders.emplace_back(submitShader(pscode, 0, GL_FRAGMENT_SHADER), GL_FRAGMENT_SHADER);
+        _program = submitProgram({_shaders[0].first, _shaders[1].first});
+        return true;
     }
 
-    bool loadCs(const char* code) {
+    // Starts compiling and linking a compute shader. The program is usable after finish().
+    bool submitCs(const char* code) {
 #ifdef _DEBUG
         if (code) {
             csSource = code;
         }
 #endif
         cleanup();
-        AutoShader cs = loadShaderFromString(code, 0, GL_COMPUTE_SHADER, name.c_str());
-        if (!cs) {
+        if (!code) {
+            return false;
+        }
+        if (isProgramBinaryCacheEnabled()) {
+            _sources = code;
+            _program = loadCachedProgram(_sources, name.c_str());
+            if (_program) {
+                _sources.clear();
+                return true;
+            }
+        }
+        _shaders.emplace_back(submitShader(code, 0, GL_COMPUTE_SHADER), GL_COMPUTE_SHADER);
+        _program = submitProgram({_shaders[0].first});
+        return true;
+    }
+
+    // Checks without blocking if a submitted program can be finished without waiting for the driver
+    bool isComplete() const { return _shaders.empty() || isProgramComplete(_program); }
+
+    // Waits for the submitted shaders to compile and link. Prints the errors and releases the program on failure.
+    bool finish() {
+        if (_shaders.empty()) {
+            return _program != 0;
+        }
+        bool compiled = true;
+        for (auto& [shader, type] : _shaders) {
+            if (shader && !checkShader(shader, type, name.c_str())) {
+                shader.shader = 0; // deleted by checkShader
+                compiled      = false;
+            }
+        }
+        if (!compiled) {
+            cleanup();
             return false;
         }
-        _program = linkProgram({cs}, name.c_str());
-        return _program != 0;
+        bool linked = checkProgram(_program, name.c_str());
+        if (!linked) {
+            _program = 0; // deleted by checkProgram
+        } else {
+            for (auto& [shader, type] : _shaders) {
+                (void) type;
+                if (shader) {
+                    glDetachShader(_program, shader);
+                }
+            }
+            cacheProgramBinary(_sources, _program);
+        }
+        _shaders.clear();
+        _sources.clear();
+        return linked;
     }
 
     void use() const { GLCHKDBG(glUseProgram(_program)); }
 
     void cleanup() {
         //_uniforms.clear();
+        _shaders.clear();
+        _sources.clear();
         if (_program) {
             glDeleteProgram(_program), _program = 0;
         }
@@ -770,6 +879,18 @@ public:
         return binding;
     }
 
+    // Gets the binding point of a shader storage block; -1 if the program has no such block.
+    GLint getStorageBlockBinding(const char* name_) const {
+        GLCHKDBG(auto index = glGetProgramResourceIndex(_program, GL_SHADER_STORAGE_BLOCK, name_));
+        if (GL_INVALID_INDEX == index) {
+            return -1;
+        }
+        const GLenum property = GL_BUFFER_BINDING;
+        GLint binding         = -1;
+        GLCHKDBG(glGetProgramResourceiv(_program, GL_SHADER_STORAGE_BLOCK, index, 1, &property, 1, nullptr, &binding));
+        return binding;
+    }
+
     operator GLuint() const { return _program; }
 };
 
@@ -855,6 +976,11 @@ private:
     GLint _location = -1;
 };
 
+// Gets the offset from the GPU timestamp clock (GL_TIMESTAMP) to the trace clock (snn::TraceRecorder::now())
+// returns:
+//  false, if GL_TIMESTAMP is not supported
+bool getTraceClockOffset(int64_t& offset);
+
 // -----------------------------------------------------------------------------
 // For asynchronous timer (not time stamp) queries
 struct GpuTimeElapsedQuery : virtual DeviceTimer {
@@ -868,6 +994,16 @@ struct GpuTimeElapsedQuery : virtual DeviceTimer {
     GLuint64 duration() const  override { return _result; }
 
     void start() override {
+        if (snn::TraceRecorder::isRecording()) {
+            _traceSubmit = snn::TraceRecorder::now();
+            _traceLevel  = snn::TraceRecorder::beginGpu();
+            // Time elapsed queries can't return the begin time, so it is marked with a timestamp query.
+            // A result of a previous run, that was never read, is discarded.
+            if (!_traceBegin.idle()) {
+                _traceBegin.allocate();
+            }
+            _traceBegin.mark();
+        }
         // SNN_LOGI("%s before start status: %d", name.c_str(), _q.status);
         _q.begin();
         // SNN_LOGI("%s after start status: %d", name.c_str(), _q.status);
@@ -887,7 +1023,10 @@ struct GpuTimeElapsedQuery : virtual DeviceTimer {
 
 private:
     QueryObject<GL_TIME_ELAPSED> _q;
+    QueryObject<GL_TIMESTAMP> _traceBegin; // GPU time of start(), if trace recording is on
     uint64_t _result = 0;
+    int64_t _traceSubmit = -1; // CPU time of start(), if trace recording is on
+    uint32_t _traceLevel = 0;
 };
 
 // -----------------------------------------------------------------------------
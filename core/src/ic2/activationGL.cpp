@@ -180,6 +180,12 @@ InferencePassesSptr ActivationLayerGl::createCS(const LayerGenOptions& options)
                        "#define OUTPUT_FORMAT rgba32f\n";
     }
 
+    // The input can be stored in another precision, when the layer converts between FP16 and FP32 layers
+    if (inputDims[0].format == ColorFormat::RGBA16F) {
+        shaderHeader += "#define INPUT_FORMAT rgba16f\n";
+    } else {
+        shaderHeader += "#define INPUT_FORMAT rgba32f\n";
+    }
     if (_desc.numInputPlanes <= 4) {
         shaderHeader += "#define INPUT_TEXTURE_2D\n";
     }
@@ -212,9 +218,9 @@ InferencePassesSptr ActivationLayerGl::createCS(const LayerGenOptions& options)
                             "layout(OUTPUT_FORMAT, binding=3) writeonly uniform PRECISION image2DArray uOutput;\n"
                             "#endif\n"
                             "#ifdef INPUT_TEXTURE_2D\n"
-                            "layout(OUTPUT_FORMAT, binding=0) readonly uniform PRECISION image2D uInput;\n"
+                            "layout(INPUT_FORMAT, binding=0) readonly uniform PRECISION image2D uInput;\n"
                             "#else\n"
-                            "layout(OUTPUT_FORMAT, binding=0) readonly uniform PRECISION image2DArray uInput;\n"
+                            "layout(INPUT_FORMAT, binding=0) readonly uniform PRECISION image2DArray uInput;\n"
                             "#endif\n";
 
     std::string shaderMain = loadShader(ACTIVATION_CS_ASSET_NAME);
@@ -0,0 +1,51 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pch.h"
+#include "adaptiveavgpool2d.h"
+#include <algorithm>
+
+using namespace snn;
+using namespace snn::dp;
+
+// Largest pooling region of the input size for the output size
+static uint32_t getMaxRegionSize(uint32_t inputSize, uint32_t outputSize) {
+    return DIV_AND_ROUND_UP(inputSize, outputSize) + (inputSize % outputSize ? 1 : 0);
+}
+
+// Smallest power of 2, not smaller than the value, up to 8
+static uint32_t getThreadCount(uint32_t value) {
+    uint32_t count = 1;
+    while (count < value && count < 8) {
+        count *= 2;
+    }
+    return count;
+}
+
+InferenceGraph::Transform AdaptiveAvgPool2dLayer::getOutputScaleDimAdjustment() const {
+    InferenceGraph::Transform ret;
+    ret.isFixed     = 1;
+    ret.fixedWidth  = (uint32_t) _desc.targetSize;
+    ret.fixedHeight = (uint32_t) _desc.targetSize;
+    // Fixed depth and batch share the storage with the translation, that is added to the fixed size
+    ret.fixedDepth  = 0;
+    ret.fixedBatch  = 0;
+    return ret;
+}
+
+void AdaptiveAvgPool2dLayer::getWorkGroupSize(uint32_t& x, uint32_t& y) const {
+    SNN_ASSERT(!inputDims.empty() && _desc.targetSize > 0);
+    x = getThreadCount(getMaxRegionSize(inputDims[0].width, _desc.targetSize));
+    y = getThreadCount(getMaxRegionSize(inputDims[0].height, _desc.targetSize));
+}
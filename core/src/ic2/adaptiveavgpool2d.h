@@ -17,8 +17,10 @@
 #include "genericlayer.h"
 #include "snn/snn.h"
 #include "snn/utils.h"
+#include "snn/inferencegraph.h"
 #include "modelparser.h"
 #include <string>
+#include <utility>
 
 namespace snn {
 namespace dp { // short for Dynamic Pipeline
@@ -32,5 +34,36 @@ struct AdaptiveAvgPool2dDesc : GenericConvDesc {
     }
 };
 
+// This is a base class to generate a shader for adaptive average pooling (https://arxiv.org/pdf/1803.01534v4.pdf).
+// Output pixel (x, y) is the average of the input region [floor(x * inW / outW), ceil((x + 1) * inW / outW)) horizontally,
+// and the same vertically, as in PyTorch. The region is summed by a work group, so shaders don't depend on the input size.
+class AdaptiveAvgPool2dLayer : public GenericConvolutionLayer {
+public:
+    AdaptiveAvgPool2dLayer(AdaptiveAvgPool2dDesc&& d): GenericConvolutionLayer(d), _desc(std::move(d)) {}
+
+    virtual ~AdaptiveAvgPool2dLayer() = default;
+
+    // Output is targetSize x targetSize, whatever the input size is
+    InferenceGraph::Transform getOutputScaleDimAdjustment() const override;
+
+    // Pooling regions depend on the whole input size
+    bool getSpatialFootprint(uint32_t&, float&) const override { return false; }
+
+    // Every input value is added once
+    void getArithmeticCost(uint64_t& macs, uint64_t& numWeights) const override {
+        macs       = inputDims.empty() ? 0 : (uint64_t) inputDims[0].width * inputDims[0].height * _desc.numInputPlanes;
+        numWeights = 0;
+    }
+
+protected:
+    AdaptiveAvgPool2dDesc _desc;
+
+    // Gets the work group size of the compute shaders: the smallest power of 2, that covers the largest pooling region,
+    // up to 8 threads in every direction. Threads of a work group sum the region with a stride and reduce the partial sums.
+    // params:
+    //  x, y - work group size
+    void getWorkGroupSize(uint32_t& x, uint32_t& y) const;
+};
+
 } // namespace dp
 } // namespace snn
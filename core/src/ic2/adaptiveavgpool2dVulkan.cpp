@@ -0,0 +1,94 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pch.h"
+#include "adaptiveavgpool2d.h"
+#include "layerFactory.h"
+#include "inferencepassVulkan.h"
+#include "uvkc/vulkan/pipeline.h"
+#include <string>
+#include <cstring>
+#include <vector>
+#include <utility>
+
+DECLARE_LAYER_VULKAN_CLASS(AdaptiveAvgPool2d);
+
+using namespace snn;
+using namespace snn::dp;
+
+static constexpr const char* ADAPTIVEAVGPOOL2D_VK_ASSET_NAME      = "shaders/shadertemplate_vk_adaptiveavgpool2d.spv";
+static constexpr const char* ADAPTIVEAVGPOOL2D_VK_FP16_ASSET_NAME = "shaders/shadertemplate_vk_adaptiveavgpool2d_fp16.spv";
+
+InferencePassesSptr AdaptiveAvgPool2dLayerVulkan::createCS(const LayerGenOptions& options) const {
+    (void) options;
+
+    InferencePassesSptr ret(new InferencePassesVulkan());
+
+    std::vector<InferencePassVulkan>& passes = InferencePassesVulkan::cast(ret.get())->passes;
+    passes.resize(1);
+
+    InferencePassVulkan& pass = passes[0];
+
+    uint32_t inputWidth  = inputDims[0].width;
+    uint32_t inputHeight = inputDims[0].height;
+    uint32_t inputDepth  = inputDims[0].depth;
+    uint32_t outputSize  = (uint32_t) _desc.targetSize;
+
+    int unit      = 4;
+    uint32_t oc_4 = UP_DIV(_desc.numOutputPlanes, unit);
+
+    // The work group sums one pooling region
+    uint32_t workX = 1, workY = 1;
+    getWorkGroupSize(workX, workY);
+
+    std::vector<uvkc::vulkan::Pipeline::SpecConstant> specConstants = {
+        {0, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = workX}},
+        {1, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = workY}},
+        {2, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = 1}},
+    };
+    pass.specConstants = specConstants;
+
+    std::vector<uint32_t> uniform(8);
+    uniform[0] = inputWidth;
+    uniform[1] = inputHeight;
+    uniform[2] = UP_DIV(inputDepth, unit);
+    uniform[3] = 1;
+    uniform[4] = outputSize;
+    uniform[5] = outputSize;
+    uniform[6] = oc_4;
+    uniform[7] = 1;
+
+    std::pair<std::string, std::vector<uint32_t>> uniformBuffer("2", uniform);
+    pass.uniformBuffers.insert(uniformBuffer);
+
+    pass.inputs  = {{"uInput", 0}};
+
+    std::vector<uchar> bytes;
+    if (_desc.preferHp) {
+        bytes = snn::loadEmbeddedAsset(ADAPTIVEAVGPOOL2D_VK_FP16_ASSET_NAME);
+    } else {
+        bytes = snn::loadEmbeddedAsset(ADAPTIVEAVGPOOL2D_VK_ASSET_NAME);
+    }
+
+    pass.vkCodes.resize((bytes.size() + 3)/4);
+    memcpy(pass.vkCodes.data(), bytes.data(), bytes.size());
+
+    pass.program = InferencePassVulkan::VkProgram {"uOutput",
+                                                    // One work group per output pixel and plane
+                                                    {outputSize, outputSize, oc_4}};
+
+    SNN_LOGV("input:%d:%d:%d, output:%d:%d:%d, work group:%d:%d", inputWidth, inputHeight, inputDepth, outputSize, outputSize, oc_4, workX, workY);
+
+    return ret;
+}
@@ -41,6 +41,8 @@ public:
     virtual ~AddLayer() = default;
     InferenceGraph::Transform getOutputScaleDimAdjustment() const override { return {0, {{1.0f, 1.0f, 0.0f, 0.0f}}}; };
 
+    const AddDesc& getAddDesc() const { return _desc; }
+
 protected:
     AddDesc _desc;
 };
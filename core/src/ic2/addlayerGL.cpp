@@ -13,15 +13,13 @@
  * limitations under the License.
  */
 #include "pch.h"
-#include "addlayer.h"
+#include "addlayerGL.h"
 #include "layerFactory.h"
 #include "inferencepassGL.h"
 #include <string>
 #include <vector>
 #include <unordered_map>
 
-DECLARE_LAYER_GL_CLASS(Add);
-
 using namespace snn;
 using namespace snn::dp;
 
@@ -200,18 +198,9 @@ InferencePassesSptr AddLayerGl::createCS(const LayerGenOptions& options) const {
         shaderHeader += "#define SILU\n";
     }
 
-    std::string shaderUniforms = "#ifdef OUTPUT_TEXTURE_2D\n"
-                            "layout(OUTPUT_FORMAT, binding=3) writeonly uniform PRECISION image2D uOutput;\n"
-                            "#else\n"
-                            "layout(OUTPUT_FORMAT, binding=3) writeonly uniform PRECISION image2DArray uOutput;\n"
-                            "#endif\n"
-                            "#ifdef INPUT_TEXTURE_2D\n"
-                            "layout(OUTPUT_FORMAT, binding=0) readonly uniform PRECISION image2D uInput0;\n"
-                            "layout(OUTPUT_FORMAT, binding=1) readonly uniform PRECISION image2D uInput1;\n"
-                            "#else\n"
-                            "layout(OUTPUT_FORMAT, binding=0) readonly uniform PRECISION image2DArray uInput0;\n"
-                            "layout(OUTPUT_FORMAT, binding=1) readonly uniform PRECISION image2DArray uInput1;\n"
-                            "#endif\n";
+    std::string shaderUniforms = buildComputeOutputDeclaration("uOutput", 3, _desc.numOutputPlanes <= 4) +
+                                 buildComputeInputDeclaration("uInput0", 0, 0, _desc.numInputPlanes <= 4) +
+                                 buildComputeInputDeclaration("uInput1", 1, 1, _desc.numInputPlanes <= 4);
 
     std::string shaderMain = loadShader(ADD_CS_ASSET_NAME);
 
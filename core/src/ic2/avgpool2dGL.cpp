@@ -37,8 +37,7 @@ void AveragePooling2DLayerGl::buildPreDefine(std::ostringstream& stream, const G
     stream << "// " << shaderFilePath << "\n";
     stream << "#define NUM_INPUT_PLANES " << _desc.numInputPlanes << "\n";
     stream << "#define NUM_OUTPUT_PLANES " << _desc.numOutputPlanes << "\n";
-    stream << "#define INPUT_WIDTH " << options.desiredInput[0].width << "\n";
-    stream << "#define INPUT_HEIGHT " << options.desiredInput[0].height << "\n";
+    buildInputSizeDefines(stream, options);
     stream << "#define NUM_STRIDE " << _desc.stride << "\n";
     stream << "#define N_DIMS " << _desc.stride * _desc.stride << "\n";
     stream << "#define CLAMPED_PADDING\n";
@@ -334,16 +333,7 @@ InferencePassesSptr AveragePooling2DLayerGl::createCS(const LayerGenOptions& /*o
         shaderHeader += "#define OUTPUT_TEXTURE_2D\n";
     }
 
-    std::string shaderUniforms = "#ifdef INPUT_TEXTURE_2D\n"
-                            "layout(OUTPUT_FORMAT, binding=0) readonly uniform PRECISION image2D uInput;\n"
-                            "#else\n"
-                            "layout(OUTPUT_FORMAT, binding=0) readonly uniform PRECISION image2DArray uInput;\n"
-                            "#endif\n"
-                            "#ifdef OUTPUT_TEXTURE_2D\n"
-                            "layout(OUTPUT_FORMAT, binding=3) writeonly uniform PRECISION image2D uOutput;\n"
-                            "#else\n"
-                            "layout(OUTPUT_FORMAT, binding=3) writeonly uniform PRECISION image2DArray uOutput;\n"
-                            "#endif\n";
+    std::string shaderUniforms = buildComputeInputDeclaration("uInput", 0, 0, _desc.numInputPlanes <= 4) + buildComputeOutputDeclaration("uOutput", 3, _desc.numOutputPlanes <= 4);
 
     std::string shaderMain = loadShader(AVGPOOL2D_CS_ASSET_NAME);
 
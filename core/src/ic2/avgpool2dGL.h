@@ -26,6 +26,8 @@ public:
     AveragePooling2DLayerGl(AveragePooling2DDesc&& d): AveragePooling2DLayer(std::move(d)) {}
     virtual ~AveragePooling2DLayerGl() = default;
 
+    bool supportsBufferActivations() const override { return true; }
+
 protected:
     InferencePassesSptr createFS(const LayerGenOptions&) const override;
     InferencePassesSptr createCS(const LayerGenOptions&) const override;
@@ -19,9 +19,14 @@
 #include "snn/imageTexture.h"
 #include "snn/deviceTimer.h"
 #include "snn/core.h"
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace snn {
+
+class RenderPass;
+
 namespace dp { // short for Dynamic Pipeline
 
 class GenericModelLayer;
@@ -38,24 +43,41 @@ public:
     SNN_NO_COPY(DeviceBackend);
     SNN_NO_MOVE(DeviceBackend);
 
-    // Initializes render passes for a model layer
+    // Creates compiled render passes of a model layer (GenericModelLayer::getCompiledPasses()), once per compiled model.
+    // Backends, that don't share compiled passes between execution contexts, create everything in initRenderPasses().
+    // params:
+    //  modelLayer - model layer
+    // returns:
+    //  false if a pass of the layer failed to compile
+    virtual bool compileRenderPasses(GenericModelLayer* modelLayer) {
+        (void) modelLayer;
+        return true;
+    }
+
+    // Completes the compilation of all passes, created by compileRenderPasses().
+    // Called once after all layers have been compiled, so that backends can compile the passes in parallel.
+    // returns:
+    //  false if a pass failed to compile
+    virtual bool finishRenderPasses() { return true; }
+
+    // Initializes render passes of a model layer for the execution context of this backend
     // params:
     //  modelLayer - model layer
     //  texInputs - input images
     //  texOutputs - output images
-    virtual void initRenderPasses(GenericModelLayer* modelLayer, ImageTextureArrayAccessor texInputs, ImageTextureArrayAccessor texOutputs) {
+    //  renderPasses - created render passes
+    virtual void initRenderPasses(GenericModelLayer* modelLayer, ImageTextureArrayAccessor texInputs, ImageTextureArrayAccessor texOutputs,
+                                  std::vector<std::shared_ptr<RenderPass>>& renderPasses) {
         (void) modelLayer;
         (void) texInputs;
         (void) texOutputs;
+        (void) renderPasses;
     }
 
     // Actions, performed before inference run
-    virtual void prepareRun(MixedInferenceCore::RunParameters& rp,
-            RenderStagesArray &stages, bool bindOutput, uint32_t bindIndex) {
+    virtual void prepareRun(MixedInferenceCore::RunParameters& rp, RenderStagesArray &stages) {
         (void) rp;
         (void) stages;
-        (void) bindOutput;
-        (void) bindIndex;
     }
 
     // Actions, performed before each layer run
@@ -79,6 +101,11 @@ public:
     // Actions, performed after all other actions of the inference run
     virtual void cleanupRun() {}
 
+    // Adds counters of the commands, recorded since the last call, to the metrics
+    virtual void addMetrics(RuntimeMetrics& metrics) {
+        (void) metrics;
+    }
+
     virtual DeviceTimer* createDeviceTimer(const std::string& name) {
         (void) name;
         return NULL;
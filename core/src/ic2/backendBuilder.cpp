@@ -25,15 +25,16 @@
 namespace snn {
 namespace dp { // short for Dynamic Pipeline
 
-DeviceBackend* BackendBuilder::build(GpuContext* context, const InferenceGraph& ig) {
+DeviceBackend* BackendBuilder::build(GpuContext* context, const InferenceGraph& ig, std::shared_ptr<WeightCache> weightCache) {
     (void) ig;
+    (void) weightCache;
     SNN_ASSERT(context);
     DeviceBackend* backendPtr = nullptr;
     switch (context->backendType) {
 #ifdef SUPPORT_GL
     case GpuBackendType::GL:
         {
-            OpenGLBackend::CreationParameters glCP {ig.mrtMode, ig.weightMode};
+            OpenGLBackend::CreationParameters glCP {ig.mrtMode, ig.weightMode, weightCache};
             backendPtr = new OpenGLBackend(glCP);
         }
         break;
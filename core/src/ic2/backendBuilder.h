@@ -16,14 +16,23 @@
 
 #include "snn/snn.h"
 #include "snn/inferencegraph.h"
+#include <memory>
 
 namespace snn {
+
+class WeightCache;
+
 namespace dp { // short for Dynamic Pipeline
 
 // This is a factory class to build specific backend classes
 class BackendBuilder {
 public:
-    static DeviceBackend* build(GpuContext* context, const InferenceGraph& ig);
+    // Builds the backend of the context
+    // params:
+    //  context - GPU context
+    //  ig - inference graph
+    //  weightCache - compiled passes, whose weights are reused by the compiled passes of this backend. Optional.
+    static DeviceBackend* build(GpuContext* context, const InferenceGraph& ig, std::shared_ptr<WeightCache> weightCache = nullptr);
 };
 
 }; // namespace dp
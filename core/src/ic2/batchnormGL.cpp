@@ -47,8 +47,7 @@ void BatchNormalizationLayerGl::buildPreDefine(std::ostringstream& stream, const
     stream << "// " << shaderFilePath << std::endl;
     stream << "#define NUM_INPUT_PLANES " << _desc.numInputPlanes << std::endl;
     stream << "#define NUM_OUTPUT_PLANES " << _desc.numOutputPlanes << std::endl;
-    stream << "#define INPUT_WIDTH " << options.desiredInput[0].width << std::endl;
-    stream << "#define INPUT_HEIGHT " << options.desiredInput[0].height << std::endl;
+    buildInputSizeDefines(stream, options);
     // Currently we have no way of getting which value
     // is being used to pad. So we default to 0.0
 
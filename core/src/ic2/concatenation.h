@@ -18,6 +18,7 @@
 #include "snn/snn.h"
 #include "modelparser.h"
 #include <utility>
+#include <vector>
 
 namespace snn {
 namespace dp { // short for Dynamic Pipeline
@@ -29,6 +30,24 @@ public:
     ConcatenateLayer(ConcatenateDesc&& d): ShaderLayer(d), _desc(std::move(d)) {}
     virtual ~ConcatenateLayer() = default;
 
+    // Calculates the positions of the inputs inside of the output texture array
+    // params:
+    //  planeOffsets - index of the first output texture layer for each input
+    // returns:
+    //  true if every input starts at a 4-channel boundary, false if not
+    bool getInputPlaneOffsets(std::vector<uint32_t>& planeOffsets) const {
+        planeOffsets.clear();
+        uint32_t channelOffset = 0;
+        for (const auto& dim : inputDims) {
+            if (channelOffset % 4 != 0) {
+                return false;
+            }
+            planeOffsets.push_back(channelOffset / 4);
+            channelOffset += dim.channels;
+        }
+        return true;
+    }
+
 protected:
     void getOutputDims(uint32_t& width, uint32_t& height, uint32_t& depthOut) const override {
         width    = inputDims[0].width;
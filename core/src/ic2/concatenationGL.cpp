@@ -127,19 +127,9 @@ InferencePassesSptr ConcatenateLayerGl::createCS(const LayerGenOptions& options)
 
     SNN_LOGD("numInputPlanes: %d; numOutputPlanes: %d", _desc.numInputPlanes, _desc.numOutputPlanes);
 
-    std::string shaderUniforms = "layout(OUTPUT_FORMAT, binding=3) writeonly uniform PRECISION image2DArray uOutput;\n"
-
-                            "#ifdef INPUT0_TEXTURE_2D\n"
-                            "layout(OUTPUT_FORMAT, binding=0) readonly uniform PRECISION image2D uInput0;\n"
-                            "#else\n"
-                            "layout(OUTPUT_FORMAT, binding=0) readonly uniform PRECISION image2DArray uInput0;\n"
-                            "#endif\n"
-
-                            "#ifdef INPUT1_TEXTURE_2D\n"
-                            "layout(OUTPUT_FORMAT, binding=1) readonly uniform PRECISION image2D uInput1;\n"
-                            "#else\n"
-                            "layout(OUTPUT_FORMAT, binding=1) readonly uniform PRECISION image2DArray uInput1;\n"
-                            "#endif\n";
+    std::string shaderUniforms = buildComputeOutputDeclaration("uOutput", 3, false) +
+                                 buildComputeInputDeclaration("uInput0", 0, 0, input0Depth <= 1) +
+                                 buildComputeInputDeclaration("uInput1", 1, 1, input1Depth <= 1);
 
     std::string shaderMain = loadShader(CONCATENATION_CS_ASSET_NAME);
 
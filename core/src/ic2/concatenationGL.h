@@ -27,6 +27,9 @@ public:
     ConcatenateLayerGl(ConcatenateDesc&& d): ConcatenateLayer(std::move(d)) {}
     virtual ~ConcatenateLayerGl() = default;
 
+    // The compute shader concatenates two inputs
+    bool supportsBufferActivations() const override { return prevLayers.size() == 2; }
+
 protected:
     bool generateConcatGLSamplingCode(int& idxStartPlane, int nOutputChannels, std::string& uniformsDeclaration, std::set<int>& inputTextures,
                                       std::string& calculation) const;
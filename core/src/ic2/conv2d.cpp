@@ -15,6 +15,7 @@
 #include "pch.h"
 #include "conv2d.h"
 #include "layerFactory.h"
+#include "snn/fp16.h"
 
 using namespace snn;
 using namespace snn::dp;
@@ -99,10 +100,19 @@ bool Conv2DLayer::oihw2hwo4i4(const std::vector<cv::Mat>& inputWeights, std::vec
     return 0;
 }
 
+bool Conv2DLayer::oihw2hwo4i4fp16(const std::vector<cv::Mat>& inputWeights, std::vector<float>& outVec, int inChannels, int outChannels, int fw, int fh, int unit) {
+    // Packed floats are converted in place
+    oihw2hwo4i4(inputWeights, outVec, inChannels, outChannels, fw, fh, unit);
+    size_t count = outVec.size();
+    snn::fp16::floatToHalf(outVec.data(), (uint16_t*) outVec.data(), count);
+    outVec.resize((count + 1) / 2);
+    return 0;
+}
+
 InferenceGraph::Transform Conv2DLayer::getOutputScaleDimAdjustment() const {
     uint32_t offset[4];
     getPaddingOffset(offset);
-    float scale       = 1 / static_cast<float>(_desc.stride);
+    float scale       = _inputUpsampling / static_cast<float>(_desc.stride);
     float translation = 0.0f;
     if (_desc.kernelSize % 2 != 0) {
         translation = 1 + (static_cast<float>(offset[0] + offset[1]) - static_cast<float>(_desc.kernelSize)) / static_cast<float>(_desc.stride);
@@ -112,4 +122,11 @@ InferenceGraph::Transform Conv2DLayer::getOutputScaleDimAdjustment() const {
     return {0, {{scale, scale, translation, translation}} };
 }
 
+bool Conv2DLayer::getSpatialFootprint(uint32_t& kernelRadius, float& scale) const {
+    // The kernel radius is in upsampled pixels, bilinear upsampling reads one more input pixel
+    kernelRadius = DIV_AND_ROUND_UP(_desc.kernelSize / 2, _inputUpsampling) + (_inputUpsamplingBilinear ? 1 : 0);
+    scale        = _inputUpsampling / static_cast<float>(_desc.stride);
+    return true;
+}
+
 
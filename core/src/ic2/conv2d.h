@@ -48,12 +48,45 @@ public:
 
     virtual void getOutputDims(uint32_t& width, uint32_t& height, uint32_t& depth) const override;
 
+    virtual bool getSpatialFootprint(uint32_t& kernelRadius, float& scale) const override;
+
+    virtual void getArithmeticCost(uint64_t& macs, uint64_t& numWeights) const override {
+        uint32_t width = 0, height = 0, depth = 0;
+        getOutputDims(width, height, depth);
+        uint64_t kernelWeights = (uint64_t) _desc.kernelSize * _desc.kernelSize * _desc.numInputPlanes * _desc.numOutputPlanes;
+        macs       = (uint64_t) width * height * kernelWeights;
+        numWeights = kernelWeights + _desc.numOutputPlanes * (_desc.useBatchNormalization ? 5 : 1);
+    }
+
+    const Conv2DDesc& getConv2DDesc() const { return _desc; }
+
+    // Gets padding: top, bottom, left, right
+    void getPaddingOffset(uint32_t (&offsets)[4]) const;
+
+    // Makes the convolution read its input through an upsampling index transform, as if the input
+    // was upsampled by the removed UpSampling2D layer in front of it. All sizes and paddings of the
+    // convolution then refer to the upsampled input, while the input texture keeps the original size.
+    // params:
+    //  scale - integer upsampling factor, 1 to read the input as is
+    //  bilinear - interpolate bilinearly (half pixel centers, clamped to the edges) instead of taking the nearest pixel
+    void setInputUpsampling(uint32_t scale, bool bilinear) {
+        _inputUpsampling         = scale;
+        _inputUpsamplingBilinear = bilinear;
+    }
+
+    uint32_t getInputUpsampling() const { return _inputUpsampling; }
+
 protected:
     Conv2DDesc _desc;
+    uint32_t _inputUpsampling     = 1;
+    bool _inputUpsamplingBilinear = false;
 
-    void getPaddingOffset(uint32_t (&offsets)[4]) const;
     static bool oihw2hwo4i4(const std::vector<cv::Mat>& inputWeights, std::vector<float>& outVec, int inChannels,
         int outChannels, int fw, int fh, int unit = 4);
+
+    // Same as oihw2hwo4i4(), but packs half floats, 2 per element of outVec
+    static bool oihw2hwo4i4fp16(const std::vector<cv::Mat>& inputWeights, std::vector<float>& outVec, int inChannels,
+        int outChannels, int fw, int fh, int unit = 4);
 };
 
 }; // namespace dp
@@ -16,6 +16,7 @@
 #include "conv2dGL.h"
 #include "layerFactory.h"
 #include "inferencepassGL.h"
+#include "snn/fp16.h"
 #include <string>
 #include <vector>
 #include <cstring>
@@ -46,6 +47,38 @@ static uint32_t getChannelsPerPass(snn::MRTMode mrtMode) {
     }
 }
 
+// Wraps the LOAD_<name> macro of a compute shader input into the upsampling index transform.
+// Positions are in the upsampled input, positions outside of it read zeros, as the loads of the input itself.
+// params:
+//  name - input name
+//  sizeUniform - name of the uniform with the size of the upsampled input
+//  scale - integer upsampling factor
+//  bilinear - interpolate bilinearly instead of taking the nearest pixel
+static std::string buildComputeInputUpsampling(const std::string& name, const std::string& sizeUniform, uint32_t scale, bool bilinear) {
+    std::ostringstream stream;
+    stream << "vec4 upsample_" << name << "(ivec3 p, ivec2 size) {\n"
+           << "    if (any(lessThan(p.xy, ivec2(0))) || any(greaterThanEqual(p.xy, size))) {\n"
+           << "        return vec4(0);\n"
+           << "    }\n";
+    if (bilinear) {
+        // Same sampling points as the bilinear upsampling shader
+        stream << "    ivec2 inputSize = size / " << scale << ";\n"
+               << "    highp vec2 src = clamp((vec2(p.xy) + 0.5) / " << scale << ".0 - 0.5, vec2(0.0), vec2(inputSize - 1));\n"
+               << "    ivec2 p0 = ivec2(floor(src));\n"
+               << "    ivec2 p1 = min(p0 + 1, inputSize - 1);\n"
+               << "    highp vec2 f = src - vec2(p0);\n"
+               << "    vec4 top = mix(LOAD_" << name << "(ivec3(p0, p.z)), LOAD_" << name << "(ivec3(p1.x, p0.y, p.z)), f.x);\n"
+               << "    vec4 bottom = mix(LOAD_" << name << "(ivec3(p0.x, p1.y, p.z)), LOAD_" << name << "(ivec3(p1, p.z)), f.x);\n"
+               << "    return mix(top, bottom, f.y);\n";
+    } else {
+        stream << "    return LOAD_" << name << "(ivec3(p.xy / " << scale << ", p.z));\n";
+    }
+    stream << "}\n"
+           << "#undef LOAD_" << name << "\n"
+           << "#define LOAD_" << name << "(p) upsample_" << name << "((p), " << sizeUniform << ".xy)\n";
+    return stream.str();
+}
+
 Conv2DLayerGl::Conv2DLayerGl(Conv2DDesc&& d) : Conv2DLayer(std::move(d)) {
     if (_desc.numInputPlanes <= MAX_PLANES_FOR_WEIGHTS_IN_CONSTANTS) {
         _desc.useUniformShaders = false;
@@ -75,17 +108,21 @@ void Conv2DLayerGl::setTextureWeights() const {
 
     for (std::size_t filter = 0; filter < _desc.numOutputPlanes; filter++) {
         std::vector<float> weightVal(4 * _desc.kernelSize * _desc.kernelSize, 0.0);
+        // Weights are collected as floats and converted to the texture format before every upload
+        std::vector<uint16_t> halfVal(4 * _desc.kernelSize * _desc.kernelSize);
+        auto getPixels = [&]() -> const void* {
+            if (!_desc.preferHp) {
+                return weightVal.data();
+            }
+            snn::fp16::floatToHalf(weightVal.data(), halfVal.data(), halfVal.size());
+            return halfVal.data();
+        };
         for (std::size_t filterPlane = 0; filterPlane < _desc.numInputPlanes; filterPlane++) {
             std::size_t idx = filter * _desc.numInputPlanes + filterPlane;
             for (std::size_t i = 0; i < _desc.kernelSize; i++) {
                 for (std::size_t j = 0; j < _desc.kernelSize; j++) {
                     std::size_t weightValIdx = (4 * _desc.kernelSize * i) + (4 * j) + (filterPlane % 4);
-                    if (_desc.preferHp) {
-                        uint16_t* fp16Addr = (uint16_t*)weightVal.data();
-                        *(fp16Addr + weightValIdx) = FP32::toHalf(_desc.weightsCvM[idx].at<float>(i, j));
-                    } else {
-                        weightVal[weightValIdx] = _desc.weightsCvM[idx].at<float>(i, j);
-                    }
+                    weightVal[weightValIdx] = _desc.weightsCvM[idx].at<float>(i, j);
                 }
             }
             if ((filterPlane + 1) % 4 == 0) {
@@ -93,12 +130,12 @@ void Conv2DLayerGl::setTextureWeights() const {
                 SNN_LOGD("Adding weights at layer: %u", filterPlane / 4);
                 if (_desc.numInputPlanes > 4) {
                     weightTextures[filter].bind(0);
-                    weightTextures[filter].setPixels((int) (filterPlane / 4), 0, 0, 0, _desc.kernelSize, _desc.kernelSize, 0, weightVal.data());
+                    weightTextures[filter].setPixels((int) (filterPlane / 4), 0, 0, 0, _desc.kernelSize, _desc.kernelSize, 0, getPixels());
                     glFinish();
                     weightTextures[filter].unbind();
                 } else {
                     weightTextures[filter].bind(0);
-                    weightTextures[filter].setPixels(0, 0, 0, _desc.kernelSize, _desc.kernelSize, 0, weightVal.data());
+                    weightTextures[filter].setPixels(0, 0, 0, _desc.kernelSize, _desc.kernelSize, 0, getPixels());
                     glFinish();
                     weightTextures[filter].unbind();
                 }
@@ -110,12 +147,12 @@ void Conv2DLayerGl::setTextureWeights() const {
         if (!weightVal.empty() && _desc.numInputPlanes % 4 != 0) {
             if (_desc.numInputPlanes > 4) {
                 weightTextures[filter].bind(0);
-                weightTextures[filter].setPixels((int) (_desc.numInputPlanes / 4), 0, 0, 0, _desc.kernelSize, _desc.kernelSize, 0, weightVal.data());
+                weightTextures[filter].setPixels((int) (_desc.numInputPlanes / 4), 0, 0, 0, _desc.kernelSize, _desc.kernelSize, 0, getPixels());
                 glFinish();
                 weightTextures[filter].unbind();
             } else {
                 weightTextures[filter].bind(0);
-                weightTextures[filter].setPixels(0, 0, 0, _desc.kernelSize, _desc.kernelSize, 0, weightVal.data());
+                weightTextures[filter].setPixels(0, 0, 0, _desc.kernelSize, _desc.kernelSize, 0, getPixels());
                 glFinish();
                 weightTextures[filter].unbind();
             }
@@ -671,8 +708,12 @@ void Conv2DLayerGl::buildPreDefine(std::ostringstream& stream, const LayerGenOpt
     stream << "#define NUM_INPUT_PLANES " << _desc.numInputPlanes << std::endl;
     stream << "#define NUM_OUTPUT_PLANES " << _desc.numOutputPlanes << std::endl;
     stream << "#define NUM_KERNEL_SIZE " << _desc.kernelSize << std::endl;
-    stream << "#define INPUT_WIDTH " << options.desiredInput[0].width << std::endl;
-    stream << "#define INPUT_HEIGHT " << options.desiredInput[0].height << std::endl;
+    // Normalized coordinates of the upsampled input address the same points of the input texture,
+    // so the nearest sampler upsamples it as is. Bilinear upsampling is done by the shader.
+    buildInputSizeDefines(stream, options, _inputUpsampling);
+    if (_inputUpsamplingBilinear) {
+        stream << "#define INPUT_UPSAMPLING_BILINEAR" << std::endl;
+    }
     stream << "#define NUM_STRIDE " << _desc.stride << std::endl;
     stream << "#define PAD_VALUE 0.0f" << std::endl;
 #if CLAMPED_PADDING == 1
@@ -1005,32 +1046,6 @@ InferencePassesSptr Conv2DLayerGl::createFS(const LayerGenOptions& options) cons
     return ret;
 }
 
-static bool oihw2hwo4i4fp16(std::vector<cv::Mat> inputWeights, std::vector<float>& outVec, int inChannels, int outChannels, int fw, int fh, int unit = 4) {
-    int alignedWeightSize = ROUND_UP(outChannels, unit) * fw * fh * ROUND_UP(inChannels, unit)/2;
-
-    SNN_LOGD("Test:%s:%d, %d, %d, %d, %d, all: %d\n", __FILENAME__, __LINE__, inChannels, outChannels, fw, fh, alignedWeightSize);
-
-    outVec.clear();
-    outVec.resize(alignedWeightSize);
-    uint16_t* out    = (uint16_t*) outVec.data();
-    int planeSize = ROUND_UP(outChannels, unit) * ROUND_UP(inChannels, unit);
-    memset(out, 0, alignedWeightSize * sizeof(float));
-    for (int b = 0; b < outChannels; ++b) {
-        int b_4 = b / unit;
-        int mx  = b % unit;
-        for (int d = 0; d < inChannels; ++d) {
-            for (int y = 0; y < fh; ++y) {
-                for (int x = 0; x < fw; ++x) {
-                    int base                                 = (y * fw + x) * planeSize;
-                    int inSize                               = ROUND_UP(inChannels, unit) * unit;
-                    out[base + inSize * b_4 + d * unit + mx] = FP32::toHalf(inputWeights[b * inChannels + d].at<float>(y * fw + x));
-                }
-            }
-        }
-    }
-    return 0;
-}
-
 #define TEXTURE_WEIGHTS
 
 InferencePassesSptr Conv2DLayerGl::createCS(const LayerGenOptions& options) const {
@@ -1111,16 +1126,14 @@ InferencePassesSptr Conv2DLayerGl::createCS(const LayerGenOptions& options) cons
     }
     std::string debugLayer("[0X] Conv2D");
     SNN_LOGD("Test:%s:%d, %s\n", __FILENAME__, __LINE__, shaderHeader.c_str());
-    std::string shaderUniforms = "#ifdef OUTPUT_TEXTURE_2D\n"
-                            "layout(OUTPUT_FORMAT, binding=3) writeonly uniform PRECISION image2D uOutput;\n"
-                            "#else\n"
-                            "layout(OUTPUT_FORMAT, binding=3) writeonly uniform PRECISION image2DArray uOutput;\n"
-                            "#endif\n"
-                            "#ifdef INPUT_TEXTURE_2D\n"
-                            "layout(OUTPUT_FORMAT, binding=0) readonly uniform PRECISION image2D uInput;\n"
-                            "#else\n"
-                            "layout(OUTPUT_FORMAT, binding=0) readonly uniform PRECISION image2DArray uInput;\n"
-                            "#endif\n"
+    std::string inputDeclaration = buildComputeInputDeclaration("uInput", 0, 0, _desc.numInputPlanes <= 4);
+    if (_inputUpsampling > 1) {
+        // uInputSize is the size of the upsampled input
+        inputDeclaration += buildComputeInputUpsampling("uInput", "uInputSize", _inputUpsampling, _inputUpsamplingBilinear);
+        inputWidth *= _inputUpsampling;
+        inputHeight *= _inputUpsampling;
+    }
+    std::string shaderUniforms = buildComputeOutputDeclaration("uOutput", 3, _desc.numOutputPlanes <= 4) + inputDeclaration +
 #ifdef TEXTURE_WEIGHTS
                             "layout(binding=2) uniform PRECISION sampler2DArray uKernel;\n";
 #else
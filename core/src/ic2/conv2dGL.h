@@ -29,6 +29,8 @@ public:
     Conv2DLayerGl(Conv2DDesc&& d);
     virtual ~Conv2DLayerGl() = default;
 
+    bool supportsBufferActivations() const override { return true; }
+
 protected:
     InferencePassesSptr createFS(const LayerGenOptions&) const override;
     InferencePassesSptr createCS(const LayerGenOptions&) const override;
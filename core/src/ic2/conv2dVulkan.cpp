@@ -45,9 +45,12 @@ InferencePassesSptr Conv2DLayerVulkan::createCS(const LayerGenOptions& options)
 
     InferencePassVulkan& pass = passes[0];
 
-    uint32_t inputWidth  = inputDims[0].width;
-    uint32_t inputHeight = inputDims[0].height;
+    // With the fused input upsampling, the shader reads the input through the upsampling index transform
+    // and works with the size of the upsampled input
+    uint32_t inputWidth  = inputDims[0].width * _inputUpsampling;
+    uint32_t inputHeight = inputDims[0].height * _inputUpsampling;
     uint32_t inputDepth  = inputDims[0].depth;
+    uint32_t bilinear    = _inputUpsamplingBilinear ? 1 : 0;
 
     uint32_t outputWidth  = 0;
     uint32_t outputHeight = 0;
@@ -168,6 +171,8 @@ InferencePassesSptr Conv2DLayerVulkan::createCS(const LayerGenOptions& options)
             {11, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = useBatchNorm}},
             {12, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = useBias}},
             {13, uvkc::vulkan::Pipeline::SpecConstant::Type::f32, { .f32 = leakyValue}},
+            {14, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = _inputUpsampling}},
+            {15, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = bilinear}},
         };
         pass.specConstants = specConstants;
     } else {
@@ -200,6 +205,8 @@ InferencePassesSptr Conv2DLayerVulkan::createCS(const LayerGenOptions& options)
             {17, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = useBatchNorm}},
             {18, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = useBias}},
             {19, uvkc::vulkan::Pipeline::SpecConstant::Type::f32, { .f32 = leakyValue}},
+            {20, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = _inputUpsampling}},
+            {21, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = bilinear}},
         };
         pass.specConstants = specConstants;
     }
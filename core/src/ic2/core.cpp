@@ -15,9 +15,11 @@
 #include "pch.h"
 #include "snn/core.h"
 #include "snn/image.h"
+#include "snn/traceRecorder.h"
 #include "backend.h"
 #include "backendBuilder.h"
 #include "dp.h"
+#include "readerwriterqueue.h"
 #include <string>
 #include <vector>
 #include <array>
@@ -29,9 +31,20 @@
 #include <algorithm>
 #include <chrono>
 #include <utility>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <cstdint>
 
 using namespace snn;
 
+// Gets the size of the texture in bytes
+static uint64_t getTextureBytes(const ImageTexture& texture) {
+    const auto& dims = texture.getDims();
+    return (uint64_t) getColorFormatDesc(texture.getFormat()).calcImageSizeInBytes(dims[0], dims[1]) * dims[2] * std::max(dims[3], 1U);
+}
+
 bool dumpTextOutputs(const std::string& dirname, const std::string& filename, const std::vector<std::vector<float>>& outputMat) {
     std::ostringstream dumpFilename;
     dumpFilename << dirname << "/" << filename << ".txt";
@@ -70,6 +83,42 @@ void dumpBinOutputs(const std::string& binFilename, const std::vector<std::vecto
     image.saveToBIN(binFilename, false);
 }
 
+// State of the pipelined execution.
+// Every slot holds CPU copies of the GPU outputs, consumed by CPU layers, for one frame in flight.
+struct snn::MixedInferenceCore::Pipeline {
+    struct Slot {
+        // Inputs of every CPU stage, starting from the split stage
+        std::vector<std::unique_ptr<ImageTextureArray>> inputs;
+        uint64_t frameIndex = 0;
+        ModelType modelType = ModelType::OTHER;
+        // Flags of the stages to run, empty to run all of them (see MixedInferenceCore::activeStages)
+        std::vector<bool> activeStages;
+        std::chrono::high_resolution_clock::time_point submitTime;
+        uint32_t traceRun = TraceRecorder::NO_RUN; // Run of the frame, ended by the worker thread after its CPU layers
+    };
+
+    // Slot index, that stops the worker thread
+    static constexpr size_t STOP = SIZE_MAX;
+
+    // Index of the first CPU stage
+    size_t split = 0;
+    std::vector<Slot> slots;
+    // Slots with downloaded GPU outputs, waiting for CPU layers. Written by submit(), read by the worker thread.
+    moodycamel::BlockingReaderWriterQueue<size_t> pendingSlots;
+    // Slots available for the next frame. Written by the worker thread, read by submit().
+    moodycamel::BlockingReaderWriterQueue<size_t> freeSlots;
+    // Finished frames, at most maxResults. Written by the worker thread, read by receive().
+    std::mutex resultsMutex;
+    std::condition_variable resultsChanged;
+    std::deque<PipelineResult> results;
+    size_t maxResults       = 1;
+    ResultOverflow overflow = ResultOverflow::BLOCK;
+    uint64_t droppedResults = 0;
+    bool stopping           = false; // Releases the worker thread, waiting for a free result
+    std::thread worker;
+    uint64_t numSubmitted = 0;
+};
+
 // -----------------------------------------------------------------------------
 //
 MixedInferenceCore::MixedInferenceCore(GpuContext* context_)
@@ -78,20 +127,74 @@ MixedInferenceCore::MixedInferenceCore(GpuContext* context_)
 {}
 
 std::unique_ptr<MixedInferenceCore> snn::MixedInferenceCore::create(GpuContext* context, const CreationParameters& cp) {
-    std::unique_ptr<MixedInferenceCore> p(new MixedInferenceCore(context));
-    p->init(cp);
-    return p;
+    return MixedInferenceCore::create(CompiledModel::create(context, cp));
 }
 
 std::unique_ptr<MixedInferenceCore> snn::MixedInferenceCore::create(GpuContext* context, const std::string& modelFileName,
+    const dp::ShaderGenOptions& options, bool dumpOutputs) {
+    return MixedInferenceCore::create(CompiledModel::create(context, modelFileName, options, dumpOutputs));
+}
+
+std::unique_ptr<MixedInferenceCore> snn::MixedInferenceCore::create(std::shared_ptr<const CompiledModel> model) {
+    if (!model) {
+        return nullptr;
+    }
+    std::unique_ptr<MixedInferenceCore> p(new MixedInferenceCore(model->getContext()));
+    p->model = model;
+    if (!p->init(model->getCreationParameters())) {
+        SNN_LOGE("Failed to initialize the inference core");
+        return nullptr;
+    }
+    return p;
+}
+
+std::shared_ptr<const CompiledModel> snn::CompiledModel::create(GpuContext* context, const MixedInferenceCore::CreationParameters& cp) {
+    auto compileTimeStart = std::chrono::high_resolution_clock::now();
+    std::shared_ptr<CompiledModel> p(new CompiledModel(context, cp));
+
+    // Programs and weights are kept by the model layers, so the backend is only needed for the compilation
+    dp::DeviceBackend* backend = dp::BackendBuilder::build(context, cp, cp.weightCache);
+    bool compiled = true;
+    for (const auto& layer : cp.layers) {
+        if (layer->layerLoc != InferenceGraph::LayerExecutionType::CPU && !layer->isInputLayer && !layer->isNoOp && layer->compileFunPtr) {
+            if (!layer->compileFunPtr(backend)) {
+                SNN_LOGE("Failed to compile layer %s", layer->name.c_str());
+                compiled = false;
+            }
+        }
+    }
+    // Render passes only submit their programs for compilation in compileRenderPasses()
+    compiled = backend->finishRenderPasses() && compiled;
+    delete backend;
+    if (!compiled) {
+        SNN_LOGE("Failed to compile the model");
+        return nullptr;
+    }
+
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - compileTimeStart);
+    SNN_LOGD("Time spent in compilation of CompiledModel: %f secs", duration.count() / 1000000.0f);
+    return p;
+}
+
+std::shared_ptr<const CompiledModel> snn::CompiledModel::create(GpuContext* context, const std::string& modelFileName,
     const dp::ShaderGenOptions& options, bool dumpOutputs) {
     bool useVulan = context->backendType == GpuBackendType::VULKAN;
-    auto dp = snn::dp::loadFromJsonModel(modelFileName, useVulan, options.mrtMode, options.weightMode, options.preferrHalfPrecision);
+    auto dp = snn::dp::loadFromJsonModel(modelFileName, useVulan, options.mrtMode, options.weightMode, options.preferrHalfPrecision,
+                                         options.layerHalfPrecision);
+    if (dp.empty()) {
+        SNN_LOGE("Failed to load model %s", modelFileName.c_str());
+        return nullptr;
+    }
+    dp::ShaderGenOptions graphOptions = options;
+    // Layer dumps need a separate output texture for every layer
+    graphOptions.zeroCopyConcat       = options.zeroCopyConcat && !dumpOutputs;
+    graphOptions.fuseInvertedResidual = options.fuseInvertedResidual && !dumpOutputs;
+    graphOptions.fuseUpsampling       = options.fuseUpsampling && !dumpOutputs;
     MixedInferenceCore::CreationParameters cp;
-    (InferenceGraph &&) cp = snn::dp::generateInferenceGraph(dp[0], options);
+    (InferenceGraph &&) cp = snn::dp::generateInferenceGraph(dp[0], graphOptions);
 
     cp.dumpOutputs = dumpOutputs;
-    return MixedInferenceCore::create(context, cp);
+    return CompiledModel::create(context, cp);
 }
 
 void snn::MixedInferenceCore::run(MixedInferenceCore::RunParameters& rp) {
@@ -101,11 +204,20 @@ void snn::MixedInferenceCore::run(MixedInferenceCore::RunParameters& rp) {
         SNN_LOGE("Wrong input texture count %d <-> %d", rp.inputImages.size(), cp.inputsDesc.size());
         return;
     }
+    if (!selectActiveStages(rp.requestedOutputs)) {
+        return;
+    }
 
-    backend->prepareRun(rp, stages, bindOutput, stages.size() - 1);
+    auto runStart     = std::chrono::steady_clock::now();
+    sampleStageTimes  = metrics.beginRun();
+    uint32_t traceRun = TraceRecorder::beginRun();
+    bindOutputImages(rp);
+    backend->prepareRun(rp, stages);
     {
         ScopedTimer st1(cpuRunTime);
         std::vector<std::vector<float>> inputs;
+        // GPU outputs are downloaded by the first CPU stage, that runs after GPU stages
+        bool gpuOutputsPending = false;
 #ifdef PROFILING
         if (backend->isProfilingEnabled()) {
             gpuRunTime->start();
@@ -114,8 +226,9 @@ void snn::MixedInferenceCore::run(MixedInferenceCore::RunParameters& rp) {
         for (std::size_t i = 0; i < stages.size(); i++) {
             auto& s = stages[i];
 
-            // Nothing to run for the input layer.
-            if (s.layer->isInputLayer) {
+            // Nothing to run for the input layer, for the layers, whose output is written by producers,
+            // and for the layers, the requested outputs don't depend on.
+            if (s.layer->isInputLayer || s.layer->isNoOp || !isStageActive(i)) {
 #ifdef PROFILING
                 if (backend->isProfilingEnabled(true)) {
                     s.timer->start();
@@ -124,35 +237,16 @@ void snn::MixedInferenceCore::run(MixedInferenceCore::RunParameters& rp) {
 #endif
                 continue;
             }
-            for (size_t n = 0; n < s.delayBindMask.size(); ++n) {
-                if (s.delayBindMask[n] > 0) {
-                    auto inputIdx = s.inputIds[n];
-                    s.stageInputs[n].attach(&rp.inputImages[inputIdx]);
-                    SNN_LOGD("Delay binding input # %zu : %d  to input texture: %s", n, inputIdx, s.stageInputs[n].getTextureInfo2().c_str());
-                }
-            }
 
             SNN_LOGD("%zu / %zu, %s, backend:%d", i, stages.size(), s.layer->name.c_str(), s.backend);
             if (s.backend == Backend::Backend_GPU) {
-                if (s.transition == Transition::Backend_CPU_GPU) {
-                    // T.B.D. Copy CPU memory to Texture
-                }
-#ifdef PROFILING
-                if (backend->isProfilingEnabled(true)) {
-                    s.timer->start();
-                }
-#endif
-                backend->prepareStage(rp, stages[i]);
-                auto backendPtr = backend;
-                s.layer->runFunPtr(backendPtr, this->cp.dumpOutputs);
-
-#ifdef PROFILING
-                if (backend->isProfilingEnabled(true)) {
-                    s.timer->stop();
-                }
-#endif
+                runGpuStage(rp, i);
+                gpuOutputsPending = true;
             } else if (s.backend == Backend::Backend_CPU) {
-                if (s.transition == Transition::Backend_GPU_CPU) {
+                // The transition stage might be skipped, if the requested outputs don't depend on it
+                bool fromGpu      = s.transition == Transition::Backend_GPU_CPU || gpuOutputsPending;
+                gpuOutputsPending = false;
+                if (fromGpu) {
 #ifdef PROFILING
                     if (backend->isProfilingEnabled()) {
                         // TODO: Do we need this stop here?
@@ -162,12 +256,13 @@ void snn::MixedInferenceCore::run(MixedInferenceCore::RunParameters& rp) {
                         gpuRunTime->stop();
                     }
 #endif
-                    backend->sync();
+                    syncBackend();
                 }
-                if (s.transition == Transition::Backend_GPU_CPU) {
+                if (fromGpu) {
                     PROFILE_TIME(download, "download to CPU") // We exclude sync() time from CPU timing statistics
                     for (size_t j = 0; j < s.stageInputs.size(); j++) {
                         s.stageInputs[j].download();
+                        metrics.addReadbackBytes(getTextureBytes(stages[s.inputIds[j]].stageOutputs[0]));
                     }
                 }
 
@@ -178,6 +273,7 @@ void snn::MixedInferenceCore::run(MixedInferenceCore::RunParameters& rp) {
                     s.stageInputs[j].setOutputMat(stages[s.inputIds[j]].stageOutputs[0].getOutputMat());
                 }
                 PROFILE_TIME(Backend_CPU, "Backend CPU") // We exclude sync() time from CPU timing statistics
+                TraceScope traceLayer(s.layer->name.c_str());
                 s.layer->imageTextureFunPtr(s.stageInputs, s.stageOutputs);
                 if (this->cp.dumpOutputs) {
 #if DUMP_RESULTS_TXT
@@ -200,19 +296,13 @@ void snn::MixedInferenceCore::run(MixedInferenceCore::RunParameters& rp) {
 
         this->output = std::move(inputs);
         inputs.clear();
-        backend->sync();
+        syncBackend();
+        convertOutputImages();
         backend->postRun(stages, this->cp.dumpOutputs, OUTPUT_DIR);
 
-#ifdef PROFILING
-        if (backend->isProfilingEnabled(true)) {
-            for (size_t i = 0; i < stages.size(); i++) {
-                auto& s = stages[i];
-                if (s.backend == Backend::Backend_GPU) {
-                    s.timer->getTime();
-                }
-            }
+        if (queryStageTimes()) {
+            getStageTimes();
         }
-#endif
 
 #ifdef PROFILING
         if (backend->isProfilingEnabled()) {
@@ -225,18 +315,22 @@ void snn::MixedInferenceCore::run(MixedInferenceCore::RunParameters& rp) {
     SNN_LOGD(printTimingStats().c_str());
 #endif
 
-    if (rp.modelOutput.modelType == ModelType::CLASSIFICATION && stages[stages.size() - 1].backend == Backend::Backend_CPU) {
+    bool lastStageActive = isStageActive(stages.size() - 1);
+    if (rp.modelOutput.modelType == ModelType::CLASSIFICATION && stages[stages.size() - 1].backend == Backend::Backend_CPU && lastStageActive) {
         // 0 = None; Add 1 to start index in classifier
         rp.modelOutput.classifierOutput = std::distance(stages[stages.size() - 1].stageOutputs[0].getOutputMat().at(0).begin(),
                                                         std::max_element(stages[stages.size() - 1].stageOutputs[0].getOutputMat().at(0).begin(),
                                                                          stages[stages.size() - 1].stageOutputs[0].getOutputMat().at(0).end())) + 1;
         SNN_LOGD("Classifier output: %d", rp.modelOutput.classifierOutput);
     }
-    else if (rp.modelOutput.modelType == ModelType::DETECTION && stages[stages.size() - 1].backend == Backend::Backend_CPU) {
+    else if (rp.modelOutput.modelType == ModelType::DETECTION && stages[stages.size() - 1].backend == Backend::Backend_CPU && lastStageActive) {
         rp.modelOutput.detectionOutput = stages[stages.size() - 1].stageOutputs[0].getOutputMat();
     }
 
     backend->cleanupRun();
+    TraceRecorder::endRun(traceRun);
+    metrics.addSkippedStages(numSkippedStages);
+    metrics.endRun(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - runStart).count());
 
     // Print out time stats every 5 seconds
 #ifdef PROFILING
@@ -244,6 +338,434 @@ void snn::MixedInferenceCore::run(MixedInferenceCore::RunParameters& rp) {
 #endif
 }
 
+void snn::MixedInferenceCore::runGpuStage(MixedInferenceCore::RunParameters& rp, size_t i) {
+    auto& s = stages[i];
+    for (size_t n = 0; n < s.delayBindMask.size(); ++n) {
+        if (s.delayBindMask[n] > 0) {
+            auto inputIdx = s.inputIds[n];
+            s.stageInputs[n].attach(&rp.inputImages[inputIdx]);
+            SNN_LOGD("Delay binding input # %zu : %d  to input texture: %s", n, inputIdx, s.stageInputs[n].getTextureInfo2().c_str());
+        }
+    }
+    if (s.transition == Transition::Backend_CPU_GPU) {
+        // T.B.D. Copy CPU memory to Texture
+    }
+    bool timed = queryStageTimes();
+    if (timed) {
+        if (!s.timer) {
+            // Stage timers of non-profiling builds are created on the first traced run
+            s.timer.reset(backend->createDeviceTimer(s.layer->name));
+        }
+        s.timer->start();
+    }
+    backend->prepareStage(rp, stages[i]);
+    auto backendPtr = backend;
+    s.layer->runFunPtr(backendPtr, s.renderPasses, this->cp.dumpOutputs);
+
+    if (timed) {
+        s.timer->stop();
+    }
+}
+
+bool snn::MixedInferenceCore::queryStageTimes() {
+#ifdef PROFILING
+    // OpenGL backend can't overlap per-stage queries with the total GPU time query of profiling builds
+    return backend->isProfilingEnabled(true);
+#else
+    return TraceRecorder::isRecording() || sampleStageTimes;
+#endif
+}
+
+void snn::MixedInferenceCore::getStageTimes() {
+    for (size_t i = 0; i < stages.size(); i++) {
+        auto& s = stages[i];
+        // Timers of the skipped stages hold no queries of the current run
+        if (s.backend == Backend::Backend_GPU && s.timer && isStageActive(i)) {
+            s.timer->getTime();
+            metrics.recordStageGpuTime(i, s.timer->duration());
+        }
+    }
+}
+
+void snn::MixedInferenceCore::syncBackend() {
+    TraceScope traceSync("backend sync");
+    auto start = std::chrono::steady_clock::now();
+    backend->sync();
+    backend->addMetrics(metrics);
+    metrics.recordSync(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+bool snn::MixedInferenceCore::startPipeline(size_t maxFramesInFlight, size_t maxResults, ResultOverflow overflow) {
+    stopPipeline();
+    if (cp.dumpOutputs) {
+        SNN_LOGE("Layer dumps are not supported in pipelined execution");
+        return false;
+    }
+    size_t split = 0;
+    while (split < stages.size() && stages[split].backend != Backend::Backend_CPU) {
+        ++split;
+    }
+    if (split == stages.size()) {
+        SNN_LOGE("Model has no CPU layers to pipeline");
+        return false;
+    }
+    for (size_t i = split; i < stages.size(); ++i) {
+        if (stages[i].backend != Backend::Backend_CPU) {
+            SNN_LOGE("GPU layer %s follows CPU layers, pipelining is not supported", stages[i].layer->name.c_str());
+            return false;
+        }
+    }
+
+    pipeline.reset(new Pipeline());
+    pipeline->split      = split;
+    pipeline->maxResults = std::max<size_t>(maxResults, 1);
+    pipeline->overflow   = overflow;
+    pipeline->slots.resize(std::max<size_t>(maxFramesInFlight, 1));
+    for (size_t k = 0; k < pipeline->slots.size(); ++k) {
+        auto& slot = pipeline->slots[k];
+        for (size_t i = split; i < stages.size(); ++i) {
+            slot.inputs.emplace_back(new ImageTextureArray(ImageTextureAllocator(context)));
+            slot.inputs.back()->allocate(stages[i].stageInputs.size());
+        }
+        pipeline->freeSlots.enqueue(k);
+    }
+    pipeline->worker = std::thread(&MixedInferenceCore::pipelineWorker, this);
+    SNN_LOGI("Pipelined execution: %zu GPU stages, %zu CPU stages, %zu frames in flight, %zu results %s", split, stages.size() - split,
+             pipeline->slots.size(), pipeline->maxResults, overflow == ResultOverflow::BLOCK ? "blocking" : "dropping the oldest");
+    return true;
+}
+
+void snn::MixedInferenceCore::stopPipeline() {
+    if (!pipeline) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(pipeline->resultsMutex);
+        pipeline->stopping = true;
+    }
+    pipeline->resultsChanged.notify_all();
+    pipeline->pendingSlots.enqueue(Pipeline::STOP);
+    if (pipeline->worker.joinable()) {
+        pipeline->worker.join();
+    }
+    pipeline.reset();
+}
+
+void snn::MixedInferenceCore::submit(MixedInferenceCore::RunParameters& rp) {
+    SNN_ASSERT(pipeline);
+    if (rp.inputImages.size() != cp.inputsDesc.size()) {
+        SNN_LOGE("Wrong input texture count %d <-> %d", rp.inputImages.size(), cp.inputsDesc.size());
+        return;
+    }
+    if (!selectActiveStages(rp.requestedOutputs)) {
+        return;
+    }
+    size_t slotIndex = 0;
+    pipeline->freeSlots.wait_dequeue(slotIndex);
+    auto& slot        = pipeline->slots[slotIndex];
+    slot.submitTime   = std::chrono::high_resolution_clock::now();
+    slot.frameIndex   = pipeline->numSubmitted++;
+    slot.modelType    = rp.modelOutput.modelType;
+    slot.activeStages = activeStages;
+
+    auto runStart    = std::chrono::steady_clock::now();
+    sampleStageTimes = metrics.beginRun();
+    slot.traceRun    = TraceRecorder::beginRun();
+    bindOutputImages(rp);
+    backend->prepareRun(rp, stages);
+    {
+        ScopedTimer st1(cpuRunTime);
+        for (size_t i = 0; i < pipeline->split; i++) {
+            auto& s = stages[i];
+            if (s.layer->isInputLayer || s.layer->isNoOp || !isStageActive(i)) {
+                continue;
+            }
+            runGpuStage(rp, i);
+        }
+        syncBackend();
+        convertOutputImages();
+        if (queryStageTimes()) {
+            getStageTimes();
+        }
+
+        // Download GPU outputs, consumed by CPU layers, into the slot.
+        // CPU layers of the previous frames might still use the stage inputs on the worker thread.
+        PROFILE_TIME(download, "download to CPU")
+        for (size_t i = pipeline->split; i < stages.size(); ++i) {
+            if (!isStageActive(i)) {
+                continue;
+            }
+            auto& s      = stages[i];
+            auto& inputs = *slot.inputs[i - pipeline->split];
+            for (size_t j = 0; j < s.inputIds.size(); j++) {
+                if (stages[s.inputIds[j]].backend == Backend::Backend_GPU) {
+                    inputs[j].attach(&stages[s.inputIds[j]].stageOutputs[0]);
+                    inputs[j].download();
+                    metrics.addReadbackBytes(getTextureBytes(stages[s.inputIds[j]].stageOutputs[0]));
+                }
+            }
+        }
+    }
+    backend->cleanupRun();
+    metrics.addSkippedStages(numSkippedStages);
+    // End-to-end time of the pipelined frames is reported by receive() as PipelineResult::latency
+    metrics.endRun(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - runStart).count());
+    pipeline->pendingSlots.enqueue(slotIndex);
+}
+
+bool snn::MixedInferenceCore::receive(MixedInferenceCore::PipelineResult& result, bool wait) {
+    SNN_ASSERT(pipeline);
+    {
+        std::unique_lock<std::mutex> lock(pipeline->resultsMutex);
+        if (wait) {
+            pipeline->resultsChanged.wait(lock, [&] { return !pipeline->results.empty(); });
+        } else if (pipeline->results.empty()) {
+            return false;
+        }
+        result = std::move(pipeline->results.front());
+        pipeline->results.pop_front();
+    }
+    pipeline->resultsChanged.notify_all();
+    return true;
+}
+
+uint64_t snn::MixedInferenceCore::getDroppedResults() const {
+    if (!pipeline) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(pipeline->resultsMutex);
+    return pipeline->droppedResults;
+}
+
+void snn::MixedInferenceCore::pipelineWorker() {
+    TraceRecorder::setThreadName("CPU layer pipeline");
+    for (;;) {
+        size_t slotIndex = 0;
+        pipeline->pendingSlots.wait_dequeue(slotIndex);
+        if (slotIndex == Pipeline::STOP) {
+            break;
+        }
+        auto& slot = pipeline->slots[slotIndex];
+        // CPU stages are touched by the worker thread only, while the pipeline is running
+        size_t lastStage = stages.size() - 1;
+        for (size_t i = pipeline->split; i < stages.size(); ++i) {
+            if (!slot.activeStages.empty() && !slot.activeStages[i]) {
+                continue;
+            }
+            auto& s      = stages[i];
+            auto& inputs = *slot.inputs[i - pipeline->split];
+            for (size_t j = 0; j < s.inputIds.size(); j++) {
+                inputs[j].setOutputMat(stages[s.inputIds[j]].stageOutputs[0].getOutputMat());
+            }
+            TraceScope traceLayer(s.layer->name.c_str());
+            s.layer->imageTextureFunPtr(inputs, s.stageOutputs);
+            lastStage = i;
+        }
+
+        PipelineResult result;
+        result.frameIndex            = slot.frameIndex;
+        result.modelOutput.modelType = slot.modelType;
+        // With requested outputs, the result holds the output of the last CPU stage, that has run
+        const auto& lastOutput       = stages[lastStage].stageOutputs[0].getOutputMat();
+        if (slot.modelType == ModelType::CLASSIFICATION && lastOutput.size() > 0) {
+            // 0 = None; Add 1 to start index in classifier
+            result.modelOutput.classifierOutput = std::distance(lastOutput.at(0).begin(), std::max_element(lastOutput.at(0).begin(), lastOutput.at(0).end())) + 1;
+        } else if (slot.modelType == ModelType::DETECTION) {
+            result.modelOutput.detectionOutput = lastOutput;
+        }
+        result.output  = lastOutput;
+        result.latency = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - slot.submitTime).count();
+        {
+            std::unique_lock<std::mutex> lock(pipeline->resultsMutex);
+            if (pipeline->results.size() >= pipeline->maxResults) {
+                if (pipeline->overflow == ResultOverflow::DROP_OLDEST) {
+                    SNN_LOGD("Result queue is full, frame %llu is dropped", (unsigned long long) pipeline->results.front().frameIndex);
+                    pipeline->results.pop_front();
+                    pipeline->droppedResults++;
+                } else {
+                    // The slot stays busy meanwhile, so submit() blocks, as soon as all slots are taken
+                    pipeline->resultsChanged.wait(lock, [&] { return pipeline->results.size() < pipeline->maxResults || pipeline->stopping; });
+                }
+            }
+            // Results of a stopping pipeline are discarded anyway
+            if (!pipeline->stopping) {
+                pipeline->results.push_back(std::move(result));
+            }
+        }
+        pipeline->resultsChanged.notify_all();
+        // The run ends after the events of its CPU layers, so that they are in the trace
+        TraceRecorder::endRun(slot.traceRun);
+        pipeline->freeSlots.enqueue(slotIndex);
+    }
+}
+
+int snn::MixedInferenceCore::findStage(const std::string& layerName) const {
+    for (size_t i = 0; i < stages.size(); ++i) {
+        if (InferenceGraph::matchLayerName(stages[i].layer->name, layerName)) {
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+ImageTexture* snn::MixedInferenceCore::getOutputImage(const std::string& layerName) {
+    int index = findStage(layerName);
+    if (index < 0) {
+        SNN_LOGE("Layer %s is not found", layerName.c_str());
+        return nullptr;
+    }
+    return &stages[index].stageOutputs[0];
+}
+
+bool snn::MixedInferenceCore::selectActiveStages(const std::vector<std::string>& requestedOutputs) {
+    if (requestedOutputs == activeOutputs) {
+        return true;
+    }
+    activeOutputs.clear();
+    activeStages.clear();
+    numSkippedStages = 0;
+    if (requestedOutputs.empty()) {
+        return true;
+    }
+
+    // Walk the inputs back from the requested layers. Stages are topologically sorted, so every stage,
+    // a requested layer depends on, precedes it.
+    std::vector<bool> active(stages.size(), false);
+    std::vector<int> pending;
+    for (const auto& name : requestedOutputs) {
+        int index = findStage(name);
+        if (index < 0) {
+            SNN_LOGE("Requested output layer %s is not found", name.c_str());
+            return false;
+        }
+        pending.push_back(index);
+    }
+    while (!pending.empty()) {
+        int index = pending.back();
+        pending.pop_back();
+        if (active[index]) {
+            continue;
+        }
+        active[index] = true;
+        for (const auto& inputRef : stages[index].layer->inputRefs) {
+            if (inputRef.index >= 0) {
+                pending.push_back(inputRef.index);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const auto& layer = *stages[i].layer;
+        if (!active[i] && !layer.isInputLayer && !layer.isNoOp) {
+            ++numSkippedStages;
+        }
+    }
+    SNN_LOGI("%zu requested outputs: %zu of %zu stages are skipped", requestedOutputs.size(), numSkippedStages, stages.size());
+    activeStages  = std::move(active);
+    activeOutputs = requestedOutputs;
+    return true;
+}
+
+void snn::MixedInferenceCore::bindOutputImages(RunParameters& rp) {
+    std::vector<ImageTexture*> images(stages.size(), nullptr);
+    if (rp.outputImages()) {
+        if (rp.requestedOutputs.empty()) {
+            images[stages.size() - 1] = &rp.outputImages[0];
+        } else {
+            // Requested outputs are validated by selectActiveStages()
+            for (size_t k = 0; k < std::min(rp.outputImages.size(), rp.requestedOutputs.size()); ++k) {
+                images[findStage(rp.requestedOutputs[k])] = &rp.outputImages[k];
+            }
+        }
+    }
+
+    bool changed = false;
+    for (size_t i = 0; i < stages.size(); ++i) {
+        auto& s             = stages[i];
+        ImageTexture* image = images[i] && validateOutputImage(i, *images[i]) ? images[i] : nullptr;
+        const auto& desc    = s.layer->outputDesc;
+        bool attach         = image && image->getFormat() == desc.format;
+        if (s.outputAttached && !attach) {
+            // The own texture of the stage was released, when the previous output image was attached
+            std::array<uint32_t, 4> dims {desc.width, desc.height, desc.depth, 1};
+            s.stageOutputs[0].resetTexture(dims, desc.format, "");
+            metrics.addTextureBytes(getTextureBytes(s.stageOutputs[0]));
+            changed = true;
+        }
+        if (attach) {
+            if (!s.outputAttached) {
+                // Attaching releases the own texture of the stage
+                metrics.releaseTextureBytes(getTextureBytes(s.stageOutputs[0]));
+            }
+            // The caller might attach another GPU image to the same object between runs, so it is attached every run
+            s.stageOutputs[0].attach(image);
+            changed = true;
+        }
+        s.outputBinding  = image;
+        s.outputAttached = attach;
+    }
+    if (changed) {
+        reattachStageOutputs();
+    }
+}
+
+bool snn::MixedInferenceCore::validateOutputImage(size_t i, ImageTexture& image) const {
+    const auto& s     = stages[i];
+    const auto& layer = *s.layer;
+    if (s.backend != Backend::Backend_GPU || layer.isInputLayer) {
+        SNN_LOG_EVERY_N_SEC(5, WARN, "Output image is not bound to layer %s: it doesn't run on GPU", layer.name.c_str());
+        return false;
+    }
+    if (layer.bufferOutput || layer.outputAlias.index >= 0) {
+        SNN_LOG_EVERY_N_SEC(5, WARN, "Output image is not bound to layer %s: it writes into a %s", layer.name.c_str(),
+                            layer.bufferOutput ? "storage buffer" : "zero-copy concatenation output");
+        return false;
+    }
+    const auto& dims = image.getDims();
+    const auto& desc = layer.outputDesc;
+    if (image.getNumTextures() == 0 || dims[0] != desc.width || dims[1] != desc.height || dims[2] != desc.depth) {
+        SNN_LOG_EVERY_N_SEC(5, ERR, "Output image %s doesn't match the output of layer %s: %ux%ux%u", image.getTextureInfo2().c_str(),
+                            layer.name.c_str(), desc.width, desc.height, desc.depth);
+        return false;
+    }
+    return true;
+}
+
+void snn::MixedInferenceCore::reattachStageOutputs() {
+    // Producers precede their consumers, and an aliased output belongs to a later stage,
+    // so a single pass in the stage order sees every referenced output up to date
+    for (size_t i = 0; i < stages.size(); ++i) {
+        auto& s           = stages[i];
+        const auto& layer = *s.layer;
+        if (layer.isInputLayer) {
+            continue;
+        }
+        for (size_t j = 0; j < layer.inputRefs.size(); ++j) {
+            const auto& inputRef = layer.inputRefs[j];
+            if (s.backend == Backend::Backend_CPU || inputRef.isStageOutput) {
+                s.stageInputs[j].attach(&stages[inputRef.index].stageOutputs[0]);
+            }
+        }
+        if (s.backend == Backend::Backend_GPU && layer.outputAlias.index >= 0) {
+            s.stageOutputs[0].attach(&stages[layer.outputAlias.index].stageOutputs[0]);
+        }
+    }
+}
+
+void snn::MixedInferenceCore::convertOutputImages() {
+    for (size_t i = 0; i < stages.size(); ++i) {
+        auto& s = stages[i];
+        if (!s.outputBinding || s.outputAttached || !isStageActive(i)) {
+            continue;
+        }
+        TraceScope traceConvert("output conversion");
+        if (!s.outputBinding->convertFrom(s.stageOutputs[0])) {
+            SNN_LOG_EVERY_N_SEC(5, ERR, "Failed to convert the output of layer %s into %s", s.layer->name.c_str(),
+                                s.outputBinding->getTextureInfo2().c_str());
+        }
+    }
+}
+
 std::pair<Backend, Transition> mapDeviceBackend(InferenceGraph::LayerExecutionType prevLayer, InferenceGraph::LayerExecutionType currLayer) {
     Backend retBackend  = Backend::NOT_DEFINED;
     Transition retTrans = Transition::NOT_DEFINED;
@@ -313,9 +835,6 @@ bool snn::MixedInferenceCore::init(const MixedInferenceCore::CreationParameters&
 
     InferenceGraph::LayerExecutionType preDev = InferenceGraph::LayerExecutionType::NOT_DEFINED;
     for (std::size_t i = 0; i < cp.layers.size(); i++) {
-        if (cp.layers[i]->flattenLayer) {
-            bindOutput = false; // If model contains a flatten layer, we do not bind last layer to output image(s)
-        }
         auto backTrans       = mapDeviceBackend(preDev, cp.layers[i]->layerLoc);
         stages[i].backend    = backTrans.first;
         stages[i].transition = backTrans.second;
@@ -338,7 +857,9 @@ bool snn::MixedInferenceCore::init(const MixedInferenceCore::CreationParameters&
             }
 
             stage.stageInputs.allocate(layer.inputRefs.size());
-            stage.stageOutputs.allocate(1);
+            if (stage.stageOutputs.size() == 0) { // Output might be already allocated by an aliased producer
+                stage.stageOutputs.allocate(1);
+            }
 
             // Skip create new texture or binding for input layer
             if (stage.layer->isInputLayer) {
@@ -368,10 +889,33 @@ bool snn::MixedInferenceCore::init(const MixedInferenceCore::CreationParameters&
                     SNN_LOGD("Backend_GPU: Stage: %zu, input: %zu, inputRef:%d delay binding: %d", i, j, inputRef.index, inputIdx);
                 }
             }
-            std::array<uint32_t, 4> dims {layer.outputDesc.width, layer.outputDesc.height, layer.outputDesc.depth, 1};
-            stage.stageOutputs[0].resetTexture(dims, layer.outputDesc.format, "");
+            if (layer.outputAlias.index >= 0) {
+                // Write directly into a layer range of the consumer's output
+                SNN_ASSERT(layer.outputAlias.index > (int) i);
+                RenderStage& owner = stages[layer.outputAlias.index];
+                if (owner.stageOutputs.size() == 0) {
+                    const InferenceGraph::IODesc& ownerDesc = cp.layers[layer.outputAlias.index]->outputDesc;
+                    std::array<uint32_t, 4> ownerDims {ownerDesc.width, ownerDesc.height, ownerDesc.depth, 1};
+                    owner.stageOutputs.allocate(1);
+                    owner.stageOutputs[0].resetTexture(ownerDims, ownerDesc.format, "");
+                    metrics.addTextureBytes(getTextureBytes(owner.stageOutputs[0]));
+                }
+                stage.stageOutputs[0].attach(&owner.stageOutputs[0]);
+                SNN_LOGD("Layer %zu: aliased to layer %d, plane offset %u", i, layer.outputAlias.index, layer.outputAlias.planeOffset);
+            } else if (!layer.isNoOp) {
+                std::array<uint32_t, 4> dims {layer.outputDesc.width, layer.outputDesc.height, layer.outputDesc.depth, 1};
+                if (layer.bufferOutput) {
+                    stage.stageOutputs[0].resetBuffer(dims, layer.outputDesc.format, "");
+                } else {
+                    stage.stageOutputs[0].resetTexture(dims, layer.outputDesc.format, "");
+                }
+                metrics.addTextureBytes(getTextureBytes(stage.stageOutputs[0]));
+            }
             SNN_LOGD("Layer %zu: texture: %s", i, stage.stageOutputs[0].getTextureInfo2().c_str());
-            layer.initFunPtr(backend, stage.stageInputs, stage.stageOutputs);
+            // No-op layer output is fully written by its producers, so there is nothing to initialize
+            if (!layer.isNoOp) {
+                layer.initFunPtr(backend, stage.stageInputs, stage.stageOutputs, stage.renderPasses);
+            }
         } else if (stage.backend == Backend::Backend_CPU) {
             SNN_LOGD("%%%%%%%% dim:%d, %d, %d", layer.outputDesc.width, layer.outputDesc.height, layer.outputDesc.depth);
             stage.stageInputs.allocate(layer.inputRefs.size());
@@ -403,6 +947,17 @@ bool snn::MixedInferenceCore::init(const MixedInferenceCore::CreationParameters&
         stage.timer.reset(backend->createDeviceTimer(layer.name + "_" + dimStr));
 #endif
     }
+
+    // GPU time is collected for the stages, that run shaders
+    std::vector<std::string> timedStages(stages.size());
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const auto& layer = *stages[i].layer;
+        if (stages[i].backend == Backend::Backend_GPU && !layer.isInputLayer && !layer.isNoOp) {
+            timedStages[i] = layer.name;
+        }
+    }
+    metrics.init(timedStages);
+
     auto initEndTime = std::chrono::high_resolution_clock::now();
     auto duration    = std::chrono::duration_cast<std::chrono::microseconds>(initEndTime - initTimeStart);
     SNN_LOGD("Time spent in initialization for MixedInferenceCore: %f secs", duration.count() / 1000000.0f);
@@ -443,6 +998,7 @@ void snn::MixedInferenceCore::writeTimeStat(std::map<std::string, std::vector<do
 
 
 snn::MixedInferenceCore::~MixedInferenceCore() {
+    stopPipeline();
     if (backend) {
         delete backend;
     }
@@ -16,6 +16,7 @@
 
 #include "snn/snn.h"
 #include "snn/utils.h"
+#include "snn/fp16.h"
 #include "Eigen/Dense"
 #include <string>
 #include <cstring>
@@ -76,7 +77,6 @@ struct CPUCommonUtil {
         for (auto image : inputMat) {
             uint32_t size       = image->size();
             auto rawDataPointer = image->data();
-            std::vector<uint8_t> dataArray(rawDataPointer, rawDataPointer + size);
             uint32_t width    = image->width();
             uint32_t height   = image->height();
             uint32_t depth    = image->depth();
@@ -87,10 +87,23 @@ struct CPUCommonUtil {
             uint32_t channelPerPlane = formatDesc.ch;
             SNN_ASSERT(channelPerPlane == 4);
             SNN_ASSERT(width * height * depth * formatDesc.bytes() == size);
-            std::vector<std::size_t> indices(size);
-            std::vector<std::size_t> reorderedIndices;
-            std::iota(indices.begin(), indices.end(), 0);
             std::size_t byteSize = formatDesc.bits / (8 * formatDesc.ch);
+            // All elements are converted at once, then reordered
+            std::size_t numElements = size / byteSize;
+            std::vector<T> values(numElements);
+            if (byteSize == 2) {
+                std::vector<float> f32(numElements);
+                snn::fp16::halfToFloat((const uint16_t*) rawDataPointer, f32.data(), numElements);
+                std::copy(f32.begin(), f32.end(), values.begin());
+            } else if (byteSize == 1) {
+                std::copy(rawDataPointer, rawDataPointer + numElements, values.begin());
+            } else {
+                for (std::size_t i = 0; i < numElements; i++) {
+                    std::memcpy(&values[i], rawDataPointer + i * byteSize, byteSize);
+                }
+            }
+            std::vector<std::size_t> reorderedIndices;
+            reorderedIndices.reserve(numElements);
             for (std::size_t row = 0; row < height; row++) {
                 for (std::size_t column = 0; column < width; column++) {
                     for (std::size_t plane = 0; plane < depth; plane++) {
@@ -101,34 +114,20 @@ struct CPUCommonUtil {
                                 uint32_t nChannels = channels - plane * channelPerPlane;
                                 if (channel < nChannels) {
                                     index = channel + nChannels * column + nChannels * width * row + nChannels * height * width * plane;
-                                    reorderedIndices.push_back(indices.at(byteSize * index));
+                                    reorderedIndices.push_back(index);
                                 }
                             } else {
                                 std::size_t index =
                                     channel + channelPerPlane * column + channelPerPlane * width * row + channelPerPlane * height * width * plane;
-                                reorderedIndices.push_back(indices.at(byteSize * index));
+                                reorderedIndices.push_back(index);
                             }
                         }
                     }
                 }
             }
+            outputMat.reserve(outputMat.size() + reorderedIndices.size());
             for (auto i : reorderedIndices) {
-                // for ( size_t i = 0; i < size; i += byteSize ) {
-                std::vector<uint8_t> floatData;
-                T data = 0;
-                for (std::size_t j = 0; j < byteSize; j++) {
-                    floatData.push_back(dataArray.at(i + j));
-                }
-                if (byteSize == 2) {
-                    uint16_t tempf16Val;
-                    std::memcpy(&tempf16Val, floatData.data(), byteSize);
-                    data = snn::convertToHighPrecision(tempf16Val);
-                } else if (byteSize == 1) {
-                    data = (float) floatData.at(0);
-                } else {
-                    std::memcpy(&data, floatData.data(), byteSize);
-                }
-                outputMat.push_back(data);
+                outputMat.push_back(values.at(i));
             }
         }
     }
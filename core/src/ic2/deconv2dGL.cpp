@@ -125,6 +125,7 @@ void Conv2DTransposeLayerGl::buildPreDefine(std::ostringstream& stream, const La
     stream << "#define NUM_INPUT_PLANES " << _desc.numInputPlanes << std::endl;
     stream << "#define NUM_OUTPUT_PLANES " << _desc.numOutputPlanes << std::endl;
     stream << "#define NUM_KERNEL_SIZE " << _desc.kernelSize << std::endl;
+    // Deconvolution templates use the input size in constant expressions, so it is always compiled in
     stream << "#define INPUT_WIDTH " << options.desiredInput[0].width << std::endl;
     stream << "#define INPUT_HEIGHT " << options.desiredInput[0].height << std::endl;
     stream << "#define NUM_STRIDE " << _desc.stride << std::endl;
@@ -33,6 +33,19 @@ public:
     virtual ~Conv2DTransposeLayerGl() = default;
     virtual InferenceGraph::Transform getOutputScaleDimAdjustment() const override;
 
+    virtual bool getSpatialFootprint(uint32_t& kernelRadius, float& scale) const override {
+        kernelRadius = UP_DIV(_desc.kernelSize / 2, _desc.stride);
+        scale        = static_cast<float>(_desc.stride);
+        return true;
+    }
+
+    // Every input pixel is scattered to kernelSize x kernelSize output pixels
+    virtual void getArithmeticCost(uint64_t& macs, uint64_t& numWeights) const override {
+        uint64_t kernelWeights = (uint64_t) _desc.kernelSize * _desc.kernelSize * _desc.numInputPlanes * _desc.numOutputPlanes;
+        macs       = inputDims.empty() ? 0 : (uint64_t) inputDims[0].width * inputDims[0].height * kernelWeights;
+        numWeights = kernelWeights + _desc.numOutputPlanes * (_desc.useBatchNormalization ? 5 : 1);
+    }
+
 protected:
     InferencePassesSptr createFS(const LayerGenOptions&) const override;
     InferencePassesSptr createCS(const LayerGenOptions&) const override;
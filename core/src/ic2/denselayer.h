@@ -47,6 +47,11 @@ public:
     virtual InferenceGraph::Transform getOutputScaleDimAdjustment() const override;
     virtual void getOutputDims(uint32_t& width, uint32_t& height, uint32_t& depth) const override;
 
+    virtual void getArithmeticCost(uint64_t& macs, uint64_t& numWeights) const override {
+        macs       = (uint64_t) _desc.numInputUnits * _desc.numOutputUnits;
+        numWeights = macs + _desc.numOutputUnits;
+    }
+
     virtual void computeImageTexture(ImageTextureArray& inputMat, ImageTextureArray& outputMat) override;
 
     virtual snn::InferenceGraph::LayerExecutionType getLayerExecutionType() const override { return executeBackend; }
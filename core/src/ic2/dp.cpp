@@ -15,6 +15,19 @@
 #include "pch.h"
 #include "dp.h"
 #include "layerFactory.h"
+#include "concatenation.h"
+#include "conv2d.h"
+#include "separableconvolution.h"
+#include "addlayer.h"
+#include "activation.h"
+#include "invertedresidual.h"
+#include "upsampling2d.h"
+#ifdef SUPPORT_GL
+    #include "inferencepassGL.h"
+#endif
+#ifdef SUPPORT_VULKAN
+    #include "inferencepassVulkan.h"
+#endif
 #include <string>
 #include <algorithm>
 #include <sstream>
@@ -24,6 +37,8 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <deque>
+#include <cmath>
+#include <numeric>
 
 using namespace snn;
 using namespace snn::dp;
@@ -113,9 +128,10 @@ void null_deleter(snn::dp::GenericModelLayer* layer) {
 }
 
 std::vector<std::shared_ptr<GenericModelLayer>> snn::dp::loadFromJsonModel(const std::string& fileName, bool useVulkan, const MRTMode& mrtMode,
-                                                                           const WeightAccessMethod& weightMode, bool preferHp) {
+                                                                           const WeightAccessMethod& weightMode, bool preferHp,
+                                                                           const std::map<uint32_t, bool>& layerHalfPrecision) {
     std::vector<std::shared_ptr<GenericModelLayer>> layers;
-    ModelParser parser({fileName, preferHp, mrtMode, weightMode});
+    ModelParser parser({fileName, preferHp, mrtMode, weightMode, layerHalfPrecision});
     int32_t layerCount = parser.getLayerCount();
     int headNodeIndex  = -1;
     std::string kernel; // kernel name (for creating layer name)
@@ -166,12 +182,483 @@ std::vector<std::shared_ptr<GenericModelLayer>> snn::dp::loadFromJsonModel(const
     return layers;
 }
 
+// Checks if the layer is listed in ShaderGenOptions::outputLayers, so it has to keep its own output texture
+static bool isOutputLayer(const std::string& name, const ShaderGenOptions& options) {
+    return std::any_of(options.outputLayers.begin(), options.outputLayers.end(),
+                       [&](const std::string& outputLayer) { return InferenceGraph::matchLayerName(name, outputLayer); });
+}
+
+// Lets the producers of concatenation layers write directly into layer ranges of the concatenation output,
+// so that the concatenation itself becomes a no-op.
+// It is possible only when every input starts at a 4-channel boundary and all involved layers are fragment shader
+// layers (a render target layer is selected when the output texture is attached to the frame buffer).
+// Otherwise concatenation falls back to copying its inputs.
+// params:
+//  graph - inference graph
+//  l2s - map from inference graph layers to model layers
+//  options - shader generating options
+// returns:
+//  number of eliminated concatenation layers
+static uint32_t planZeroCopyConcatenation(InferenceGraph& graph, std::map<InferenceGraph::Layer*, std::shared_ptr<GenericModelLayer>>& l2s,
+                                          const ShaderGenOptions& options) {
+    uint32_t numConcats    = 0;
+    uint32_t numEliminated = 0;
+    for (size_t i = 0; i < graph.layers.size(); ++i) {
+        auto igLayer = graph.layers[i].get();
+        auto concatLayer = std::dynamic_pointer_cast<ConcatenateLayer>(l2s[igLayer]);
+        if (!concatLayer) {
+            continue;
+        }
+        numConcats++;
+        // The last layer output can be replaced by the model output image at runtime
+        if (igLayer->layerLoc != InferenceGraph::LayerExecutionType::GPU_FS || i == graph.layers.size() - 1) {
+            continue;
+        }
+        std::vector<uint32_t> planeOffsets;
+        if (!concatLayer->getInputPlaneOffsets(planeOffsets) || planeOffsets.size() != igLayer->inputRefs.size()) {
+            SNN_LOGD("Concatenation %s: inputs are not 4-channel aligned, keep copying", igLayer->name.c_str());
+            continue;
+        }
+        bool canAlias = true;
+        std::set<int> producers;
+        for (size_t j = 0; j < igLayer->inputRefs.size() && canAlias; ++j) {
+            const auto& ref = igLayer->inputRefs[j];
+            if (!ref.isStageOutput || !producers.insert(ref.index).second) {
+                canAlias = false;
+                break;
+            }
+            auto producer = graph.layers[ref.index].get();
+            const auto& producerDesc = producer->outputDesc;
+            canAlias = producer->layerLoc == InferenceGraph::LayerExecutionType::GPU_FS && !producer->isNoOp &&
+                       producer->outputAlias.index < 0 && l2s[producer]->nextLayers.size() == 1 && !isOutputLayer(producer->name, options) &&
+                       producerDesc.width == igLayer->outputDesc.width && producerDesc.height == igLayer->outputDesc.height &&
+                       producerDesc.format == igLayer->outputDesc.format &&
+                       planeOffsets[j] + producerDesc.depth <= igLayer->outputDesc.depth;
+        }
+        if (!canAlias) {
+            continue;
+        }
+        for (size_t j = 0; j < igLayer->inputRefs.size(); ++j) {
+            auto producer = graph.layers[igLayer->inputRefs[j].index].get();
+            producer->outputAlias.index       = (int) i;
+            producer->outputAlias.planeOffset = planeOffsets[j];
+            l2s[producer]->setOutputPlaneOffset(planeOffsets[j]);
+        }
+        igLayer->isNoOp = true;
+        numEliminated++;
+        SNN_LOGD("Concatenation %s is replaced by aliased producer outputs", igLayer->name.c_str());
+    }
+    if (numConcats > 0) {
+        SNN_LOGI("Zero-copy concatenation: %u of %u concatenation layers eliminated", numEliminated, numConcats);
+    }
+    return numEliminated;
+}
+
+// Checks if a layer is a 1x1 convolution without stride and padding, that can be a part of the fused inverted residual block
+static std::shared_ptr<Conv2DLayer> asPointwiseConvolution(const std::shared_ptr<GenericModelLayer>& layer) {
+    auto conv = std::dynamic_pointer_cast<Conv2DLayer>(layer);
+    if (!conv) {
+        return nullptr;
+    }
+    const auto& desc = conv->getConv2DDesc();
+    uint32_t padding[4];
+    conv->getPaddingOffset(padding);
+    if (desc.kernelSize != 1 || desc.stride != 1 || desc.useMultiInputs || padding[0] || padding[1] || padding[2] || padding[3] ||
+        !InvertedResidualLayer::isActivationSupported(desc.activation) || layer->prevLayers.size() != 1) {
+        return nullptr;
+    }
+    return conv;
+}
+
+// Replaces MobileNetV2 style inverted residual blocks: expand 1x1 convolution -> depthwise 3x3 convolution ->
+// project 1x1 convolution (-> add of the block input) with a single fused layer, that keeps the expanded
+// activations on chip instead of writing them to textures.
+// Only compute shader backends (GL compute shaders and Vulkan) have the fused kernel.
+// params:
+//  layers - model layers. Fused layers are removed from the collection, the new layers are appended.
+//  options - shader generating options
+// returns:
+//  number of fused blocks
+static uint32_t fuseInvertedResidualBlocks(InferenceModel& layers, const ShaderGenOptions& options) {
+    if (!options.compute && !options.vulkan) {
+        return 0;
+    }
+    uint32_t numFused = 0;
+    std::set<std::shared_ptr<GenericModelLayer>> fusedLayers;
+    InferenceModel newLayers;
+    for (auto& layer : layers) {
+        if (fusedLayers.count(layer)) {
+            continue;
+        }
+        auto expand = asPointwiseConvolution(layer);
+        if (!expand || expand->nextLayers.size() != 1) {
+            continue;
+        }
+        auto depthwise = std::dynamic_pointer_cast<SeparableConv2DLayer>(expand->nextLayers[0]);
+        if (!depthwise || depthwise->prevLayers.size() != 1 || depthwise->nextLayers.size() != 1) {
+            continue;
+        }
+        const auto& dwDesc = depthwise->getSeparableConv2DDesc();
+        if (dwDesc.kernelSize != 3 || (dwDesc.stride != 1 && dwDesc.stride != 2) || dwDesc.numInputPlanes != dwDesc.numOutputPlanes ||
+            dwDesc.numInputPlanes != expand->getConv2DDesc().numOutputPlanes || !InvertedResidualLayer::isActivationSupported(dwDesc.activation)) {
+            continue;
+        }
+        auto project = asPointwiseConvolution(depthwise->nextLayers[0]);
+        if (!project || project->getConv2DDesc().numInputPlanes != dwDesc.numOutputPlanes) {
+            continue;
+        }
+        // The fused kernel runs in one precision
+        bool preferHp = expand->getDesc().preferHp;
+        if (depthwise->getDesc().preferHp != preferHp || project->getDesc().preferHp != preferHp) {
+            continue;
+        }
+        auto blockInput = expand->prevLayers[0];
+
+        InvertedResidualDesc desc;
+        (CommonLayerDesc&) desc = expand->getDesc();
+        desc.expand             = expand->getConv2DDesc();
+        desc.depthwise          = dwDesc;
+        desc.project            = project->getConv2DDesc();
+        desc.numInputPlanes     = desc.expand.numInputPlanes;
+        desc.numOutputPlanes    = desc.project.numOutputPlanes;
+        depthwise->getPaddingOffset(desc.padding);
+
+        // The residual add is fused, if it adds the block input to the project output
+        std::shared_ptr<GenericModelLayer> lastLayer = project;
+        if (project->nextLayers.size() == 1 && dwDesc.stride == 1 && desc.numInputPlanes == desc.numOutputPlanes) {
+            auto add = std::dynamic_pointer_cast<AddLayer>(project->nextLayers[0]);
+            if (add && add->prevLayers.size() == 2 && add->getDesc().preferHp == preferHp &&
+                InvertedResidualLayer::isActivationSupported(add->getAddDesc().activation) &&
+                ((add->prevLayers[0] == project && add->prevLayers[1] == blockInput) ||
+                 (add->prevLayers[1] == project && add->prevLayers[0] == blockInput))) {
+                desc.residual               = true;
+                desc.residualActivation     = add->getAddDesc().activation;
+                desc.residualLeakyReluAlpha = add->getAddDesc().leakyReluAlpha;
+                lastLayer                   = add;
+            }
+        }
+        // Outputs of the fused layers are not stored anywhere
+        if (isOutputLayer(expand->getName(), options) || isOutputLayer(depthwise->getName(), options) || isOutputLayer(project->getName(), options) ||
+            isOutputLayer(lastLayer->getName(), options)) {
+            SNN_LOGD("Inverted residual block %s is not fused: its layers are requested as outputs", expand->getName().c_str());
+            continue;
+        }
+
+        // Owned the same way as the layers, created by loadFromJsonModel()
+        std::shared_ptr<GenericModelLayer> fused(InvertedResidualCreator1(std::move(desc), options.vulkan), &null_deleter);
+        const auto& expandName = expand->getName();
+        fused->setName(expandName.substr(0, expandName.rfind(']') + 1) + " InvertedResidual");
+
+        // Connect the fused layer in place of the block
+        fused->prevLayers.push_back(blockInput);
+        std::replace(blockInput->nextLayers.begin(), blockInput->nextLayers.end(), std::static_pointer_cast<GenericModelLayer>(expand), fused);
+        if (lastLayer != project) {
+            blockInput->nextLayers.erase(std::remove(blockInput->nextLayers.begin(), blockInput->nextLayers.end(), lastLayer), blockInput->nextLayers.end());
+        }
+        fused->nextLayers = lastLayer->nextLayers;
+        for (auto& next : fused->nextLayers) {
+            std::replace(next->prevLayers.begin(), next->prevLayers.end(), lastLayer, fused);
+        }
+
+        fusedLayers.insert(expand);
+        fusedLayers.insert(depthwise);
+        fusedLayers.insert(project);
+        fusedLayers.insert(lastLayer);
+        newLayers.push_back(fused);
+        numFused++;
+        SNN_LOGD("Fused inverted residual block: %s (residual: %d)", fused->getName().c_str(), lastLayer != project);
+    }
+    if (numFused > 0) {
+        layers.erase(std::remove_if(layers.begin(), layers.end(), [&](const std::shared_ptr<GenericModelLayer>& l) { return fusedLayers.count(l) > 0; }),
+                     layers.end());
+        layers.insert(layers.end(), newLayers.begin(), newLayers.end());
+    }
+    return numFused;
+}
+
+// Removes upsampling layers, that feed only 2D convolutions, and lets the convolutions read the low resolution
+// input through the upsampling index transform (see Conv2DLayer::setInputUpsampling()). The upsampled tensor,
+// that is scale^2 times larger than its input, is then neither written nor read.
+// Only nearest and bilinear upsampling with integer scales is fused. Upsampling layers after model inputs are kept,
+// so the first convolution of the model stays the same.
+// params:
+//  layers - model layers. Fused upsampling layers are removed from the collection.
+//  options - shader generating options
+// returns:
+//  number of fused upsampling layers
+static uint32_t fuseUpsamplingIntoConvolutions(InferenceModel& layers, const ShaderGenOptions& options) {
+    std::set<std::shared_ptr<GenericModelLayer>> fusedLayers;
+    for (auto& layer : layers) {
+        auto upsampling = std::dynamic_pointer_cast<UpSampling2DLayer>(layer);
+        if (!upsampling || upsampling->prevLayers.size() != 1 || upsampling->nextLayers.empty() || upsampling->prevLayers[0]->isInputLayer()) {
+            continue;
+        }
+        const auto& desc = upsampling->getUpSampling2DDesc();
+        bool bilinear    = desc.interpolationType == "bilinear";
+        if ((!bilinear && desc.interpolationType != "nearest") || desc.scale < 2.0f || desc.scale != std::floor(desc.scale)) {
+            continue;
+        }
+        std::vector<std::shared_ptr<Conv2DLayer>> convolutions;
+        for (auto& next : upsampling->nextLayers) {
+            auto conv = std::dynamic_pointer_cast<Conv2DLayer>(next);
+            if (!conv || conv->prevLayers.size() != 1 || conv->getConv2DDesc().useMultiInputs || conv->getInputUpsampling() != 1) {
+                break;
+            }
+            convolutions.push_back(conv);
+        }
+        if (convolutions.size() != upsampling->nextLayers.size()) {
+            continue;
+        }
+        // The upsampled tensor is not stored anywhere
+        if (isOutputLayer(upsampling->getName(), options)) {
+            SNN_LOGD("Upsampling %s is not fused: it is requested as an output", upsampling->getName().c_str());
+            continue;
+        }
+
+        // Connect the convolutions to the upsampling input
+        auto input = upsampling->prevLayers[0];
+        input->nextLayers.erase(std::remove(input->nextLayers.begin(), input->nextLayers.end(), layer), input->nextLayers.end());
+        for (auto& conv : convolutions) {
+            conv->setInputUpsampling((uint32_t) desc.scale, bilinear);
+            conv->prevLayers[0] = input;
+            input->nextLayers.push_back(conv);
+        }
+        upsampling->prevLayers.clear();
+        upsampling->nextLayers.clear();
+        fusedLayers.insert(layer);
+        SNN_LOGD("Fused %s upsampling %s into %zu convolutions", desc.interpolationType.c_str(), upsampling->getName().c_str(), convolutions.size());
+    }
+    if (!fusedLayers.empty()) {
+        layers.erase(std::remove_if(layers.begin(), layers.end(), [&](const std::shared_ptr<GenericModelLayer>& l) { return fusedLayers.count(l) > 0; }),
+                     layers.end());
+    }
+    return (uint32_t) fusedLayers.size();
+}
+
+// Gets the format of the layer output texture. Input layers pass the model input images through,
+// so they keep the model precision, other layers follow their own (possibly overridden) precision.
+static ColorFormat getOutputFormat(const std::shared_ptr<GenericModelLayer>& layer, const ShaderGenOptions& options) {
+    bool halfPrecision = layer->isInputLayer() ? options.preferrHalfPrecision : layer->getDesc().preferHp;
+    return halfPrecision ? ColorFormat::RGBA16F : ColorFormat::RGBA32F;
+}
+
+// Inserts precision conversion layers between layers of different precisions.
+// GL compute shaders read their inputs as images with the format qualifier of the layer precision,
+// so an input, stored in another format, is converted by a linear activation layer first.
+// Fragment shaders and Vulkan shaders read their inputs through samplers and don't need conversions.
+// params:
+//  layers - model layers. The conversion layers are appended.
+//  options - shader generating options
+// returns:
+//  number of inserted conversion layers
+static uint32_t insertPrecisionConversions(InferenceModel& layers, const ShaderGenOptions& options) {
+    bool anyCompute = options.compute || std::any_of(options.layerCompute.begin(), options.layerCompute.end(), [](const auto& p) { return p.second; });
+    if (!anyCompute || options.vulkan || options.layerHalfPrecision.empty()) {
+        return 0;
+    }
+    InferenceModel newLayers;
+    for (auto& producer : layers) {
+        bool producerHp = getOutputFormat(producer, options) == ColorFormat::RGBA16F;
+        // One conversion layer per producer and target precision is shared by all consumers
+        std::shared_ptr<GenericModelLayer> conversion;
+        auto consumers = producer->nextLayers;
+        for (auto& consumer : consumers) {
+            bool consumerHp = consumer->getDesc().preferHp;
+            if (consumerHp == producerHp) {
+                continue;
+            }
+            if (!conversion) {
+                ActivationDesc desc;
+                (CommonLayerDesc&) desc = producer->getDesc();
+                desc.numInputPlanes     = desc.numOutputPlanes;
+                desc.preferHp           = consumerHp;
+                desc.isInputLayer       = false;
+                desc.activation         = "linear";
+                desc.leakyReluAlpha     = 0.0f;
+                // Owned the same way as the layers, created by loadFromJsonModel()
+                conversion.reset(ActivationCreator1(std::move(desc), false), &null_deleter);
+                conversion->setName(producer->getName() + (consumerHp ? " to FP16" : " to FP32"));
+                conversion->prevLayers.push_back(producer);
+                producer->nextLayers.push_back(conversion);
+                newLayers.push_back(conversion);
+            }
+            producer->nextLayers.erase(std::remove(producer->nextLayers.begin(), producer->nextLayers.end(), consumer), producer->nextLayers.end());
+            std::replace(consumer->prevLayers.begin(), consumer->prevLayers.end(), producer, conversion);
+            conversion->nextLayers.push_back(consumer);
+            SNN_LOGD("Precision conversion: %s -> %s", producer->getName().c_str(), consumer->getName().c_str());
+        }
+    }
+    layers.insert(layers.end(), newLayers.begin(), newLayers.end());
+    if (!newLayers.empty()) {
+        SNN_LOGI("Inserted %zu precision conversion layers", newLayers.size());
+    }
+    return (uint32_t) newLayers.size();
+}
+
+// Selects the layer outputs, that are kept in NC4HW4 storage buffers instead of textures (see ShaderGenOptions::bufferActivations).
+// An output is a buffer, if the layer and all its consumers have buffer compute shaders. Input layers, requested outputs
+// and the last layers keep textures, so the graph inputs and outputs are converted by the first and the last buffer layers.
+// params:
+//  layers - model layers
+//  options - shader generating options
+// returns:
+//  number of buffer outputs
+static uint32_t planBufferActivations(const InferenceModel& layers, const ShaderGenOptions& options) {
+    if (options.bufferActivations && options.vulkan) {
+        SNN_LOGW("Storage buffer activations are not supported by the Vulkan backend, textures are used");
+    }
+    if (!options.bufferActivations || !options.compute || options.vulkan || options.dynamicShapes) {
+        return 0;
+    }
+    uint32_t numBuffers = 0;
+    for (auto& layer : layers) {
+        bool buffer = !layer->isInputLayer() && layer->supportsBufferActivations() && !layer->nextLayers.empty() &&
+                      !isOutputLayer(layer->getName(), options) &&
+                      std::all_of(layer->nextLayers.begin(), layer->nextLayers.end(), [](const auto& next) { return next->supportsBufferActivations(); });
+        layer->setOutputBuffer(buffer);
+        numBuffers += buffer ? 1 : 0;
+    }
+    SNN_LOGI("%u of %zu layer outputs are storage buffers", numBuffers, layers.size());
+    return numBuffers;
+}
+
+// Logs the number of fused inverted residual blocks and the texture traffic they do not produce
+// params:
+//  graph - inference graph
+//  l2s - map from inference graph layers to model layers
+static void logFusedBlocks(const InferenceGraph& graph, std::map<InferenceGraph::Layer*, std::shared_ptr<GenericModelLayer>>& l2s) {
+    if (graph.numFusedBlocks == 0) {
+        return;
+    }
+    uint64_t bytes = 0;
+    for (auto& igLayer : graph.layers) {
+        auto fused = std::dynamic_pointer_cast<InvertedResidualLayer>(l2s[igLayer.get()]);
+        if (fused) {
+            bytes += fused->getEliminatedTrafficBytes();
+        }
+    }
+    SNN_LOGI("Fused %u inverted residual blocks, %.2f MB of intermediate texture traffic per inference eliminated", graph.numFusedBlocks,
+             bytes / (1024.0 * 1024.0));
+}
+
+// Gets the number of render or compute passes of a layer
+static uint32_t getNumPasses(const InferencePasses* passes) {
+    if (!passes) {
+        return 0;
+    }
+    switch (passes->backendType) {
+#ifdef SUPPORT_GL
+    case GpuBackendType::GL:
+        return (uint32_t) InferencePassesGl::cast(passes)->passes.size();
+#endif
+#ifdef SUPPORT_VULKAN
+    case GpuBackendType::VULKAN:
+        return (uint32_t) InferencePassesVulkan::cast(passes)->passes.size();
+#endif
+    default:
+        return 0;
+    }
+}
+
+static uint64_t getTextureBytes(const InferenceGraph::IODesc& desc) {
+    return (uint64_t) getColorFormatDesc(desc.format).calcImageSizeInBytes(desc.width, desc.height) * desc.depth;
+}
+
+// Logs the number of upsampling layers fused into convolutions and the texture traffic they do not produce:
+// the upsampling pass (reading the input and writing the upsampled tensor) and the reads of the upsampled tensor
+// by the convolutions, which read the smaller input instead.
+// params:
+//  graph - inference graph
+//  l2s - map from inference graph layers to model layers
+static void logFusedUpsamplings(const InferenceGraph& graph, std::map<InferenceGraph::Layer*, std::shared_ptr<GenericModelLayer>>& l2s) {
+    if (graph.numFusedUpsamplings == 0) {
+        return;
+    }
+    uint64_t bytes           = 0;
+    uint32_t numConvolutions = 0;
+    // Convolutions of one fused upsampling layer have the same input and scale
+    std::set<std::pair<int, uint32_t>> upsamplings;
+    for (auto& igLayer : graph.layers) {
+        auto conv = std::dynamic_pointer_cast<Conv2DLayer>(l2s[igLayer.get()]);
+        if (!conv || conv->getInputUpsampling() == 1 || igLayer->inputRefs.empty() || igLayer->inputRefs[0].index < 0) {
+            continue;
+        }
+        uint32_t scale         = conv->getInputUpsampling();
+        uint64_t inputBytes    = getTextureBytes(graph.layers[igLayer->inputRefs[0].index]->outputDesc);
+        uint64_t upsampleBytes = inputBytes * scale * scale;
+        bytes += upsampleBytes - inputBytes;
+        if (upsamplings.emplace(igLayer->inputRefs[0].index, scale).second) {
+            bytes += inputBytes + upsampleBytes;
+        }
+        numConvolutions++;
+    }
+    SNN_LOGI("Fused %u upsampling layers into %u convolutions, %.2f MB of intermediate texture traffic per inference eliminated", graph.numFusedUpsamplings,
+             numConvolutions, bytes / (1024.0 * 1024.0));
+}
+
+// Estimates the static cost of every layer: arithmetic work, texture and weight traffic and the number of passes.
+// Every pass is assumed to read all layer inputs once (a fragment shader pass of a MRT split layer
+// produces only a part of the output channels), neighbor pixel reads are assumed to hit the texture cache.
+// params:
+//  graph - inference graph
+//  l2s - map from inference graph layers to model layers
+static void estimateLayerCosts(InferenceGraph& graph, std::map<InferenceGraph::Layer*, std::shared_ptr<GenericModelLayer>>& l2s) {
+    InferenceGraph::LayerCost total;
+    for (auto& igLayer : graph.layers) {
+        InferenceGraph::LayerCost& cost = igLayer->cost;
+        cost = {};
+        if (igLayer->isInputLayer || igLayer->isNoOp) {
+            continue;
+        }
+        const auto& modelLayer = l2s[igLayer.get()];
+        uint64_t numWeights = 0;
+        modelLayer->getArithmeticCost(cost.macs, numWeights);
+        cost.numPasses = getNumPasses(modelLayer->getPasses());
+        uint64_t inputBytes = 0;
+        for (const auto& inputRef : igLayer->inputRefs) {
+            if (inputRef.index >= 0) {
+                inputBytes += getTextureBytes(graph.layers[inputRef.index]->outputDesc);
+            }
+        }
+        cost.bytesRead    = inputBytes * std::max(cost.numPasses, 1U);
+        cost.weightBytes  = numWeights * (modelLayer->getDesc().preferHp ? 2 : 4);
+        cost.bytesWritten = getTextureBytes(igLayer->outputDesc);
+        SNN_LOGV("Layer %s: %.3f MMACs, %.3f MB read, %.3f MB weights, %.3f MB written, %u passes", igLayer->name.c_str(), cost.macs / 1e6,
+                 cost.bytesRead / 1e6, cost.weightBytes / 1e6, cost.bytesWritten / 1e6, cost.numPasses);
+        total.macs += cost.macs;
+        total.bytesRead += cost.bytesRead;
+        total.weightBytes += cost.weightBytes;
+        total.bytesWritten += cost.bytesWritten;
+        total.numPasses += cost.numPasses;
+    }
+    SNN_LOGI("Static cost per inference: %.3f GMACs, %.2f MB of textures read, %.2f MB of weights, %.2f MB written, %u passes", total.macs / 1e9,
+             total.bytesRead / 1e6, total.weightBytes / 1e6, total.bytesWritten / 1e6, total.numPasses);
+}
+
 InferenceGraph snn::dp::generateInferenceGraph(std::shared_ptr<GenericModelLayer> head, const ShaderGenOptions& options) {
+    uint32_t numFusedBlocks      = 0;
+    uint32_t numFusedUpsamplings = 0;
+    InferenceModel reachableLayers;
+    BFSTraverse(
+        head, [](std::shared_ptr<GenericModelLayer> s) { return s->nextLayers; },
+        [&](std::shared_ptr<GenericModelLayer> current) { reachableLayers.push_back(current); });
+    if (options.fuseInvertedResidual) {
+        numFusedBlocks = fuseInvertedResidualBlocks(reachableLayers, options);
+    }
+    // After the inverted residual blocks: the fused block kernel reads its input as is
+    if (options.fuseUpsampling) {
+        numFusedUpsamplings = fuseUpsamplingIntoConvolutions(reachableLayers, options);
+    }
+    insertPrecisionConversions(reachableLayers, options);
+    uint32_t numBufferActivations = planBufferActivations(reachableLayers, options);
     // generate an topological sorted shader list
     auto modelLayers = topologicalSort(head);
     InferenceGraph graph;
-    graph.mrtMode    = options.mrtMode;
-    graph.weightMode = options.weightMode;
+    graph.mrtMode              = options.mrtMode;
+    graph.weightMode           = options.weightMode;
+    graph.numFusedBlocks       = numFusedBlocks;
+    graph.numFusedUpsamplings  = numFusedUpsamplings;
+    graph.numBufferActivations = numBufferActivations;
     std::map<std::shared_ptr<GenericModelLayer>, InferenceGraph::Layer*> s2l;
     std::map<InferenceGraph::Layer*, std::shared_ptr<GenericModelLayer>> l2s;
 
@@ -187,12 +674,17 @@ InferenceGraph snn::dp::generateInferenceGraph(std::shared_ptr<GenericModelLayer
             modelLayer->computeImageTexture(inputMat, outputMat);
         };
 
-        igLayer->initFunPtr = [modelLayer](DeviceBackend *backend, ImageTextureArray& inputMat, ImageTextureArray& outputMat) {
-            modelLayer->init(backend, inputMat, outputMat);
+        igLayer->compileFunPtr = [modelLayer](DeviceBackend *backend) {
+            return modelLayer->compile(backend);
+        };
+
+        igLayer->initFunPtr = [modelLayer](DeviceBackend *backend, ImageTextureArray& inputMat, ImageTextureArray& outputMat,
+                                           std::vector<std::shared_ptr<RenderPass>>& renderPasses) {
+            modelLayer->init(backend, inputMat, outputMat, renderPasses);
         };
 
-        igLayer->runFunPtr = [modelLayer](DeviceBackend *backend, bool dumpOutputs) {
-            modelLayer->run(backend, dumpOutputs);
+        igLayer->runFunPtr = [modelLayer](DeviceBackend *backend, const std::vector<std::shared_ptr<RenderPass>>& renderPasses, bool dumpOutputs) {
+            modelLayer->run(backend, renderPasses, dumpOutputs);
         };
 
         s2l[modelLayer] = igLayer;
@@ -323,10 +815,12 @@ InferenceGraph snn::dp::generateInferenceGraph(std::shared_ptr<GenericModelLayer
                 SNN_LOGD("%%%%%%%% layer: %zu, name : %s, output dim: %d %d %d loc: %d", i, modelLayer->getName().c_str(), width, height, depth,
                     (int)igLayer->layerLoc);
             }
-            igLayer->layerLoc  = modelLayer->getLayerExecutionType();
+            igLayer->layerLoc     = modelLayer->getLayerExecutionType();
+            igLayer->signature    = modelLayer->getSignature();
+            igLayer->bufferOutput = modelLayer->isOutputBuffer();
 
             igLayer->outputDesc = {
-                options.preferrHalfPrecision ? ColorFormat::RGBA16F : ColorFormat::RGBA32F, width, height,
+                getOutputFormat(modelLayer, options), width, height,
                     DIV_4_ROUND_UP(modelLayer->getDesc().numOutputPlanes),
                 modelLayer->getDesc().numOutputPlanes
             };
@@ -376,6 +870,13 @@ InferenceGraph snn::dp::generateInferenceGraph(std::shared_ptr<GenericModelLayer
 
     graph.inputsDesc = options.desiredInput;
 
+    if (options.zeroCopyConcat) {
+        graph.numEliminatedConcats = planZeroCopyConcatenation(graph, l2s, options);
+    }
+    logFusedBlocks(graph, l2s);
+    logFusedUpsamplings(graph, l2s);
+    estimateLayerCosts(graph, l2s);
+
     modelFormat << "================================================================\n";
     SNN_LOGI("\n%s", modelFormat.str().c_str());
     return graph;
@@ -430,11 +931,25 @@ std::vector<std::shared_ptr<GenericModelLayer>> topologicalSort2(const std::vect
 
 // This new generateInferenceGraph support multiple inputs with new topological sort algorithm.
 InferenceGraph snn::dp::generateInferenceGraph(std::vector<std::shared_ptr<GenericModelLayer>> &layers, const ShaderGenOptions& options) {
+    uint32_t numFusedBlocks      = 0;
+    uint32_t numFusedUpsamplings = 0;
+    if (options.fuseInvertedResidual) {
+        numFusedBlocks = fuseInvertedResidualBlocks(layers, options);
+    }
+    // After the inverted residual blocks: the fused block kernel reads its input as is
+    if (options.fuseUpsampling) {
+        numFusedUpsamplings = fuseUpsamplingIntoConvolutions(layers, options);
+    }
+    insertPrecisionConversions(layers, options);
+    uint32_t numBufferActivations = planBufferActivations(layers, options);
     // generate an topological sorted shader list
     auto modelLayers = topologicalSort2(layers);
     InferenceGraph graph;
-    graph.mrtMode    = options.mrtMode;
-    graph.weightMode = options.weightMode;
+    graph.mrtMode              = options.mrtMode;
+    graph.weightMode           = options.weightMode;
+    graph.numFusedBlocks       = numFusedBlocks;
+    graph.numFusedUpsamplings  = numFusedUpsamplings;
+    graph.numBufferActivations = numBufferActivations;
     std::map<std::shared_ptr<GenericModelLayer>, InferenceGraph::Layer*> s2l;
     std::map<InferenceGraph::Layer*, std::shared_ptr<GenericModelLayer>> l2s;
 
@@ -450,12 +965,17 @@ InferenceGraph snn::dp::generateInferenceGraph(std::vector<std::shared_ptr<Gener
             modelLayer->computeImageTexture(inputMat, outputMat);
         };
 
-        igLayer->initFunPtr = [modelLayer](DeviceBackend *backend, ImageTextureArray& inputMat, ImageTextureArray& outputMat) {
-            modelLayer->init(backend, inputMat, outputMat);
+        igLayer->compileFunPtr = [modelLayer](DeviceBackend *backend) {
+            return modelLayer->compile(backend);
+        };
+
+        igLayer->initFunPtr = [modelLayer](DeviceBackend *backend, ImageTextureArray& inputMat, ImageTextureArray& outputMat,
+                                           std::vector<std::shared_ptr<RenderPass>>& renderPasses) {
+            modelLayer->init(backend, inputMat, outputMat, renderPasses);
         };
 
-        igLayer->runFunPtr = [modelLayer](DeviceBackend *backend, bool dumpOutputs) {
-            modelLayer->run(backend, dumpOutputs);
+        igLayer->runFunPtr = [modelLayer](DeviceBackend *backend, const std::vector<std::shared_ptr<RenderPass>>& renderPasses, bool dumpOutputs) {
+            modelLayer->run(backend, renderPasses, dumpOutputs);
         };
 
         s2l[modelLayer] = igLayer;
@@ -584,10 +1104,12 @@ InferenceGraph snn::dp::generateInferenceGraph(std::vector<std::shared_ptr<Gener
             } else {
                 modelLayer->createInferencePasses(opt);
             }
-            igLayer->layerLoc  = modelLayer->getLayerExecutionType();
+            igLayer->layerLoc     = modelLayer->getLayerExecutionType();
+            igLayer->signature    = modelLayer->getSignature();
+            igLayer->bufferOutput = modelLayer->isOutputBuffer();
 
             igLayer->outputDesc = {
-                options.preferrHalfPrecision ? ColorFormat::RGBA16F : ColorFormat::RGBA32F, width, height,
+                getOutputFormat(modelLayer, options), width, height,
                     DIV_4_ROUND_UP(modelLayer->getDesc().numOutputPlanes),
                 modelLayer->getDesc().numOutputPlanes
             };
@@ -634,7 +1156,59 @@ InferenceGraph snn::dp::generateInferenceGraph(std::vector<std::shared_ptr<Gener
 
     graph.inputsDesc = options.desiredInput;
 
+    if (options.zeroCopyConcat) {
+        graph.numEliminatedConcats = planZeroCopyConcatenation(graph, l2s, options);
+    }
+    logFusedBlocks(graph, l2s);
+    logFusedUpsamplings(graph, l2s);
+    estimateLayerCosts(graph, l2s);
+
     modelFormat << "================================================================\n";
     SNN_LOGI("\n%s", modelFormat.str().c_str());
     return graph;
 }
+
+bool snn::dp::getReceptiveFieldHalo(const InferenceModel& layers, uint32_t& halo, float& outputScale, uint32_t& alignment) {
+    // Receptive field radius and step between neighbor output pixels, both in model input pixels
+    struct Footprint {
+        float radius = 0.0f;
+        float step   = 1.0f;
+    };
+    std::map<std::shared_ptr<GenericModelLayer>, Footprint> footprints;
+    auto sortedLayers = topologicalSort2(layers);
+    Footprint last;
+    halo        = 0;
+    outputScale = 1.0f;
+    alignment   = 1;
+    for (auto& layer : sortedLayers) {
+        Footprint input;
+        for (auto& prevLayer : layer->prevLayers) {
+            const Footprint& prev = footprints[prevLayer];
+            input.radius = std::max(input.radius, prev.radius);
+            input.step   = std::max(input.step, prev.step);
+        }
+        Footprint& current = footprints[layer];
+        if (layer->isInputLayer()) {
+            current = input;
+        } else {
+            uint32_t kernelRadius = 0;
+            float scale           = 1.0f;
+            if (!layer->getSpatialFootprint(kernelRadius, scale)) {
+                SNN_LOGD("Layer %s output depends on the whole input", layer->getName().c_str());
+                return false;
+            }
+            current.radius = input.radius + kernelRadius * input.step;
+            current.step   = input.step / scale;
+        }
+        // Intermediate strides matter, even if later layers upsample back to the input resolution
+        uint32_t stride = static_cast<uint32_t>(std::lround(current.step));
+        if (stride > 1) {
+            alignment = std::lcm(alignment, stride);
+        }
+        last = current;
+    }
+    halo        = static_cast<uint32_t>(std::ceil(last.radius));
+    outputScale = 1.0f / last.step;
+    SNN_LOGD("Receptive field halo: %u, output scale: %f, alignment: %u", halo, outputScale, alignment);
+    return true;
+}
@@ -33,10 +33,12 @@ namespace dp { // short for Dynamic Pipeline
 //  mrtMode - MRT (multi rendering target) mode
 //  weightMode - weight access mode
 //  preferHp - flag to generate graph for FP16 calculations
+//  layerHalfPrecision - per-layer precision overrides, keyed by the layer index in the model file (see ShaderGenOptions)
 // returns:
 //  vector of shared pointers to model layers objects
 std::vector<std::shared_ptr<GenericModelLayer>> loadFromJsonModel(const std::string& fileName, bool useVulkan, const MRTMode& mrtMode,
-                                                                  const WeightAccessMethod& weightMode, bool preferHp = true);
+                                                                  const WeightAccessMethod& weightMode, bool preferHp = true,
+                                                                  const std::map<uint32_t, bool>& layerHalfPrecision = {});
 
 typedef std::vector<std::shared_ptr<GenericModelLayer>> InferenceModel;
 
@@ -56,5 +58,18 @@ InferenceGraph generateInferenceGraph(const std::shared_ptr<GenericModelLayer> f
 //  an inference graph
 InferenceGraph generateInferenceGraph(std::vector<std::shared_ptr<GenericModelLayer>> &layers, const ShaderGenOptions& options);
 
+// Calculates the receptive field halo of the model: the number of extra input pixels needed
+// at each side of an input region to calculate the model output for that region exactly.
+// params:
+//  layers - collection of model layers
+//  halo - receptive field halo in model input pixels
+//  outputScale - ratio of model output resolution to model input resolution
+//  alignment - least common multiple of the cumulative downsampling factors of all layers, in model input pixels.
+//              Input regions must start at its multiple to line up with the stride grid of every layer,
+//              also in models, that upsample the downsampled activations back.
+// returns:
+//  true if the model output is local (the model can be run tile by tile), false if not
+bool getReceptiveFieldHalo(const InferenceModel& layers, uint32_t& halo, float& outputScale, uint32_t& alignment);
+
 }; // namespace dp
 } // namespace snn
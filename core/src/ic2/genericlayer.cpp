@@ -15,20 +15,33 @@
 #include "pch.h"
 #include "genericlayer.h"
 #include "backend.h"
+#include <algorithm>
+#include <array>
+#include <sstream>
 #include <string>
 #include <utility>
 
 namespace snn {
 namespace dp {
 
+// Storage buffer binding points of buffer activations. Bindings 3..8 hold the weights of convolution layers.
+static constexpr uint32_t OUTPUT_BUFFER_BINDING = 9;
+static constexpr uint32_t INPUT_BUFFER_BINDING  = 10;
+
 GenericModelLayer::~GenericModelLayer() {
     prevLayers.clear();
     nextLayers.clear();
 }
 
-void GenericModelLayer::init(dp::DeviceBackend *backend, ImageTextureArray& inputMat, ImageTextureArray& outputMat) {
+bool GenericModelLayer::compile(dp::DeviceBackend *backend) {
+    SNN_LOGD("Layer compiled: %s", name.c_str());
+    return backend->compileRenderPasses(this);
+}
+
+void GenericModelLayer::init(dp::DeviceBackend *backend, ImageTextureArray& inputMat, ImageTextureArray& outputMat,
+                             std::vector<std::shared_ptr<RenderPass>>& renderPasses) {
     SNN_LOGD("Layer initialized: %s", name.c_str());
-    backend->initRenderPasses(this, inputMat, outputMat);
+    backend->initRenderPasses(this, inputMat, outputMat, renderPasses);
 }
 
 void GenericModelLayer::setName(const std::string& genericName) {
@@ -36,7 +49,7 @@ void GenericModelLayer::setName(const std::string& genericName) {
     SNN_LOGD("Layer name: %s", name.c_str());
 }
 
-void GenericModelLayer::run(snn::dp::DeviceBackend *, bool dumpOutputs) {
+void GenericModelLayer::run(snn::dp::DeviceBackend *, const std::vector<std::shared_ptr<RenderPass>>& renderPasses, bool dumpOutputs) {
     SNN_LOGD("Layer run: %s, %lu passes", name.c_str(), renderPasses.size());
 
     for (std::size_t passCount = 0; passCount < renderPasses.size(); ++passCount) {
@@ -89,6 +102,34 @@ void GenericModelLayer::getOutputDims(uint32_t& width, uint32_t& height, uint32_
     }
 }
 
+bool GenericModelLayer::getSpatialFootprint(uint32_t& kernelRadius, float& scale) const {
+    auto t       = getOutputScaleDimAdjustment();
+    kernelRadius = 0;
+    scale        = t.isFixed ? 1.0f : t.scaleWidth;
+    return !t.isFixed;
+}
+
+void GenericModelLayer::getArithmeticCost(uint64_t& macs, uint64_t& numWeights) const {
+    // One operation per output value
+    uint32_t width = 0, height = 0, depth = 0;
+    getOutputDims(width, height, depth);
+    macs       = (uint64_t) width * height * _desc.numOutputPlanes;
+    numWeights = 0;
+}
+
+std::string GenericModelLayer::getSignature() const {
+    // Layer names are "<model> layer [<index>] <type>"
+    auto typePos          = name.rfind("] ");
+    std::string signature = typePos == std::string::npos ? name : name.substr(typePos + 2);
+    for (const auto& dim : inputDims) {
+        signature += formatString(" %ux%ux%u", dim.width, dim.height, dim.channels);
+    }
+    uint32_t width = 0, height = 0, depth = 0;
+    getOutputDims(width, height, depth);
+    signature += formatString(" -> %ux%ux%u k%u %s", width, height, _desc.numOutputPlanes, _desc.kernelSize, _desc.preferHp ? "fp16" : "fp32");
+    return signature;
+}
+
 void ShaderLayer::createInferencePasses(const LayerGenOptions& options) {
     InferencePassesSptr ret;
     // Try create Vulkan shader, if the options says so.
@@ -96,15 +137,25 @@ void ShaderLayer::createInferencePasses(const LayerGenOptions& options) {
         ret = createCS(options);
         setLayerExecutionType(InferenceGraph::LayerExecutionType::GPU_VK);
     } else {
-        // auto executeLevel = getLayerExecutionType();
+        // Shader kind of this layer may be overridden by the measured placement
+        LayerGenOptions layerOptions = options;
+        auto placement               = options.layerCompute.find(getSignature());
+        if (placement != options.layerCompute.end()) {
+            layerOptions.compute = placement->second;
+        }
+        // Buffer activations are accessible by compute shaders only
+        if (isOutputBuffer() || std::any_of(prevLayers.begin(), prevLayers.end(), [](const auto& prev) { return prev->isOutputBuffer(); })) {
+            SNN_ASSERT(supportsBufferActivations());
+            layerOptions.compute = true;
+        }
         // Try create compute shader, if the options says so.
-        if ((options.compute)) {
-            ret = createCS(options);
+        if (layerOptions.compute) {
+            ret = createCS(layerOptions);
             setLayerExecutionType(InferenceGraph::LayerExecutionType::GPU_CS);
         }
         // Buf if the shader layer does not support compute shader yet, we'll fallback to fragment shader.
         if (!ret) {
-            ret = createFS(options);
+            ret = createFS(layerOptions);
             setLayerExecutionType(InferenceGraph::LayerExecutionType::GPU_FS);
         }
     }
@@ -126,5 +177,80 @@ void ShaderLayer::findAndReplace(std::string& s, const std::string& from, const
     }
 }
 
+void ShaderLayer::buildInputSizeDefines(std::ostream& stream, const LayerGenOptions& options, uint32_t inputScale) {
+    if (options.dynamicShapes) {
+        if (inputScale == 1) {
+            stream << "#define INPUT_WIDTH textureSize(inputTextures, 0).x\n";
+            stream << "#define INPUT_HEIGHT textureSize(inputTextures, 0).y\n";
+        } else {
+            stream << "#define INPUT_WIDTH (textureSize(inputTextures, 0).x * " << inputScale << ")\n";
+            stream << "#define INPUT_HEIGHT (textureSize(inputTextures, 0).y * " << inputScale << ")\n";
+        }
+    } else {
+        stream << "#define INPUT_WIDTH " << options.desiredInput[0].width * inputScale << "\n";
+        stream << "#define INPUT_HEIGHT " << options.desiredInput[0].height * inputScale << "\n";
+    }
+}
+
+// Declares an NC4HW4 storage buffer block. FP16 pixels are packed into uvec2 by packHalf2x16(),
+// so the buffer has the same layout as the layers of an RGBA16F texture.
+static void buildActivationBufferBlock(std::ostream& stream, const std::string& name, uint32_t binding, const char* access, bool halfPrecision,
+                                       const std::array<uint32_t, 3>& size) {
+    stream << "layout(std430, binding=" << binding << ") " << access << " buffer " << name << " {\n"
+           << "    " << (halfPrecision ? "uvec2" : "vec4") << " data[];\n"
+           << "} " << name << "Buffer;\n"
+           << "const ivec3 " << name << "BufferSize = ivec3(" << size[0] << ", " << size[1] << ", " << size[2] << ");\n"
+           << "bool " << name << "BufferContains(ivec3 p) { return all(greaterThanEqual(p, ivec3(0))) && all(lessThan(p, " << name << "BufferSize)); }\n"
+           << "int " << name << "BufferIndex(ivec3 p) { return (p.z * " << name << "BufferSize.y + p.y) * " << name << "BufferSize.x + p.x; }\n";
+}
+
+std::string ShaderLayer::buildComputeInputDeclaration(const std::string& name, uint32_t inputIndex, uint32_t binding, bool texture2D) const {
+    std::ostringstream stream;
+    if (inputIndex < prevLayers.size() && prevLayers[inputIndex]->isOutputBuffer()) {
+        const InferenceGraph::IODesc& dims = inputDims.at(inputIndex);
+        bool halfPrecision                 = dims.format == ColorFormat::RGBA16F;
+        buildActivationBufferBlock(stream, name, INPUT_BUFFER_BINDING + inputIndex, "readonly", halfPrecision, {dims.width, dims.height, dims.depth});
+        stream << "vec4 load_" << name << "(ivec3 p) {\n"
+               << "    if (!" << name << "BufferContains(p)) {\n"
+               << "        return vec4(0);\n"
+               << "    }\n";
+        if (halfPrecision) {
+            stream << "    uvec2 v = " << name << "Buffer.data[" << name << "BufferIndex(p)];\n"
+                   << "    return vec4(unpackHalf2x16(v.x), unpackHalf2x16(v.y));\n";
+        } else {
+            stream << "    return " << name << "Buffer.data[" << name << "BufferIndex(p)];\n";
+        }
+        stream << "}\n"
+               << "#define LOAD_" << name << "(p) load_" << name << "(p)\n";
+    } else {
+        stream << "layout(OUTPUT_FORMAT, binding=" << binding << ") readonly uniform PRECISION " << (texture2D ? "image2D " : "image2DArray ") << name << ";\n"
+               << "#define LOAD_" << name << "(p) imageLoad(" << name << ", " << (texture2D ? "(p).xy" : "(p)") << ")\n";
+    }
+    return stream.str();
+}
+
+std::string ShaderLayer::buildComputeOutputDeclaration(const std::string& name, uint32_t binding, bool texture2D) const {
+    std::ostringstream stream;
+    if (isOutputBuffer()) {
+        uint32_t width = 0, height = 0, depth = 0;
+        getOutputDims(width, height, depth);
+        buildActivationBufferBlock(stream, name, OUTPUT_BUFFER_BINDING, "writeonly", _desc.preferHp, {width, height, DIV_4_ROUND_UP(_desc.numOutputPlanes)});
+        stream << "void store_" << name << "(ivec3 p, vec4 v) {\n"
+               << "    if (" << name << "BufferContains(p)) {\n";
+        if (_desc.preferHp) {
+            stream << "        " << name << "Buffer.data[" << name << "BufferIndex(p)] = uvec2(packHalf2x16(v.xy), packHalf2x16(v.zw));\n";
+        } else {
+            stream << "        " << name << "Buffer.data[" << name << "BufferIndex(p)] = v;\n";
+        }
+        stream << "    }\n"
+               << "}\n"
+               << "#define STORE_" << name << "(p, v) store_" << name << "(p, v)\n";
+    } else {
+        stream << "layout(OUTPUT_FORMAT, binding=" << binding << ") writeonly uniform PRECISION " << (texture2D ? "image2D " : "image2DArray ") << name << ";\n"
+               << "#define STORE_" << name << "(p, v) imageStore(" << name << ", " << (texture2D ? "(p).xy" : "(p)") << ", v)\n";
+    }
+    return stream.str();
+}
+
 }   // namespace dp
 }   // namespace snn
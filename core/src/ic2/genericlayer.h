@@ -24,6 +24,7 @@
 #include "modelparser.h"
 #include <glm/glm.hpp>
 #include <string>
+#include <ostream>
 #include <vector>
 #include <memory>
 #include <opencv2/core/mat.hpp>
@@ -50,7 +51,7 @@ struct CommonLayerDesc {
         isRange01       = parser.isInputRange01();
         numOutputPlanes = (uint32_t) parser.getOutputPlanes(layerId);
         numInputPlanes  = (uint32_t) parser.getInputPlanes(layerId);
-        preferHp        = parser.getPrecision();
+        preferHp        = parser.getPrecision(layerId);
         mrtMode         = parser.getMRTMode();
         weightMode      = parser.getWeightMode();
     }
@@ -74,8 +75,12 @@ protected:
     InferencePassesSptr passes;
 
 private:
-    // Collection of render passes
-    std::vector<std::shared_ptr<RenderPass>> renderPasses;
+    // Compiled render passes, shared by all execution contexts. Render passes themselves are owned by the contexts.
+    std::vector<std::shared_ptr<CompiledRenderPass>> compiledPasses;
+
+    uint32_t outputPlaneOffset = 0;
+
+    bool outputBuffer = false;
 
 public:
     std::vector<std::shared_ptr<GenericModelLayer>> prevLayers;
@@ -99,8 +104,8 @@ public:
         return passes.get();
     }
 
-    std::vector<std::shared_ptr<RenderPass>>& getRenderPasses() {
-        return renderPasses;
+    std::vector<std::shared_ptr<CompiledRenderPass>>& getCompiledPasses() {
+        return compiledPasses;
     }
 
     bool isInputLayer() { return _desc.isInputLayer; }
@@ -115,10 +120,41 @@ public:
 
     void setWeightAccessMode(const WeightAccessMethod& mode) { _desc.weightMode = mode; }
 
-    virtual void init(DeviceBackend* backend, ImageTextureArray& inputMat, ImageTextureArray& outputMat);
+    // Index of the first output texture layer, this layer writes into.
+    // Non-zero when the output is aliased to a layer range of a consumer's output (e.g. zero-copy concatenation).
+    uint32_t getOutputPlaneOffset() const { return outputPlaneOffset; }
+
+    void setOutputPlaneOffset(uint32_t offset) { outputPlaneOffset = offset; }
+
+    // Checks if the GL compute shader of the layer can read its inputs from and write its output into
+    // NC4HW4 storage buffers (see ShaderGenOptions::bufferActivations).
+    virtual bool supportsBufferActivations() const { return false; }
+
+    // True if the layer output is an NC4HW4 storage buffer instead of a texture
+    bool isOutputBuffer() const { return outputBuffer; }
+
+    void setOutputBuffer(bool buffer) { outputBuffer = buffer; }
+
+    // Compiles programs and uploads weights of the layer, once per compiled model
+    // returns:
+    //  false if a program of the layer failed to compile
+    virtual bool compile(DeviceBackend* backend);
+
+    // Creates render passes of the layer for one execution context
+    // params:
+    //  backend - backend of the execution context
+    //  inputMat - input images
+    //  outputMat - output images
+    //  renderPasses - created render passes
+    virtual void init(DeviceBackend* backend, ImageTextureArray& inputMat, ImageTextureArray& outputMat,
+                      std::vector<std::shared_ptr<RenderPass>>& renderPasses);
 
     // Run layer on GPU
-    virtual void run(DeviceBackend* backend, bool dumpOutputs);
+    // params:
+    //  backend - backend of the execution context
+    //  renderPasses - render passes of the execution context, created by init()
+    //  dumpOutputs - flag to dump layer outputs
+    virtual void run(DeviceBackend* backend, const std::vector<std::shared_ptr<RenderPass>>& renderPasses, bool dumpOutputs);
 
     virtual void getOutputDims(uint32_t& width, uint32_t& height, uint32_t& depth) const;
 
@@ -133,6 +169,26 @@ public:
 
     virtual bool isTransition() const { return false; }
 
+    // Gets the spatial footprint of the layer. Used to calculate the receptive field of the graph.
+    // params:
+    //  kernelRadius - distance (in input pixels) from an output pixel to the farthest input pixel it depends on
+    //  scale - ratio of output resolution to input resolution
+    // returns:
+    //  true if every output pixel depends on a bounded input region, false if it depends on the whole input
+    virtual bool getSpatialFootprint(uint32_t& kernelRadius, float& scale) const;
+
+    // Gets the arithmetic work of the layer. Used by the static cost model. Valid after the input dimensions are known.
+    // params:
+    //  macs - multiply-accumulate operations per inference. Comparisons and additions of
+    //         element-wise and pooling layers are counted as one operation each.
+    //  numWeights - number of weights, biases and other parameters, read by the shaders
+    virtual void getArithmeticCost(uint64_t& macs, uint64_t& numWeights) const;
+
+    // Gets the layer signature: type, input and output shapes, kernel size and precision.
+    // Layers with equal signatures run the same shaders, so the signature keys per-layer shader placement.
+    // Valid after the input dimensions are known.
+    std::string getSignature() const;
+
 private:
     // Defines output shape transformation
     virtual InferenceGraph::Transform getOutputScaleDimAdjustment() const = 0;
@@ -162,6 +218,36 @@ public:
 
     static void findAndReplace(std::string& s, const std::string& from, const std::string& to);
 
+    // Writes INPUT_WIDTH and INPUT_HEIGHT shader defines.
+    // With dynamic shapes the size is queried from the inputTextures sampler at runtime.
+    // params:
+    //  stream - shader source stream
+    //  options - layer generation options
+    //  inputScale - factor of the input size, used by layers, that upsample their input on the fly
+    static void buildInputSizeDefines(std::ostream& stream, const LayerGenOptions& options, uint32_t inputScale = 1);
+
+    // Declares an input activation of a GL compute shader and its LOAD_<name>(ivec3) accessor.
+    // The input is an image, or an NC4HW4 storage buffer, if its producer writes into a buffer.
+    // Loads outside of the input return 0 for both kinds of storage.
+    // params:
+    //  name - image uniform name or storage block name
+    //  inputIndex - index of the input
+    //  binding - image unit of an image input
+    //  texture2D - an image input is declared as image2D, not image2DArray
+    // returns:
+    //  shader declaration code
+    std::string buildComputeInputDeclaration(const std::string& name, uint32_t inputIndex, uint32_t binding, bool texture2D) const;
+
+    // Declares the output activation of a GL compute shader and its STORE_<name>(ivec3, vec4) accessor.
+    // Stores outside of the output are ignored for both kinds of storage.
+    // params:
+    //  name - image uniform name or storage block name
+    //  binding - image unit of an image output
+    //  texture2D - an image output is declared as image2D, not image2DArray
+    // returns:
+    //  shader declaration code
+    std::string buildComputeOutputDeclaration(const std::string& name, uint32_t binding, bool texture2D) const;
+
     virtual void createInferencePasses(const LayerGenOptions& options) override;
 
     virtual InferenceGraph::LayerExecutionType getLayerExecutionType() const override { return executeBackend; }
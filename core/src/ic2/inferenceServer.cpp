@@ -0,0 +1,416 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pch.h"
+#include "snn/inferenceServer.h"
+#include "snn/imageTexture.h"
+#ifdef SUPPORT_GL
+    #include "glUtils.h"
+#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace snn;
+
+static uint64_t toNs(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+struct InferenceServer::Task {
+    Request request;
+    std::promise<Response> promise;
+    std::chrono::steady_clock::time_point submitTime;
+};
+
+// Bounded multi-producer multi-consumer queue of task pointers (D. Vyukov's algorithm).
+// Every cell has a sequence number, that tells producers and consumers, whose turn it is,
+// so push() and pop() only contend on the enqueue and dequeue positions.
+class InferenceServer::TaskQueue {
+public:
+    // params:
+    //  minCapacity - minimal number of cells, rounded up to a power of 2
+    explicit TaskQueue(size_t minCapacity) {
+        size_t capacity = 2;
+        while (capacity < minCapacity) {
+            capacity *= 2;
+        }
+        mask  = capacity - 1;
+        cells.reset(new Cell[capacity]);
+        for (size_t i = 0; i < capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // returns:
+    //  false if the queue is full
+    bool push(Task* task) {
+        Cell* cell;
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell         = &cells[pos & mask];
+            size_t seq   = cell->sequence.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t) seq - (intptr_t) pos;
+            if (dif == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->task = task;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // returns:
+    //  oldest task or nullptr, if the queue is empty
+    Task* pop() {
+        Cell* cell;
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell         = &cells[pos & mask];
+            size_t seq   = cell->sequence.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t) seq - (intptr_t) (pos + 1);
+            if (dif == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                return nullptr;
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        Task* task = cell->task;
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        return task;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        Task* task = nullptr;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> enqueuePos {0};
+    alignas(64) std::atomic<size_t> dequeuePos {0};
+};
+
+struct InferenceServer::Worker {
+#ifdef SUPPORT_GL
+    // OpenGL context of the worker thread, null with Vulkan
+    std::unique_ptr<gl::RenderContext> renderContext;
+#endif
+    std::unique_ptr<MixedInferenceCore> core;
+    // Model inputs of every request of a batch
+    std::vector<std::unique_ptr<ImageTextureArray>> inputs;
+    std::thread thread;
+};
+
+// -----------------------------------------------------------------------------
+//
+snn::InferenceServer::InferenceServer(GpuContext* context_)
+    : context(context_)
+{}
+
+snn::InferenceServer::~InferenceServer() {
+    stop();
+    SNN_LOGV("InferenceServer destroyed");
+}
+
+std::unique_ptr<InferenceServer> snn::InferenceServer::create(GpuContext* context, const CreationParameters& cp) {
+    std::unique_ptr<InferenceServer> p(new InferenceServer(context));
+    if (!p->init(cp)) {
+        return nullptr;
+    }
+    return p;
+}
+
+bool snn::InferenceServer::init(const CreationParameters& cp_) {
+    if (cp_.options.desiredInput.empty()) {
+        SNN_LOGE("Inference server needs the input description in ShaderGenOptions::desiredInput");
+        return false;
+    }
+    cp               = cp_;
+    cp.numWorkers    = std::max(1U, cp.numWorkers);
+    cp.maxBatch      = std::max(1U, cp.maxBatch);
+    cp.maxQueueDepth = std::max(1U, cp.maxQueueDepth);
+    if (context->backendType == GpuBackendType::VULKAN && cp.numWorkers > 1) {
+        SNN_LOGW("Execution contexts of one Vulkan device share its command pool and queue, using one worker");
+        cp.numWorkers = 1;
+    }
+
+    if (!cp.model && cp.modelFileName.empty()) {
+        SNN_LOGE("Inference server needs a compiled model or a model file name");
+        return false;
+    }
+    model = cp.model ? cp.model : CompiledModel::create(context, cp.modelFileName, cp.options);
+    if (!model) {
+        SNN_LOGE("Failed to compile model %s", cp.modelFileName.c_str());
+        return false;
+    }
+
+    // Request inputs are copied into the input images as is, so they must have the same size
+    ImageTextureArray probe {ImageTextureAllocator(context)};
+    probe.allocate(cp.options.desiredInput.size());
+    for (size_t i = 0; i < cp.options.desiredInput.size(); ++i) {
+        const auto& desc = cp.options.desiredInput[i];
+        probe[i].reset({desc.width, desc.height, desc.depth, 1}, desc.format);
+        inputBytes.push_back(probe[i].getRawImage().size());
+    }
+
+    queue.reset(new TaskQueue(cp.maxQueueDepth));
+    for (uint32_t i = 0; i < cp.numWorkers; ++i) {
+        workers.emplace_back(new Worker());
+#ifdef SUPPORT_GL
+        if (context->backendType == GpuBackendType::GL) {
+            // Created on this thread, so that it shares objects with the current context
+            workers.back()->renderContext.reset(new gl::RenderContext(gl::RenderContext::SHARED));
+        }
+#endif
+    }
+    for (auto& worker : workers) {
+        worker->thread = std::thread(&InferenceServer::workerMain, this, std::ref(*worker));
+    }
+    SNN_LOGI("Inference server started: %u workers, batches up to %u, queue depth %u", cp.numWorkers, cp.maxBatch, cp.maxQueueDepth);
+    return true;
+}
+
+std::future<InferenceServer::Response> snn::InferenceServer::submit(Request request) {
+    std::unique_ptr<Task> task(new Task());
+    task->request    = std::move(request);
+    task->submitTime = std::chrono::steady_clock::now();
+    auto future      = task->promise.get_future();
+    numSubmitted.fetch_add(1, std::memory_order_relaxed);
+
+    bool valid = task->request.inputs.size() == inputBytes.size();
+    for (size_t i = 0; valid && i < inputBytes.size(); ++i) {
+        valid = task->request.inputs[i].size() == inputBytes[i];
+    }
+    if (!valid) {
+        SNN_LOGE("Request inputs don't match ShaderGenOptions::desiredInput");
+        dropTask(task.release());
+        return future;
+    }
+
+    bool reserved = tryReserveSlot();
+    if (!reserved && cp.backpressure == Backpressure::BLOCK) {
+        std::unique_lock<std::mutex> lock(slotMutex);
+        blockedSubmits.fetch_add(1);
+        // Pairs with the fence in takeTask(): either the worker sees the blocked call, or the call sees the free slot
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        slotCv.wait(lock, [&] { return stopping || (reserved = tryReserveSlot()); });
+        blockedSubmits.fetch_sub(1);
+    }
+    if (!reserved || stopping) {
+        if (reserved) {
+            queueDepth.fetch_sub(1);
+        }
+        dropTask(task.release());
+        return future;
+    }
+
+    // The queue has a cell for every reserved slot
+    bool pushed = queue->push(task.release());
+    SNN_ASSERT(pushed);
+    (void) pushed;
+    // Pairs with the fence in takeTask(): either this call sees the sleeping worker, or the worker sees the task
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (stopping) {
+        // stop() might have drained the queue before the push, so the task would never complete.
+        // Tasks are popped once, so draining here and in stop() at the same time is safe.
+        drainQueue();
+        return future;
+    }
+    if (sleepingWorkers.load() > 0) {
+        std::lock_guard<std::mutex> lock(taskMutex);
+        taskCv.notify_one();
+    }
+    return future;
+}
+
+void snn::InferenceServer::stop() {
+    if (!stopping.exchange(true)) {
+        {
+            std::lock_guard<std::mutex> lock(taskMutex);
+            taskCv.notify_all();
+        }
+        {
+            std::lock_guard<std::mutex> lock(slotMutex);
+            slotCv.notify_all();
+        }
+        for (auto& worker : workers) {
+            if (worker->thread.joinable()) {
+                worker->thread.join();
+            }
+        }
+    }
+    drainQueue();
+}
+
+void snn::InferenceServer::drainQueue() {
+    if (!queue) {
+        return;
+    }
+    while (Task* task = queue->pop()) {
+        queueDepth.fetch_sub(1);
+        dropTask(task);
+    }
+}
+
+InferenceServer::Stats snn::InferenceServer::getStats() const {
+    Stats stats;
+    stats.submitted = numSubmitted.load(std::memory_order_relaxed);
+    stats.completed = numCompleted.load(std::memory_order_relaxed);
+    stats.rejected  = numRejected.load(std::memory_order_relaxed);
+    stats.batches   = numBatches.load(std::memory_order_relaxed);
+    stats.latency   = latency.snapshot();
+    stats.queueTime = queueTime.snapshot();
+    return stats;
+}
+
+bool snn::InferenceServer::tryReserveSlot() {
+    uint32_t depth = queueDepth.load();
+    while (depth < cp.maxQueueDepth) {
+        if (queueDepth.compare_exchange_weak(depth, depth + 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+InferenceServer::Task* snn::InferenceServer::takeTask(const std::chrono::steady_clock::time_point* deadline) {
+    Task* task = stopping ? nullptr : queue->pop();
+    if (!task && !stopping) {
+        std::unique_lock<std::mutex> lock(taskMutex);
+        sleepingWorkers.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto ready = [&] { return stopping || (task = queue->pop()) != nullptr; };
+        if (deadline) {
+            taskCv.wait_until(lock, *deadline, ready);
+        } else {
+            taskCv.wait(lock, ready);
+        }
+        sleepingWorkers.fetch_sub(1);
+    }
+    if (!task) {
+        return nullptr;
+    }
+    queueDepth.fetch_sub(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (blockedSubmits.load() > 0) {
+        std::lock_guard<std::mutex> lock(slotMutex);
+        slotCv.notify_one();
+    }
+    return task;
+}
+
+void snn::InferenceServer::workerMain(Worker& worker) {
+#ifdef SUPPORT_GL
+    if (worker.renderContext) {
+        worker.renderContext->makeCurrent();
+    }
+#endif
+    worker.core = MixedInferenceCore::create(model);
+    for (uint32_t i = 0; i < cp.maxBatch; ++i) {
+        worker.inputs.emplace_back(new ImageTextureArray(ImageTextureAllocator(context)));
+        worker.inputs.back()->allocate(cp.options.desiredInput.size());
+    }
+
+    auto timeout = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(cp.batchTimeoutMs));
+    std::vector<Task*> batch;
+    while (Task* first = takeTask(nullptr)) {
+        // Requests, that waited in the queue longer than the timeout, are batched with the ones queued already
+        auto deadline = first->submitTime + timeout;
+        batch.assign(1, first);
+        while (batch.size() < cp.maxBatch) {
+            Task* task = takeTask(&deadline);
+            if (!task) {
+                break;
+            }
+            batch.push_back(task);
+        }
+        runBatch(worker, batch);
+    }
+
+    // Objects of the worker are deleted, while its context is current
+    worker.inputs.clear();
+    worker.core.reset();
+#ifdef SUPPORT_GL
+    worker.renderContext.reset();
+#endif
+}
+
+void snn::InferenceServer::runBatch(Worker& worker, const std::vector<Task*>& batch) {
+    auto batchStart = std::chrono::steady_clock::now();
+    numBatches.fetch_add(1, std::memory_order_relaxed);
+    const auto& desiredInput = cp.options.desiredInput;
+    // Inputs of the whole batch are uploaded before the first run
+    for (size_t t = 0; t < batch.size(); ++t) {
+        auto& inputTexs = *worker.inputs[t];
+        for (size_t i = 0; i < desiredInput.size(); ++i) {
+            const auto& desc = desiredInput[i];
+            inputTexs[i].reset({desc.width, desc.height, desc.depth, 1}, desc.format, batch[t]->request.inputs[i].data());
+            inputTexs[i].upload();
+        }
+    }
+
+    bool gpuOutput = model->getCreationParameters().layers.back()->layerLoc != InferenceGraph::LayerExecutionType::CPU;
+    for (size_t t = 0; t < batch.size(); ++t) {
+        Task* task = batch[t];
+        auto inVec  = std::vector<std::vector<std::vector<float>>>();
+        auto outVec = std::vector<std::vector<std::vector<float>>>();
+        SNNModelOutput modelOutput;
+        modelOutput.modelType = cp.modelType;
+        MixedInferenceCore::RunParameters rp = {*worker.inputs[t], {}, inVec, outVec, modelOutput};
+        worker.core->run(rp);
+
+        Response response;
+        ImageTexture& outputImage = worker.core->getOutputImage();
+        if (gpuOutput) {
+            const RawImage& raw = outputImage.getRawImage();
+            response.outputImage.assign(raw.data(), raw.data() + raw.size());
+        } else {
+            response.output = outputImage.getOutputMat();
+        }
+        response.ok          = true;
+        response.modelOutput = std::move(rp.modelOutput);
+        response.batchSize   = (uint32_t) batch.size();
+        auto end             = std::chrono::steady_clock::now();
+        response.queueTime   = toNs(batchStart - task->submitTime) / 1e6;
+        response.latency     = toNs(end - task->submitTime) / 1e6;
+        queueTime.record(toNs(batchStart - task->submitTime));
+        latency.record(toNs(end - task->submitTime));
+        numCompleted.fetch_add(1, std::memory_order_relaxed);
+        task->promise.set_value(std::move(response));
+        delete task;
+    }
+}
+
+void snn::InferenceServer::dropTask(Task* task) {
+    numRejected.fetch_add(1, std::memory_order_relaxed);
+    task->promise.set_value(Response());
+    delete task;
+}
@@ -49,6 +49,9 @@ public:
         return {0, {{1.0f, 1.0f, 0.0f, 0.0f}} };
     }
 
+    // Normalization statistics are calculated over the whole image
+    virtual bool getSpatialFootprint(uint32_t&, float&) const override { return false; }
+
 protected:
     InstanceNormDesc _desc;
 };
@@ -0,0 +1,175 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pch.h"
+#include "invertedresidual.h"
+#include "layerFactory.h"
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+using namespace snn;
+using namespace snn::dp;
+
+int InvertedResidualLayer::getActivationId(const std::string& activation) {
+    if (activation.empty() || !activation.compare("linear") || !activation.compare("none")) {
+        return 0;
+    } else if (!activation.compare("relu")) {
+        return 1;
+    } else if (!activation.compare("relu6")) {
+        return 2;
+    } else if (!activation.compare("tanh")) {
+        return 3;
+    } else if (!activation.compare("sigmoid")) {
+        return 4;
+    } else if (!activation.compare("leakyRelu") || !activation.compare("leaky_relu")) {
+        return 5;
+    } else if (!activation.compare("SiLU")) {
+        return 6;
+    }
+    return -1;
+}
+
+InferenceGraph::Transform InvertedResidualLayer::getOutputScaleDimAdjustment() const {
+    float scale       = 1.0f / static_cast<float>(_desc.depthwise.stride);
+    float translation = 1.0f + (static_cast<float>(_desc.padding[0] + _desc.padding[1]) - static_cast<float>(_desc.depthwise.kernelSize)) /
+                        static_cast<float>(_desc.depthwise.stride);
+    return {0, {{scale, scale, translation, translation}}};
+}
+
+void InvertedResidualLayer::getOutputDims(uint32_t& width, uint32_t& height, uint32_t& depth) const {
+    // Same as SeparableConv2DLayer::getOutputDims()
+    for (auto& dim : inputDims) {
+        width  = (dim.width - _desc.depthwise.kernelSize + _desc.padding[0] + _desc.padding[2]) / _desc.depthwise.stride + 1;
+        height = (dim.height - _desc.depthwise.kernelSize + _desc.padding[1] + _desc.padding[3]) / _desc.depthwise.stride + 1;
+        depth  = _desc.project.numOutputPlanes;
+        break;
+    }
+}
+
+uint64_t InvertedResidualLayer::getEliminatedTrafficBytes() const {
+    if (inputDims.empty()) {
+        return 0;
+    }
+    uint32_t outputWidth = 0, outputHeight = 0, outputDepth = 0;
+    getOutputDims(outputWidth, outputHeight, outputDepth);
+    uint64_t bytesPerSlice   = _desc.preferHp ? 8 : 16;
+    uint64_t expandedSlices  = DIV_4_ROUND_UP(_desc.expand.numOutputPlanes);
+    uint64_t inputPixels     = (uint64_t) inputDims[0].width * inputDims[0].height;
+    uint64_t outputPixels    = (uint64_t) outputWidth * outputHeight;
+    // Expand output is written and read back by the depthwise convolution,
+    // depthwise output is written and read back by the project convolution
+    uint64_t bytes = 2 * bytesPerSlice * expandedSlices * (inputPixels + outputPixels);
+    if (_desc.residual) {
+        // Project output is written and read back by the add layer
+        bytes += 2 * bytesPerSlice * DIV_4_ROUND_UP(_desc.project.numOutputPlanes) * outputPixels;
+    }
+    return bytes;
+}
+
+void InvertedResidualLayer::getArithmeticCost(uint64_t& macs, uint64_t& numWeights) const {
+    macs       = 0;
+    numWeights = 0;
+    if (inputDims.empty()) {
+        return;
+    }
+    uint32_t outputWidth = 0, outputHeight = 0, outputDepth = 0;
+    getOutputDims(outputWidth, outputHeight, outputDepth);
+    uint64_t inputChannels    = _desc.expand.numInputPlanes;
+    uint64_t expandedChannels = _desc.expand.numOutputPlanes;
+    uint64_t outputChannels   = _desc.project.numOutputPlanes;
+    uint64_t taps             = (uint64_t) _desc.depthwise.kernelSize * _desc.depthwise.kernelSize;
+    uint64_t inputPixels      = (uint64_t) inputDims[0].width * inputDims[0].height;
+    uint64_t outputPixels     = (uint64_t) outputWidth * outputHeight;
+    // Expanded activations are calculated once per input pixel, halos of neighbor tiles are ignored
+    macs = inputPixels * inputChannels * expandedChannels + outputPixels * expandedChannels * (taps + outputChannels);
+    if (_desc.residual) {
+        macs += outputPixels * outputChannels;
+    }
+    numWeights = expandedChannels * (inputChannels + taps + outputChannels) + 2 * expandedChannels + outputChannels;
+}
+
+void InvertedResidualLayer::getLanes(uint32_t& outputsPerLane, uint32_t& lanes) const {
+    uint32_t oc_4  = DIV_4_ROUND_UP(_desc.project.numOutputPlanes);
+    lanes          = std::min(oc_4, MAX_LANES);
+    outputsPerLane = std::min(UP_DIV(oc_4, lanes), MAX_OUTPUTS_PER_LANE);
+}
+
+// Calculates per channel scale and shift, that fold batch normalization and bias into the convolution
+static void foldBatchNorm(bool useBatchNormalization, const std::map<std::string, std::vector<float>>& batchNormalization,
+                          const std::vector<double>& biases, uint32_t channels, std::vector<float>& scale, std::vector<float>& shift) {
+    scale.assign(channels, 1.0f);
+    shift.assign(channels, 0.0f);
+    for (size_t i = 0; i < std::min(biases.size(), (size_t) channels); i++) {
+        shift[i] = (float) biases[i];
+    }
+    if (!useBatchNormalization) {
+        return;
+    }
+    const auto& beta     = batchNormalization.at("beta");
+    const auto& gamma    = batchNormalization.at("gamma");
+    const auto& mean     = batchNormalization.at("movingMean");
+    const auto& variance = batchNormalization.at("movingVariance");
+    for (uint32_t i = 0; i < channels; i++) {
+        // Same epsilon and clamp as in the convolution shaders
+        float sqrtVar = std::max(std::sqrt(variance[i] + 0.001f), 0.0001f);
+        scale[i]      = gamma[i] / sqrtVar;
+        shift[i]      = (shift[i] - mean[i]) * scale[i] + beta[i];
+    }
+}
+
+void InvertedResidualLayer::packWeights(std::vector<float>& weights, std::vector<float>& biases) const {
+    uint32_t inputChannels    = _desc.expand.numInputPlanes;
+    uint32_t expandedChannels = _desc.expand.numOutputPlanes;
+    uint32_t outputChannels   = _desc.project.numOutputPlanes;
+    uint32_t ic_4             = DIV_4_ROUND_UP(inputChannels);
+    uint32_t ec_4             = DIV_4_ROUND_UP(expandedChannels);
+    uint32_t oc_4             = DIV_4_ROUND_UP(outputChannels);
+    uint32_t taps             = _desc.depthwise.kernelSize * _desc.depthwise.kernelSize;
+
+    std::vector<float> expandScale, expandShift, dwScale, dwShift, projectScale, projectShift;
+    foldBatchNorm(_desc.expand.useBatchNormalization, _desc.expand.batchNormalization, _desc.expand.biases, expandedChannels, expandScale, expandShift);
+    foldBatchNorm(_desc.depthwise.useBatchNormalization, _desc.depthwise.batchNormalization, _desc.depthwise.biases, expandedChannels, dwScale, dwShift);
+    foldBatchNorm(_desc.project.useBatchNormalization, _desc.project.batchNormalization, _desc.project.biases, outputChannels, projectScale, projectShift);
+
+    size_t dwOffset      = (size_t) ec_4 * ic_4 * 16;
+    size_t projectOffset = dwOffset + (size_t) ec_4 * taps * 4;
+    weights.assign(projectOffset + (size_t) oc_4 * ec_4 * 16, 0.0f);
+
+    // Matrix column m holds the weights of input channel m of the slice for 4 output channels of the slice
+    for (uint32_t o = 0; o < expandedChannels; o++) {
+        for (uint32_t i = 0; i < inputChannels; i++) {
+            size_t index   = ((size_t)(o / 4) * ic_4 + i / 4) * 16 + (i % 4) * 4 + o % 4;
+            weights[index] = _desc.expand.weightsCvM[o * inputChannels + i].at<float>(0) * expandScale[o];
+        }
+    }
+    for (uint32_t c = 0; c < expandedChannels; c++) {
+        for (uint32_t t = 0; t < taps; t++) {
+            size_t index   = dwOffset + ((size_t)(c / 4) * taps + t) * 4 + c % 4;
+            weights[index] = _desc.depthwise.weightsCvM[c].at<float>(t) * dwScale[c];
+        }
+    }
+    for (uint32_t o = 0; o < outputChannels; o++) {
+        for (uint32_t i = 0; i < expandedChannels; i++) {
+            size_t index   = projectOffset + ((size_t)(o / 4) * ec_4 + i / 4) * 16 + (i % 4) * 4 + o % 4;
+            weights[index] = _desc.project.weightsCvM[o * expandedChannels + i].at<float>(0) * projectScale[o];
+        }
+    }
+
+    biases.assign((size_t)(2 * ec_4 + oc_4) * 4, 0.0f);
+    std::copy(expandShift.begin(), expandShift.end(), biases.begin());
+    std::copy(dwShift.begin(), dwShift.end(), biases.begin() + ec_4 * 4);
+    std::copy(projectShift.begin(), projectShift.end(), biases.begin() + ec_4 * 8);
+}
@@ -0,0 +1,104 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "genericlayer.h"
+#include "conv2d.h"
+#include "separableconvolution.h"
+#include "addlayer.h"
+#include "snn/snn.h"
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace snn {
+namespace dp { // short for Dynamic Pipeline
+
+// Describes a MobileNetV2 style inverted residual block:
+// expand 1x1 convolution -> depthwise convolution -> project 1x1 convolution (-> residual add).
+// It is not parsed from the model file, but is built from the layers of the block by fuseInvertedResidualBlocks().
+struct InvertedResidualDesc : CommonLayerDesc {
+    Conv2DDesc expand;
+    SeparableConv2DDesc depthwise;
+    Conv2DDesc project;
+    // Padding of the depthwise convolution: top, bottom, left, right
+    uint32_t padding[4] = {0, 0, 0, 0};
+    // True, if the block input is added to the project convolution output
+    bool residual = false;
+    std::string residualActivation = "linear";
+    float residualLeakyReluAlpha   = 0.0f;
+};
+
+// This is a base class to generate a shader for the fused inverted residual block.
+// The expanded activations are calculated per output tile in the shared memory of the compute shader,
+// so they are never written to textures.
+class InvertedResidualLayer : public ShaderLayer {
+public:
+    InvertedResidualLayer(InvertedResidualDesc&& d): ShaderLayer(d), _desc(std::move(d)) {}
+    virtual ~InvertedResidualLayer() = default;
+
+    virtual InferenceGraph::Transform getOutputScaleDimAdjustment() const override;
+
+    virtual void getOutputDims(uint32_t& width, uint32_t& height, uint32_t& depth) const override;
+
+    virtual bool getSpatialFootprint(uint32_t& kernelRadius, float& scale) const override {
+        kernelRadius = _desc.depthwise.kernelSize / 2;
+        scale        = 1.0f / static_cast<float>(_desc.depthwise.stride);
+        return true;
+    }
+
+    // Gets the number of bytes, the unfused block would write and read back through the expanded and
+    // intermediate textures. Valid after the inference passes are created.
+    uint64_t getEliminatedTrafficBytes() const;
+
+    virtual void getArithmeticCost(uint64_t& macs, uint64_t& numWeights) const override;
+
+    // Checks if the fused kernel supports an activation function
+    // params:
+    //  activation - activation name from the model file
+    // returns:
+    //  true if supported, false if not
+    static bool isActivationSupported(const std::string& activation) { return getActivationId(activation) >= 0; }
+
+protected:
+    InvertedResidualDesc _desc;
+
+    // Output tile of one work group
+    static constexpr uint32_t TILE_SIZE = 4;
+    // Number of expanded 4-channel slices, kept in the shared memory at a time
+    static constexpr uint32_t EXPAND_CHUNK = 4;
+    // Maximum number of 4-channel output slices, accumulated by one shader invocation
+    static constexpr uint32_t MAX_OUTPUTS_PER_LANE = 4;
+    // Maximum number of invocations along Z axis of the work group
+    static constexpr uint32_t MAX_LANES = 8;
+
+    // Gets activation function id, used by the shaders
+    // returns:
+    //  0 - linear, 1 - relu, 2 - relu6, 3 - tanh, 4 - sigmoid, 5 - leaky relu, 6 - SiLU, -1 - not supported
+    static int getActivationId(const std::string& activation);
+
+    // Gets the number of output slices per invocation and the number of invocations along Z axis
+    void getLanes(uint32_t& outputsPerLane, uint32_t& lanes) const;
+
+    // Packs weights of all 3 convolutions with batch normalization folded in.
+    // params:
+    //  weights - expand 4x4 matrices [expanded slice][input slice], then depthwise vectors [expanded slice][tap],
+    //            then project 4x4 matrices [output slice][expanded slice]. Matrices are stored by columns.
+    //  biases - expand, depthwise and project biases
+    void packWeights(std::vector<float>& weights, std::vector<float>& biases) const;
+};
+
+}; // namespace dp
+} // namespace snn
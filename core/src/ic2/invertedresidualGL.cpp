@@ -0,0 +1,131 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pch.h"
+#include "invertedresidual.h"
+#include "layerFactory.h"
+#include "inferencepassGL.h"
+#include <string>
+#include <vector>
+#include <sstream>
+
+DECLARE_LAYER_GL_CLASS(InvertedResidual);
+
+using namespace snn;
+using namespace snn::dp;
+
+static constexpr const char* INVERTED_RESIDUAL_CS_ASSET_NAME = "shaders/shadertemplate_cs_invertedresidual.glsl";
+
+InferencePassesSptr InvertedResidualLayerGl::createFS(const LayerGenOptions&) const {
+    // Blocks are fused only when compute shaders are generated
+    SNN_RIP("Fused inverted residual block is not implemented for fragment shaders !");
+}
+
+InferencePassesSptr InvertedResidualLayerGl::createCS(const LayerGenOptions& options) const {
+    (void) options;
+
+    InferencePassesSptr ret(new InferencePassesGl());
+
+    std::vector<InferencePassGl>& passes = InferencePassesGl::cast(ret.get())->passes;
+    passes.resize(1);
+
+    InferencePassGl& pass = passes[0];
+
+    uint32_t inputWidth  = inputDims[0].width;
+    uint32_t inputHeight = inputDims[0].height;
+
+    uint32_t outputWidth  = 0;
+    uint32_t outputHeight = 0;
+    uint32_t outputDepth  = 0;
+    getOutputDims(outputWidth, outputHeight, outputDepth);
+
+    uint32_t ic_4 = DIV_4_ROUND_UP(_desc.expand.numInputPlanes);
+    uint32_t ec_4 = DIV_4_ROUND_UP(_desc.expand.numOutputPlanes);
+    uint32_t oc_4 = DIV_4_ROUND_UP(_desc.project.numOutputPlanes);
+    uint32_t taps = _desc.depthwise.kernelSize * _desc.depthwise.kernelSize;
+
+    uint32_t outputsPerLane = 1, lanes = 1;
+    getLanes(outputsPerLane, lanes);
+
+    std::ostringstream shaderHeader;
+    if (_desc.preferHp) {
+        shaderHeader << "#version 320 es \n"
+                        "#define PRECISION mediump\n"
+                        "precision PRECISION float;\n"
+                        "layout(std430) buffer;\n"
+                        "#define OUTPUT_FORMAT rgba16f\n";
+    } else {
+        shaderHeader << "#version 320 es \n"
+                        "#define PRECISION highp\n"
+                        "precision PRECISION float;\n"
+                        "layout(std430) buffer;\n"
+                        "#define OUTPUT_FORMAT rgba32f\n";
+    }
+    if (_desc.expand.numInputPlanes <= 4) {
+        shaderHeader << "#define INPUT_TEXTURE_2D\n";
+    }
+    if (_desc.project.numOutputPlanes <= 4) {
+        shaderHeader << "#define OUTPUT_TEXTURE_2D\n";
+    }
+    if (_desc.residual) {
+        shaderHeader << "#define RESIDUAL\n";
+    }
+    shaderHeader << "#define WORK_X " << TILE_SIZE << "\n";
+    shaderHeader << "#define WORK_Y " << TILE_SIZE << "\n";
+    shaderHeader << "#define WORK_Z " << lanes << "\n";
+    shaderHeader << "#define OUTPUTS_PER_LANE " << outputsPerLane << "\n";
+    shaderHeader << "#define EXPAND_CHUNK " << std::min(EXPAND_CHUNK, ec_4) << "\n";
+    shaderHeader << "#define KERNEL_SIZE " << _desc.depthwise.kernelSize << "\n";
+    shaderHeader << "#define STRIDE " << _desc.depthwise.stride << "\n";
+    shaderHeader << "#define PAD_X " << _desc.padding[2] << "\n";
+    shaderHeader << "#define PAD_Y " << _desc.padding[0] << "\n";
+    shaderHeader << "#define IC4 " << ic_4 << "\n";
+    shaderHeader << "#define EC4 " << ec_4 << "\n";
+    shaderHeader << "#define OC4 " << oc_4 << "\n";
+    shaderHeader << "#define DW_WEIGHT_OFFSET " << ec_4 * ic_4 * 4 << "\n";
+    shaderHeader << "#define PROJECT_WEIGHT_OFFSET " << ec_4 * ic_4 * 4 + ec_4 * taps << "\n";
+    shaderHeader << "#define EXPAND_ACTIVATION " << getActivationId(_desc.expand.activation) << "\n";
+    shaderHeader << "#define EXPAND_LEAKY_VAL " << std::to_string(_desc.expand.leakyReluAlpha) << "\n";
+    shaderHeader << "#define DW_ACTIVATION " << getActivationId(_desc.depthwise.activation) << "\n";
+    shaderHeader << "#define DW_LEAKY_VAL " << std::to_string(_desc.depthwise.leakyReluAlpha) << "\n";
+    shaderHeader << "#define PROJECT_ACTIVATION " << getActivationId(_desc.project.activation) << "\n";
+    shaderHeader << "#define PROJECT_LEAKY_VAL " << std::to_string(_desc.project.leakyReluAlpha) << "\n";
+    shaderHeader << "#define RESIDUAL_ACTIVATION " << getActivationId(_desc.residualActivation) << "\n";
+    shaderHeader << "#define RESIDUAL_LEAKY_VAL " << std::to_string(_desc.residualLeakyReluAlpha) << "\n";
+
+    // Weights and biases are always read from SSBOs
+    pass.weightMeta.clear();
+    pass.weightMeta.push_back((uint32_t) 2); // 2 means fused inverted residual layout
+    pass.weightMeta.push_back((uint32_t) snn::WeightAccessMethod::SSBO_BUFFER);
+    pass.weightMeta.push_back((uint32_t) _desc.preferHp);
+    pass.weightMeta.push_back((uint32_t) _desc.depthwise.kernelSize);
+    pass.weightMeta.push_back((uint32_t) _desc.depthwise.kernelSize);
+    pass.weightMeta.push_back((uint32_t) _desc.expand.numInputPlanes);
+    pass.weightMeta.push_back((uint32_t) _desc.project.numOutputPlanes);
+    packWeights(pass._vecWeights, pass._vecBias);
+
+    pass.uniforms = {{"uOutputSize", glm::ivec3(outputWidth, outputHeight, oc_4)}, {"uInputSize", glm::ivec3(inputWidth, inputHeight, ic_4)}};
+
+    pass.inputs  = {{"uInput", 0}};
+    pass.source  = shaderHeader.str() + loadShader(INVERTED_RESIDUAL_CS_ASSET_NAME);
+    pass.program = InferencePassGl::CsProgram {"uOutput",
+                                               // One work group per output tile and per WORK_Z * OUTPUTS_PER_LANE output slices
+                                               {UP_DIV(outputWidth, TILE_SIZE), UP_DIV(outputHeight, TILE_SIZE), UP_DIV(oc_4, lanes * outputsPerLane)}};
+
+    SNN_LOGD("%s: input %u:%u:%u, expanded %u, output %u:%u:%u, residual %d, lanes %u x %u", name.c_str(), inputWidth,
+             inputHeight, _desc.expand.numInputPlanes, _desc.expand.numOutputPlanes, outputWidth, outputHeight, outputDepth, _desc.residual, lanes,
+             outputsPerLane);
+
+    return ret;
+}
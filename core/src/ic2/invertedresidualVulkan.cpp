@@ -0,0 +1,119 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pch.h"
+#include "invertedresidual.h"
+#include "layerFactory.h"
+#include "inferencepassVulkan.h"
+#include "uvkc/vulkan/pipeline.h"
+#include <string>
+#include <vector>
+#include <utility>
+
+DECLARE_LAYER_VULKAN_CLASS(InvertedResidual);
+
+using namespace snn;
+using namespace snn::dp;
+
+static constexpr const char* INVERTED_RESIDUAL_VK_ASSET_NAME = "shaders/shadertemplate_vk_invertedresidual.spv";
+static constexpr const char* INVERTED_RESIDUAL_VK_FP16_ASSET_NAME = "shaders/shadertemplate_vk_invertedresidual_fp16.spv";
+
+InferencePassesSptr InvertedResidualLayerVulkan::createCS(const LayerGenOptions& options) const {
+    (void) options;
+
+    InferencePassesSptr ret(new InferencePassesVulkan());
+
+    std::vector<InferencePassVulkan>& passes = InferencePassesVulkan::cast(ret.get())->passes;
+    passes.resize(1);
+
+    InferencePassVulkan& pass = passes[0];
+
+    uint32_t inputWidth  = inputDims[0].width;
+    uint32_t inputHeight = inputDims[0].height;
+
+    uint32_t outputWidth  = 0;
+    uint32_t outputHeight = 0;
+    uint32_t outputDepth  = 0;
+    getOutputDims(outputWidth, outputHeight, outputDepth);
+
+    uint32_t ic_4 = DIV_4_ROUND_UP(_desc.expand.numInputPlanes);
+    uint32_t ec_4 = DIV_4_ROUND_UP(_desc.expand.numOutputPlanes);
+    uint32_t oc_4 = DIV_4_ROUND_UP(_desc.project.numOutputPlanes);
+    uint32_t taps = _desc.depthwise.kernelSize * _desc.depthwise.kernelSize;
+
+    uint32_t outputsPerLane = 1, lanes = 1;
+    getLanes(outputsPerLane, lanes);
+
+    packWeights(pass._vecWeights, pass._vecBias);
+    pass.objectBuffers.insert({"2", pass._vecWeights});
+    pass.objectBuffers.insert({"3", pass._vecBias});
+
+    std::vector<uvkc::vulkan::Pipeline::SpecConstant> specConstants = {
+        {0, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = _desc.padding[2]}},
+        {1, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = _desc.padding[0]}},
+        {2, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = _desc.depthwise.kernelSize}},
+        {3, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = _desc.depthwise.stride}},
+        {4, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = outputWidth}},
+        {5, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = outputHeight}},
+        {6, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = oc_4}},
+        {7, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = inputWidth}},
+        {8, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = inputHeight}},
+        {9, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = ic_4}},
+        {10, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = ec_4}},
+        {11, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = std::min(EXPAND_CHUNK, ec_4)}},
+        {12, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = outputsPerLane}},
+        {13, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = ec_4 * ic_4 * 4}},
+        {14, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = ec_4 * ic_4 * 4 + ec_4 * taps}},
+        {15, uvkc::vulkan::Pipeline::SpecConstant::Type::s32, { .s32 = getActivationId(_desc.expand.activation)}},
+        {16, uvkc::vulkan::Pipeline::SpecConstant::Type::s32, { .s32 = getActivationId(_desc.depthwise.activation)}},
+        {17, uvkc::vulkan::Pipeline::SpecConstant::Type::s32, { .s32 = getActivationId(_desc.project.activation)}},
+        {18, uvkc::vulkan::Pipeline::SpecConstant::Type::s32, { .s32 = getActivationId(_desc.residualActivation)}},
+        {19, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = _desc.residual ? 1U : 0U}},
+        {20, uvkc::vulkan::Pipeline::SpecConstant::Type::u32, { .u32 = lanes}},
+    };
+
+    const float leakyValues[] = {_desc.expand.leakyReluAlpha, _desc.depthwise.leakyReluAlpha, _desc.project.leakyReluAlpha, _desc.residualLeakyReluAlpha};
+    for (uint32_t i = 0; i < 4; i++) {
+        uvkc::vulkan::Pipeline::SpecConstant tmpConstant;
+        tmpConstant.id        = 21 + i;
+        tmpConstant.type      = ::uvkc::vulkan::Pipeline::SpecConstant::Type::f32;
+        tmpConstant.value.f32 = leakyValues[i];
+        specConstants.push_back(tmpConstant);
+    }
+
+    pass.specConstants = specConstants;
+
+    pass.inputs = {{"inputImage", 0}};
+
+    std::vector<uchar> bytes;
+    if (_desc.preferHp) {
+        bytes       = snn::loadEmbeddedAsset(INVERTED_RESIDUAL_VK_FP16_ASSET_NAME);
+        pass.source = INVERTED_RESIDUAL_VK_FP16_ASSET_NAME;
+    } else {
+        bytes       = snn::loadEmbeddedAsset(INVERTED_RESIDUAL_VK_ASSET_NAME);
+        pass.source = INVERTED_RESIDUAL_VK_ASSET_NAME;
+    }
+
+    pass.vkCodes.resize((bytes.size() + 3) / 4);
+    memcpy(pass.vkCodes.data(), bytes.data(), bytes.size());
+
+    pass.program = InferencePassVulkan::VkProgram {"outputImage",
+                                                   // One work group per output tile and per lanes * outputsPerLane output slices
+                                                   {UP_DIV(outputWidth, TILE_SIZE), UP_DIV(outputHeight, TILE_SIZE), UP_DIV(oc_4, lanes * outputsPerLane)}};
+
+    SNN_LOGV("input:%d:%d:%d, expanded:%d, output:%d:%d:%d", inputWidth, inputHeight, _desc.expand.numInputPlanes, _desc.expand.numOutputPlanes,
+             outputWidth, outputHeight, outputDepth);
+
+    return ret;
+}
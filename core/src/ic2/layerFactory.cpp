@@ -29,6 +29,7 @@
 #include "flattenlayer.h"
 #include "inputlayer.h"
 #include "instancenorm.h"
+#include "invertedresidual.h"
 #include "maxpool2d.h"
 #include "padlayer.h"
 #include "separableconvolution.h"
@@ -40,9 +41,9 @@
 #include <unordered_map>
 
 #ifdef SUPPORT_GL
-    DECLARE_LAYER_GL_CLASS(Add);
+    #include "addlayerGL.h"
     DECLARE_LAYER_GL_CLASS(Activation);
-    #include "adaptiveavgpool2dGL.h"
+    DECLARE_LAYER_GL_CLASS(AdaptiveAvgPool2d);
     #include "avgpool2dGL.h"
     #include "batchnormGL.h"
     #include "calculationGL.h"
@@ -52,6 +53,7 @@
     DECLARE_LAYER_GL_CLASS(Dense);
     DECLARE_LAYER_GL_CLASS(Flatten);
     DECLARE_LAYER_GL_CLASS(InstanceNorm);
+    DECLARE_LAYER_GL_CLASS(InvertedResidual);
     #include "maxpool2dGL.h"
     #include "padlayerGL.h"
     #include "separableconvolutionGL.h"
@@ -64,7 +66,7 @@
     DECLARE_LAYER_VULKAN_CLASS(Add);
     DECLARE_LAYER_VULKAN_CLASS(Activation);
     DECLARE_LAYER_VULKAN_CLASS(AveragePooling2D);
-    DECLARE_LAYER_VULKAN_CLASS_NOT_IMPL(AdaptiveAvgPool2d);
+    DECLARE_LAYER_VULKAN_CLASS(AdaptiveAvgPool2d);
     DECLARE_LAYER_VULKAN_CLASS(BatchNormalization);
     DECLARE_LAYER_VULKAN_CLASS(Concatenate);
     DECLARE_LAYER_VULKAN_CLASS_NOT_IMPL(Calculate);
@@ -73,6 +75,7 @@
     DECLARE_LAYER_VULKAN_CLASS(Dense);
     DECLARE_LAYER_VULKAN_CLASS(Flatten);
     DECLARE_LAYER_VULKAN_CLASS(InstanceNorm);
+    DECLARE_LAYER_VULKAN_CLASS(InvertedResidual);
     DECLARE_LAYER_VULKAN_CLASS(MaxPooling2D);
     DECLARE_LAYER_VULKAN_CLASS(Pad);
     DECLARE_LAYER_VULKAN_CLASS(SeparableConv2D);
@@ -210,6 +213,7 @@ DEFINE_SHADER_LAYER1(Flatten);
 DEFINE_SHADER_LAYER1(Pad);
 DEFINE_SHADER_LAYER1(BatchNormalization);
 DEFINE_SHADER_LAYER1(InstanceNorm);
+DEFINE_SHADER_LAYER1(InvertedResidual);
 DEFINE_SHADER_LAYER1(Unary);
 
 } // namespace dp
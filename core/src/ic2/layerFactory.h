@@ -144,6 +144,7 @@ DECLARE_SHADER_LAYER1(Flatten);
 DECLARE_SHADER_LAYER1(Pad);
 DECLARE_SHADER_LAYER1(BatchNormalization);
 DECLARE_SHADER_LAYER1(InstanceNorm);
+DECLARE_SHADER_LAYER1(InvertedResidual);
 DECLARE_SHADER_LAYER1(YOLO);
 DECLARE_SHADER_LAYER1(Unary);
 
@@ -39,6 +39,19 @@ public:
     virtual ~MaxPooling2DLayer() = default;
     InferenceGraph::Transform getOutputScaleDimAdjustment() const override;
 
+    bool getSpatialFootprint(uint32_t& kernelRadius, float& scale) const override {
+        kernelRadius = _desc.kernelSize / 2;
+        scale        = 1.0f / static_cast<float>(_desc.stride);
+        return true;
+    }
+
+    void getArithmeticCost(uint64_t& macs, uint64_t& numWeights) const override {
+        uint32_t width = 0, height = 0, depth = 0;
+        getOutputDims(width, height, depth);
+        macs       = (uint64_t) width * height * _desc.numOutputPlanes * _desc.kernelSize * _desc.kernelSize;
+        numWeights = 0;
+    }
+
 protected:
     MaxPooling2DDesc _desc;
 
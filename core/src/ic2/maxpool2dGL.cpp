@@ -125,8 +125,7 @@ void MaxPooling2DLayerGl::buildPreDefine(std::ostringstream& stream, const Gener
     stream << "// " << shaderFilePath << std::endl;
     stream << "#define NUM_INPUT_PLANES " << _desc.numInputPlanes << std::endl;
     stream << "#define NUM_OUTPUT_PLANES " << _desc.numOutputPlanes << std::endl;
-    stream << "#define INPUT_WIDTH " << options.desiredInput[0].width << std::endl;
-    stream << "#define INPUT_HEIGHT " << options.desiredInput[0].height << std::endl;
+    buildInputSizeDefines(stream, options);
     stream << "#define NUM_STRIDE " << _desc.stride << std::endl;
     stream << "#define N_DIMS " << _desc.kernelSize * _desc.kernelSize << std::endl;
     stream << "#define KERNEL_SIZE " << _desc.kernelSize << std::endl;
@@ -365,16 +364,7 @@ InferencePassesSptr MaxPooling2DLayerGl::createCS(const LayerGenOptions& options
         shaderHeader += "#define OUTPUT_TEXTURE_2D\n";
     }
 
-    std::string shaderUniforms = "#ifdef INPUT_TEXTURE_2D\n"
-                            "layout(OUTPUT_FORMAT, binding=0) readonly uniform PRECISION image2D uInput;\n"
-                            "#else\n"
-                            "layout(OUTPUT_FORMAT, binding=0) readonly uniform PRECISION image2DArray uInput;\n"
-                            "#endif\n"
-                            "#ifdef OUTPUT_TEXTURE_2D\n"
-                            "layout(OUTPUT_FORMAT, binding=3) writeonly uniform PRECISION image2D uOutput;\n"
-                            "#else\n"
-                            "layout(OUTPUT_FORMAT, binding=3) writeonly uniform PRECISION image2DArray uOutput;\n"
-                            "#endif\n";
+    std::string shaderUniforms = buildComputeInputDeclaration("uInput", 0, 0, _desc.numInputPlanes <= 4) + buildComputeOutputDeclaration("uOutput", 3, _desc.numOutputPlanes <= 4);
 
     std::string shaderMain = loadShader(MAXPOOLING2D_CS_ASSET_NAME);
 
@@ -28,6 +28,8 @@ public:
     MaxPooling2DLayerGl(MaxPooling2DDesc&& d): MaxPooling2DLayer(std::move(d)) {}
     virtual ~MaxPooling2DLayerGl() = default;
 
+    bool supportsBufferActivations() const override { return true; }
+
 protected:
     InferencePassesSptr createFS(const LayerGenOptions&) const override;
     InferencePassesSptr createCS(const LayerGenOptions&) const override;
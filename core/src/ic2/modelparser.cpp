@@ -14,6 +14,7 @@
  */
 #include "pch.h"
 #include <snn/utils.h>
+#include <snn/fp16.h>
 #include "modelparser.h"
 #include <string>
 #include <vector>
@@ -36,6 +37,11 @@ bool ModelParser::isInputRange01() {
 
 bool ModelParser::getPrecision() { return this->preferHp; }
 
+bool ModelParser::getPrecision(int layerId) {
+    auto it = layerHalfPrecision.find((uint32_t) layerId);
+    return it != layerHalfPrecision.end() ? it->second : this->preferHp;
+}
+
 int ModelParser::getLayerCount() {
     SNN_LOGV("ModelParser:: Get number of _shaderLayers in the model");
     picojson::object& numNode = _modelOb.get("numLayers").get<picojson::object>();
@@ -212,6 +218,7 @@ ModelParser::ModelParser(const CreationParameters cp) {
     this->preferHp   = cp.preferHp;
     this->mrtMode    = cp.mrtMode;
     this->weightMode = cp.weightMode;
+    this->layerHalfPrecision = cp.layerHalfPrecision;
 
 #ifdef __ANDROID__
     auto jsonBytes = snn::loadJsonFromStorage(name.c_str());
@@ -617,19 +624,13 @@ int ModelParser::getConvolutionLayer(int& layerId, int& numOutputPlanes, int& nu
         picojson::object& weightObj = layerObj["weights"].get<picojson::object>();
         weights                     = std::vector<cv::Mat>(numInputPlanes * numOutputPlanes, cv::Mat(kernelSize, kernelSize, CV_32FC1));
         int matProgress             = 0;
-        float value;
         if (isBinWeight) {
             for (int i = 0; i < numOutputPlanes; i++) {
                 for (int j = 0; j < numInputPlanes; j++) {
                     cv::Mat writeMatrix = cv::Mat::zeros(kernelSize, kernelSize, CV_32FC1);
-                    for (int writingRow = 0; writingRow < kernelSize; writingRow++) {
-                        for (int writingCol = 0; writingCol < kernelSize; writingCol++) {
-                            binFile.read((char*) &value, sizeof(float));
-                            if (this->preferHp) {
-                                value = snn::convertToMediumPrecision(value);
-                            }
-                            writeMatrix.at<float>(writingRow, writingCol) = value;
-                        }
+                    binFile.read((char*) writeMatrix.ptr<float>(), kernelSize * kernelSize * sizeof(float));
+                    if (getPrecision(layerId)) {
+                        snn::fp16::roundToHalf(writeMatrix.ptr<float>(), writeMatrix.ptr<float>(), kernelSize * kernelSize);
                     }
                     weights.at(matProgress) = std::move(writeMatrix);
                     matProgress++;
@@ -643,14 +644,13 @@ int ModelParser::getConvolutionLayer(int& layerId, int& numOutputPlanes, int& nu
                     cv::Mat writeMatrix = cv::Mat::zeros(kernelSize, kernelSize, CV_32FC1);
                     for (int writingRow = 0; writingRow < kernelSize; writingRow++) {
                         for (int writingCol = 0; writingCol < kernelSize; writingCol++) {
-                            float data = static_cast<float>(weightArray[element_number].get<double_t>());
-                            if (this->preferHp) {
-                                data = snn::convertToMediumPrecision(data);
-                            }
+                            writeMatrix.at<float>(writingRow, writingCol) = static_cast<float>(weightArray[element_number].get<double_t>());
                             element_number++;
-                            writeMatrix.at<float>(writingRow, writingCol) = data;
                         }
                     }
+                    if (getPrecision(layerId)) {
+                        snn::fp16::roundToHalf(writeMatrix.ptr<float>(), writeMatrix.ptr<float>(), kernelSize * kernelSize);
+                    }
                     weights.at(matProgress) = std::move(writeMatrix);
                     matProgress++;
                 }
@@ -660,22 +660,16 @@ int ModelParser::getConvolutionLayer(int& layerId, int& numOutputPlanes, int& nu
         biases.resize(numOutputPlanes);
         if (layerObj["useBias"].get<std::string>().compare("True") == 0) {
             if (isBinWeight) {
-                for (int i = 0; i < numOutputPlanes; i++) {
-                    binFile.read((char*) &value, sizeof(float));
-                    biases[i] = value;
-                    if (this->preferHp) {
-                        biases[i] = snn::convertToMediumPrecision(biases[i]);
-                    }
-                }
+                binFile.read((char*) biases.data(), numOutputPlanes * sizeof(float));
             } else {
                 picojson::array biasArray = weightObj["bias"].get<picojson::array>();
                 for (int i = 0; i < numOutputPlanes; i++) {
                     biases[i] = biasArray[i].get<double_t>();
-                    if (this->preferHp) {
-                        biases[i] = snn::convertToMediumPrecision(biases[i]);
-                    }
                 }
             }
+            if (getPrecision(layerId)) {
+                snn::fp16::roundToHalf(biases);
+            }
         } else {
             for (int i = 0; i < numOutputPlanes; i++) {
                 biases[i] = 0.0f;
@@ -692,37 +686,9 @@ int ModelParser::getConvolutionLayer(int& layerId, int& numOutputPlanes, int& nu
 
             picojson::object& batchNormObj = layerObj["batchNormalization"].get<picojson::object>();
             if (isBinWeight) {
-                gammaBN = std::vector<float>(numOutputPlanes);
-                for (int i = 0; i < numOutputPlanes; i++) {
-                    binFile.read((char*) &value, sizeof(float));
-                    gammaBN[i] = value;
-                    if (this->preferHp) {
-                        gammaBN[i] = snn::convertToMediumPrecision(value);
-                    }
-                }
-                betaBN = std::vector<float>(numOutputPlanes);
-                for (int i = 0; i < numOutputPlanes; i++) {
-                    binFile.read((char*) &value, sizeof(float));
-                    betaBN[i] = value;
-                    if (this->preferHp) {
-                        betaBN[i] = snn::convertToMediumPrecision(value);
-                    }
-                }
-                meanBN = std::vector<float>(numOutputPlanes);
-                for (int i = 0; i < numOutputPlanes; i++) {
-                    binFile.read((char*) &value, sizeof(float));
-                    meanBN[i] = value;
-                    if (this->preferHp) {
-                        meanBN[i] = snn::convertToMediumPrecision(value);
-                    }
-                }
-                varianceBN = std::vector<float>(numOutputPlanes);
-                for (int i = 0; i < numOutputPlanes; i++) {
-                    binFile.read((char*) &value, sizeof(float));
-                    varianceBN[i] = value;
-                    if (this->preferHp) {
-                        varianceBN[i] = snn::convertToMediumPrecision(value);
-                    }
+                for (auto bn : {&gammaBN, &betaBN, &meanBN, &varianceBN}) {
+                    bn->resize(numOutputPlanes);
+                    binFile.read((char*) bn->data(), numOutputPlanes * sizeof(float));
                 }
             } else {
                 picojson::array betaArray  = batchNormObj["beta"].get<picojson::array>();
@@ -742,17 +708,15 @@ int ModelParser::getConvolutionLayer(int& layerId, int& numOutputPlanes, int& nu
                 }
 
                 for (int i = 0; i < numOutputPlanes; i++) {
-                    if (this->preferHp) {
-                        betaBN.emplace_back(snn::convertToMediumPrecision(static_cast<float>(betaArray[i].get<double>())));
-                        gammaBN.emplace_back(snn::convertToMediumPrecision(static_cast<float>(gammaArray[i].get<double>())));
-                        meanBN.emplace_back(snn::convertToMediumPrecision(static_cast<float>(movingMean[i].get<double>())));
-                        varianceBN.emplace_back(snn::convertToMediumPrecision(static_cast<float>(movingVariance[i].get<double>())));
-                    } else {
-                        betaBN.emplace_back(static_cast<float>(betaArray[i].get<double>()));
-                        gammaBN.emplace_back(static_cast<float>(gammaArray[i].get<double>()));
-                        meanBN.emplace_back(static_cast<float>(movingMean[i].get<double>()));
-                        varianceBN.emplace_back(static_cast<float>(movingVariance[i].get<double>()));
-                    }
+                    betaBN.emplace_back(static_cast<float>(betaArray[i].get<double>()));
+                    gammaBN.emplace_back(static_cast<float>(gammaArray[i].get<double>()));
+                    meanBN.emplace_back(static_cast<float>(movingMean[i].get<double>()));
+                    varianceBN.emplace_back(static_cast<float>(movingVariance[i].get<double>()));
+                }
+            }
+            if (getPrecision(layerId)) {
+                for (auto bn : {&gammaBN, &betaBN, &meanBN, &varianceBN}) {
+                    snn::fp16::roundToHalf(*bn);
                 }
             }
             batchNormalization.insert(std::pair<std::string, std::vector<float>>("beta", betaBN));
@@ -767,7 +731,7 @@ int ModelParser::getConvolutionLayer(int& layerId, int& numOutputPlanes, int& nu
             } else {
                 leakyReluAlpha = static_cast<float>(layerObj["alpha"].get<double>());
             }
-            if (this->preferHp) {
+            if (getPrecision(layerId)) {
                 leakyReluAlpha = snn::convertToMediumPrecision(leakyReluAlpha);
             }
         }
@@ -826,14 +790,9 @@ int ModelParser::getDepthwiseConvolutionLayer(int& layerId, int& numOutputPlanes
         if (isBinWeight) {
             for (int j = 0; j < numInputPlanes; j++) {
                 cv::Mat writeMatrix = cv::Mat::zeros(kernelSize, kernelSize, CV_32FC1);
-                for (int writingRow = 0; writingRow < kernelSize; writingRow++) {
-                    for (int writingCol = 0; writingCol < kernelSize; writingCol++) {
-                        binFile.read((char*)&value, sizeof(float));
-                        if (this->preferHp) {
-                            value = snn::convertToMediumPrecision(value);
-                        }
-                        writeMatrix.at<float>(writingRow, writingCol) = value;
-                    }
+                binFile.read((char*) writeMatrix.ptr<float>(), kernelSize * kernelSize * sizeof(float));
+                if (getPrecision(layerId)) {
+                    snn::fp16::roundToHalf(writeMatrix.ptr<float>(), writeMatrix.ptr<float>(), kernelSize * kernelSize);
                 }
                 weights.at(matProgress) = std::move(writeMatrix);
                 matProgress++;
@@ -848,17 +807,16 @@ int ModelParser::getDepthwiseConvolutionLayer(int& layerId, int& numOutputPlanes
                     chw[c * planeSize + i] = (float) weightArray[i * numInputPlanes + c].get<double_t>();
                 }
             }
+            if (getPrecision(layerId)) {
+                snn::fp16::roundToHalf(chw);
+            }
             int element_number = 0;
             for (int j = 0; j < numInputPlanes; j++) {
                 cv::Mat writeMatrix = cv::Mat::zeros(kernelSize, kernelSize, CV_32FC1);
                 for (int writingRow = 0; writingRow < kernelSize; writingRow++) {
                     for (int writingCol = 0; writingCol < kernelSize; writingCol++) {
-                        float data = chw[element_number];
-                        if (this->preferHp) {
-                            data = snn::convertToMediumPrecision(data);
-                        }
+                        writeMatrix.at<float>(writingRow, writingCol) = chw[element_number];
                         element_number++;
-                        writeMatrix.at<float>(writingRow, writingCol) = data;
                     }
                 }
                 weights.at(matProgress) = std::move(writeMatrix);
@@ -869,22 +827,16 @@ int ModelParser::getDepthwiseConvolutionLayer(int& layerId, int& numOutputPlanes
         biases.resize(numOutputPlanes);
         if (layerObj["useBias"].get<std::string>().compare("True") == 0) {
             if (isBinWeight) {
-                for (int i = 0; i < numOutputPlanes; i++) {
-                    binFile.read((char*)&value, sizeof(float));
-                    biases[i] = value;
-                    if (this->preferHp) {
-                        biases[i] = snn::convertToMediumPrecision(biases[i]);
-                    }
-                }
+                binFile.read((char*) biases.data(), numOutputPlanes * sizeof(float));
             } else {
                 picojson::array biasArray = weightObj["bias"].get<picojson::array>();
                 for (int i = 0; i < numOutputPlanes; i++) {
                     biases[i] = biasArray[i].get<double_t>();
-                    if (this->preferHp) {
-                        biases[i] = snn::convertToMediumPrecision(biases[i]);
-                    }
                 }
             }
+            if (getPrecision(layerId)) {
+                snn::fp16::roundToHalf(biases);
+            }
         }
         else {
             for (int i = 0; i < numOutputPlanes; i++) {
@@ -942,17 +894,15 @@ int ModelParser::getDepthwiseConvolutionLayer(int& layerId, int& numOutputPlanes
                 }
 
                 for (int i = 0; i < numOutputPlanes; i++) {
-                    if (this->preferHp) {
-                        betaBN.emplace_back(snn::convertToMediumPrecision(static_cast<float>(betaArray[i].get<double>())));
-                        gammaBN.emplace_back(snn::convertToMediumPrecision(static_cast<float>(gammaArray[i].get<double>())));
-                        meanBN.emplace_back(snn::convertToMediumPrecision(static_cast<float>(movingMean[i].get<double>())));
-                        varianceBN.emplace_back(snn::convertToMediumPrecision(static_cast<float>(movingVariance[i].get<double>())));
-                    } else {
-                        betaBN.emplace_back(static_cast<float>(betaArray[i].get<double>()));
-                        gammaBN.emplace_back(static_cast<float>(gammaArray[i].get<double>()));
-                        meanBN.emplace_back(static_cast<float>(movingMean[i].get<double>()));
-                        varianceBN.emplace_back(static_cast<float>(movingVariance[i].get<double>()));
-                    }
+                    betaBN.emplace_back(static_cast<float>(betaArray[i].get<double>()));
+                    gammaBN.emplace_back(static_cast<float>(gammaArray[i].get<double>()));
+                    meanBN.emplace_back(static_cast<float>(movingMean[i].get<double>()));
+                    varianceBN.emplace_back(static_cast<float>(movingVariance[i].get<double>()));
+                }
+            }
+            if (getPrecision(layerId)) {
+                for (auto bn : {&gammaBN, &betaBN, &meanBN, &varianceBN}) {
+                    snn::fp16::roundToHalf(*bn);
                 }
             }
             batchNormalization.insert(std::pair<std::string, std::vector<float>>("beta", betaBN));
@@ -962,7 +912,7 @@ int ModelParser::getDepthwiseConvolutionLayer(int& layerId, int& numOutputPlanes
         }
 
         if (activation.compare("leakyRelu") == 0) {
-            if (this->preferHp) {
+            if (getPrecision(layerId)) {
                 if (layerObj.count("leakyReluAlpha")) {
                     leakyReluAlpha = snn::convertToMediumPrecision(static_cast<float>(layerObj["leakyReluAlpha"].get<double>()));
                 } else {
@@ -1045,36 +995,24 @@ int ModelParser::getBatchNormLayer(int& layerId, int& numOutputPlanes, int& numI
         }
 
         for (int i = 0; i < numOutputPlanes; i++) {
-            if (this->preferHp) {
-                if (batchNormObj.count("beta")) {
-                    betaBN.emplace_back(snn::convertToMediumPrecision(static_cast<float>(betaArray[i].get<double>())));
-                } else {
-                    betaBN.emplace_back(snn::convertToMediumPrecision(static_cast<float>(0.0f)));
-                }
-
-                if (batchNormObj.count("gamma")) {
-                    gammaBN.emplace_back(snn::convertToMediumPrecision(static_cast<float>(gammaArray[i].get<double>())));
-                } else {
-                    gammaBN.emplace_back(snn::convertToMediumPrecision(static_cast<float>(1.0f)));
-                }
-
-                meanBN.emplace_back(snn::convertToMediumPrecision(static_cast<float>(movingMean[i].get<double>())));
-                varianceBN.emplace_back(snn::convertToMediumPrecision(static_cast<float>(movingVariance[i].get<double>())));
+            if (batchNormObj.count("beta")) {
+                betaBN.emplace_back(static_cast<float>(betaArray[i].get<double>()));
             } else {
-                if (batchNormObj.count("beta")) {
-                    betaBN.emplace_back(static_cast<float>(betaArray[i].get<double>()));
-                } else {
-                    betaBN.emplace_back(static_cast<float>(0.0f));
-                }
+                betaBN.emplace_back(static_cast<float>(0.0f));
+            }
 
-                if (batchNormObj.count("gamma")) {
-                    gammaBN.emplace_back(static_cast<float>(gammaArray[i].get<double>()));
-                } else {
-                    gammaBN.emplace_back(static_cast<float>(1.0f));
-                }
+            if (batchNormObj.count("gamma")) {
+                gammaBN.emplace_back(static_cast<float>(gammaArray[i].get<double>()));
+            } else {
+                gammaBN.emplace_back(static_cast<float>(1.0f));
+            }
 
-                meanBN.emplace_back(static_cast<float>(movingMean[i].get<double>()));
-                varianceBN.emplace_back(static_cast<float>(movingVariance[i].get<double>()));
+            meanBN.emplace_back(static_cast<float>(movingMean[i].get<double>()));
+            varianceBN.emplace_back(static_cast<float>(movingVariance[i].get<double>()));
+        }
+        if (getPrecision(layerId)) {
+            for (auto bn : {&gammaBN, &betaBN, &meanBN, &varianceBN}) {
+                snn::fp16::roundToHalf(*bn);
             }
         }
         batchNormalization.insert(std::pair<std::string, std::vector<float>>("beta", betaBN));
@@ -1086,7 +1024,7 @@ int ModelParser::getBatchNormLayer(int& layerId, int& numOutputPlanes, int& numI
             activation = layerObj["activation"].get<std::string>();
         }
         if (activation.compare("leakyRelu") == 0) {
-            if (this->preferHp) {
+            if (getPrecision(layerId)) {
                 if (layerObj.count("leakyReluAlpha")) {
                     leakyReluAlpha = snn::convertToMediumPrecision(static_cast<float>(layerObj["leakyReluAlpha"].get<double>()));
                 } else {
@@ -1167,25 +1105,23 @@ int ModelParser::getInstanceNormalizationLayer(int& layerId, int& numOutputPlane
         picojson::array biasArray = weightObj["bias"].get<picojson::array>();
         for (int i = 0; i < numOutputPlanes; i++) {
             bias.at(i) = biasArray[i].get<double_t>();
-            if (this->preferHp) {
-                bias.at(i) = snn::convertToMediumPrecision(bias.at(i));
-            }
         }
 
         scale.resize(numOutputPlanes);
         picojson::array scaleArray = weightObj["scale"].get<picojson::array>();
         for (int i = 0; i < numOutputPlanes; i++) {
             scale.at(i) = scaleArray[i].get<double_t>();
-            if (this->preferHp) {
-                scale.at(i) = snn::convertToMediumPrecision(scale.at(i));
-            }
+        }
+        if (getPrecision(layerId)) {
+            snn::fp16::roundToHalf(bias);
+            snn::fp16::roundToHalf(scale);
         }
 
         batchNormalization.insert(std::pair<std::string, std::vector<float>>("beta", bias));
         batchNormalization.insert(std::pair<std::string, std::vector<float>>("gamma", scale));
 
         if (activation.compare("leakyRelu") == 0) {
-            if (this->preferHp) {
+            if (getPrecision(layerId)) {
                 leakyReluAlpha = snn::convertToMediumPrecision(static_cast<float>(layerObj["leakyReluAlpha"].get<double>()));
             } else {
                 leakyReluAlpha = static_cast<float>(layerObj["leakyReluAlpha"].get<double>());
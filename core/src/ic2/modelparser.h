@@ -31,6 +31,7 @@ class ModelParser {
 private:
     picojson::value _modelOb;
     bool preferHp; // For half precision (16-bit floats)
+    std::map<uint32_t, bool> layerHalfPrecision; // Per-layer precision overrides, keyed by the layer index
     bool isBinWeight = false;
     std::ifstream binFile; // For reading weight from separate file
     MRTMode mrtMode;
@@ -42,6 +43,7 @@ public:
         bool preferHp;
         MRTMode mrtMode;
         WeightAccessMethod weightMode;
+        std::map<uint32_t, bool> layerHalfPrecision = {};
     };
 
     bool isInputRange01();
@@ -64,6 +66,13 @@ public:
 
     bool getPrecision();
 
+    // Gets the precision of a layer: the per-layer override, if there is one, or the model precision
+    // params:
+    //  layerId - layer index
+    // returns:
+    //  true for 16-bit floats, false for 32-bit floats
+    bool getPrecision(int layerId);
+
     snn::MRTMode getMRTMode();
 
     snn::WeightAccessMethod getWeightMode();
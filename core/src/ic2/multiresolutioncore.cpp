@@ -0,0 +1,131 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pch.h"
+#include "snn/multiresolutioncore.h"
+#include "dp.h"
+#include "renderpass.h"
+#ifdef SUPPORT_GL
+    #include "glUtils.h"
+#endif
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace snn;
+
+snn::MultiResolutionInferenceCore::MultiResolutionInferenceCore(GpuContext* context_, const CreationParameters& cp_)
+    : context(context_)
+    , cp(cp_)
+    , weightCache(std::make_shared<WeightCache>())
+{
+    cp.options.dynamicShapes = true;
+    if (cp.cacheCapacity == 0) {
+        cp.cacheCapacity = 1;
+    }
+#ifdef SUPPORT_GL
+    if (cp.programBinaryCacheSize > 0 && context->backendType == GpuBackendType::GL) {
+        gl::setProgramBinaryCacheLimit(cp.programBinaryCacheSize);
+    }
+#endif
+}
+
+std::unique_ptr<MultiResolutionInferenceCore> snn::MultiResolutionInferenceCore::create(GpuContext* context, const CreationParameters& cp) {
+    if (cp.options.desiredInput.empty()) {
+        SNN_LOGE("Input description is missing");
+        return nullptr;
+    }
+    return std::unique_ptr<MultiResolutionInferenceCore>(new MultiResolutionInferenceCore(context, cp));
+}
+
+MixedInferenceCore* snn::MultiResolutionInferenceCore::acquire(const std::vector<std::array<uint32_t, 2>>& inputSizes) {
+    if (!cores.empty() && cores.front().inputSizes == inputSizes) {
+        return cores.front().core.get();
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    bool hit   = false;
+    for (auto iter = cores.begin(); iter != cores.end(); ++iter) {
+        if (iter->inputSizes == inputSizes) {
+            cores.splice(cores.begin(), cores, iter);
+            hit = true;
+            break;
+        }
+    }
+
+    if (!hit) {
+        if (inputSizes.size() != cp.options.desiredInput.size()) {
+            SNN_LOGE("Wrong input count %zu <-> %zu", inputSizes.size(), cp.options.desiredInput.size());
+            return nullptr;
+        }
+        // Every prepared core needs its own layers, as layers keep the inference passes and GPU resources
+        bool useVulkan = context->backendType == GpuBackendType::VULKAN;
+        auto dp = snn::dp::loadFromJsonModel(cp.modelFileName, useVulkan, cp.options.mrtMode, cp.options.weightMode, cp.options.preferrHalfPrecision,
+                                             cp.options.layerHalfPrecision);
+        if (dp.empty()) {
+            SNN_LOGE("Failed to load model %s", cp.modelFileName.c_str());
+            return nullptr;
+        }
+        dp::ShaderGenOptions options = cp.options;
+        for (size_t i = 0; i < inputSizes.size(); ++i) {
+            options.desiredInput[i].width  = inputSizes[i][0];
+            options.desiredInput[i].height = inputSizes[i][1];
+        }
+        MixedInferenceCore::CreationParameters inferenceCP;
+        (InferenceGraph &&) inferenceCP = snn::dp::generateInferenceGraph(dp, options);
+        inferenceCP.dumpOutputs         = false;
+        inferenceCP.weightCache         = weightCache;
+        if (inferenceCP.layers.empty()) {
+            SNN_LOGE("Failed to generate inference graph for input resolution %ux%u", inputSizes[0][0], inputSizes[0][1]);
+            return nullptr;
+        }
+
+        if (cores.size() >= cp.cacheCapacity) {
+            // Release the least recently used core first to keep the peak GPU memory down.
+            // Its weights stay alive, while cores of other resolutions use them.
+            cores.pop_back();
+        }
+        auto core = MixedInferenceCore::create(context, inferenceCP);
+        if (!core) {
+            // Failed resolutions are not cached, so that the next request tries again
+            SNN_LOGE("Failed to prepare input resolution %ux%u", inputSizes[0][0], inputSizes[0][1]);
+            return nullptr;
+        }
+        cores.push_front({inputSizes, std::move(core)});
+    }
+
+    auto end       = std::chrono::high_resolution_clock::now();
+    lastSwitchTime = std::chrono::duration<double, std::milli>(end - start).count();
+    SNN_LOGI("Switched to input resolution %ux%u in %.3f ms (%s, %zu cached)", inputSizes[0][0], inputSizes[0][1], lastSwitchTime,
+        hit ? "cache hit" : "prepared", cores.size());
+    return cores.front().core.get();
+}
+
+bool snn::MultiResolutionInferenceCore::prepare(const std::vector<std::array<uint32_t, 2>>& inputSizes) {
+    return acquire(inputSizes) != nullptr;
+}
+
+void snn::MultiResolutionInferenceCore::run(MixedInferenceCore::RunParameters& rp) {
+    std::vector<std::array<uint32_t, 2>> inputSizes;
+    for (size_t i = 0; i < rp.inputImages.size(); ++i) {
+        const auto& dims = rp.inputImages[i].getDims();
+        inputSizes.push_back({dims[0], dims[1]});
+    }
+    auto core = acquire(inputSizes);
+    if (!core) {
+        return;
+    }
+    core->run(rp);
+}
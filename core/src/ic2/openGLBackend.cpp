@@ -23,13 +23,34 @@
 #include <memory>
 #include <variant>
 #include <utility>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 
 using namespace snn;
 using namespace snn::dp;
 
-OpenGLBackend::OpenGLBackend(const snn::dp::OpenGLBackend::CreationParameters& cp) {
+// Issues every binding call of render passes, to compare with the state cache
+static constexpr const char* SNN_GL_NO_STATE_CACHE = "SNN_GL_NO_STATE_CACHE";
+
+// Compiles and links the programs of render passes one by one, to compare with parallel compilation
+static constexpr const char* SNN_GL_SERIAL_SHADER_COMPILE = "SNN_GL_SERIAL_SHADER_COMPILE";
+
+static bool getEnvFlag(const char* name) {
+    const char* value = getenv(name);
+    return value && strcmp(value, "0") != 0;
+}
+
+OpenGLBackend::OpenGLBackend(const snn::dp::OpenGLBackend::CreationParameters& cp)
+    : _state(getEnvFlag(SNN_GL_NO_STATE_CACHE))
+    , _serialShaderCompile(getEnvFlag(SNN_GL_SERIAL_SHADER_COMPILE))
+{
     _cp = cp;
 
+    if (!_serialShaderCompile && gl::enableParallelShaderCompile()) {
+        SNN_LOGD("Parallel shader compilation is enabled");
+    }
+
     samplers.resize(2);
 
     int channelsPerPass = static_cast<int>(this->_cp.mrtMode);
@@ -80,113 +101,132 @@ OpenGLBackend::OpenGLBackend(const snn::dp::OpenGLBackend::CreationParameters& c
     glSamplerParameteri(sampler2, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glSamplerParameteri(sampler2, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-    samplers.at(0) = std::move(sampler);
-    samplers.at(1) = std::move(sampler2);
+    // Render passes bind samplers themselves. The same samplers are used by all passes.
+    samplers.at(0) = sampler;
+    samplers.at(1) = sampler2;
 
     // allocate debug buffer
     debugger.allocate(16 * 1024);
 }
 
-void OpenGLBackend::initRenderPasses(snn::dp::GenericModelLayer* modelLayer, snn::ImageTextureArrayAccessor texInputs,
-    snn::ImageTextureArrayAccessor texOutputs) {
-    modelLayer->getRenderPasses().clear();
+bool OpenGLBackend::compileRenderPasses(snn::dp::GenericModelLayer* modelLayer) {
+    modelLayer->getCompiledPasses().clear();
 
     if (modelLayer->isInputLayer()) {
-        return;
+        return true;
     }
 
     const InferencePassesGl* passesGl = InferencePassesGl::cast(modelLayer->getPasses());
     for (size_t i = 0; i < passesGl->passes.size(); i++) {
         auto& pass = passesGl->passes[i];
 
-        std::visit(match {[&](const InferencePassGl::FsProgram&) {
-                            sampler.bind(0);
-                            sampler2.bind(1);
-                            samplers.at(0) = std::move(sampler);
-                            samplers.at(1) = std::move(sampler2);
-                            weightSamplersUint.clear();
-                            int index = 2;
-                            for (auto& sampler : weightSamplers) {
-                                sampler.bind(index);
-                                weightSamplersUint.push_back((GLuint) sampler);
-                                index++;
-                            }
-                        },
-                        [&](const InferencePassGl::CsProgram&) {
-                            sampler.bind(0);
-                            sampler2.bind(1);
-                            samplers.at(0)      = std::move(sampler);
-                            samplers.at(1)      = std::move(sampler2);
-                            auto& weightSampler = weightSamplers.at(0);
-                            weightSampler.bind(2);
-                            weightSamplersUint.clear();
-                            weightSamplersUint.resize(1);
-                            weightSamplersUint.at(0) = (GLuint) weightSampler;
-                        }},
-                    pass.program);
+        // Output of the layer might be a layer range of a consumer's output (zero-copy concatenation)
+        InferencePassGl passGl = pass;
+        if (auto fs = std::get_if<InferencePassGl::FsProgram>(&passGl.program)) {
+            fs->outputSliceIndex += modelLayer->getOutputPlaneOffset();
+        } else {
+            SNN_ASSERT(modelLayer->getOutputPlaneOffset() == 0);
+        }
+
+        std::string name = formatString("%s pass[%d]", modelLayer->getName().c_str(), i);
+        std::shared_ptr<const OpenGLCompiledPass> weightSource;
+        if (_cp.weightCache) {
+            weightSource = std::static_pointer_cast<const OpenGLCompiledPass>(_cp.weightCache->find(name));
+        }
+        OpenGLCompiledPass::CreationParameters cpcp = {
+            name,
+            passGl,
+            weightSource,
+        };
+
+        auto compiledPass = std::make_shared<snn::OpenGLCompiledPass>(cpcp);
+        if (_cp.weightCache && !weightSource) {
+            _cp.weightCache->add(name, compiledPass);
+        }
+        if (_serialShaderCompile) {
+            if (!compiledPass->finishInit()) {
+                return false;
+            }
+        } else {
+            _pendingPasses.push_back(compiledPass);
+        }
+
+        modelLayer->getCompiledPasses().push_back(compiledPass);
+    }
+    return true;
+}
+
+bool OpenGLBackend::finishRenderPasses() {
+    SNN_LOGD("Finishing %zu compiled passes", _pendingPasses.size());
+    // Without parallel compilation all programs are complete, and the passes are finished in the creation order.
+    // Otherwise finish the passes, whose programs are ready, and wait for the oldest one only when none is.
+    // All passes are finished even after a failure, so that every program error is logged
+    bool compiled = true;
+    while (!_pendingPasses.empty()) {
+        auto ready = std::stable_partition(_pendingPasses.begin(), _pendingPasses.end(),
+            [](const std::shared_ptr<OpenGLCompiledPass>& pass) { return !pass->isProgramComplete(); });
+        if (ready == _pendingPasses.end()) {
+            compiled = _pendingPasses.front()->finishInit() && compiled;
+            _pendingPasses.erase(_pendingPasses.begin());
+            continue;
+        }
+        for (auto it = ready; it != _pendingPasses.end(); ++it) {
+            compiled = (*it)->finishInit() && compiled;
+        }
+        _pendingPasses.erase(ready, _pendingPasses.end());
+    }
+    return compiled;
+}
+
+void OpenGLBackend::initRenderPasses(snn::dp::GenericModelLayer* modelLayer, snn::ImageTextureArrayAccessor texInputs,
+    snn::ImageTextureArrayAccessor texOutputs, std::vector<std::shared_ptr<RenderPass>>& renderPasses) {
+    renderPasses.clear();
 
+    const auto& compiledPasses = modelLayer->getCompiledPasses();
+    for (const auto& compiledPass : compiledPasses) {
+        auto compiledPassGl = std::static_pointer_cast<const OpenGLCompiledPass>(compiledPass);
         OpenGLRenderPass::CreationParameters rpcp = {
-            formatString("%s pass[%d]", modelLayer->getName().c_str(), i),
-            pass,
+            compiledPassGl->getName(),
+            compiledPassGl,
             samplers,
             weightSamplersUint,
             texInputs,
             texOutputs,
+            &_state,
         };
-
-        auto renderPass = std::make_shared<snn::OpenGLRenderPass>(rpcp);
-
-        modelLayer->getRenderPasses().push_back(renderPass);
+        renderPasses.push_back(std::make_shared<snn::OpenGLRenderPass>(rpcp));
     }
 }
 
-void OpenGLBackend::prepareRun(snn::MixedInferenceCore::RunParameters& rp,
-        RenderStagesArray &stages, bool bindOutput, uint32_t bindIndex) {
+void OpenGLBackend::prepareRun(snn::MixedInferenceCore::RunParameters& rp, RenderStagesArray &stages) {
     (void) rp;
     (void) stages;
-    (void) bindOutput;
-    (void) bindIndex;
-#ifdef __ANDROID__
-    if (rp.outputImages()) {
-        if (bindOutput) {
-#ifdef _DEBUG
-            ImageTextureGL& outputImageGL = ImageTextureGL::cast(rp.outputImages[0]);
-            const InferenceGraph::IODesc& outputDesc = stages[bindIndex].layer->outputDesc;
-            for (size_t i = 0; i < outputImageGL.getNumTextures(); i++) {
-                gl::TextureObject* tex = outputImageGL.texture(i);
-#if 0
-                // Texture format in fact might not match the description.
-                // For example we describe output format in a shader as RGBAF16, but write into RGBAF32.
-                // TODO: figure out why this works just fine.
-                SNN_ASSERT(tex->getDesc().format == outputDesc.format);
-#endif
-                SNN_LOGI("%d %d", tex->getDesc().width, outputDesc.width);
-                SNN_ASSERT(tex->getDesc().width == outputDesc.width);
-                SNN_ASSERT(tex->getDesc().height == outputDesc.height);
-                SNN_ASSERT(tex->getDesc().depth == outputDesc.depth);
-                // We do not compare channels as they can be rounded up to 4. Comparing format is enough
-            }
-#endif
-            stages[bindIndex].stageOutputs[0].attach(&rp.outputImages[0]);
-        }
-    }
-#endif
 
     // setup common GL states
     glDisable(GL_DEPTH_TEST);
     // bind debug buffer
     debugger.clearCounter();
     debugger.bind();
+    // Bindings might be changed outside of the render passes since the last run
+    _state.invalidate();
     return;
 }
 
 void OpenGLBackend::prepareStage(snn::MixedInferenceCore::RunParameters& rp, snn::RenderStage& stage) {
     (void) rp;
     snn::ImageTextureGLArrayAccessor stageOutputsGL = stage.stageOutputs;
+    if (stageOutputsGL[0].buffer()) {
+        // Only compute shaders write into storage buffers, they don't need the viewport
+        return;
+    }
     glViewport(0, 0, (GLsizei) stageOutputsGL[0].texture(0)->getDesc().width, (GLsizei) stageOutputsGL[0].texture(0)->getDesc().height);
 }
 
 bool OpenGLBackend::sync() {
+    // Render passes keep their frame buffers bound. Restore the default one for the application
+    // and for the downloads of CPU layers, that change other bindings as well.
+    _state.unbindFramebuffer();
+    _state.invalidate();
     glFinish();
     return true;
 }
@@ -210,6 +250,13 @@ bool OpenGLBackend::isProfilingEnabled(bool queryPerLayerTime) {
     }
 }
 
+void OpenGLBackend::addMetrics(RuntimeMetrics& metrics) {
+    auto counters = _state.takeCounters();
+    SNN_LOGD("Issued %llu GL binding calls, skipped %llu redundant ones", (unsigned long long) counters.issued,
+             (unsigned long long) counters.skipped);
+    metrics.addGlStateCalls(counters.issued, counters.skipped);
+}
+
 DeviceTimer* OpenGLBackend::createDeviceTimer(const std::string& name) {
     return new gl::GpuTimeElapsedQuery(name);
 }
@@ -19,7 +19,10 @@
 #include "snn/utils.h"
 #include "snn/imageTexture.h"
 #include "glUtils.h"
+#include "openGLStateCache.h"
+#include "openGLRenderpass.h"
 #include "snn/core.h"
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -34,6 +37,7 @@ public:
     struct CreationParameters {
         MRTMode mrtMode               = MRTMode::DOUBLE_PLANE;        // set during generateInferenceGraph. Defaults to SINGLE_PLANE
         WeightAccessMethod weightMode = WeightAccessMethod::TEXTURES; // set during generateInferenceGraph. Defaults to TEXTURE
+        std::shared_ptr<WeightCache> weightCache;                     // Compiled passes, whose weights are reused. Optional.
     };
 
     // Constructor
@@ -46,21 +50,28 @@ public:
     SNN_NO_COPY(OpenGLBackend);
     SNN_NO_MOVE(OpenGLBackend);
 
-    // Initializes render passes for a model layer
+    // Creates compiled passes of a model layer and submits their programs for compilation
+    // params:
+    //  modelLayer - model layer
+    bool compileRenderPasses(dp::GenericModelLayer* modelLayer) override;
+
+    // Waits for the programs of all compiled passes, finishing the passes in the order their programs complete
+    bool finishRenderPasses() override;
+
+    // Creates render passes of a model layer, that share the compiled passes of the layer
     // params:
     //  modelLayer - model layer
     //  texInputs - input images
     //  texOutputs - output images
-    void initRenderPasses(dp::GenericModelLayer* modelLayer, ImageTextureArrayAccessor texInputs, ImageTextureArrayAccessor texOutputs) override;
+    //  renderPasses - created render passes
+    void initRenderPasses(dp::GenericModelLayer* modelLayer, ImageTextureArrayAccessor texInputs, ImageTextureArrayAccessor texOutputs,
+                          std::vector<std::shared_ptr<RenderPass>>& renderPasses) override;
 
     // Actions, performed before inference run
     // params:
     //  rp - run parameters
-    //  stages - array of render stages
-    //  bindOutput - flag, indicating whether we need to bind output image to external image
-    //  bindIndex - the index of the layer to bind
-    void prepareRun(MixedInferenceCore::RunParameters& rp,
-            RenderStagesArray &stages, bool bindOutput, uint32_t bindIndex) override;
+    //  stages - array of render stages. Output images are bound to the stages by MixedInferenceCore beforehand.
+    void prepareRun(MixedInferenceCore::RunParameters& rp, RenderStagesArray &stages) override;
 
     // Actions, performed before each layer run
     // params:
@@ -88,6 +99,11 @@ public:
     //  a pointer to a new device timer object
     DeviceTimer* createDeviceTimer(const std::string& name) override;
 
+    // Adds binding call statistics of render passes to runtime metrics
+    // params:
+    //  metrics - runtime metrics of the inference core
+    void addMetrics(RuntimeMetrics& metrics) override;
+
 private:
     CreationParameters _cp;
     gl::DebugSSBO debugger;
@@ -98,6 +114,9 @@ private:
     std::vector<GLuint> samplers;
     std::vector<GLuint> weightSamplersUint;
     size_t runCounter = 0;
+    OpenGLStateCache _state;
+    bool _serialShaderCompile;                                       // Finish every compiled pass right after creating it
+    std::vector<std::shared_ptr<OpenGLCompiledPass>> _pendingPasses; // Compiled passes, whose programs are being compiled
 };
 
 }; // namespace dp
@@ -18,6 +18,7 @@
 #include "inferencepassGL.h"
 #include "snn/core.h"
 #include "imageTextureGL.h"
+#include "snn/fp16.h"
 #include <string>
 #include <vector>
 #include <variant>
@@ -25,18 +26,13 @@
 
 // -----------------------------------------------------------------------------
 //
-snn::OpenGLRenderPass::OpenGLRenderPass(const snn::OpenGLRenderPass::CreationParameters& cp)
+snn::OpenGLCompiledPass::OpenGLCompiledPass(const snn::OpenGLCompiledPass::CreationParameters& cp)
     : _cp(cp)
 {
-    SNN_LOGD("Render pass created: %s", snn::ImageTextureGLArrayAccessor(_cp.texOutputs)[0].getTextureInfo2().c_str());
-    _quad.allocate();
-
-    // create program
+    // Start compiling the program. The driver might do it on its own threads, until finishInit() needs the result.
     _program.name = cp.name;
     if (isCompute()) {
-        if (!_program.loadCs(cp.pass.source.c_str())) {
-            return;
-        }
+        _submitted = _program.submitCs(cp.pass.source.c_str());
     } else {
         const char* vscode = R"glsl(#version 320 es
             out vec2 v_uv;
@@ -50,10 +46,25 @@ snn::OpenGLRenderPass::OpenGLRenderPass(const snn::OpenGLRenderPass::CreationPar
                 v_uv = v[gl_VertexID].zw;
             }
         )glsl";
-        if (!_program.loadVsPs(vscode, cp.pass.source.c_str())) {
-            return;
-        }
+        _submitted = _program.submitVsPs(vscode, cp.pass.source.c_str());
+    }
+}
+
+bool snn::OpenGLCompiledPass::isProgramComplete() const {
+    return !_submitted || _program.isComplete();
+}
+
+bool snn::OpenGLCompiledPass::finishInit() {
+    if (!_submitted) {
+        // The submission failed, or the pass is finished already
+        return _program.finish();
     }
+    _submitted = false;
+    if (!_program.finish()) {
+        SNN_LOGE("Failed to compile %s", _cp.name.c_str());
+        return false;
+    }
+    const CreationParameters& cp = _cp;
 
     // query all uniform locations.
     for (auto& [name, value] : cp.pass.uniforms) {
@@ -87,7 +98,13 @@ snn::OpenGLRenderPass::OpenGLRenderPass(const snn::OpenGLRenderPass::CreationPar
         SNN_LOGD("%d. %s (%d) (%d)", i + 1, name, type, size);
     }
 
-    if (_cp.pass.weightMeta.size() > 0) {
+    if (_cp.weightSource && _cp.weightSource->hasSameWeights(_cp.pass)) {
+        // The source keeps its weight objects alive, while this pass holds it
+        SNN_LOGD("Pass %s reuses the weights of the same pass for another input resolution", cp.name.c_str());
+        _weights           = _cp.weightSource->_weights;
+        _weightUniformTags = _cp.weightSource->_weightUniformTags;
+        _ssboMap           = _cp.weightSource->_ssboMap;
+    } else if (_cp.pass.weightMeta.size() > 0) {
         uint32_t layout = _cp.pass.weightMeta[0];
         if (isCompute()) {
             uint32_t weightMethod = _cp.pass.weightMeta[1];
@@ -125,9 +142,12 @@ snn::OpenGLRenderPass::OpenGLRenderPass(const snn::OpenGLRenderPass::CreationPar
             }
         }
     }
+
+    initBindings();
+    return true;
 }
 
-void snn::OpenGLRenderPass::initGLFSData(uint32_t weightMethod, uint32_t fp16, uint32_t kernelW, uint32_t kernelH,
+void snn::OpenGLCompiledPass::initGLFSData(uint32_t weightMethod, uint32_t fp16, uint32_t kernelW, uint32_t kernelH,
     uint32_t numInputPlanes, uint32_t numOutputPlanes, uint32_t channelsPerPass, uint32_t fsPlaneIndex) {
 
     uint32_t kernelSize = (uint32_t) kernelW;
@@ -239,7 +259,7 @@ void snn::OpenGLRenderPass::initGLFSData(uint32_t weightMethod, uint32_t fp16, u
                 _weights);
 }
 
-void snn::OpenGLRenderPass::setTextureWeights(uint32_t weightMethod, uint32_t fp16, uint32_t kernelW, uint32_t kernelH,
+void snn::OpenGLCompiledPass::setTextureWeights(uint32_t weightMethod, uint32_t fp16, uint32_t kernelW, uint32_t kernelH,
     uint32_t numInputPlanes, uint32_t numOutputPlanes, uint32_t channelsPerPass, uint32_t fsPlaneIndex) const {
 
     uint32_t kernelSize = (uint32_t) kernelW;
@@ -253,29 +273,33 @@ void snn::OpenGLRenderPass::setTextureWeights(uint32_t weightMethod, uint32_t fp
 
     for (std::size_t filter = 0; filter < outputChannels; filter++) {
         std::vector<float> weightVal(4 * kernelSize * kernelSize, 0.0);
+        // Weights are collected as floats and converted to the texture format before every upload
+        std::vector<uint16_t> halfVal(4 * kernelSize * kernelSize);
+        auto getPixels = [&]() -> const void* {
+            if (!preferHp) {
+                return weightVal.data();
+            }
+            snn::fp16::floatToHalf(weightVal.data(), halfVal.data(), halfVal.size());
+            return halfVal.data();
+        };
         for (std::size_t filterPlane = 0; filterPlane < numInputPlanes; filterPlane++) {
             uint32_t outputChannel = filter;
             std::size_t idx = outputChannel * numInputPlanes + filterPlane;
             for (std::size_t i = 0; i < kernelSize; i++) {
                 for (std::size_t j = 0; j < kernelSize; j++) {
                     std::size_t weightValIdx = (4 * kernelSize * i) + (4 * j) + (filterPlane % 4);
-                    if (preferHp) {
-                        uint16_t* fp16Addr = (uint16_t*)weightVal.data();
-                        *(fp16Addr + weightValIdx) = FP32::toHalf(_cp.pass.modelWeights[idx].at<float>(i, j));
-                    } else {
-                        weightVal[weightValIdx] = _cp.pass.modelWeights[idx].at<float>(i, j);
-                    }
+                    weightVal[weightValIdx] = _cp.pass.modelWeights[idx].at<float>(i, j);
                 }
             }
             if ((filterPlane + 1) % 4 == 0) {
                 if (numInputPlanes > 4) {
                     _weightTextures[filter].bind(0);
-                    _weightTextures[filter].setPixels((int) (filterPlane / 4), 0, 0, 0, kernelSize, kernelSize, 0, weightVal.data());
+                    _weightTextures[filter].setPixels((int) (filterPlane / 4), 0, 0, 0, kernelSize, kernelSize, 0, getPixels());
                     glFinish();
                     _weightTextures[filter].unbind();
                 } else {
                     _weightTextures[filter].bind(0);
-                    _weightTextures[filter].setPixels(0, 0, 0, kernelSize, kernelSize, 0, weightVal.data());
+                    _weightTextures[filter].setPixels(0, 0, 0, kernelSize, kernelSize, 0, getPixels());
                     glFinish();
                     _weightTextures[filter].unbind();
                 }
@@ -284,12 +308,12 @@ void snn::OpenGLRenderPass::setTextureWeights(uint32_t weightMethod, uint32_t fp
         if (!weightVal.empty() && numInputPlanes % 4 != 0) {
             if (numInputPlanes > 4) {
                 _weightTextures[filter].bind(0);
-                _weightTextures[filter].setPixels((int) (numInputPlanes / 4), 0, 0, 0, kernelSize, kernelSize, 0, weightVal.data());
+                _weightTextures[filter].setPixels((int) (numInputPlanes / 4), 0, 0, 0, kernelSize, kernelSize, 0, getPixels());
                 glFinish();
                 _weightTextures[filter].unbind();
             } else {
                 _weightTextures[filter].bind(0);
-                _weightTextures[filter].setPixels(0, 0, 0, kernelSize, kernelSize, 0, weightVal.data());
+                _weightTextures[filter].setPixels(0, 0, 0, kernelSize, kernelSize, 0, getPixels());
                 glFinish();
                 _weightTextures[filter].unbind();
             }
@@ -297,7 +321,7 @@ void snn::OpenGLRenderPass::setTextureWeights(uint32_t weightMethod, uint32_t fp
     }
 }
 
-void snn::OpenGLRenderPass::setBufferWeights(uint32_t weightMethod, uint32_t fp16, uint32_t kernelW, uint32_t kernelH,
+void snn::OpenGLCompiledPass::setBufferWeights(uint32_t weightMethod, uint32_t fp16, uint32_t kernelW, uint32_t kernelH,
     uint32_t numInputPlanes, uint32_t numOutputPlanes, uint32_t channelsPerPass, uint32_t fsPlaneIndex) const {
 
     uint32_t kernelSize = (uint32_t) kernelW;
@@ -342,7 +366,7 @@ void snn::OpenGLRenderPass::setBufferWeights(uint32_t weightMethod, uint32_t fp1
     }
 }
 
-void snn::OpenGLRenderPass::initGLFSDataDW(uint32_t weightMethod, uint32_t fp16, uint32_t kernelW, uint32_t kernelH,
+void snn::OpenGLCompiledPass::initGLFSDataDW(uint32_t weightMethod, uint32_t fp16, uint32_t kernelW, uint32_t kernelH,
     uint32_t numInputPlanes, uint32_t numOutputPlanes, uint32_t channelsPerPass, uint32_t fsPlaneIndex) {
 
     uint32_t kernelSize = (uint32_t) kernelW;
@@ -448,7 +472,7 @@ void snn::OpenGLRenderPass::initGLFSDataDW(uint32_t weightMethod, uint32_t fp16,
                 _weights);
 }
 
-void snn::OpenGLRenderPass::setTextureWeightsDW(uint32_t weightMethod, uint32_t fp16, uint32_t kernelW, uint32_t kernelH,
+void snn::OpenGLCompiledPass::setTextureWeightsDW(uint32_t weightMethod, uint32_t fp16, uint32_t kernelW, uint32_t kernelH,
     uint32_t numInputPlanes, uint32_t numOutputPlanes, uint32_t channelsPerPass, uint32_t fsPlaneIndex) const {
 
     uint32_t kernelSize = (uint32_t) kernelW;
@@ -462,21 +486,25 @@ void snn::OpenGLRenderPass::setTextureWeightsDW(uint32_t weightMethod, uint32_t
     (void) numInputPlanes;
 
     std::vector<float> weightVal(4 * kernelSize * kernelSize, 0.0);
+    // Weights are collected as floats and converted to the texture format before every upload
+    std::vector<uint16_t> halfVal(4 * kernelSize * kernelSize);
+    auto getPixels = [&]() -> const void* {
+        if (!preferHp) {
+            return weightVal.data();
+        }
+        snn::fp16::floatToHalf(weightVal.data(), halfVal.data(), halfVal.size());
+        return halfVal.data();
+    };
     for (std::size_t filter = 0; filter < outputChannels; filter++) {
         for (std::size_t i = 0; i < kernelSize; i++) {
             for (std::size_t j = 0; j < kernelSize; j++) {
                 std::size_t weightValIdx = (4 * kernelSize * i) + (4 * j) + (filter % 4);
-                if (preferHp) {
-                    uint16_t* fp16Addr = (uint16_t*)weightVal.data();
-                    *(fp16Addr + weightValIdx) = FP32::toHalf(_cp.pass.modelWeights[filter].at<float>(i, j));
-                } else {
-                    weightVal[weightValIdx] = _cp.pass.modelWeights[filter].at<float>(i, j);
-                }
+                weightVal[weightValIdx] = _cp.pass.modelWeights[filter].at<float>(i, j);
             }
         }
         if ((filter + 1) % 4 == 0) {
             _weightTextures[filter / 4].bind(0);
-            _weightTextures[filter / 4].setPixels(0, 0, 0, kernelSize, kernelSize, 0, weightVal.data());
+            _weightTextures[filter / 4].setPixels(0, 0, 0, kernelSize, kernelSize, 0, getPixels());
             glFinish();
             _weightTextures[filter / 4].unbind();
             weightVal.clear();
@@ -485,13 +513,13 @@ void snn::OpenGLRenderPass::setTextureWeightsDW(uint32_t weightMethod, uint32_t
     }
     if (!weightVal.empty() && outputChannels % 4 != 0) {
         _weightTextures[DIV_4_ROUND_UP(outputChannels)].bind(0);
-        _weightTextures[DIV_4_ROUND_UP(outputChannels)].setPixels(0, 0, 0, kernelSize, kernelSize, 0, weightVal.data());
+        _weightTextures[DIV_4_ROUND_UP(outputChannels)].setPixels(0, 0, 0, kernelSize, kernelSize, 0, getPixels());
         glFinish();
         _weightTextures[DIV_4_ROUND_UP(outputChannels)].unbind();
     }
 }
 
-void snn::OpenGLRenderPass::setBufferWeightsDW(uint32_t weightMethod, uint32_t fp16, uint32_t kernelW, uint32_t kernelH,
+void snn::OpenGLCompiledPass::setBufferWeightsDW(uint32_t weightMethod, uint32_t fp16, uint32_t kernelW, uint32_t kernelH,
     uint32_t numInputPlanes, uint32_t numOutputPlanes, uint32_t channelsPerPass, uint32_t fsPlaneIndex) const {
 
     uint32_t kernelSize = (uint32_t) kernelW;
@@ -551,7 +579,7 @@ void snn::OpenGLRenderPass::setBufferWeightsDW(uint32_t weightMethod, uint32_t f
     }
 }
 
-void snn::OpenGLRenderPass::initGLCSData(uint32_t weightMethod, uint32_t fp16, uint32_t kernelW, uint32_t kernelH,
+void snn::OpenGLCompiledPass::initGLCSData(uint32_t weightMethod, uint32_t fp16, uint32_t kernelW, uint32_t kernelH,
     uint32_t numInputPlanes, uint32_t numOutputPlanes) {
     (void) kernelW;
     (void) kernelH;
@@ -633,128 +661,215 @@ void snn::OpenGLRenderPass::initGLCSData(uint32_t weightMethod, uint32_t fp16, u
     }
 }
 
+// -----------------------------------------------------------------------------
+//
+snn::OpenGLRenderPass::OpenGLRenderPass(const snn::OpenGLRenderPass::CreationParameters& cp)
+    : _cp(cp)
+    , _runtimeUniforms(cp.compiled->_runtimeUniforms)
+{
+    SNN_LOGD("Render pass created: %s", snn::ImageTextureGLArrayAccessor(_cp.texOutputs)[0].getTextureInfo2().c_str());
+    SNN_ASSERT(!_cp.compiled->_submitted); // finishInit() has to be called first
+    _quad.allocate();
+}
+
 void snn::OpenGLRenderPass::updateParameters() {
-    if (_cp.pass.runtimeData.empty()) {
+    const InferencePassGl& pass = _cp.compiled->_cp.pass;
+    if (pass.runtimeData.empty()) {
         return;
     }
-    uint32_t* jitterOffset = _cp.pass.runtimeData.data();
-    size_t len = _cp.pass.runtimeData.size()/_cp.pass.period;
+    const uint32_t* jitterOffset = pass.runtimeData.data();
+    size_t len = pass.runtimeData.size()/pass.period;
     for (size_t i = 0; i < _runtimeUniforms.size(); i++) {
-        uint32_t paramIdx = _cp.pass.runtimeUniforms[_runtimeUniforms[i].getName()].first;
-        uint32_t value = jitterOffset[UP_DIV(_runIdx, _cp.pass.totalPasses) % len * _cp.pass.period + paramIdx];
+        uint32_t paramIdx = pass.runtimeUniforms.at(_runtimeUniforms[i].getName()).first;
+        uint32_t value = jitterOffset[UP_DIV(_runIdx, pass.totalPasses) % len * pass.period + paramIdx];
         _runtimeUniforms[i].update((int)value);
         _runtimeUniforms[i].apply();
         SNN_LOGD("Update runtime parameter for %s, %d-%zu, %d at %d",
              _runtimeUniforms[i].getName().c_str(), _runIdx, i, value,
-             UP_DIV(_runIdx, _cp.pass.totalPasses) % len * _cp.pass.period + paramIdx);
+             UP_DIV(_runIdx, pass.totalPasses) % len * pass.period + paramIdx);
     }
 }
 
 // -----------------------------------------------------------------------------
 //
 void snn::OpenGLRenderPass::run() {
-    _program.use();
+    const OpenGLCompiledPass& compiled = *_cp.compiled;
+    OpenGLStateCache& state = *_cp.state;
+    state.useProgram(compiled._program);
     bindProgramInputs();
     snn::ImageTextureGLArrayAccessor texOutputsGL = _cp.texOutputs;
-    auto ssboMap = _ssboMap;
 
     std::visit(match {
                     [&](const InferencePassGl::FsProgram& fs) {
-                        // bind output texture to frame buffer
+                        // The output texture stays attached to the frame buffer between runs. It changes only,
+                        // if an external output texture is bound to the last layer.
                         // note: dont' apply viewport here. viewport is already applied by call already.
-                        _fb.bind();
-                        _fb.attachTexture(*(texOutputsGL[0].texture(0)), fs.outputSliceIndex, fs.outputSliceCount);
-                        gl::clearScreen(GL_COLOR_BUFFER_BIT);
-                        _quad.draw();
-                        _fb.detachTexture();
-                        FrameBuffer2::unbind();
+                        const gl::TextureObject* texOutput = texOutputsGL[0].texture(0);
+                        state.bindFramebuffer(_fb);
+                        if (_attachedTexture != texOutput->id()) {
+                            _fb.attachTexture(*texOutput, fs.outputSliceIndex, fs.outputSliceCount);
+                            _attachedTexture = texOutput->id();
+                        }
+                        // No clear: the full screen triangle writes every pixel of the viewport.
+                        state.bindVertexArray(_quad.va);
+                        GLCHKDBG(glDrawArrays(GL_TRIANGLES, 0, 3));
                     },
                     [&](const InferencePassGl::CsProgram& cs) {
-                        for (std::pair<uint32_t, GLuint> element : ssboMap) {
-                            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, element.first, element.second);
+                        for (auto [index, buffer] : compiled._ssboMap) {
+                            state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, index, buffer);
                         }
-                        auto outputBinding = _program.getUniformBinding(cs.outputImageUniform.c_str());
 
-                        const gl::TextureObject::TextureDesc& texOutputDesc = texOutputsGL[0].texture(0)->getDesc();
-                        auto internalFormat = getNativeColorGL(texOutputDesc.format).glInternalFormat;
-                        GLCHKDBG(glBindImageTexture(outputBinding, *(texOutputsGL[0].texture(0)), 0, true, 0, GL_WRITE_ONLY, internalFormat));
+                        // Storage buffer outputs have no texture
+                        auto outputBuffer = texOutputsGL[0].buffer();
+                        if (outputBuffer) {
+                            state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, (GLuint) compiled._outputBinding, outputBuffer->getId());
+                        } else {
+                            const gl::TextureObject* texOutput = texOutputsGL[0].texture(0);
+                            auto internalFormat = getNativeColorGL(texOutput->getDesc().format).glInternalFormat;
+                            state.bindImageTexture((GLuint) compiled._outputBinding, texOutput->id(), GL_WRITE_ONLY, internalFormat);
+                        }
                         SNN_LOGD("Bind output: %s", texOutputsGL[0].getTextureInfo2().c_str());
 
                         GLCHKDBG(glDispatchCompute(cs.dispatchSize[0], cs.dispatchSize[1], cs.dispatchSize[2]));
                         SNN_LOGD("dispatch sizes: %d:%d:%d", cs.dispatchSize[0], cs.dispatchSize[1], cs.dispatchSize[2]);
+                        // Image and buffer stores are not coherent with the loads of the next compute shader
+                        // and the texture fetches of the next fragment shader without a barrier.
+                        GLCHKDBG(glMemoryBarrier(outputBuffer ? GL_SHADER_STORAGE_BARRIER_BIT
+                                                              : (GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT)));
                     },
                },
-               _cp.pass.program);
+               compiled._cp.pass.program);
 }
 
 // -----------------------------------------------------------------------------
 //
-void snn::OpenGLRenderPass::bindProgramInputs() {
-    // bind input textures
-    snn::ImageTextureGLArrayAccessor texInputsGL = _cp.texInputs;
-    for (auto[name, index] : _cp.pass.inputs) {
-        auto tex = texInputsGL[index].texture(0);
+bool snn::OpenGLCompiledPass::hasSameWeights(const InferencePassGl& pass) const {
+    auto sameMats = [](const std::vector<cv::Mat>& a, const std::vector<cv::Mat>& b) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (a[i].size != b[i].size || a[i].type() != b[i].type() || !a[i].isContinuous() || !b[i].isContinuous() ||
+                memcmp(a[i].data, b[i].data, a[i].total() * a[i].elemSize())) {
+                return false;
+            }
+        }
+        return true;
+    };
+    const InferencePassGl& own = _cp.pass;
+    if (own.weightMeta != pass.weightMeta || own.weightDims != pass.weightDims || own._vecWeights != pass._vecWeights ||
+        own._vecBias != pass._vecBias || own._vecMean != pass._vecMean || own._vecVariance != pass._vecVariance ||
+        own._vecBeta != pass._vecBeta || own._vecGamma != pass._vecGamma) {
+        return false;
+    }
+    for (size_t i = 0; i < 4; ++i) {
+        if (own.weightMatrices[i] != pass.weightMatrices[i]) {
+            return false;
+        }
+    }
+    return sameMats(own.modelWeights, pass.modelWeights);
+}
+
+void snn::OpenGLCompiledPass::initBindings() {
+    // Uniform values and block bindings are the program state, so they are set once, and not on every run
+    _program.use();
+    for (auto& u : _uniforms) {
+        u.apply();
+    }
 
+    // Compute shader inputs and outputs are images or storage blocks (see ShaderLayer::buildComputeInputDeclaration())
+    auto getBinding = [&](const std::string& name) {
         auto binding = _program.getUniformBinding(name.c_str());
+        return (binding < 0 && isCompute()) ? _program.getStorageBlockBinding(name.c_str()) : binding;
+    };
+
+    for (auto [name, index] : _cp.pass.inputs) {
+        auto binding = getBinding(name);
         if (binding >= 0) {
-            if (isCompute()) {
-                auto internalFormat = getNativeColorGL(tex->getDesc().format).glInternalFormat;
-                glBindImageTexture(binding, tex->id(), 0, true, 0, GL_READ_ONLY, internalFormat);
-                CHECK_GL_ERROR("glBindImageTexture");
-            } else {
-                SNN_LOGV("Bind input: %s: %d, with %d %d", name.c_str(), index, tex->id(), binding);
-                tex->bind(binding);
-                glBindSampler(binding, _cp.sampler.at(index));
-            }
+            _inputBindings.emplace_back(index, binding);
         } else {
-            SNN_LOGE("Binding input not found: %s: index: %d, texture id: %d", name.c_str(), index, tex->id());
+            SNN_LOGE("Binding input not found: %s: index: %d", name.c_str(), index);
         }
     }
 
-    auto passWeights = _weights;
-    auto weightUniformTags = _weightUniformTags;
-
     std::visit(match {[&](const std::vector<const gl::TextureObject*>& weightTextures) {
                         for (std::size_t index = 0; index < weightTextures.size(); index++) {
-                            auto tex     = weightTextures[index];
-                            auto binding = _program.getUniformBinding(weightUniformTags[index].c_str());
-                            if (binding >= 0) {
-                                tex->bind(binding);
-                                glBindSampler(binding, _cp.weightSamplers[index]);
-                            } else {
-                                SNN_LOGE("Binding input not found: %s: index: %d, texture id: %d", weightUniformTags[index].c_str(), index, tex->id());
+                            auto binding = _program.getUniformBinding(_weightUniformTags[index].c_str());
+                            if (binding < 0) {
+                                SNN_LOGE("Binding input not found: %s: index: %d, texture id: %d", _weightUniformTags[index].c_str(), index,
+                                         weightTextures[index]->id());
                             }
+                            _weightBindings.push_back(binding);
                         }},
                         [&](const std::vector<const gl::BufferObject<GL_UNIFORM_BUFFER>*>& weightBuffers) {
                             for (std::size_t index = 0; index < weightBuffers.size(); index++) {
-                                auto buf        = weightBuffers[index];
-                                auto blockIndex = glGetUniformBlockIndex(_program, weightUniformTags[index].c_str());
-                                auto binding    = _program.getUniformBinding(weightUniformTags[index].c_str());
+                                auto blockIndex = glGetUniformBlockIndex(_program, _weightUniformTags[index].c_str());
+                                auto binding    = _program.getUniformBinding(_weightUniformTags[index].c_str());
                                 glUniformBlockBinding(_program, blockIndex, binding);
-                                buf->bindBase(binding);
+                                _weightBindings.push_back(binding);
                             }
                         },
                         [&](const std::vector<const gl::BufferObject<GL_SHADER_STORAGE_BUFFER>*>& weightBuffers) {
                             for (std::size_t index = 0; index < weightBuffers.size(); index++) {
-                                auto buf        = weightBuffers[index];
-                                auto blockIndex = glGetProgramResourceIndex(_program, GL_SHADER_STORAGE_BUFFER, weightUniformTags[index].c_str());
-                                auto binding    = index + 2;
+                                auto blockIndex = glGetProgramResourceIndex(_program, GL_SHADER_STORAGE_BUFFER, _weightUniformTags[index].c_str());
+                                auto binding    = (GLint) index + 2;
                                 glShaderStorageBlockBinding(_program, blockIndex, binding);
-                                buf->bindBase(binding);
+                                _weightBindings.push_back(binding);
                             }
                         }
-            }, passWeights);
+            }, _weights);
 
-    // bind uniforms
-    for (auto& u : _uniforms) {
-        u.apply();
+    if (auto cs = std::get_if<InferencePassGl::CsProgram>(&_cp.pass.program)) {
+        _outputBinding = getBinding(cs->outputImageUniform);
     }
+}
 
-    updateParameters();
-    // bind runtime uniforms
-    for (auto& u : _runtimeUniforms) {
-        u.apply();
+// -----------------------------------------------------------------------------
+//
+void snn::OpenGLRenderPass::bindProgramInputs() {
+    const OpenGLCompiledPass& compiled = *_cp.compiled;
+    OpenGLStateCache& state = *_cp.state;
+
+    // bind input textures
+    snn::ImageTextureGLArrayAccessor texInputsGL = _cp.texInputs;
+    for (auto [index, binding] : compiled._inputBindings) {
+        if (auto buffer = texInputsGL[index].buffer()) {
+            state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, (GLuint) binding, buffer->getId());
+            continue;
+        }
+        auto tex = texInputsGL[index].texture(0);
+        if (compiled.isCompute()) {
+            auto internalFormat = getNativeColorGL(tex->getDesc().format).glInternalFormat;
+            state.bindImageTexture((GLuint) binding, tex->id(), GL_READ_ONLY, internalFormat);
+        } else {
+            SNN_LOGV("Bind input: %d, with %d %d", index, tex->id(), binding);
+            state.bindTexture((GLuint) binding, tex->getDesc().target, tex->id());
+            state.bindSampler((GLuint) binding, _cp.sampler.at(index));
+        }
     }
+
+    std::visit(match {[&](const std::vector<const gl::TextureObject*>& weightTextures) {
+                        for (std::size_t index = 0; index < weightTextures.size(); index++) {
+                            auto binding = compiled._weightBindings[index];
+                            if (binding >= 0) {
+                                state.bindTexture((GLuint) binding, weightTextures[index]->getDesc().target, weightTextures[index]->id());
+                                state.bindSampler((GLuint) binding, _cp.weightSamplers[index]);
+                            }
+                        }},
+                        [&](const std::vector<const gl::BufferObject<GL_UNIFORM_BUFFER>*>& weightBuffers) {
+                            for (std::size_t index = 0; index < weightBuffers.size(); index++) {
+                                state.bindBufferBase(GL_UNIFORM_BUFFER, (GLuint) compiled._weightBindings[index], weightBuffers[index]->getId());
+                            }
+                        },
+                        [&](const std::vector<const gl::BufferObject<GL_SHADER_STORAGE_BUFFER>*>& weightBuffers) {
+                            for (std::size_t index = 0; index < weightBuffers.size(); index++) {
+                                state.bindBufferBase(GL_SHADER_STORAGE_BUFFER, (GLuint) compiled._weightBindings[index], weightBuffers[index]->getId());
+                            }
+                        }
+            }, compiled._weights);
+
+    // runtime uniforms change between runs
+    updateParameters();
     _runIdx++;
 }
 
@@ -795,7 +910,7 @@ bool snn::OpenGLRenderPass::debugPassOutput(const std::string& folderName) {
     return true;
 }
 
-bool snn::OpenGLRenderPass::debugPassWeights(const std::string& folderName, int shaderPass) {
+bool snn::OpenGLCompiledPass::debugPassWeights(const std::string& folderName, int shaderPass) const {
     std::string layerName = normalizeName(_cp.name);
     std::string path = formatString("%s/%s", folderName.c_str(), layerName.c_str());
     if (!createDirIfNotExists(path)) {
@@ -21,6 +21,7 @@
 #include "inferencepassGL.h"
 #include "framebuffer.h"
 #include "glUtils.h"
+#include "openGLStateCache.h"
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -29,64 +30,63 @@
 
 namespace snn {
 
-// This classes implements actions, performed during a render pass.
-class OpenGLRenderPass : public RenderPass {
+// This class holds the program and the weights of a render pass.
+// GL programs, textures and buffers are shared by all contexts of a share group, so one compiled pass
+// serves the render passes of all execution contexts of a model.
+class OpenGLCompiledPass : public CompiledRenderPass {
 public:
-    OpenGLRenderPass() = default;
-
-    virtual ~OpenGLRenderPass() = default;
+    virtual ~OpenGLCompiledPass() = default;
 
-    SNN_NO_COPY(OpenGLRenderPass);
-    SNN_NO_MOVE(OpenGLRenderPass);
+    SNN_NO_COPY(OpenGLCompiledPass);
+    SNN_NO_MOVE(OpenGLCompiledPass);
 
     // Creation parameters structure
     struct CreationParameters {
         std::string name;                       // Name
         InferencePassGl pass;                   // Inference pass
-        std::vector<GLuint> sampler;            // An array of OpenGL samplers. Used to sample inputs
-        std::vector<GLuint> weightSamplers;     // An array of OpenGL samplers. Used to sample weights
-        ImageTextureArrayAccessor texInputs;    // Input images
-        ImageTextureArrayAccessor texOutputs;   // Output images
+        // Finished pass of the same layer for another input resolution. Its weight textures and buffers
+        // are used instead of uploading the weights again, if the weights are the same. Optional.
+        std::shared_ptr<const OpenGLCompiledPass> weightSource;
     };
 
-    // Constructor
+    // Constructor. Only submits the program for compilation, finishInit() completes the initialization.
     // params:
     //  cp - creation parameters
-    OpenGLRenderPass(const CreationParameters& cp);
+    OpenGLCompiledPass(const CreationParameters& cp);
 
-    // Dump layer outputs
-    // params:
-    //  folderName - directory where to dump
-    // return:
-    //  true if success, false if not
-    bool debugPassOutput(const std::string& folderName) override;
+    // Checks without blocking if the program has been compiled and linked by the driver
+    // returns:
+    //  true if finishInit() won't wait for the driver
+    bool isProgramComplete() const;
 
-    // Dump layer inputs
-    // params:
-    //  folderName - directory where to dump
-    // return:
-    //  true if success, false if not
-    bool debugPassInputs(const std::string& folderName) override;
+    // Waits for the program, then looks up the uniforms and uploads the weights.
+    // Must be called once before the pass is used by render passes.
+    // returns:
+    //  true if the program has been compiled and linked, false if not
+    bool finishInit();
 
     // Dump layer weights
     // params:
     //  folderName - directory where to dump
     // return:
     //  true if success, false if not
-    bool debugPassWeights(const std::string& foldername, int shaderPass) override;
+    bool debugPassWeights(const std::string& foldername, int shaderPass) const;
 
-    // Run render pass
-    void run() override;
+    // Checks if render pass uses a compute shader
+    // returns:
+    //  true if the pass uses compute shader, false if not
+    bool isCompute() const { return std::holds_alternative<InferencePassGl::CsProgram>(_cp.pass.program); }
+
+    const std::string& getName() const { return _cp.name; }
 
 private:
+    friend class OpenGLRenderPass;
+
     CreationParameters _cp;
-    gl::FullScreenQuad _quad;
-    FrameBuffer2 _fb; // do we need per-pass FBO? maybe an global one per inference core is enough.
     gl::SimpleGlslProgram _program;
+    bool _submitted = false;      // The program is submitted, and finishInit() has not been called yet
     std::vector<gl::SimpleUniform> _uniforms;
-    uint32_t _runIdx = 0;
     std::vector<gl::SimpleUniform> _runtimeUniforms;
-    void updateParameters();
 
     //For Fragment Shader
     snn::FixedSizeArray<gl::TextureObject> _weightTextures;
@@ -200,10 +200,79 @@ private:
     void initGLCSData(uint32_t weightMethod, uint32_t fp16, uint32_t kernelW, uint32_t kernelH,
         uint32_t numInputPlanes, uint32_t numOutputPlanes);
 
-    // Checks if render pass uses a compute shader
-    // returns:
-    //  true if the pass uses compute shader, false if not
-    bool isCompute() const { return std::holds_alternative<InferencePassGl::CsProgram>(_cp.pass.program); }
+    // Texture units, image units and binding points of the program. Bindings of a linked program don't change.
+    std::vector<std::pair<uint32_t, GLint>> _inputBindings; // Input index and binding
+    std::vector<GLint> _weightBindings;
+    GLint _outputBinding = -1;
+
+    // Sets the static uniforms and block bindings of the program, and queries its bindings
+    void initBindings();
+
+    // Checks if the pass uploads the same weights as the given inference pass
+    bool hasSameWeights(const InferencePassGl& pass) const;
+};
+
+// This classes implements actions, performed during a render pass of one execution context.
+// It owns the GL objects, that can't be shared between contexts, and binds the activations of its context.
+class OpenGLRenderPass : public RenderPass {
+public:
+    virtual ~OpenGLRenderPass() = default;
+
+    SNN_NO_COPY(OpenGLRenderPass);
+    SNN_NO_MOVE(OpenGLRenderPass);
+
+    // Creation parameters structure
+    struct CreationParameters {
+        std::string name;                                    // Name
+        std::shared_ptr<const OpenGLCompiledPass> compiled;  // Program and weights, finished with finishInit()
+        std::vector<GLuint> sampler;                         // An array of OpenGL samplers. Used to sample inputs
+        std::vector<GLuint> weightSamplers;                  // An array of OpenGL samplers. Used to sample weights
+        ImageTextureArrayAccessor texInputs;                 // Input images
+        ImageTextureArrayAccessor texOutputs;                // Output images
+        OpenGLStateCache* state;                             // Bound GL state of the backend
+    };
+
+    // Constructor
+    // params:
+    //  cp - creation parameters
+    OpenGLRenderPass(const CreationParameters& cp);
+
+    // Dump layer outputs
+    // params:
+    //  folderName - directory where to dump
+    // return:
+    //  true if success, false if not
+    bool debugPassOutput(const std::string& folderName) override;
+
+    // Dump layer inputs
+    // params:
+    //  folderName - directory where to dump
+    // return:
+    //  true if success, false if not
+    bool debugPassInputs(const std::string& folderName) override;
+
+    // Dump layer weights
+    // params:
+    //  folderName - directory where to dump
+    // return:
+    //  true if success, false if not
+    bool debugPassWeights(const std::string& foldername, int shaderPass) override {
+        return _cp.compiled->debugPassWeights(foldername, shaderPass);
+    }
+
+    // Run render pass
+    void run() override;
+
+private:
+    CreationParameters _cp;
+    gl::FullScreenQuad _quad;
+    FrameBuffer2 _fb;             // Keeps the output attachments between runs
+    GLuint _attachedTexture = 0;  // Output texture, attached to _fb
+    uint32_t _runIdx = 0;
+    std::vector<gl::SimpleUniform> _runtimeUniforms;
+
+    // Sets the runtime uniforms of the current run. They are applied to the shared program before every draw or dispatch.
+    void updateParameters();
 
     // Binds program inputs
     void bindProgramInputs();
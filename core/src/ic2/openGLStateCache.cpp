@@ -0,0 +1,99 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pch.h"
+#include "openGLStateCache.h"
+
+using namespace snn;
+
+void OpenGLStateCache::invalidate() {
+    _program     = UNKNOWN;
+    _vertexArray = UNKNOWN;
+    _framebuffer = UNKNOWN;
+    _activeUnit  = UNKNOWN;
+    _textures.fill(TextureBinding());
+    _samplers.fill(UNKNOWN);
+    _images.fill(ImageBinding());
+    _buffers.clear();
+}
+
+void OpenGLStateCache::useProgram(GLuint program) {
+    if (update(_program, program)) {
+        GLCHKDBG(glUseProgram(program));
+    }
+}
+
+void OpenGLStateCache::bindVertexArray(GLuint vertexArray) {
+    if (update(_vertexArray, vertexArray)) {
+        GLCHKDBG(glBindVertexArray(vertexArray));
+    }
+}
+
+void OpenGLStateCache::bindFramebuffer(const FrameBuffer2& fb) {
+    if (update(_framebuffer, fb.id())) {
+        fb.bind();
+    }
+}
+
+void OpenGLStateCache::unbindFramebuffer() {
+    if (update(_framebuffer, 0u)) {
+        FrameBuffer2::unbind();
+    }
+}
+
+void OpenGLStateCache::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+    TextureBinding binding;
+    binding.target  = target;
+    binding.texture = texture;
+    TextureBinding uncached;
+    if (!update(unit < MAX_UNITS ? _textures[unit] : uncached, binding)) {
+        return;
+    }
+    if (update(_activeUnit, unit)) {
+        GLCHKDBG(glActiveTexture(GL_TEXTURE0 + unit));
+    }
+    GLCHKDBG(glBindTexture(target, texture));
+}
+
+void OpenGLStateCache::bindSampler(GLuint unit, GLuint sampler) {
+    GLuint uncached = UNKNOWN;
+    if (update(unit < MAX_UNITS ? _samplers[unit] : uncached, sampler)) {
+        GLCHKDBG(glBindSampler(unit, sampler));
+    }
+}
+
+void OpenGLStateCache::bindImageTexture(GLuint unit, GLuint texture, GLenum access, GLenum format) {
+    ImageBinding binding;
+    binding.texture = texture;
+    binding.access  = access;
+    binding.format  = format;
+    ImageBinding uncached;
+    if (update(unit < MAX_UNITS ? _images[unit] : uncached, binding)) {
+        GLCHKDBG(glBindImageTexture(unit, texture, 0, GL_TRUE, 0, access, format));
+    }
+}
+
+void OpenGLStateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    uint64_t key = ((uint64_t) target << 32) | index;
+    auto it      = _buffers.emplace(key, UNKNOWN).first;
+    if (update(it->second, buffer)) {
+        GLCHKDBG(glBindBufferBase(target, index, buffer));
+    }
+}
+
+OpenGLStateCache::Counters OpenGLStateCache::takeCounters() {
+    Counters counters = _counters;
+    _counters         = Counters();
+    return counters;
+}
@@ -0,0 +1,130 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "glUtils.h"
+#include "framebuffer.h"
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+
+namespace snn {
+
+// Skips GL binding calls, that would not change the bound state.
+// Render passes of one backend bind programs, textures, samplers and buffers through this cache only.
+// Other code (uploads, downloads, applications) may change the bindings, and deleted objects are unbound,
+// so the cache must be invalidated before the first pass of an inference, and after the GPU has been synced for CPU layers.
+class OpenGLStateCache {
+public:
+    // Binding statistics of render passes
+    struct Counters {
+        uint64_t issued  = 0; // Number of issued GL binding calls
+        uint64_t skipped = 0; // Number of skipped redundant GL binding calls
+    };
+
+    // Constructor
+    // params:
+    //  disabled - issue every binding call, as without the cache. Used for comparison.
+    explicit OpenGLStateCache(bool disabled = false): _disabled(disabled) { invalidate(); }
+
+    // Forgets all cached bindings
+    void invalidate();
+
+    void useProgram(GLuint program);
+
+    void bindVertexArray(GLuint vertexArray);
+
+    // Binds a frame buffer object. FrameBuffer2 is used to keep its bound frame buffer pointer valid.
+    void bindFramebuffer(const FrameBuffer2& fb);
+
+    // Binds the default frame buffer
+    void unbindFramebuffer();
+
+    // Binds a texture to a texture unit
+    // params:
+    //  unit - texture unit index
+    //  target - texture target
+    //  texture - texture id
+    void bindTexture(GLuint unit, GLenum target, GLuint texture);
+
+    void bindSampler(GLuint unit, GLuint sampler);
+
+    // Binds the base level of all texture layers to an image unit
+    // params:
+    //  unit - image unit index
+    //  texture - texture id
+    //  access - GL_READ_ONLY, GL_WRITE_ONLY or GL_READ_WRITE
+    //  format - internal format of the texture
+    void bindImageTexture(GLuint unit, GLuint texture, GLenum access, GLenum format);
+
+    // Binds a buffer to an indexed binding point
+    // params:
+    //  target - GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER
+    //  index - binding point index
+    //  buffer - buffer id
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+    // Gets and resets the statistics
+    Counters takeCounters();
+
+private:
+    static constexpr GLuint UNKNOWN   = ~0u;
+    static constexpr size_t MAX_UNITS = 32; // Bindings to units beyond this are issued always
+
+    struct TextureBinding {
+        GLenum target  = GL_NONE;
+        GLuint texture = UNKNOWN;
+
+        bool operator==(const TextureBinding& that) const { return target == that.target && texture == that.texture; }
+    };
+
+    struct ImageBinding {
+        GLuint texture = UNKNOWN;
+        GLenum access  = GL_NONE;
+        GLenum format  = GL_NONE;
+
+        bool operator==(const ImageBinding& that) const { return texture == that.texture && access == that.access && format == that.format; }
+    };
+
+    bool _disabled;
+    GLuint _program     = UNKNOWN;
+    GLuint _vertexArray = UNKNOWN;
+    GLuint _framebuffer = UNKNOWN;
+    GLuint _activeUnit  = UNKNOWN;
+    std::array<TextureBinding, MAX_UNITS> _textures;
+    std::array<GLuint, MAX_UNITS> _samplers;
+    std::array<ImageBinding, MAX_UNITS> _images;
+    std::unordered_map<uint64_t, GLuint> _buffers; // Key is target and binding point index
+    Counters _counters;
+
+    // Checks if a cached value is up to date, and updates it if not
+    // params:
+    //  cached - cached value
+    //  value - new value
+    // returns:
+    //  true if the binding call has to be issued
+    template<typename T>
+    bool update(T& cached, const T& value) {
+        if (!_disabled && cached == value) {
+            ++_counters.skipped;
+            return false;
+        }
+        cached = value;
+        ++_counters.issued;
+        return true;
+    }
+};
+
+} // namespace snn
@@ -18,6 +18,7 @@
 #include "snn/snn.h"
 #include "modelparser.h"
 #include <string>
+#include <algorithm>
 #include <utility>
 
 namespace snn {
@@ -41,6 +42,14 @@ public:
     virtual ~PadLayer() = default;
     virtual InferenceGraph::Transform getOutputScaleDimAdjustment() const override;
 
+    virtual bool getSpatialFootprint(uint32_t& kernelRadius, float& scale) const override {
+        uint32_t offsets[4];
+        getPaddingOffset(offsets);
+        kernelRadius = *std::max_element(offsets, offsets + 4);
+        scale        = 1.0f;
+        return true;
+    }
+
 protected:
     PadDesc _desc;
 
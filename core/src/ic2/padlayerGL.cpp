@@ -33,8 +33,7 @@ void PadLayerGl::buildPreDefine(std::ostringstream& stream, const LayerGenOption
     stream << "// " << shaderFilePath << std::endl;
     stream << "#define NUM_INPUT_PLANES " << _desc.numInputPlanes << std::endl;
     stream << "#define NUM_OUTPUT_PLANES    " << _desc.numOutputPlanes << std::endl;
-    stream << "#define INPUT_WIDTH " << options.desiredInput[0].width << std::endl;
-    stream << "#define INPUT_HEIGHT " << options.desiredInput[0].height << std::endl;
+    buildInputSizeDefines(stream, options);
     stream << "#define PAD_VALUE 0.0f" << std::endl;
     // Currently we have no way of getting which value
     // is being used to pad. So we default to 0.0
@@ -0,0 +1,232 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pch.h"
+#include "snn/precisionPlanner.h"
+#include "snn/core.h"
+#include "snn/image.h"
+#include "dp.h"
+#include <picojson.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace snn;
+
+namespace {
+
+// Outputs of the model for every calibration sample
+typedef std::vector<std::vector<float>> ModelOutputs;
+
+// Reads the output of the last stage as floats
+void readOutput(MixedInferenceCore& core, std::vector<float>& values) {
+    values.clear();
+    ImageTexture& output = core.getOutputImage();
+    // CPU layers store their results in the float buffer
+    if (!output.getOutputMat().empty()) {
+        for (const auto& row : output.getOutputMat()) {
+            values.insert(values.end(), row.begin(), row.end());
+        }
+        return;
+    }
+    output.download();
+    ManagedImage<Rgba32f> image = toRgba32f(output.getRawImage());
+    const auto& desc            = image.desc();
+    for (size_t p = 0; p < desc.planes.size(); ++p) {
+        const auto& plane = desc.planes[p];
+        for (uint32_t z = 0; z < plane.depth; ++z) {
+            for (uint32_t y = 0; y < plane.height; ++y) {
+                for (uint32_t x = 0; x < plane.width; ++x) {
+                    const Rgba32f& pixel = image.at(p, x, y, z);
+                    values.insert(values.end(), pixel.f32, pixel.f32 + 4);
+                }
+            }
+        }
+    }
+}
+
+// Builds the model with the given precision and runs it on every calibration sample
+bool runModel(GpuContext* context, const std::string& modelFileName, const dp::ShaderGenOptions& options,
+              const std::vector<ImageTextureArrayAccessor>& calibrationInputs, ModelOutputs& outputs) {
+    auto core = MixedInferenceCore::create(context, modelFileName, options);
+    if (!core) {
+        return false;
+    }
+    outputs.resize(calibrationInputs.size());
+    for (size_t i = 0; i < calibrationInputs.size(); ++i) {
+        std::vector<std::vector<std::vector<float>>> inputMatrix, output;
+        SNNModelOutput modelOutput;
+        MixedInferenceCore::RunParameters rp = {calibrationInputs[i], {}, inputMatrix, output, modelOutput};
+        core->run(rp);
+        readOutput(*core, outputs[i]);
+    }
+    return true;
+}
+
+// Relative RMS difference of the outputs
+double getError(const ModelOutputs& outputs, const ModelOutputs& reference) {
+    double diff = 0.0, norm = 0.0;
+    for (size_t i = 0; i < reference.size(); ++i) {
+        SNN_ASSERT(outputs[i].size() == reference[i].size());
+        for (size_t j = 0; j < reference[i].size(); ++j) {
+            double d = (double) outputs[i][j] - reference[i][j];
+            diff += d * d;
+            norm += (double) reference[i][j] * reference[i][j];
+        }
+    }
+    if (!std::isfinite(diff)) {
+        return INFINITY;
+    }
+    return norm > 0.0 ? std::sqrt(diff / norm) : std::sqrt(diff);
+}
+
+} // namespace
+
+bool snn::PrecisionPlanner::plan(GpuContext* context, const CreationParameters& cp, const std::vector<ImageTextureArrayAccessor>& calibrationInputs,
+                                 PrecisionPlan& plan) {
+    if (calibrationInputs.empty()) {
+        SNN_LOGE("Precision planning needs at least one calibration sample");
+        return false;
+    }
+    bool useVulkan = context->backendType == GpuBackendType::VULKAN;
+    auto layers    = dp::loadFromJsonModel(cp.modelFileName, useVulkan, cp.options.mrtMode, cp.options.weightMode, false);
+    if (layers.empty()) {
+        SNN_LOGE("Failed to load model %s", cp.modelFileName.c_str());
+        return false;
+    }
+
+    dp::ShaderGenOptions options     = cp.options;
+    options.preferrHalfPrecision     = false;
+    auto evaluate = [&](const std::map<uint32_t, bool>& layerHalfPrecision, const ModelOutputs* reference, ModelOutputs& outputs, double& error) {
+        options.layerHalfPrecision = layerHalfPrecision;
+        if (!runModel(context, cp.modelFileName, options, calibrationInputs, outputs)) {
+            return false;
+        }
+        error = reference ? getError(outputs, *reference) : 0.0;
+        return true;
+    };
+
+    ModelOutputs reference, outputs;
+    double error = 0.0;
+    if (!evaluate({}, nullptr, reference, error)) {
+        return false;
+    }
+
+    // Error of every layer switched to FP16 alone
+    plan = {};
+    plan.errorBudget = cp.errorBudget;
+    for (uint32_t i = 0; i < (uint32_t) layers.size(); ++i) {
+        // Input layers pass the model input through
+        if (layers[i]->isInputLayer()) {
+            continue;
+        }
+        if (!evaluate({{i, true}}, &reference, outputs, error)) {
+            return false;
+        }
+        plan.layerErrors.push_back({i, layers[i]->getName(), error});
+        SNN_LOGD("FP16 %s: error %g", layers[i]->getName().c_str(), error);
+    }
+    std::stable_sort(plan.layerErrors.begin(), plan.layerErrors.end(),
+                     [](const PrecisionPlan::LayerError& a, const PrecisionPlan::LayerError& b) { return a.error < b.error; });
+
+    // Errors accumulate, so the largest prefix of the sorted layers, that fits into the budget, is searched by bisection
+    auto getPrefix = [&](size_t count) {
+        std::map<uint32_t, bool> layerHalfPrecision;
+        for (size_t j = 0; j < plan.layerErrors.size(); ++j) {
+            layerHalfPrecision[plan.layerErrors[j].layerIndex] = j < count;
+        }
+        return layerHalfPrecision;
+    };
+    size_t lo = 0;
+    size_t hi = std::count_if(plan.layerErrors.begin(), plan.layerErrors.end(), [&](const PrecisionPlan::LayerError& e) { return e.error <= cp.errorBudget; });
+    double loError = 0.0;
+    while (lo < hi) {
+        size_t mid = (lo + hi + 1) / 2;
+        if (!evaluate(getPrefix(mid), &reference, outputs, error)) {
+            return false;
+        }
+        if (error <= cp.errorBudget) {
+            lo      = mid;
+            loError = error;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    plan.layerHalfPrecision = getPrefix(lo);
+    plan.error              = loError;
+    SNN_LOGI("Precision plan for %s: %zu of %zu layers in FP16, error %g (budget %g)", cp.modelFileName.c_str(), lo, plan.layerErrors.size(), plan.error,
+             cp.errorBudget);
+    return true;
+}
+
+bool snn::PrecisionPlan::save(const std::string& fileName) const {
+    std::ofstream file(fileName);
+    if (!file.good()) {
+        SNN_LOGE("Failed to open %s", fileName.c_str());
+        return false;
+    }
+    file << "{\n  \"error_budget\": " << errorBudget << ",\n  \"error\": " << error << ",\n  \"layers\": [";
+    for (size_t i = 0; i < layerErrors.size(); ++i) {
+        const auto& layer = layerErrors[i];
+        auto it           = layerHalfPrecision.find(layer.layerIndex);
+        bool fp16         = it != layerHalfPrecision.end() && it->second;
+        file << (i ? ",\n" : "\n") << "    {\"index\": " << layer.layerIndex << ", \"name\": " << picojson::value(layer.name).serialize()
+             << ", \"fp16\": " << (fp16 ? "true" : "false") << ", \"error\": " << layer.error << "}";
+    }
+    file << "\n  ]\n}\n";
+    return file.good();
+}
+
+bool snn::PrecisionPlan::load(const std::string& fileName) {
+    std::ifstream file(fileName);
+    if (!file.good()) {
+        SNN_LOGE("Failed to open %s", fileName.c_str());
+        return false;
+    }
+    std::stringstream ss;
+    ss << file.rdbuf();
+    picojson::value json;
+    std::string err = picojson::parse(json, ss.str());
+    if (!err.empty() || !json.is<picojson::object>() || !json.get("layers").is<picojson::array>()) {
+        SNN_LOGE("Invalid precision plan %s: %s", fileName.c_str(), err.c_str());
+        return false;
+    }
+    *this = {};
+    if (json.get("error_budget").is<double>()) {
+        errorBudget = json.get("error_budget").get<double>();
+    }
+    if (json.get("error").is<double>()) {
+        error = json.get("error").get<double>();
+    }
+    for (const auto& layer : json.get("layers").get<picojson::array>()) {
+        if (!layer.get("index").is<double>() || !layer.get("fp16").is<bool>()) {
+            SNN_LOGE("Invalid layer in precision plan %s", fileName.c_str());
+            return false;
+        }
+        LayerError layerError;
+        layerError.layerIndex = (uint32_t) layer.get("index").get<double>();
+        if (layer.get("name").is<std::string>()) {
+            layerError.name = layer.get("name").get<std::string>();
+        }
+        if (layer.get("error").is<double>()) {
+            layerError.error = layer.get("error").get<double>();
+        }
+        layerHalfPrecision[layerError.layerIndex] = layer.get("fp16").get<bool>();
+        layerErrors.push_back(layerError);
+    }
+    return true;
+}
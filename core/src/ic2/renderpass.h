@@ -15,10 +15,46 @@
 #pragma once
 
 #include "snn/utils.h"
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 
 namespace snn {
 
+// This is a base class of the compiled part of a render pass: programs and weights, that don't depend on the activations.
+// Compiled passes are immutable after creation, so that render passes of all execution contexts of a model share them.
+class CompiledRenderPass {
+public:
+    CompiledRenderPass() = default;
+
+    virtual ~CompiledRenderPass() = default;
+
+    SNN_NO_COPY(CompiledRenderPass);
+    SNN_NO_MOVE(CompiledRenderPass);
+};
+
+// This class holds compiled passes of models, that are generated from the same model file for different input resolutions
+// (see MultiResolutionInferenceCore). A new compiled pass reuses the weight textures and buffers of the cached pass
+// with the same name, if their weights are the same. Passes are not kept alive by the cache.
+class WeightCache {
+public:
+    std::shared_ptr<const CompiledRenderPass> find(const std::string& name) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto iter = passes.find(name);
+        return iter == passes.end() ? nullptr : iter->second.lock();
+    }
+
+    void add(const std::string& name, const std::shared_ptr<const CompiledRenderPass>& pass) {
+        std::lock_guard<std::mutex> lock(mutex);
+        passes[name] = pass;
+    }
+
+private:
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, std::weak_ptr<const CompiledRenderPass>> passes;
+};
+
 // This is a base class of one render pass.
 // Derived classes implement actions, performed during a render pass.
 class RenderPass {
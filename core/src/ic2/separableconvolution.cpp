@@ -16,6 +16,7 @@
 #include "separableconvolution.h"
 #include "layerFactory.h"
 #include "inferencepass.h"
+#include "snn/fp16.h"
 #include <string>
 #include <vector>
 #include <algorithm>
@@ -109,3 +110,13 @@ bool SeparableConv2DLayer::oihw2hwo4i4(std::vector<cv::Mat> inputWeights, std::v
     }
     return 0;
 }
+
+bool SeparableConv2DLayer::oihw2hwo4i4fp16(const std::vector<cv::Mat>& inputWeights, std::vector<float>& outVec, int inChannels,
+    int outChannels, int fw, int fh, int unit) {
+    // Packed floats are converted in place
+    oihw2hwo4i4(inputWeights, outVec, inChannels, outChannels, fw, fh, unit);
+    size_t count = outVec.size();
+    snn::fp16::floatToHalf(outVec.data(), (uint16_t*) outVec.data(), count);
+    outVec.resize((count + 1) / 2);
+    return 0;
+}
@@ -49,11 +49,33 @@ public:
     virtual InferenceGraph::Transform getOutputScaleDimAdjustment() const override;
     virtual void getOutputDims(uint32_t& width, uint32_t& height, uint32_t& depth) const override;
 
+    virtual bool getSpatialFootprint(uint32_t& kernelRadius, float& scale) const override {
+        kernelRadius = _desc.kernelSize / 2;
+        scale        = 1.0f / static_cast<float>(_desc.stride);
+        return true;
+    }
+
+    // Depthwise convolution: every output channel depends on one input channel
+    virtual void getArithmeticCost(uint64_t& macs, uint64_t& numWeights) const override {
+        uint32_t width = 0, height = 0, depth = 0;
+        getOutputDims(width, height, depth);
+        uint64_t kernelWeights = (uint64_t) _desc.kernelSize * _desc.kernelSize * _desc.numOutputPlanes;
+        macs       = (uint64_t) width * height * kernelWeights;
+        numWeights = kernelWeights + _desc.numOutputPlanes * (_desc.useBatchNormalization ? 5 : 1);
+    }
+
+    const SeparableConv2DDesc& getSeparableConv2DDesc() const { return _desc; }
+
+    // Gets padding: top, bottom, left, right
+    void getPaddingOffset(uint32_t (&offsets)[4]) const;
+
 protected:
     mutable SeparableConv2DDesc _desc;
 
-    void getPaddingOffset(uint32_t (&offsets)[4]) const;
     static bool oihw2hwo4i4(std::vector<cv::Mat> inputWeights, std::vector<float>& outVec, int inChannels, int outChannels, int fw, int fh, int unit = 4);
+
+    // Same as oihw2hwo4i4(), but packs half floats, 2 per element of outVec
+    static bool oihw2hwo4i4fp16(const std::vector<cv::Mat>& inputWeights, std::vector<float>& outVec, int inChannels, int outChannels, int fw, int fh, int unit = 4);
 };
 
 } // namespace dp
@@ -16,6 +16,7 @@
 #include "separableconvolutionGL.h"
 #include "layerFactory.h"
 #include "inferencepassGL.h"
+#include "snn/fp16.h"
 #include <string>
 #include <cstring>
 #include <vector>
@@ -56,23 +57,27 @@ SeparableConv2DLayerGl::SeparableConv2DLayerGl(SeparableConv2DDesc&& d): Separab
 
 void SeparableConv2DLayerGl::setTextureWeights() const {
     std::vector<float> weightVal(4 * _desc.kernelSize * _desc.kernelSize, 0.0);
+    // Weights are collected as floats and converted to the texture format before every upload
+    std::vector<uint16_t> halfVal(4 * _desc.kernelSize * _desc.kernelSize);
+    auto getPixels = [&]() -> const void* {
+        if (!_desc.preferHp) {
+            return weightVal.data();
+        }
+        snn::fp16::floatToHalf(weightVal.data(), halfVal.data(), halfVal.size());
+        return halfVal.data();
+    };
     for (std::size_t filter = 0; filter < _desc.numOutputPlanes; filter++) {
         SNN_LOGD("Updating weights for weight texture: %u, %u", this->weightTextures[filter].id(), this->weightTextures[filter].target());
         for (std::size_t i = 0; i < _desc.kernelSize; i++) {
             for (std::size_t j = 0; j < _desc.kernelSize; j++) {
                 std::size_t weightValIdx = (4 * _desc.kernelSize * i) + (4 * j) + (filter % 4);
                 SNN_LOGD("Filling IDX %u in buffer with size %u", weightValIdx, weightVal.size());
-                if (_desc.preferHp) {
-                    uint16_t* fp16Addr = (uint16_t*)weightVal.data();
-                    *(fp16Addr + weightValIdx) = FP32::toHalf(_desc.weightsCvM[filter].at<float>(i, j));
-                } else {
-                    weightVal[weightValIdx] = _desc.weightsCvM[filter].at<float>(i, j);
-                }
+                weightVal[weightValIdx] = _desc.weightsCvM[filter].at<float>(i, j);
             }
         }
         if ((filter + 1) % 4 == 0) {
             this->weightTextures[filter / 4].bind(0);
-            this->weightTextures[filter / 4].setPixels(0, 0, 0, _desc.kernelSize, _desc.kernelSize, 0, weightVal.data());
+            this->weightTextures[filter / 4].setPixels(0, 0, 0, _desc.kernelSize, _desc.kernelSize, 0, getPixels());
             glFinish();
             this->weightTextures[filter / 4].unbind();
             weightVal.clear();
@@ -85,7 +90,7 @@ void SeparableConv2DLayerGl::setTextureWeights() const {
             weightVal.push_back(0.0f);
         }
         this->weightTextures[DIV_4_ROUND_UP(_desc.numOutputPlanes)].bind(0);
-        this->weightTextures[DIV_4_ROUND_UP(_desc.numOutputPlanes)].setPixels(0, 0, 0, _desc.kernelSize, _desc.kernelSize, 0, weightVal.data());
+        this->weightTextures[DIV_4_ROUND_UP(_desc.numOutputPlanes)].setPixels(0, 0, 0, _desc.kernelSize, _desc.kernelSize, 0, getPixels());
         glFinish();
         this->weightTextures[DIV_4_ROUND_UP(_desc.numOutputPlanes)].unbind();
     }
@@ -433,8 +438,7 @@ void SeparableConv2DLayerGl::buildPreDefine(std::ostringstream& stream, const La
     stream << "#version 320 es\n";
     stream << "#define NUM_INPUT_PLANES " << _desc.numInputPlanes << std::endl;
     stream << "#define NUM_OUTPUT_PLANES " << _desc.numOutputPlanes << std::endl;
-    stream << "#define INPUT_WIDTH " << options.desiredInput[0].width << std::endl;
-    stream << "#define INPUT_HEIGHT " << options.desiredInput[0].height << std::endl;
+    buildInputSizeDefines(stream, options);
     stream << "#define NUM_KERNEL_SIZE " << _desc.kernelSize << std::endl;
     stream << "#define NUM_STRIDE " << _desc.stride << std::endl;
     stream << "#define PAD_VALUE 0.0f" << std::endl;
@@ -684,32 +688,6 @@ InferencePassesSptr SeparableConv2DLayerGl::createFS(const LayerGenOptions& opti
     return ret;
 }
 
-static bool oihw2hwo4i4fp16(std::vector<cv::Mat> inputWeights, std::vector<float>& outVec, int inChannels, int outChannels, int fw, int fh, int unit = 4) {
-    (void) inChannels;
-    int alignedWeightSize = ROUND_UP(outChannels, unit) * fw * fh / 2;
-
-    outVec.clear();
-    outVec.resize(alignedWeightSize);
-    std::fill(outVec.begin(), outVec.end(), 0);
-
-    uint16_t* out    = (uint16_t*) outVec.data();
-    int planeSize = ROUND_UP(outChannels, unit) * fw;
-
-    for (int b = 0; b < outChannels; ++b) {
-        int b_4 = b / unit;
-        int mx  = b % unit;
-        for (int y = 0; y < fh; ++y) {
-            for (int x = 0; x < fw; ++x) {
-                int base                                 = y * planeSize;
-                int inSize                               = ROUND_UP(outChannels, unit); // in the number of floats
-                out[base + inSize * x + b_4 * unit + mx] = FP32::toHalf(inputWeights[b].at<float>(y * fw + x));
-            }
-        }
-    }
-
-    return 0;
-}
-
 #define TEXTURE_WEIGHTS
 
 InferencePassesSptr SeparableConv2DLayerGl::createCS(const LayerGenOptions& options) const {
@@ -778,16 +756,8 @@ InferencePassesSptr SeparableConv2DLayerGl::createCS(const LayerGenOptions& opti
         shaderHeader += "#define USE_BATCH_NORMALIZATION\n";
     }
     std::string debugLayer("[0X] Conv2D");
-    std::string shaderUniforms = "#ifdef OUTPUT_TEXTURE_2D\n"
-                            "layout(OUTPUT_FORMAT, binding=3) writeonly uniform PRECISION image2D uOutput;\n"
-                            "#else\n"
-                            "layout(OUTPUT_FORMAT, binding=3) writeonly uniform PRECISION image2DArray uOutput;\n"
-                            "#endif\n"
-                            "#ifdef INPUT_TEXTURE_2D\n"
-                            "layout(OUTPUT_FORMAT, binding=0) readonly uniform PRECISION image2D uInput;\n"
-                            "#else\n"
-                            "layout(OUTPUT_FORMAT, binding=0) readonly uniform PRECISION image2DArray uInput;\n"
-                            "#endif\n"
+    std::string shaderUniforms = buildComputeOutputDeclaration("uOutput", 3, _desc.numOutputPlanes <= 4) +
+                                 buildComputeInputDeclaration("uInput", 0, 0, _desc.numInputPlanes <= 4) +
 #ifdef TEXTURE_WEIGHTS
                             "layout(binding=2) uniform PRECISION sampler2DArray uKernel;\n";
 #else
@@ -30,6 +30,8 @@ public:
     SeparableConv2DLayerGl(SeparableConv2DDesc&& d);
     virtual ~SeparableConv2DLayerGl() = default;
 
+    bool supportsBufferActivations() const override { return true; }
+
 protected:
     InferencePassesSptr createFS(const LayerGenOptions&) const override;
     InferencePassesSptr createCS(const LayerGenOptions&) const override;
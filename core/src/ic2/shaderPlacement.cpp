@@ -0,0 +1,180 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pch.h"
+#include "snn/shaderPlacement.h"
+#include "snn/core.h"
+#include "glUtils.h"
+#include <picojson.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace snn;
+
+std::map<std::string, bool> snn::ShaderPlacementTable::getLayerCompute(double minGain, bool compute) const {
+    std::map<std::string, bool> layerCompute;
+    for (const auto& layer : layers) {
+        const auto& entry = layer.second;
+        if (entry.fsMs <= 0.0 || entry.csMs <= 0.0) {
+            continue;
+        }
+        // Noise of the measurement should not flip layers back and forth
+        if (compute) {
+            layerCompute[layer.first] = entry.fsMs >= entry.csMs * (1.0 - minGain);
+        } else {
+            layerCompute[layer.first] = entry.csMs < entry.fsMs * (1.0 - minGain);
+        }
+    }
+    return layerCompute;
+}
+
+void snn::ShaderPlacementTable::merge(const ShaderPlacementTable& other) {
+    if (device.empty()) {
+        device = other.device;
+    }
+    SNN_ASSERT(device == other.device);
+    for (const auto& layer : other.layers) {
+        auto& entry = layers[layer.first];
+        if (layer.second.fsMs > 0.0) {
+            entry.fsMs = layer.second.fsMs;
+        }
+        if (layer.second.csMs > 0.0) {
+            entry.csMs = layer.second.csMs;
+        }
+    }
+}
+
+bool snn::ShaderPlacementTable::save(const std::string& fileName) const {
+    std::ofstream file(fileName);
+    if (!file.good()) {
+        SNN_LOGE("Failed to open %s", fileName.c_str());
+        return false;
+    }
+    file << "{\n  \"device\": " << picojson::value(device).serialize() << ",\n  \"layers\": [";
+    bool first = true;
+    for (const auto& layer : layers) {
+        file << (first ? "\n" : ",\n") << "    {\"signature\": " << picojson::value(layer.first).serialize() << ", \"fs_ms\": " << layer.second.fsMs
+             << ", \"cs_ms\": " << layer.second.csMs << "}";
+        first = false;
+    }
+    file << "\n  ]\n}\n";
+    return file.good();
+}
+
+bool snn::ShaderPlacementTable::load(const std::string& fileName) {
+    std::ifstream file(fileName);
+    if (!file.good()) {
+        SNN_LOGE("Failed to open %s", fileName.c_str());
+        return false;
+    }
+    std::stringstream ss;
+    ss << file.rdbuf();
+    picojson::value json;
+    std::string err = picojson::parse(json, ss.str());
+    if (!err.empty() || !json.is<picojson::object>() || !json.get("device").is<std::string>() || !json.get("layers").is<picojson::array>()) {
+        SNN_LOGE("Invalid shader placement table %s: %s", fileName.c_str(), err.c_str());
+        return false;
+    }
+    *this  = {};
+    device = json.get("device").get<std::string>();
+    for (const auto& layer : json.get("layers").get<picojson::array>()) {
+        if (!layer.get("signature").is<std::string>() || !layer.get("fs_ms").is<double>() || !layer.get("cs_ms").is<double>()) {
+            SNN_LOGE("Invalid layer in shader placement table %s", fileName.c_str());
+            return false;
+        }
+        auto& entry = layers[layer.get("signature").get<std::string>()];
+        entry.fsMs  = layer.get("fs_ms").get<double>();
+        entry.csMs  = layer.get("cs_ms").get<double>();
+    }
+    return true;
+}
+
+std::string snn::ShaderPlacement::getDeviceName(GpuContext* context) {
+    SNN_ASSERT(context->backendType == GpuBackendType::GL);
+    (void) context;
+    const char* vendor   = (const char*) glGetString(GL_VENDOR);
+    const char* renderer = (const char*) glGetString(GL_RENDERER);
+    return formatString("%s %s", vendor ? vendor : "", renderer ? renderer : "");
+}
+
+bool snn::ShaderPlacement::measure(GpuContext* context, const CreationParameters& cp, const ImageTextureArrayAccessor& inputs, ShaderPlacementTable& table) {
+    if (context->backendType != GpuBackendType::GL) {
+        SNN_LOGE("Shader placement applies to OpenGL only");
+        return false;
+    }
+    auto device = getDeviceName(context);
+    if (!table.device.empty() && table.device != device) {
+        SNN_LOGE("Shader placement table of %s can't be extended on %s", table.device.c_str(), device.c_str());
+        return false;
+    }
+    table.device = device;
+
+    for (bool compute : {false, true}) {
+        dp::ShaderGenOptions options = cp.options;
+        options.vulkan               = false;
+        options.compute              = compute;
+        options.layerCompute.clear();
+        auto core = MixedInferenceCore::create(context, cp.modelFileName, options);
+        if (!core) {
+            return false;
+        }
+
+        std::vector<std::vector<std::vector<float>>> inputMatrix, output;
+        SNNModelOutput modelOutput;
+        MixedInferenceCore::RunParameters rp = {inputs, {}, inputMatrix, output, modelOutput};
+        // First runs include shader warm-up in drivers
+        core->setGpuSamplingInterval(0);
+        for (uint32_t i = 0; i < cp.warmupRuns; ++i) {
+            core->run(rp);
+        }
+        core->setGpuSamplingInterval(1);
+        for (uint32_t i = 0; i < std::max(1U, cp.runs); ++i) {
+            core->run(rp);
+        }
+
+        // Stage names are layer names
+        std::map<std::string, const InferenceGraph::Layer*> layersByName;
+        for (const auto& layer : core->getInferenceGraph().layers) {
+            layersByName[layer->name] = layer.get();
+        }
+        auto expectedLoc = compute ? InferenceGraph::LayerExecutionType::GPU_CS : InferenceGraph::LayerExecutionType::GPU_FS;
+        // Layers with equal signatures are averaged
+        std::map<std::string, std::pair<double, uint32_t>> times;
+        for (const auto& stage : core->getMetrics().stageGpuTime) {
+            auto it = layersByName.find(stage.name);
+            // Layers without compute shaders fall back to fragment shaders and are not measured twice
+            if (it == layersByName.end() || it->second->layerLoc != expectedLoc || it->second->isNoOp || !stage.time.count) {
+                continue;
+            }
+            auto& t = times[it->second->signature];
+            t.first += stage.time.getMeanMs();
+            t.second++;
+        }
+        for (const auto& t : times) {
+            auto& entry = table.layers[t.first];
+            double ms   = t.second.first / t.second.second;
+            if (compute) {
+                entry.csMs = ms;
+            } else {
+                entry.fsMs = ms;
+            }
+        }
+        SNN_LOGI("Measured %zu %s shader layers of %s", times.size(), compute ? "compute" : "fragment", cp.modelFileName.c_str());
+    }
+    return true;
+}
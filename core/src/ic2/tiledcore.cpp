@@ -0,0 +1,303 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pch.h"
+#include "snn/tiledcore.h"
+#include "dp.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace snn;
+
+// Granularity of the input change detection in pixels. Tiles are dirty, if any block of their input window has changed.
+static constexpr uint32_t DIFF_BLOCK_SIZE = 16;
+
+static uint32_t alignUp(uint32_t value, uint32_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+snn::TiledInferenceCore::TiledInferenceCore(GpuContext* context_)
+    : context(context_)
+    , tileInputs(ImageTextureAllocator(context_))
+    , windowInputs(ImageTextureAllocator(context_))
+    , referenceInputs(ImageTextureAllocator(context_))
+{}
+
+std::unique_ptr<TiledInferenceCore> snn::TiledInferenceCore::create(GpuContext* context, const CreationParameters& cp) {
+    bool useVulkan = context->backendType == GpuBackendType::VULKAN;
+    auto dp = snn::dp::loadFromJsonModel(cp.modelFileName, useVulkan, cp.options.mrtMode, cp.options.weightMode, cp.options.preferrHalfPrecision,
+                                         cp.options.layerHalfPrecision);
+    if (dp.empty()) {
+        SNN_LOGE("Failed to load model %s", cp.modelFileName.c_str());
+        return nullptr;
+    }
+    return create(context, cp, std::move(dp));
+}
+
+std::unique_ptr<TiledInferenceCore> snn::TiledInferenceCore::create(GpuContext* context, const CreationParameters& cp, dp::InferenceModel layers) {
+    std::unique_ptr<TiledInferenceCore> p(new TiledInferenceCore(context));
+    if (!p->init(cp, std::move(layers))) {
+        return nullptr;
+    }
+    return p;
+}
+
+bool snn::TiledInferenceCore::init(const CreationParameters& cp, dp::InferenceModel dp) {
+    if (cp.options.desiredInput.size() != 1) {
+        SNN_LOGE("Tiled inference supports models with exactly one input, got %zu", cp.options.desiredInput.size());
+        return false;
+    }
+    if (cp.tileWidth == 0 || cp.tileHeight == 0) {
+        SNN_LOGE("Invalid tile size %ux%u", cp.tileWidth, cp.tileHeight);
+        return false;
+    }
+    // Vulkan images have no block difference shader, so every tile would be computed anyway
+    if (cp.incremental && context->backendType == GpuBackendType::VULKAN) {
+        SNN_LOGE("Incremental tiled inference is not supported with Vulkan");
+        return false;
+    }
+
+    uint32_t receptiveHalo = 0;
+    if (!snn::dp::getReceptiveFieldHalo(dp, receptiveHalo, outputScale, alignment)) {
+        SNN_LOGE("Model %s has layers depending on the whole image and can not be tiled", cp.modelFileName.c_str());
+        return false;
+    }
+    halo = receptiveHalo;
+    if (cp.overlap >= 0) {
+        halo = static_cast<uint32_t>(cp.overlap);
+        if (halo < receptiveHalo) {
+            SNN_LOGW("Overlap %u is less than the receptive field radius %u, tile seams might be visible", halo, receptiveHalo);
+        }
+    }
+
+    // Downscaling layers need tile origins at the multiple of their cumulative downscaling factors,
+    // also if the model upsamples back later, so the halo and the tile size are aligned as well
+    halo       = alignUp(halo, alignment);
+    tileWidth  = alignUp(cp.tileWidth, alignment);
+    tileHeight = alignUp(cp.tileHeight, alignment);
+
+    dp::ShaderGenOptions options = cp.options;
+    options.desiredInput[0].width  = tileWidth + 2 * halo;
+    options.desiredInput[0].height = tileHeight + 2 * halo;
+
+    MixedInferenceCore::CreationParameters inferenceCP;
+    (InferenceGraph &&) inferenceCP = snn::dp::generateInferenceGraph(dp, options);
+    inferenceCP.dumpOutputs         = false;
+    core = MixedInferenceCore::create(context, inferenceCP);
+    if (!core) {
+        return false;
+    }
+
+    tileInputs.allocate(1);
+    incremental     = cp.incremental;
+    changeThreshold = cp.changeThreshold;
+    if (incremental) {
+        slotWidth  = alignUp(tileWidth + 2 * halo, DIFF_BLOCK_SIZE);
+        slotHeight = alignUp(tileHeight + 2 * halo, DIFF_BLOCK_SIZE);
+        windowInputs.allocate(1);
+        referenceInputs.allocate(1);
+    }
+    SNN_LOGI("Tiled inference: tile %ux%u, halo %u, alignment %u, output scale %f, incremental %d, change threshold %f", tileWidth, tileHeight,
+             halo, alignment, outputScale, incremental, changeThreshold);
+    return true;
+}
+
+bool snn::TiledInferenceCore::gatherTileWindows(ImageTexture& input) {
+    const auto& inputDims  = input.getDims();
+    uint32_t imageWidth    = inputDims[0];
+    uint32_t imageHeight   = inputDims[1];
+    uint32_t inputWidth    = tileWidth + 2 * halo;
+    uint32_t inputHeight   = tileHeight + 2 * halo;
+    uint32_t windowsWidth  = DIV_AND_ROUND_UP(imageWidth, tileWidth) * slotWidth;
+    uint32_t windowsHeight = DIV_AND_ROUND_UP(imageHeight, tileHeight) * slotHeight;
+
+    ImageTexture& windows   = windowInputs[0];
+    ImageTexture& reference = referenceInputs[0];
+    const auto& windowDims  = windows.getDims();
+    if (windowDims[0] != windowsWidth || windowDims[1] != windowsHeight || windowDims[2] != inputDims[2] || windows.getFormat() != input.getFormat()) {
+        windows.resetTexture({windowsWidth, windowsHeight, inputDims[2], 1}, input.getFormat(), "tiled input windows");
+        reference.resetTexture({windowsWidth, windowsHeight, inputDims[2], 1}, input.getFormat(), "tiled reference input windows");
+        referenceValid = false;
+    }
+    uint32_t slotY = 0;
+    for (uint32_t tileY = 0; tileY < imageHeight; tileY += tileHeight, slotY += slotHeight) {
+        uint32_t srcY  = std::min(tileY > halo ? tileY - halo : 0, imageHeight - inputHeight);
+        uint32_t slotX = 0;
+        for (uint32_t tileX = 0; tileX < imageWidth; tileX += tileWidth, slotX += slotWidth) {
+            uint32_t srcX = std::min(tileX > halo ? tileX - halo : 0, imageWidth - inputWidth);
+            if (!windows.copyRegionFrom(input, srcX, srcY, slotX, slotY, inputWidth, inputHeight)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool snn::TiledInferenceCore::findDirtyTiles(std::vector<bool>& dirty) {
+    if (!referenceValid) {
+        return false;
+    }
+    ImageTexture& windows = windowInputs[0];
+    if (!windows.computeBlockDifference(referenceInputs[0], DIFF_BLOCK_SIZE, DIFF_BLOCK_SIZE, blockDiffs)) {
+        if (!differenceWarned) {
+            SNN_LOGW("Input images can not be compared on GPU, incremental tiled inference computes all tiles");
+            differenceWarned = true;
+        }
+        return false;
+    }
+
+    const auto& windowDims = windows.getDims();
+    uint32_t slotBlocksX   = slotWidth / DIFF_BLOCK_SIZE;
+    uint32_t slotBlocksY   = slotHeight / DIFF_BLOCK_SIZE;
+    uint32_t blocksX       = windowDims[0] / DIFF_BLOCK_SIZE;
+    uint32_t tilesX        = windowDims[0] / slotWidth;
+    uint32_t tilesY        = windowDims[1] / slotHeight;
+    dirty.clear();
+    // The halo covers the receptive field of the model, so changes outside of the tile window don't reach the tile output.
+    // Padding of the slots is never written, so it is the same in both images.
+    for (uint32_t ty = 0; ty < tilesY; ty++) {
+        for (uint32_t tx = 0; tx < tilesX; tx++) {
+            bool changed = false;
+            for (uint32_t by = ty * slotBlocksY; by < (ty + 1) * slotBlocksY && !changed; by++) {
+                for (uint32_t bx = tx * slotBlocksX; bx < (tx + 1) * slotBlocksX && !changed; bx++) {
+                    changed = blockDiffs[by * blocksX + bx] > changeThreshold;
+                }
+            }
+            dirty.push_back(changed);
+        }
+    }
+    return true;
+}
+
+std::array<uint32_t, 2> snn::TiledInferenceCore::getOutputSize(uint32_t inputWidth, uint32_t inputHeight) const {
+    return {static_cast<uint32_t>(std::lround(inputWidth * outputScale)), static_cast<uint32_t>(std::lround(inputHeight * outputScale))};
+}
+
+bool snn::TiledInferenceCore::run(ImageTexture& input, ImageTexture& output) {
+    const auto& inputDims = input.getDims();
+    uint32_t imageWidth   = inputDims[0];
+    uint32_t imageHeight  = inputDims[1];
+    uint32_t inputWidth   = tileWidth + 2 * halo;
+    uint32_t inputHeight  = tileHeight + 2 * halo;
+    if (imageWidth < inputWidth || imageHeight < inputHeight) {
+        SNN_LOGE("Image %ux%u is smaller than the tile input %ux%u, run the model without tiling", imageWidth, imageHeight, inputWidth, inputHeight);
+        return false;
+    }
+    if (imageWidth % alignment || imageHeight % alignment) {
+        SNN_LOGE("Image %ux%u is not aligned to %u", imageWidth, imageHeight, alignment);
+        return false;
+    }
+
+    ImageTexture& tileInput = tileInputs[0];
+    const auto& tileDims    = tileInput.getDims();
+    if (tileDims[0] != inputWidth || tileDims[1] != inputHeight || tileDims[2] != inputDims[2] || tileInput.getFormat() != input.getFormat()) {
+        tileInput.resetTexture({inputWidth, inputHeight, inputDims[2], 1}, input.getFormat(), "tile input");
+    }
+
+    auto outputSize = getOutputSize(imageWidth, imageHeight);
+    // The tile output is only known after the first run, so the output image is allocated lazily
+    bool outputReady = false;
+
+    // Tiles of the incremental mode reuse the output of previous frames, so the output image must not change
+    std::vector<bool> dirty;
+    bool allDirty = true;
+    if (incremental) {
+        const auto& outputDims = output.getDims();
+        if (lastOutput != &output || outputDims[0] != outputSize[0] || outputDims[1] != outputSize[1]) {
+            referenceValid = false;
+        }
+        if (!gatherTileWindows(input)) {
+            return false;
+        }
+        allDirty   = !findDirtyTiles(dirty);
+        lastOutput = &output;
+        computedTiles.assign(DIV_AND_ROUND_UP(imageWidth, tileWidth) * DIV_AND_ROUND_UP(imageHeight, tileHeight), true);
+    }
+    size_t tileIndex      = 0;
+    uint32_t tilesSkipped = 0;
+
+    auto outVec = std::vector<std::vector<std::vector<float>>>();
+    auto inVec  = std::vector<std::vector<std::vector<float>>>();
+    snn::SNNModelOutput modelOutput;
+    MixedInferenceCore::RunParameters rp = {tileInputs, {}, inVec, outVec, modelOutput};
+
+    uint32_t slotY = 0;
+    for (uint32_t tileY = 0; tileY < imageHeight; tileY += tileHeight, slotY += slotHeight) {
+        uint32_t validHeight = std::min(tileHeight, imageHeight - tileY);
+        // Border tiles are shifted inside the image instead of being padded,
+        // so that every tile sees real pixels and the model runs at the same size.
+        uint32_t srcY  = std::min(tileY > halo ? tileY - halo : 0, imageHeight - inputHeight);
+        uint32_t slotX = 0;
+        for (uint32_t tileX = 0; tileX < imageWidth; tileX += tileWidth, slotX += slotWidth) {
+            uint32_t validWidth = std::min(tileWidth, imageWidth - tileX);
+            uint32_t srcX       = std::min(tileX > halo ? tileX - halo : 0, imageWidth - inputWidth);
+            if (srcX % alignment || srcY % alignment) {
+                SNN_LOGE("Tile input origin %u,%u is not aligned to %u", srcX, srcY, alignment);
+                return false;
+            }
+            size_t index = tileIndex++;
+            if (!allDirty && !dirty[index]) {
+                computedTiles[index] = false;
+                tilesSkipped++;
+                continue;
+            }
+
+            if (!tileInput.copyRegionFrom(input, srcX, srcY, 0, 0, inputWidth, inputHeight)) {
+                return false;
+            }
+            core->run(rp);
+
+            ImageTexture& tileOutput = core->getOutputImage();
+            if (!outputReady) {
+                const auto& tileOutputDims = tileOutput.getDims();
+                const auto& outputDims     = output.getDims();
+                if (outputDims[0] != outputSize[0] || outputDims[1] != outputSize[1] || outputDims[2] != tileOutputDims[2] ||
+                    output.getFormat() != tileOutput.getFormat()) {
+                    output.resetTexture({outputSize[0], outputSize[1], tileOutputDims[2], 1}, tileOutput.getFormat(), "tiled output");
+                }
+                outputReady = true;
+            }
+            auto origin = getOutputSize(tileX - srcX, tileY - srcY);
+            auto dst    = getOutputSize(tileX, tileY);
+            auto region = getOutputSize(validWidth, validHeight);
+            if (!output.copyRegionFrom(tileOutput, origin[0], origin[1], dst[0], dst[1], region[0], region[1])) {
+                return false;
+            }
+            // The tile keeps the window, it was computed from, so changes below the threshold don't accumulate
+            if (incremental && !allDirty && !referenceInputs[0].copyRegionFrom(windowInputs[0], slotX, slotY, slotX, slotY, inputWidth, inputHeight)) {
+                return false;
+            }
+        }
+    }
+
+    if (incremental) {
+        if (allDirty) {
+            // Slot padding is copied as well, so it matches in both images
+            const auto& windowDims = windowInputs[0].getDims();
+            if (!referenceInputs[0].copyRegionFrom(windowInputs[0], 0, 0, 0, 0, windowDims[0], windowDims[1])) {
+                return false;
+            }
+            referenceValid = true;
+        }
+        uint32_t numTiles = DIV_AND_ROUND_UP(imageWidth, tileWidth) * DIV_AND_ROUND_UP(imageHeight, tileHeight);
+        stats.frames++;
+        stats.tilesComputed += numTiles - tilesSkipped;
+        stats.tilesSkipped  += tilesSkipped;
+        SNN_LOGD("Incremental tiled inference: %u of %u tiles computed", numTiles - tilesSkipped, numTiles);
+    }
+    return true;
+}
@@ -42,6 +42,15 @@ public:
     };
 }
 
+    // Bilinear interpolation reads one neighbor input pixel
+    virtual bool getSpatialFootprint(uint32_t& kernelRadius, float& scale) const override {
+        kernelRadius = (_desc.interpolationType.compare("bilinear") == 0) ? 1 : 0;
+        scale        = _desc.scale;
+        return true;
+    }
+
+    const UpSampling2DDesc& getUpSampling2DDesc() const { return _desc; }
+
 protected:
     UpSampling2DDesc _desc;
 };
@@ -116,16 +116,8 @@ InferencePassesSptr UpSampling2DLayerGl::createCS(const LayerGenOptions& options
     if (_desc.numOutputPlanes <= 4) {
         shaderHeader += "#define OUTPUT_TEXTURE_2D\n";
     }
-    std::string shaderUniforms = "#ifdef INPUT_TEXTURE_2D\n"
-                            "layout(OUTPUT_FORMAT, binding=0) readonly uniform PRECISION image2D uInput;\n"
-                            "#else\n"
-                            "layout(OUTPUT_FORMAT, binding=0) readonly uniform PRECISION image2DArray uInput;\n"
-                            "#endif\n"
-                            "#ifdef OUTPUT_TEXTURE_2D\n"
-                            "layout(OUTPUT_FORMAT, binding=3) writeonly uniform PRECISION image2D uOutput;\n"
-                            "#else\n"
-                            "layout(OUTPUT_FORMAT, binding=3) writeonly uniform PRECISION image2DArray uOutput;\n"
-                            "#endif\n";
+    std::string shaderUniforms = buildComputeInputDeclaration("uInput", 0, 0, _desc.numInputPlanes <= 4) +
+                                 buildComputeOutputDeclaration("uOutput", 3, _desc.numOutputPlanes <= 4);
 
     std::string shaderMain;
 
@@ -27,6 +27,8 @@ public:
     UpSampling2DLayerGl(UpSampling2DDesc&& d): UpSampling2DLayer(std::move(d)) {}
     virtual ~UpSampling2DLayerGl() = default;
 
+    bool supportsBufferActivations() const override { return true; }
+
 private:
     bool generateUpSampling2DGLSamplingCode(int& idxStartPlane, int nOutputChannels, std::string& uniformsDeclaration, std::string& calculation,
                                             const bool& compute) const;
@@ -19,13 +19,24 @@
 #include "dp.h"
 #include "inferencepassVulkan.h"
 #include "vkUtils.h"
+#include <cstdlib>
+#include <cstring>
 #include <vector>
 
 using namespace snn;
 using namespace snn::dp;
 
+// Records a barrier after every dispatch, to compare with the dependency-aware barriers
+static constexpr const char* SNN_VULKAN_BARRIER_EVERY_DISPATCH = "SNN_VULKAN_BARRIER_EVERY_DISPATCH";
+
+static bool getEnvBarrierEveryDispatch() {
+    const char* value = getenv(SNN_VULKAN_BARRIER_EVERY_DISPATCH);
+    return value && strcmp(value, "0") != 0;
+}
+
 VulkanBackend::VulkanBackend(GpuContext* context_)
     : context(context_)
+    , _barriers(getEnvBarrierEveryDispatch())
 {
     uvkc::benchmark::VulkanContext* ukvcContext = VulkanGpuContext::cast(context)->getUvkcContext();
     _device = (ukvcContext->devices[0].get());
@@ -38,11 +49,15 @@ VulkanBackend::VulkanBackend(GpuContext* context_)
 
     BM_CHECK_OK_AND_ASSIGN(_weightSampler0,  (_device->CreateSampler()));
     BM_CHECK_OK_AND_ASSIGN(_cmdBuffer, (_device->AllocateCommandBuffer()));
+
+    auto vulkanContext = VulkanGpuContext::cast(context);
+    _traceClock.reset(new vk::TraceClock(vulkanContext->getInstance(), vulkanContext->getPhysicalDevice(), _device));
 }
 
 void VulkanBackend::initRenderPasses(snn::dp::GenericModelLayer* modelLayer, snn::ImageTextureArrayAccessor texInputs,
-    snn::ImageTextureArrayAccessor texOutputs) {
-    modelLayer->getRenderPasses().clear();
+    snn::ImageTextureArrayAccessor texOutputs, std::vector<std::shared_ptr<RenderPass>>& renderPasses) {
+    // Vulkan passes are not compiled separately yet: every execution context creates its own pipelines and weights
+    renderPasses.clear();
 
     if (modelLayer->isInputLayer()) {
         return;
@@ -56,6 +71,9 @@ void VulkanBackend::initRenderPasses(snn::dp::GenericModelLayer* modelLayer, snn
     std::vector<uvkc::vulkan::Sampler*> weightSamplers;
     weightSamplers.push_back(_weightSampler0.get());
 
+    // Vulkan shaders store to absolute output layers, so outputs can't be aliased into a consumer's output
+    SNN_ASSERT(modelLayer->getOutputPlaneOffset() == 0);
+
     const InferencePassesVulkan* passesVulkan = InferencePassesVulkan::cast(modelLayer->getPasses());
     for (size_t i = 0; i < passesVulkan->passes.size(); i++) {
         auto& pass = passesVulkan->passes[i];
@@ -69,28 +87,20 @@ void VulkanBackend::initRenderPasses(snn::dp::GenericModelLayer* modelLayer, snn
             texOutputs,
             _device,
             _cmdBuffer.get(),
+            &_barriers,
         };
 
         auto renderPass = std::make_shared<snn::VulkanRenderPass>(context, rpcp);
 
-        modelLayer->getRenderPasses().push_back(renderPass);
+        renderPasses.push_back(renderPass);
     }
 }
 
-void VulkanBackend::prepareRun(snn::MixedInferenceCore::RunParameters& rp,
-        RenderStagesArray &stages, bool bindOutput, uint32_t bindIndex) {
+void VulkanBackend::prepareRun(snn::MixedInferenceCore::RunParameters& rp, RenderStagesArray &stages) {
     (void) rp;
     (void) stages;
-    (void) bindOutput;
-    (void) bindIndex;
-#ifdef __ANDROID__
-    if (rp.outputImages()) {
-        if (bindOutput) {
-            stages[bindIndex].stageOutputs[0].attach(&rp.outputImages[0]);
-        }
-    }
-#endif
     BM_CHECK_OK(_cmdBuffer->Begin());
+    _barriers.begin();
     _isSynced = false;
 }
 
@@ -99,6 +109,7 @@ bool VulkanBackend::sync() {
         SNN_LOGD("already synced");
         return false;
     }
+    _barriers.end(*_cmdBuffer);
     BM_CHECK_OK(_cmdBuffer->End());
     BM_CHECK_OK(_device->QueueSubmitAndWait(*_cmdBuffer));
     _isSynced = true;
@@ -146,6 +157,13 @@ void VulkanBackend::cleanupRun() {
     return;
 }
 
+void VulkanBackend::addMetrics(RuntimeMetrics& metrics) {
+    auto counters = _barriers.takeCounters();
+    SNN_LOGD("Recorded %llu dispatches, %llu barriers, %llu layout transitions", (unsigned long long) counters.dispatches,
+             (unsigned long long) counters.barriers, (unsigned long long) counters.transitions);
+    metrics.addGpuCommands(counters.dispatches, counters.barriers);
+}
+
 DeviceTimer* VulkanBackend::createDeviceTimer(const std::string& name) {
-    return new vk::GpuTimeElapsedQuery(name, _cmdBuffer.get(), _device);
+    return new vk::GpuTimeElapsedQuery(name, _cmdBuffer.get(), _device, _traceClock.get());
 }
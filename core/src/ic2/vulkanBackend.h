@@ -20,6 +20,8 @@
 #include "snn/imageTexture.h"
 #include "snn/deviceTimer.h"
 #include "uvkc/benchmark/vulkan_context.h"
+#include "vulkanBarrierScheduler.h"
+#include "vkUtils.h"
 #include <string>
 #include <memory>
 
@@ -46,16 +48,15 @@ public:
     //  modelLayer - model layer
     //  texInputs - input images
     //  texOutputs - output images
-    void initRenderPasses(dp::GenericModelLayer* modelLayer, ImageTextureArrayAccessor texInputs, ImageTextureArrayAccessor texOutputs) override;
+    //  renderPasses - created render passes
+    void initRenderPasses(dp::GenericModelLayer* modelLayer, ImageTextureArrayAccessor texInputs, ImageTextureArrayAccessor texOutputs,
+                          std::vector<std::shared_ptr<RenderPass>>& renderPasses) override;
 
     // Actions, performed before inference run
     // params:
     //  rp - run parameters
-    //  stages - array of render stages
-    //  bindOutput - flag, indicating whether we need to bind output image to external image
-    //  bindIndex - the index of the layer to bind
-    void prepareRun(MixedInferenceCore::RunParameters& rp,
-            RenderStagesArray &stages, bool bindOutput, uint32_t bindIndex) override;
+    //  stages - array of render stages. Output images are bound to the stages by MixedInferenceCore beforehand.
+    void prepareRun(MixedInferenceCore::RunParameters& rp, RenderStagesArray &stages) override;
 
     // Actions, performed after the inference run
     // params:
@@ -70,6 +71,9 @@ public:
     // Actions, performed after all other actions of the inference run
     void cleanupRun() override;
 
+    // Adds dispatch and barrier counts to the metrics
+    void addMetrics(RuntimeMetrics& metrics) override;
+
     // Creates a device timer
     // params:
     //  name - timer's name
@@ -82,7 +86,9 @@ private:
     std::unique_ptr<uvkc::vulkan::Sampler> _sampler0, _sampler1, _sampler2;
     std::unique_ptr<uvkc::vulkan::Sampler> _weightSampler0;
     std::unique_ptr<uvkc::vulkan::CommandBuffer> _cmdBuffer;
+    VulkanBarrierScheduler _barriers;
     uvkc::vulkan::Device* _device;
+    std::unique_ptr<vk::TraceClock> _traceClock;
     bool _isSynced = false;
 };
 
@@ -0,0 +1,104 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pch.h"
+#include "vulkanBarrierScheduler.h"
+
+using namespace snn;
+
+void VulkanBarrierScheduler::begin() {
+    // Command buffers are submitted and waited on, so nothing is pending at the start of a new one
+    _pendingReads.clear();
+    _pendingWrites.clear();
+    _hasWrites = false;
+}
+
+void VulkanBarrierScheduler::end(uvkc::vulkan::CommandBuffer& cmdBuffer) {
+    // Barriers between dispatches synchronize compute shaders only, so the writes synchronized by them count too
+    if (!_hasWrites) {
+        return;
+    }
+    cmdBuffer.EndBarrier();
+    _counters.barriers++;
+    _pendingReads.clear();
+    _pendingWrites.clear();
+    _hasWrites = false;
+}
+
+void VulkanBarrierScheduler::beforeDispatch(uvkc::vulkan::CommandBuffer& cmdBuffer, const std::vector<uvkc::vulkan::Image*>& reads,
+                                            const std::vector<uvkc::vulkan::Image*>& writes,
+                                            std::vector<uvkc::vulkan::CommandBuffer::PipelineBarrierInfo>& transitions) {
+    // Transitions from compute shader accesses synchronize their images
+    std::unordered_set<VkImage> transitioned;
+    for (const auto& info : transitions) {
+        if (info.src_stage & VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT) {
+            for (const auto& barrier : info.image_barriers) {
+                transitioned.insert(barrier.image);
+            }
+        }
+    }
+
+    bool hazard = false;
+    for (auto image : reads) {
+        hazard = hazard || (_pendingWrites.count(image->image()) && !transitioned.count(image->image()));
+    }
+    for (auto image : writes) {
+        hazard = hazard || ((_pendingWrites.count(image->image()) || _pendingReads.count(image->image())) && !transitioned.count(image->image()));
+    }
+    if (hazard) {
+        recordBarrier(cmdBuffer);
+    }
+
+    if (!transitions.empty()) {
+        for (const auto& info : transitions) {
+            _counters.transitions += info.image_barriers.size();
+        }
+        _counters.barriers += transitions.size();
+        cmdBuffer.TransitionImageLayout(transitions);
+        for (auto image : transitioned) {
+            _pendingReads.erase(image);
+            _pendingWrites.erase(image);
+        }
+    }
+}
+
+void VulkanBarrierScheduler::afterDispatch(uvkc::vulkan::CommandBuffer& cmdBuffer, const std::vector<uvkc::vulkan::Image*>& reads,
+                                           const std::vector<uvkc::vulkan::Image*>& writes) {
+    _counters.dispatches++;
+    _hasWrites = _hasWrites || !writes.empty();
+    if (_barrierEveryDispatch) {
+        recordBarrier(cmdBuffer);
+        return;
+    }
+    for (auto image : reads) {
+        _pendingReads.insert(image->image());
+    }
+    for (auto image : writes) {
+        _pendingWrites.insert(image->image());
+    }
+}
+
+VulkanBarrierScheduler::Counters VulkanBarrierScheduler::takeCounters() {
+    Counters ret = _counters;
+    _counters    = {};
+    return ret;
+}
+
+void VulkanBarrierScheduler::recordBarrier(uvkc::vulkan::CommandBuffer& cmdBuffer) {
+    // A global memory barrier makes all previous shader writes visible, and orders all previous accesses
+    cmdBuffer.DispatchBarrier();
+    _counters.barriers++;
+    _pendingReads.clear();
+    _pendingWrites.clear();
+}
@@ -0,0 +1,84 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "uvkc/vulkan/command_buffer.h"
+#include "uvkc/vulkan/image.h"
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+namespace snn {
+
+// Records only the pipeline barriers, that dispatches of one command buffer depend on.
+// Every dispatch declares images it reads and writes. A barrier is recorded before a dispatch only if it reads an image
+// with an unsynchronized write (RAW), or writes an image with an unsynchronized read or write (WAR, WAW).
+// So dispatches, that don't depend on each other (e.g. branches of a model), run between the same two barriers,
+// and one barrier synchronizes all of them at once. Layout transitions, that the dispatch needs, synchronize
+// their images too, and are batched into as few pipeline barriers as possible.
+class VulkanBarrierScheduler {
+public:
+    // Barrier statistics of recorded dispatches
+    struct Counters {
+        uint64_t dispatches  = 0; // Number of recorded dispatches
+        uint64_t barriers    = 0; // Number of recorded pipeline barriers, including layout transitions
+        uint64_t transitions = 0; // Number of image layout transitions
+    };
+
+    // Constructor
+    // params:
+    //  barrierEveryDispatch - record a barrier after every dispatch, as without the scheduler. Used for comparison.
+    explicit VulkanBarrierScheduler(bool barrierEveryDispatch = false): _barrierEveryDispatch(barrierEveryDispatch) {}
+
+    // Starts a new command buffer. Previous command buffers must be complete.
+    void begin();
+
+    // Records a final barrier before the command buffer ends, if any dispatch has written an image,
+    // so that transfers and shaders of later submissions and the host see the writes
+    // params:
+    //  cmdBuffer - command buffer
+    void end(uvkc::vulkan::CommandBuffer& cmdBuffer);
+
+    // Records barriers, that must precede a dispatch
+    // params:
+    //  cmdBuffer - command buffer
+    //  reads - images the dispatch reads
+    //  writes - images the dispatch writes
+    //  transitions - layout transitions, that the dispatch needs, built with CommandBuffer::AddTransitionImageLayout()
+    void beforeDispatch(uvkc::vulkan::CommandBuffer& cmdBuffer, const std::vector<uvkc::vulkan::Image*>& reads,
+                        const std::vector<uvkc::vulkan::Image*>& writes, std::vector<uvkc::vulkan::CommandBuffer::PipelineBarrierInfo>& transitions);
+
+    // Marks images of a recorded dispatch as accessed
+    // params:
+    //  cmdBuffer - command buffer
+    //  reads - images the dispatch reads
+    //  writes - images the dispatch writes
+    void afterDispatch(uvkc::vulkan::CommandBuffer& cmdBuffer, const std::vector<uvkc::vulkan::Image*>& reads,
+                       const std::vector<uvkc::vulkan::Image*>& writes);
+
+    // Gets and resets the statistics
+    Counters takeCounters();
+
+private:
+    bool _barrierEveryDispatch;
+    std::unordered_set<VkImage> _pendingReads;  // Images, read by dispatches after the last barrier
+    std::unordered_set<VkImage> _pendingWrites; // Images, written by dispatches after the last barrier
+    bool _hasWrites = false;                    // Any dispatch of the command buffer has written an image
+    Counters _counters;
+
+    void recordBarrier(uvkc::vulkan::CommandBuffer& cmdBuffer);
+};
+
+} // namespace snn
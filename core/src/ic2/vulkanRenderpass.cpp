@@ -19,6 +19,7 @@
 #include "vulkanRenderpass.h"
 #include "imageTextureVulkan.h"
 #include "colorVulkan.h"
+#include "snn/fp16.h"
 #include "uvkc/benchmark/vulkan_buffer_util.h"
 #include "uvkc/benchmark/vulkan_image_util.h"
 #include <string>
@@ -82,10 +83,7 @@ std::shared_ptr<uvkc::vulkan::Image> createVkImage(uvkc::vulkan::Device* device,
     [&](void *ptr, size_t numBytes) {
         float *dstBuffer = reinterpret_cast<float *>(ptr);
         if (format == snn::ColorFormat::RGBA16F) {
-            for (uint32_t i = 0; i < elements; i++) {
-                auto f32 = reinterpret_cast<float *>(srcBuffer) + i;
-                *((uint16_t*) ptr + i) = snn::FP32::toHalf(f32[0]);
-            }
+            snn::fp16::floatToHalf(reinterpret_cast<float *>(srcBuffer), reinterpret_cast<uint16_t *>(ptr), elements);
         } else {
             memcpy(dstBuffer, srcBuffer, outputBytes);
         }
@@ -174,6 +172,11 @@ snn::VulkanRenderPass::VulkanRenderPass(GpuContext* context_, const snn::VulkanR
             SNN_LOGD("boundImages: (weights) VkImage: %p, VkImageView: %p", _weightImages[idx].get()->image(), _weightImages[idx].get()->image_view());
             idx++;
         }
+        // Weight images never change, so they are bound once
+        BM_CHECK_OK(_cp.device->AttachImageToDescriptor(
+            *_shaderModule, _layoutSetMap,
+            {_boundImages.data(), _boundImages.size()},
+            &_weightLayouts));
     }
 }
 
@@ -214,7 +217,7 @@ void snn::VulkanRenderPass::run() {
     SNN_ASSERT(texOutputsVulkan.size() > 0);
     dstImages.push_back(texOutputsVulkan[0].vkImage(0));
 
-    std::vector<uvkc::vulkan::Device::BoundImage> boundImages(_boundImages);
+    std::vector<uvkc::vulkan::Device::BoundImage> boundImages;
     boundImages.push_back({dstImages[0].get(), _cp.samplers[0], /*set=*/0, /*binding=*/0});
     SNN_LOGD("boundImages (dest): VkImage: %p, VkImageView: %p", dstImages[0].get()->image(), dstImages[0].get()->image_view());
 
@@ -239,14 +242,27 @@ void snn::VulkanRenderPass::run() {
     boundDescriptorSets[0].index = 0;
     boundDescriptorSets[0].set = _layoutSetMap.at(descriptorSetLayout);
 
+    // Weights are transitioned only once, images already in the needed layout are skipped
     std::vector<uvkc::vulkan::CommandBuffer::PipelineBarrierInfo> barriers_info;
+    for (size_t j = 0; j < _boundImages.size(); ++j) {
+        if (_boundImages[j].image->image_layout() != _weightLayouts[j]) {
+            BM_CHECK_OK(_cp.cmdBuffer->AddTransitionImageLayout(*(_boundImages[j].image), _weightLayouts[j], barriers_info));
+        }
+    }
     for (size_t j = 0; j < boundImages.size(); ++j) {
-        BM_CHECK_OK(
-        _cp.cmdBuffer->AddTransitionImageLayout(*(boundImages[j].image), image_layouts[j], barriers_info));
+        if (boundImages[j].image->image_layout() != image_layouts[j]) {
+            BM_CHECK_OK(_cp.cmdBuffer->AddTransitionImageLayout(*(boundImages[j].image), image_layouts[j], barriers_info));
+        }
+    }
+
+    // Only dependencies on previous dispatches of the command buffer are synchronized.
+    // Image transitions with compatible pipeline stages are combined into one pipeline barrier.
+    std::vector<uvkc::vulkan::Image*> reads, writes;
+    writes.push_back(dstImages[0].get());
+    for (auto& img : srcImages) {
+        reads.push_back(img.get());
     }
-    // Minimizing the number of pipeline barriers, by combining image transitions with compatible
-    // pipeline stages into oine pipeline barrier
-    _cp.cmdBuffer->TransitionImageLayout(barriers_info);
+    _cp.barriers->beforeDispatch(*_cp.cmdBuffer, reads, writes, barriers_info);
 
     _cp.cmdBuffer->BindPipelineAndDescriptorSets(
         *_pipeline, {boundDescriptorSets.data(), boundDescriptorSets.size()});
@@ -256,7 +272,7 @@ void snn::VulkanRenderPass::run() {
     SNN_LOGD("Dispatch vulkan pipeline: %d, %d, %d", vk.dispatchSize[0], vk.dispatchSize[1], vk.dispatchSize[2]);
     _cp.cmdBuffer->Dispatch(vk.dispatchSize[0], vk.dispatchSize[1], vk.dispatchSize[2]);
 
-    _cp.cmdBuffer->DispatchBarrier();
+    _cp.barriers->afterDispatch(*_cp.cmdBuffer, reads, writes);
 }
 
 bool snn::VulkanRenderPass::debugPassInputs(const std::string& folderName) {
@@ -19,6 +19,7 @@
 #include "snn/inferencegraph.h"
 #include "inferencepassVulkan.h"
 #include "renderpass.h"
+#include "vulkanBarrierScheduler.h"
 #include "uvkc/benchmark/vulkan_context.h"
 #include <string>
 #include <vector>
@@ -45,6 +46,7 @@ public:
         ImageTextureArrayAccessor texOutputs;               // Output images
         uvkc::vulkan::Device *device;                       // Pointer to Vulkan device object
         uvkc::vulkan::CommandBuffer *cmdBuffer;             // Pointer to Vulkan command buffer object
+        VulkanBarrierScheduler *barriers;                   // Pointer to barrier scheduler of the command buffer
     };
 
     // Constructor
@@ -84,6 +86,7 @@ private:
     std::vector<std::shared_ptr<uvkc::vulkan::Image>> _srcImages, _dstImages;
     std::vector<std::shared_ptr<uvkc::vulkan::Image>> _weightImages;
     std::vector<uvkc::vulkan::Device::BoundImage> _boundImages;
+    std::vector<VkImageLayout> _weightLayouts;            // Layouts of the weight images, bound once at creation
     std::unique_ptr<::uvkc::vulkan::TimestampQueryPool> _tsQueryPool;
 };
 
@@ -15,6 +15,8 @@
 #include "pch.h"
 #include "snn/image.h"
 #include "snn/colorUtils.h"
+#include "snn/fp16.h"
+#include "imageConvert.h"
 #include <libyuv.h>
 #include <stb_image.h>
 #include <stb_image_write.h>
@@ -612,6 +614,245 @@ bool snn::toRgb8(Rgb8& dst, const uint8_t* src, ColorFormat srcFormat, bool norm
     return true;
 }
 
+// Row-wise conversions. They are used, when pixels of every row are contiguous in both images,
+// and replace the per-pixel format switch with one vectorized kernel call per row.
+// Images with padded pixels fall back to the per-pixel conversions.
+
+// Per-channel transform dst = src * scale + bias, applied after the source channels are read as floats.
+// Channels, missing in the source format, read as 0.
+struct ChannelTransform {
+    float scale[4];
+    float bias[4];
+};
+
+static bool isPacked(const RawImage& image, size_t p) { return image.desc().planes[p].step == getColorFormatDesc(image.format(p)).bits; }
+
+// Runs row(srcRow, dstRow, width, scratch) for every row of the plane, splitting the rows between threads
+template<typename ROW>
+static void forEachRow(const RawImage& src, RawImage& dst, size_t p, ROW row) {
+    size_t width    = src.width(p);
+    size_t height   = src.height(p);
+    size_t rowBytes = width * std::max(getColorFormatDesc(src.format(p)).bytes(), getColorFormatDesc(dst.format(p)).bytes());
+    convert::parallelForRows(height * src.depth(p), rowBytes, [&](size_t begin, size_t end) {
+        std::vector<float> scratch;
+        for (size_t r = begin; r < end; ++r) {
+            row(src.at(p, 0, r % height, r / height), dst.at(p, 0, r % height, r / height), width, scratch);
+        }
+    });
+}
+
+// Gets the transform, that matches the per-pixel toRgba32f():
+// 8-bit formats are normalized to [0, 1] and the alpha of RGB formats is 1.
+static bool getRgba32fTransform(ColorFormat format, ChannelTransform& t) {
+    float scale;
+    switch (format) {
+    case ColorFormat::RGBA32F:
+    case ColorFormat::RGB32F:
+    case ColorFormat::RGBA16F:
+        scale = 1.0f;
+        break;
+    case ColorFormat::RGBA8:
+    case ColorFormat::RGB8:
+    case ColorFormat::R8:
+        scale = 1.0f / 255.0f;
+        break;
+    default:
+        return false;
+    }
+    size_t ch = getColorFormatDesc(format).ch;
+    for (size_t c = 0; c < 4; ++c) {
+        t.scale[c] = c < ch ? scale : 0.0f;
+        t.bias[c]  = 0.0f;
+    }
+    if (ch == 3) {
+        t.bias[3] = 1.0f;
+    }
+    return true;
+}
+
+// Gets the transform, that matches the per-pixel norm2rgba32f()
+static bool getNormalizeTransform(ColorFormat format, const std::vector<float>& means, const std::vector<float>& norms, ChannelTransform& t) {
+    ChannelTransform unused;
+    size_t ch = getColorFormatDesc(format).ch;
+    if (!getRgba32fTransform(format, unused) || means.size() < ch || norms.size() < ch) {
+        return false;
+    }
+    for (size_t c = 0; c < 4; ++c) {
+        if (c < ch) {
+            t.scale[c] = norms[c];
+            t.bias[c]  = -means[c] * norms[c];
+        } else if (ch == 3) {
+            // Alpha of RGB formats
+            t.scale[c] = 0.0f;
+            t.bias[c]  = 1.0f;
+        } else {
+            // Missing channels of R8 are normalized zeros
+            t.scale[c] = 0.0f;
+            t.bias[c]  = -means[0] * norms[0];
+        }
+    }
+    return true;
+}
+
+// Converts a row to RGBA32F. The format must be supported by getRgba32fTransform().
+static void rowToRgba32f(const uint8_t* src, ColorFormat format, float* dst, size_t width, const ChannelTransform& t) {
+    switch (format) {
+    case ColorFormat::RGBA32F:
+        convert::scaleBiasRgba((const float*) src, dst, width, t.scale, t.bias);
+        break;
+    case ColorFormat::RGB32F:
+        convert::scaleBiasRgba((const float*) src, dst, width, t.scale, t.bias);
+        // The 4th float of a pixel is padding
+        for (size_t x = 0; x < width; ++x) {
+            dst[x * 4 + 3] = t.bias[3];
+        }
+        break;
+    case ColorFormat::RGBA16F:
+        fp16::halfToFloat((const uint16_t*) src, dst, width * 4);
+        convert::scaleBiasRgba(dst, dst, width, t.scale, t.bias);
+        break;
+    case ColorFormat::RGBA8:
+        convert::u8ToF32(src, dst, width * 4);
+        convert::scaleBiasRgba(dst, dst, width, t.scale, t.bias);
+        break;
+    case ColorFormat::RGB8:
+        for (size_t x = 0; x < width; ++x) {
+            for (size_t c = 0; c < 3; ++c) {
+                dst[x * 4 + c] = src[x * 3 + c] * t.scale[c] + t.bias[c];
+            }
+            dst[x * 4 + 3] = t.bias[3];
+        }
+        break;
+    case ColorFormat::R8:
+        for (size_t x = 0; x < width; ++x) {
+            dst[x * 4]     = src[x] * t.scale[0] + t.bias[0];
+            dst[x * 4 + 1] = t.bias[1];
+            dst[x * 4 + 2] = t.bias[2];
+            dst[x * 4 + 3] = t.bias[3];
+        }
+        break;
+    default:
+        SNN_RIP("unsupported color format: %s", getColorFormatDesc(format).name);
+    }
+}
+
+// Converts a plane to RGBA32F row by row
+// returns:
+//  false if the plane has to be converted pixel by pixel
+static bool planeToRgba32f(const RawImage& src, RawImage& dst, size_t p, const ChannelTransform& t) {
+    if (!isPacked(src, p) || !isPacked(dst, p)) {
+        return false;
+    }
+    auto format = src.format(p);
+    forEachRow(src, dst, p, [&](const uint8_t* s, uint8_t* d, size_t width, std::vector<float>&) { rowToRgba32f(s, format, (float*) d, width, t); });
+    return true;
+}
+
+// Converts a plane to RGBA16F row by row
+// returns:
+//  false if the plane has to be converted pixel by pixel
+static bool planeToRgba16f(const RawImage& src, RawImage& dst, size_t p) {
+    if (!isPacked(src, p) || !isPacked(dst, p)) {
+        return false;
+    }
+    auto format = src.format(p);
+    ChannelTransform t;
+    if (format == ColorFormat::RGBA16F) {
+        forEachRow(src, dst, p, [](const uint8_t* s, uint8_t* d, size_t width, std::vector<float>&) { memcpy(d, s, width * sizeof(Rgba16f)); });
+    } else if (format == ColorFormat::RGBA32F) {
+        forEachRow(src, dst, p, [](const uint8_t* s, uint8_t* d, size_t width, std::vector<float>&) {
+            fp16::floatToHalf((const float*) s, (uint16_t*) d, width * 4);
+        });
+    } else if (getRgba32fTransform(format, t)) {
+        forEachRow(src, dst, p, [&](const uint8_t* s, uint8_t* d, size_t width, std::vector<float>& scratch) {
+            scratch.resize(width * 4);
+            rowToRgba32f(s, format, scratch.data(), width, t);
+            fp16::floatToHalf(scratch.data(), (uint16_t*) d, width * 4);
+        });
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Converts a plane to R32F row by row and applies dst = value * scale + bias
+// returns:
+//  false if the plane has to be converted pixel by pixel
+static bool planeToR32f(const RawImage& src, RawImage& dst, size_t p, float scale, float bias) {
+    if (!isPacked(src, p) || !isPacked(dst, p)) {
+        return false;
+    }
+    auto format = src.format(p);
+    if (format != ColorFormat::R32F && format != ColorFormat::R16F && format != ColorFormat::R8 && format != ColorFormat::RGBA8) {
+        return false;
+    }
+    forEachRow(src, dst, p, [&](const uint8_t* s, uint8_t* d, size_t width, std::vector<float>&) {
+        auto dstRow     = (float*) d;
+        float rowScale  = scale;
+        switch (format) {
+        case ColorFormat::R32F:
+            memcpy(dstRow, s, width * sizeof(float));
+            break;
+        case ColorFormat::R16F:
+            fp16::halfToFloat((const uint16_t*) s, dstRow, width);
+            break;
+        case ColorFormat::R8:
+            convert::u8ToF32(s, dstRow, width);
+            rowScale /= 255.0f;
+            break;
+        default: // RGBA8
+            for (size_t x = 0; x < width; ++x) {
+                dstRow[x] = s[x * 4];
+            }
+            rowScale /= 255.0f;
+            break;
+        }
+        if (rowScale != 1.0f || bias != 0.0f) {
+            for (size_t x = 0; x < width; ++x) {
+                dstRow[x] = dstRow[x] * rowScale + bias;
+            }
+        }
+    });
+    return true;
+}
+
+// Clamps a plane to [0, 1] row by row
+// returns:
+//  false if the plane has to be clamped pixel by pixel
+static bool clampPlane(const RawImage& src, RawImage& dst, size_t p) {
+    if (!isPacked(src, p) || !isPacked(dst, p)) {
+        return false;
+    }
+    const auto& cfd = getColorFormatDesc(src.format(p));
+    // Values per pixel, including padding
+    size_t numValues = cfd.bytes() / cfd.colorDepth();
+    switch (getColorFormatType(src.format(p))) {
+    case ColorFormatType::UINT8:
+        forEachRow(src, dst, p, [&](const uint8_t* s, uint8_t* d, size_t width, std::vector<float>&) {
+            if (s != d) {
+                memcpy(d, s, width * cfd.bytes());
+            }
+        });
+        break;
+    case ColorFormatType::FLOAT16:
+        forEachRow(src, dst, p, [&](const uint8_t* s, uint8_t* d, size_t width, std::vector<float>& scratch) {
+            scratch.resize(width * numValues);
+            fp16::halfToFloat((const uint16_t*) s, scratch.data(), scratch.size());
+            convert::clampF32(scratch.data(), scratch.data(), scratch.size(), 0.0f, 1.0f);
+            fp16::floatToHalf(scratch.data(), (uint16_t*) d, scratch.size());
+        });
+        break;
+    case ColorFormatType::FLOAT32:
+        forEachRow(src, dst, p, [&](const uint8_t* s, uint8_t* d, size_t width, std::vector<float>&) {
+            convert::clampF32((const float*) s, (float*) d, width * numValues, 0.0f, 1.0f);
+        });
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
 bool snn::toRgba32f(const RawImage& src, TypedImage<Rgba32f>& dst) {
     if (src.desc().planes.size() != dst.desc().planes.size()) {
         SNN_RIP("mismatched src/dst image dimension.");
@@ -623,6 +864,10 @@ bool snn::toRgba32f(const RawImage& src, TypedImage<Rgba32f>& dst) {
         if (dst.width(p) != width || dst.height(p) != height || dst.depth(p) != depth) {
             SNN_RIP("mismatched src/dst image dimension.");
         }
+        ChannelTransform t;
+        if (getRgba32fTransform(src.format(p), t) && planeToRgba32f(src, dst, p, t)) {
+            continue;
+        }
         for (size_t z = 0; z < depth; ++z) {
             for (size_t y = 0; y < height; ++y) {
                 for (size_t x = 0; x < width; ++x) {
@@ -647,6 +892,9 @@ bool snn::toRgba16f(const RawImage& src, TypedImage<Rgba16f>& dst) {
         if (dst.width(p) != width || dst.height(p) != height || dst.depth(p) != depth) {
             SNN_RIP("mismatched src/dst image dimension.");
         }
+        if (planeToRgba16f(src, dst, p)) {
+            continue;
+        }
         for (size_t z = 0; z < depth; ++z) {
             for (size_t y = 0; y < height; ++y) {
                 for (size_t x = 0; x < width; ++x) {
@@ -671,6 +919,9 @@ bool snn::toR32f(const RawImage& src, TypedImage<R32f>& dst) {
         if (dst.width(p) != width || dst.height(p) != height || dst.depth(p) != depth) {
             SNN_RIP("mismatched src/dst image dimension.");
         }
+        if (planeToR32f(src, dst, p, 1.0f, 0.0f)) {
+            continue;
+        }
         for (size_t z = 0; z < depth; ++z) {
             for (size_t y = 0; y < height; ++y) {
                 for (size_t x = 0; x < width; ++x) {
@@ -695,6 +946,16 @@ bool snn::toRgba32f(const RawImage& src, TypedImage<Rgba32f>& dst, float min, fl
         if (dst.width(p) != width || dst.height(p) != height || dst.depth(p) != depth) {
             SNN_RIP("mismatched src/dst image dimension.");
         }
+        ChannelTransform t;
+        if (getRgba32fTransform(src.format(p), t)) {
+            for (size_t c = 0; c < 4; ++c) {
+                t.scale[c] *= max - min;
+                t.bias[c]   = t.bias[c] * (max - min) + min;
+            }
+            if (planeToRgba32f(src, dst, p, t)) {
+                continue;
+            }
+        }
         for (size_t z = 0; z < depth; ++z) {
             for (size_t y = 0; y < height; ++y) {
                 for (size_t x = 0; x < width; ++x) {
@@ -725,10 +986,10 @@ static bool norm2rgba32f(Rgba32f& dst, const uint8_t* src, ColorFormat srcFormat
         break;
     case ColorFormat::RGBA16F: {
         auto f16 = (const uint16_t*) src;
-        dst.red    = FP16::toFloat((f16[0] - means[0]) * norms[0]);
-        dst.green    = FP16::toFloat((f16[1] - means[1]) * norms[1]);
-        dst.blue    = FP16::toFloat((f16[2] - means[2]) * norms[2]);
-        dst.alpha    = FP16::toFloat((f16[3] - means[3]) * norms[3]);
+        dst.red    = (FP16::toFloat(f16[0]) - means[0]) * norms[0];
+        dst.green  = (FP16::toFloat(f16[1]) - means[1]) * norms[1];
+        dst.blue   = (FP16::toFloat(f16[2]) - means[2]) * norms[2];
+        dst.alpha  = (FP16::toFloat(f16[3]) - means[3]) * norms[3];
         break;
     }
     case ColorFormat::RGBA8:
@@ -775,6 +1036,10 @@ bool snn::normalize(const RawImage& src, TypedImage<Rgba32f>& dst, const std::ve
         if (dst.width(p) != width || dst.height(p) != height || dst.depth(p) != depth) {
             SNN_RIP("mismatched src/dst image dimension.");
         }
+        ChannelTransform t;
+        if (getNormalizeTransform(src.format(p), means, norms, t) && planeToRgba32f(src, dst, p, t)) {
+            continue;
+        }
         for (size_t z = 0; z < depth; ++z) {
             for (size_t y = 0; y < height; ++y) {
                 for (size_t x = 0; x < width; ++x) {
@@ -808,6 +1073,9 @@ void snn::clamp(const RawImage& src, RawImage& dst) {
         if (dst.width(p) != width || dst.height(p) != height || dst.depth(p) != depth || dst.format(p) != format) {
             SNN_RIP("mismatched src/dst image dimension.");
         }
+        if (clampPlane(src, dst, p)) {
+            continue;
+        }
         const auto& cfd = getColorFormatDesc(format);
         auto ch = cfd.ch;
         auto cd = cfd.colorDepth();
@@ -829,7 +1097,7 @@ void snn::clamp(const RawImage& src, RawImage& dst) {
                                 const FP16* ptrFP16 = reinterpret_cast<const snn::FP16*>(srcPtr);
                                 float val = FP16::toFloat(ptrFP16->u);
                                 val = std::min(1.0f, std::max(0.0f, val));
-                                *dstPtr = FP32::toHalf(val);
+                                *reinterpret_cast<uint16_t*>(dstPtr) = FP32::toHalf(val);
                             }
                             break;
                         case snn::ColorFormatType::FLOAT32:
@@ -930,6 +1198,9 @@ bool snn::toR32f(const RawImage& src, TypedImage<R32f>& dst, float min, float ma
         if (dst.width(p) != width || dst.height(p) != height || dst.depth(p) != depth) {
             SNN_RIP("mismatched src/dst image dimension.");
         }
+        if (planeToR32f(src, dst, p, max - min, min)) {
+            continue;
+        }
         for (size_t z = 0; z < depth; ++z) {
             for (size_t y = 0; y < height; ++y) {
                 for (size_t x = 0; x < width; ++x) {
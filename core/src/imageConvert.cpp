@@ -0,0 +1,184 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pch.h"
+#include "imageConvert.h"
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    #include <immintrin.h>
+    // AVX2 kernels are compiled for their own target and selected at runtime
+    #define SNN_CONVERT_AVX2 1
+    #define SNN_TARGET_AVX2  __attribute__((target("avx2")))
+#endif
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+    #define SNN_CONVERT_SSE2 1
+#endif
+#if defined(__aarch64__)
+    #include <arm_neon.h>
+    #define SNN_CONVERT_NEON 1
+#endif
+
+using namespace snn;
+
+namespace {
+
+#ifdef SNN_CONVERT_AVX2
+bool hasAvx2() {
+    static const bool ret = __builtin_cpu_supports("avx2");
+    return ret;
+}
+
+SNN_TARGET_AVX2 size_t u8ToF32Avx2(const uint8_t* src, float* dst, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) (src + i)));
+        _mm256_storeu_ps(dst + i, _mm256_cvtepi32_ps(v));
+    }
+    return i;
+}
+
+SNN_TARGET_AVX2 size_t scaleBiasRgbaAvx2(const float* src, float* dst, size_t numPixels, const float scale[4], const float bias[4]) {
+    __m256 s = _mm256_broadcast_ps((const __m128*) scale);
+    __m256 b = _mm256_broadcast_ps((const __m128*) bias);
+    size_t i = 0;
+    for (; i + 2 <= numPixels; i += 2) {
+        _mm256_storeu_ps(dst + i * 4, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(src + i * 4), s), b));
+    }
+    return i;
+}
+
+SNN_TARGET_AVX2 size_t clampF32Avx2(const float* src, float* dst, size_t count, float lo, float hi) {
+    __m256 l = _mm256_set1_ps(lo);
+    __m256 h = _mm256_set1_ps(hi);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(dst + i, _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i), l), h));
+    }
+    return i;
+}
+#endif
+
+} // namespace
+
+void snn::convert::u8ToF32(const uint8_t* src, float* dst, size_t count) {
+    size_t i = 0;
+#ifdef SNN_CONVERT_AVX2
+    if (hasAvx2()) {
+        i = u8ToF32Avx2(src, dst, count);
+    }
+#endif
+#ifdef SNN_CONVERT_SSE2
+    __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+        __m128i v  = _mm_loadu_si128((const __m128i*) (src + i));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        _mm_storeu_ps(dst + i, _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)));
+        _mm_storeu_ps(dst + i + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)));
+        _mm_storeu_ps(dst + i + 8, _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)));
+        _mm_storeu_ps(dst + i + 12, _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)));
+    }
+#endif
+#ifdef SNN_CONVERT_NEON
+    for (; i + 8 <= count; i += 8) {
+        uint16x8_t v = vmovl_u8(vld1_u8(src + i));
+        vst1q_f32(dst + i, vcvtq_f32_u32(vmovl_u16(vget_low_u16(v))));
+        vst1q_f32(dst + i + 4, vcvtq_f32_u32(vmovl_u16(vget_high_u16(v))));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = (float) src[i];
+    }
+}
+
+void snn::convert::scaleBiasRgba(const float* src, float* dst, size_t numPixels, const float scale[4], const float bias[4]) {
+    size_t i = 0;
+#ifdef SNN_CONVERT_AVX2
+    if (hasAvx2()) {
+        i = scaleBiasRgbaAvx2(src, dst, numPixels, scale, bias);
+    }
+#endif
+#ifdef SNN_CONVERT_SSE2
+    __m128 s = _mm_loadu_ps(scale);
+    __m128 b = _mm_loadu_ps(bias);
+    for (; i < numPixels; ++i) {
+        _mm_storeu_ps(dst + i * 4, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src + i * 4), s), b));
+    }
+#endif
+#ifdef SNN_CONVERT_NEON
+    float32x4_t s = vld1q_f32(scale);
+    float32x4_t b = vld1q_f32(bias);
+    for (; i < numPixels; ++i) {
+        vst1q_f32(dst + i * 4, vmlaq_f32(b, vld1q_f32(src + i * 4), s));
+    }
+#endif
+    for (; i < numPixels; ++i) {
+        for (size_t c = 0; c < 4; ++c) {
+            dst[i * 4 + c] = src[i * 4 + c] * scale[c] + bias[c];
+        }
+    }
+}
+
+void snn::convert::clampF32(const float* src, float* dst, size_t count, float lo, float hi) {
+    size_t i = 0;
+#ifdef SNN_CONVERT_AVX2
+    if (hasAvx2()) {
+        i = clampF32Avx2(src, dst, count, lo, hi);
+    }
+#endif
+#ifdef SNN_CONVERT_SSE2
+    __m128 l = _mm_set1_ps(lo);
+    __m128 h = _mm_set1_ps(hi);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(dst + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), l), h));
+    }
+#endif
+#ifdef SNN_CONVERT_NEON
+    float32x4_t l = vdupq_n_f32(lo);
+    float32x4_t h = vdupq_n_f32(hi);
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(dst + i, vminq_f32(vmaxq_f32(vld1q_f32(src + i), l), h));
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[i] = std::min(hi, std::max(lo, src[i]));
+    }
+}
+
+void snn::convert::parallelForRows(size_t numRows, size_t rowBytes, const std::function<void(size_t begin, size_t end)>& body) {
+    // Starting a thread costs about as much as converting this many bytes
+    static constexpr size_t MIN_BYTES_PER_THREAD = 256 * 1024;
+    static const size_t maxThreads               = std::max(1U, std::min(8U, std::thread::hardware_concurrency()));
+    size_t numThreads = std::min({maxThreads, numRows, numRows * rowBytes / MIN_BYTES_PER_THREAD});
+    if (numThreads <= 1) {
+        body(0, numRows);
+        return;
+    }
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads - 1);
+    size_t rowsPerThread = (numRows + numThreads - 1) / numThreads;
+    for (size_t t = 1; t < numThreads; ++t) {
+        size_t begin = std::min(numRows, t * rowsPerThread);
+        size_t end   = std::min(numRows, begin + rowsPerThread);
+        threads.emplace_back(body, begin, end);
+    }
+    body(0, std::min(numRows, rowsPerThread));
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
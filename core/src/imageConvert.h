@@ -0,0 +1,51 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// This file contains vectorized kernels, used by the image conversions in image.cpp.
+// Every kernel has AVX2 (selected at runtime), SSE2, NEON (AArch64) and portable implementations.
+// Half float conversions are in snn/fp16.h.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace snn {
+namespace convert {
+
+// Converts 8-bit unsigned values to floats without scaling
+void u8ToF32(const uint8_t* src, float* dst, size_t count);
+
+// Applies a per-channel transform dst = src * scale + bias to RGBA pixels. src and dst may be equal.
+// params:
+//  src - source pixels, 4 floats each
+//  dst - destination pixels, 4 floats each
+//  numPixels - number of pixels
+//  scale - per-channel scale
+//  bias - per-channel bias
+void scaleBiasRgba(const float* src, float* dst, size_t numPixels, const float scale[4], const float bias[4]);
+
+// Clamps floats to [lo, hi] range. src and dst may be equal.
+void clampF32(const float* src, float* dst, size_t count, float lo, float hi);
+
+// Splits the rows of an image between threads. Small images are processed on the calling thread.
+// params:
+//  numRows - number of rows
+//  rowBytes - size of the largest row (source or destination) in bytes
+//  body - called with [begin, end) ranges of rows
+void parallelForRows(size_t numRows, size_t rowBytes, const std::function<void(size_t begin, size_t end)>& body);
+
+} // namespace convert
+} // namespace snn
@@ -92,6 +92,72 @@ void ImageTexture::convertToRGBA32FAndNormalize(const std::vector<float>& means,
     _format = ColorFormat::RGBA32F;
 }
 
+bool ImageTexture::getYuvPreprocessUniforms(const RawImage& yuv, const YuvPreprocessParams& params, YuvPreprocessUniforms& uniforms) const {
+    size_t planes = yuv.desc().planes.size();
+    bool isNv12   = planes == 2 && yuv.format(0) == ColorFormat::R8 && yuv.format(1) == ColorFormat::RG8;
+    bool isI420   = planes == 3 && yuv.format(0) == ColorFormat::R8 && yuv.format(1) == ColorFormat::R8 && yuv.format(2) == ColorFormat::R8;
+    if (!isNv12 && !isI420) {
+        SNN_LOGE("Frame is neither NV12/NV21 nor I420 image");
+        return false;
+    }
+    if ((_format != ColorFormat::RGBA32F && _format != ColorFormat::RGBA16F) || _dims[0] == 0 || _dims[1] == 0 || _dims[2] != 1 || _dims[3] != 1) {
+        SNN_LOGE("Can't preprocess a frame into %ux%ux%ux%u %s image", _dims[0], _dims[1], _dims[2], _dims[3], getColorFormatDesc(_format).name);
+        return false;
+    }
+
+    uint32_t frameWidth  = yuv.width(0);
+    uint32_t frameHeight = yuv.height(0);
+    uint32_t cropX       = std::min(params.cropX, frameWidth);
+    uint32_t cropY       = std::min(params.cropY, frameHeight);
+    uint32_t cropWidth   = params.cropWidth ? params.cropWidth : frameWidth - cropX;
+    uint32_t cropHeight  = params.cropHeight ? params.cropHeight : frameHeight - cropY;
+    if (cropWidth == 0 || cropHeight == 0 || params.cropX + cropWidth > frameWidth || params.cropY + cropHeight > frameHeight) {
+        SNN_LOGE("Crop region %u,%u %ux%u is out of %ux%u frame", params.cropX, params.cropY, cropWidth, cropHeight, frameWidth, frameHeight);
+        return false;
+    }
+
+    float outputWidth  = (float) _dims[0];
+    float outputHeight = (float) _dims[1];
+    float dstWidth     = outputWidth;
+    float dstHeight    = outputHeight;
+    if (params.letterbox) {
+        float scale = std::min(outputWidth / cropWidth, outputHeight / cropHeight);
+        dstWidth    = cropWidth * scale;
+        dstHeight   = cropHeight * scale;
+    }
+    uniforms.dstRect = {(outputWidth - dstWidth) * 0.5f, (outputHeight - dstHeight) * 0.5f, dstWidth, dstHeight};
+    uniforms.srcRect = {(float) cropX / frameWidth, (float) cropY / frameHeight, (float) cropWidth / frameWidth, (float) cropHeight / frameHeight};
+
+    // BT.601 coefficients. libyuv approximates the limited range ones in fixed point, so nv12ToRgba8() differs by up to 3 levels.
+    float ys = params.fullRange ? 1.0f : 1.164f;
+    float yo = params.fullRange ? 0.0f : 16.0f;
+    float ub = params.fullRange ? 1.772f : 2.018f;
+    float ug = params.fullRange ? 0.344f : 0.391f;
+    float vg = params.fullRange ? 0.714f : 0.813f;
+    float vr = params.fullRange ? 1.402f : 1.596f;
+    // Texture values are in 0..1 range, chroma values are centered around 128 / 255
+    float bias = -yo * ys;
+    std::array<float, 4> yColumn {ys * 255.0f, ys * 255.0f, ys * 255.0f, 0.0f};
+    std::array<float, 4> uColumn {0.0f, -ug * 255.0f, ub * 255.0f, 0.0f};
+    std::array<float, 4> vColumn {vr * 255.0f, -vg * 255.0f, 0.0f, 0.0f};
+    std::array<float, 4> oneColumn {bias - vr * 128.0f, bias + (ug + vg) * 128.0f, bias - ub * 128.0f, 255.0f};
+    if (params.swapUV) {
+        std::swap(uColumn, vColumn);
+    }
+    for (size_t i = 0; i < 4; i++) {
+        uniforms.yuvToRgba[i]      = yColumn[i];
+        uniforms.yuvToRgba[4 + i]  = uColumn[i];
+        uniforms.yuvToRgba[8 + i]  = vColumn[i];
+        uniforms.yuvToRgba[12 + i] = oneColumn[i];
+    }
+
+    uniforms.means        = params.means;
+    uniforms.norms        = params.norms;
+    uniforms.padColor     = params.padColor;
+    uniforms.chromaPlanes = isNv12 ? 1 : 2;
+    return true;
+}
+
 
 void ImageTexture::reset(const std::array<uint32_t, 4>& dims, ColorFormat format, void* buffer /*= NULL*/, const std::string& name /*= ""*/) {
     _backend = Backend::Backend_CPU;
@@ -46,6 +46,9 @@ gl::TextureObject* ImageTextureGL::texture(size_t index) {
 }
 
 std::string ImageTextureGL::getTextureInfo() const {
+    if (_buffer) {
+        return "buffer " + std::to_string(_buffer->getId());
+    }
     if (_textures.empty()) {
         return "<empty>";
     }
@@ -53,10 +56,15 @@ std::string ImageTextureGL::getTextureInfo() const {
 }
 
 std::string ImageTextureGL::getTextureInfo2() const {
+    char buf[256];
+    if (_buffer) {
+        snprintf(buf, sizeof(buf), "buffer: %d, w: %u, h: %u, d: %u, format: %s", _buffer->getId(), _dims[0], _dims[1], _dims[2],
+            getColorFormatDesc(_format).name);
+        return std::string(buf);
+    }
     if (_textures.empty()) {
         return "<empty>";
     }
-    char buf[256];
     snprintf(buf, sizeof(buf), "id: %d, target: %d, w: %d, h: %d, d: %d, c: %d, format: %s",
         _textures[0].id(), _textures[0].target(),
         _textures[0].getDesc().width, _textures[0].getDesc().height, _textures[0].getDesc().depth, _textures[0].getDesc().channels,
@@ -69,6 +77,13 @@ void ImageTextureGL::attach(ImageTexture* src) {
     _backend = Backend::Backend_GPU;
     SNN_ASSERT(src->getType() == GpuBackendType::GL);
     ImageTextureGL* srcGL = static_cast<ImageTextureGL*>(src);
+    if (srcGL->_buffer) {
+        // Buffer images have no textures, the layout is known from the dimensions only
+        _buffer = srcGL->_buffer;
+        _dims   = srcGL->_dims;
+        _format = srcGL->_format;
+        return;
+    }
     SNN_ASSERT(_textures.size() > 0);
     SNN_ASSERT(_textures.size() <= srcGL->_textures.size());
     for (size_t i = 0; i < _textures.size(); i++) {
@@ -100,6 +115,7 @@ void ImageTextureGL::attach(const std::vector<const GpuImageHandle*>& images) {
 
 void ImageTextureGL::resetTexture() {
     _backend = Backend::Backend_GPU;
+    _buffer.reset();
 
     uint32_t width  = _dims[0];
     uint32_t height = _dims[1];
@@ -128,6 +144,19 @@ void ImageTextureGL::resetTexture(const std::array<uint32_t, 4>& dims, ColorForm
     resetTexture();
 }
 
+void ImageTextureGL::resetBuffer(const std::array<uint32_t, 4>& dims, ColorFormat format, const std::string& name) {
+    SNN_ASSERT(dims[3] == 1);
+    _name    = name;
+    _dims    = dims;
+    _format  = format;
+    _backend = Backend::Backend_GPU;
+
+    size_t size = getColorFormatDesc(format).calcImageSizeInBytes(dims[0], dims[1]) * dims[2];
+    _buffer     = std::make_shared<gl::BufferObject<GL_SHADER_STORAGE_BUFFER>>();
+    _buffer->allocate(size, (const uint8_t*) nullptr, GL_DYNAMIC_COPY);
+    SNN_LOGD("buffer = %d, size = %zu, format = %d", _buffer->getId(), size, (int) _format);
+}
+
 bool ImageTextureGL::resizeTexture(gl::TextureObject& inputTex, gl::TextureObject& outputTex, float xScale, float yScale, const std::array<float, 4>& means,
     const std::array<float, 4>& norms, bool linearFilter) {
 
@@ -157,19 +186,14 @@ bool ImageTextureGL::resizeTexture(gl::TextureObject& inputTex, gl::TextureObjec
                             "layout(OUTPUT_FORMAT, binding=3) writeonly uniform PRECISION image2DArray uOutput;\n"
                             "#endif\n";
 
-    std::string sourceCode, shaderMain;
-    // 2. Compile the Shader
-    if (!linearFilter) {
-        shaderMain = loadShader(RESIZE_NEAREST_CS_ASSET_NAME);
-    } else {
-        shaderMain = loadShader(RESIZE_BILINEAR_CS_ASSET_NAME);
+    // 2. Compile the Shader, or reuse the one compiled by an earlier call
+    gl::SimpleGlslProgram* csProgram = getProgram(shaderHeader + shaderUniforms, linearFilter ? RESIZE_BILINEAR_CS_ASSET_NAME : RESIZE_NEAREST_CS_ASSET_NAME);
+    if (!csProgram) {
+        return false;
     }
-    sourceCode = shaderHeader + shaderUniforms + shaderMain;
-    gl::SimpleGlslProgram csProgram;
-    csProgram.loadCs(sourceCode.c_str());
 
     // 3. Bind input/output texture
-    csProgram.use();
+    csProgram->use();
 
     glBindImageTexture(3, outputTex.getDesc().id, 0, true, 0, GL_WRITE_ONLY, GL_RGBA32F);
     CHECK_GL_ERROR("glBindImageTexture");
@@ -184,11 +208,80 @@ bool ImageTextureGL::resizeTexture(gl::TextureObject& inputTex, gl::TextureObjec
     glUniform4f(6, norms[0], norms[1], norms[2], norms[3]);
 
     // 4. Run the shader
-    glDispatchCompute(std::max(1U, outputTex.getDesc().width / 8), std::max(1U, outputTex.getDesc().height / 8), inputTex.getDesc().depth);
+    glDispatchCompute((outputTex.getDesc().width + 7) / 8, (outputTex.getDesc().height + 7) / 8, inputTex.getDesc().depth);
     glFinish();
     return 0;
 }
 
+gl::SimpleGlslProgram* ImageTextureGL::getProgram(const std::string& header, const char* assetName) {
+    std::string key = std::string(assetName) + '\n' + header;
+    auto iter       = _programs.find(key);
+    if (iter != _programs.end()) {
+        return iter->second.get();
+    }
+    std::string sourceCode = header + loadShader(assetName);
+    auto program           = std::make_unique<gl::SimpleGlslProgram>(assetName);
+    if (!program->loadCs(sourceCode.c_str())) {
+        SNN_LOGE("Failed to compile %s", assetName);
+        return nullptr;
+    }
+    return (_programs[key] = std::move(program)).get();
+}
+
+bool ImageTextureGL::preprocessYuv(const RawImage& yuv, const YuvPreprocessParams& params) {
+    YuvPreprocessUniforms uniforms;
+    if (!getYuvPreprocessUniforms(yuv, params, uniforms)) {
+        return false;
+    }
+    if (!isValid() || _textures[0].target() != GL_TEXTURE_2D) {
+        SNN_LOGE("Texture for preprocessed frame is not allocated: %s", getTextureInfo2().c_str());
+        return false;
+    }
+
+    std::string shaderHeader = "#version 320 es \n"
+                               "#define PRECISION highp\n"
+                               "precision PRECISION float;\n";
+    shaderHeader += formatString("#define OUTPUT_FORMAT %s\n", _format == ColorFormat::RGBA16F ? "rgba16f" : "rgba32f");
+    shaderHeader += formatString("#define CHROMA_PLANES %u\n", uniforms.chromaPlanes);
+    shaderHeader += "#define WORK_X 8\n"
+                    "#define WORK_Y 8\n"
+                    "#define WORK_Z 1\n";
+    gl::SimpleGlslProgram* csProgram = getProgram(shaderHeader, YUV_PREPROCESS_CS_ASSET_NAME);
+    if (!csProgram) {
+        return false;
+    }
+
+    // Planes are uploaded as they are, the shader converts them to RGBA
+    GLint filter = params.linearFilter ? GL_LINEAR : GL_NEAREST;
+    for (size_t i = 0; i < yuv.desc().planes.size(); i++) {
+        gl::TextureObject& plane = _yuvPlanes[i];
+        const auto& desc         = plane.getDesc();
+        if (plane.empty() || desc.format != yuv.format(i) || desc.width != yuv.width(i) || desc.height != yuv.height(i)) {
+            plane.allocate2D(yuv.format(i), yuv.width(i), yuv.height(i));
+        }
+        plane.setPixels(0, 0, 0, yuv.width(i), yuv.height(i), yuv.pitch(i), yuv.plane(i));
+        plane.bind(i);
+        GLCHK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter));
+        GLCHK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter));
+    }
+
+    csProgram->use();
+    GLCHK(glBindImageTexture(3, _textures[0].id(), 0, GL_FALSE, 0, GL_WRITE_ONLY, _format == ColorFormat::RGBA16F ? GL_RGBA16F : GL_RGBA32F));
+    glUniform2i(2, (GLint) _dims[0], (GLint) _dims[1]);
+    glUniform4fv(3, 1, uniforms.dstRect.data());
+    glUniform4fv(4, 1, uniforms.srcRect.data());
+    glUniformMatrix4fv(5, 1, GL_FALSE, uniforms.yuvToRgba.data());
+    glUniform4fv(9, 1, uniforms.means.data());
+    glUniform4fv(10, 1, uniforms.norms.data());
+    glUniform4fv(11, 1, uniforms.padColor.data());
+    GLCHK(glDispatchCompute((_dims[0] + 7) / 8, (_dims[1] + 7) / 8, 1));
+    // The first layer reads the texture next, without waiting for the CPU
+    GLCHK(glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT));
+
+    _backend = Backend::Backend_GPU;
+    return true;
+}
+
 bool ImageTextureGL::resize(float xScale, float yScale, const std::array<float, 4>& means, const std::array<float, 4>& norms,
     bool linearFilter, ColorFormat /*cf*/) {
     if (_backend != Backend::Backend_GPU) {
@@ -221,10 +314,168 @@ bool ImageTextureGL::resize(float xScale, float yScale, const std::array<float,
     return 0;
 }
 
+bool ImageTextureGL::copyRegionFrom(ImageTexture& src, uint32_t srcX, uint32_t srcY, uint32_t dstX, uint32_t dstY,
+    uint32_t regionWidth, uint32_t regionHeight) {
+    ImageTextureGL& srcGL = ImageTextureGL::cast(src);
+    if (srcGL._backend != Backend::Backend_GPU) {
+        srcGL.upload();
+    }
+    SNN_ASSERT(srcGL.getNumTextures() >= getNumTextures());
+    for (size_t i = 0; i < getNumTextures(); i++) {
+        const gl::TextureObject::TextureDesc& srcDesc = srcGL._textures[i].getDesc();
+        const gl::TextureObject::TextureDesc& dstDesc = _textures[i].getDesc();
+        if (srcX + regionWidth > srcDesc.width || srcY + regionHeight > srcDesc.height ||
+            dstX + regionWidth > dstDesc.width || dstY + regionHeight > dstDesc.height) {
+            SNN_LOGE("Region %ux%u is out of bounds: %s -> %s", regionWidth, regionHeight, srcGL.getTextureInfo2().c_str(), getTextureInfo2().c_str());
+            return false;
+        }
+        GLsizei layers = (GLsizei) std::min(srcDesc.depth, dstDesc.depth);
+        GLCHK(glCopyImageSubData(srcGL._textures[i].id(), srcGL._textures[i].target(), 0, (GLint) srcX, (GLint) srcY, 0,
+            _textures[i].id(), _textures[i].target(), 0, (GLint) dstX, (GLint) dstY, 0, (GLsizei) regionWidth, (GLsizei) regionHeight, layers));
+    }
+    _backend = Backend::Backend_GPU;
+    return true;
+}
+
+// Attaches a texture layer to the color attachment 0 of the frame buffer, bound to the target
+static void attachTextureLayer(GLenum target, const gl::TextureObject& texture, GLint layer) {
+    if (texture.target() == GL_TEXTURE_2D) {
+        GLCHKDBG(glFramebufferTexture2D(target, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture.id(), 0));
+    } else {
+        GLCHKDBG(glFramebufferTextureLayer(target, GL_COLOR_ATTACHMENT0, texture.id(), 0, layer));
+    }
+}
+
+bool ImageTextureGL::convertFrom(ImageTexture& src) {
+    ImageTextureGL& srcGL = ImageTextureGL::cast(src);
+    if (srcGL._backend != Backend::Backend_GPU) {
+        srcGL.upload();
+    }
+    if (srcGL._buffer || _buffer) {
+        SNN_LOGE("Storage buffer images can't be converted: %s -> %s", srcGL.getTextureInfo2().c_str(), getTextureInfo2().c_str());
+        return false;
+    }
+    SNN_ASSERT(srcGL.getNumTextures() >= getNumTextures());
+    for (auto& fb : _convertFramebuffers) {
+        if (!fb) {
+            fb.reset(new FrameBuffer2());
+        }
+    }
+    // Blitting converts between normalized and floating point color formats, unlike glCopyImageSubData()
+    GLCHKDBG(glBindFramebuffer(GL_READ_FRAMEBUFFER, _convertFramebuffers[0]->id()));
+    GLCHKDBG(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _convertFramebuffers[1]->id()));
+    bool ok = true;
+    for (size_t i = 0; i < getNumTextures(); i++) {
+        const gl::TextureObject::TextureDesc& srcDesc = srcGL._textures[i].getDesc();
+        const gl::TextureObject::TextureDesc& dstDesc = _textures[i].getDesc();
+        if (srcDesc.width != dstDesc.width || srcDesc.height != dstDesc.height || srcDesc.depth != dstDesc.depth) {
+            SNN_LOGE("Image sizes don't match: %s -> %s", srcGL.getTextureInfo2().c_str(), getTextureInfo2().c_str());
+            ok = false;
+            break;
+        }
+        GLint w = (GLint) dstDesc.width;
+        GLint h = (GLint) dstDesc.height;
+        for (GLint layer = 0; layer < (GLint) dstDesc.depth; layer++) {
+            attachTextureLayer(GL_READ_FRAMEBUFFER, srcGL._textures[i], layer);
+            attachTextureLayer(GL_DRAW_FRAMEBUFFER, _textures[i], layer);
+            GLCHK(glBlitFramebuffer(0, 0, w, h, 0, 0, w, h, GL_COLOR_BUFFER_BIT, GL_NEAREST));
+        }
+    }
+    FrameBuffer2::unbind();
+    if (ok) {
+        _backend = Backend::Backend_GPU;
+    }
+    return ok;
+}
+
+bool ImageTextureGL::computeBlockDifference(ImageTexture& previous, uint32_t blockWidth, uint32_t blockHeight, std::vector<float>& maxDiffs) {
+    ImageTextureGL& prevGL = ImageTextureGL::cast(previous);
+    if (_backend != Backend::Backend_GPU) {
+        upload();
+    }
+    if (prevGL._backend != Backend::Backend_GPU) {
+        prevGL.upload();
+    }
+    // The shader fetches floats from textures, so storage buffers and integer formats are compared on CPU by the caller
+    if (_buffer || prevGL._buffer || _format == ColorFormat::RGBA16U || _format != prevGL._format || getNumTextures() != prevGL.getNumTextures() ||
+        blockWidth == 0 || blockHeight == 0) {
+        return false;
+    }
+
+    uint32_t blocksX = DIV_AND_ROUND_UP(_dims[0], blockWidth);
+    uint32_t blocksY = DIV_AND_ROUND_UP(_dims[1], blockHeight);
+    size_t numBlocks = (size_t) blocksX * blocksY;
+    if (_blockDiffs.empty() || _blockDiffs.length < numBlocks * sizeof(uint32_t)) {
+        _blockDiffs.allocate<uint32_t>(numBlocks, nullptr, GL_DYNAMIC_READ);
+    }
+    std::vector<uint32_t> bits(numBlocks, 0);
+    _blockDiffs.update(bits.data(), 0, numBlocks);
+
+    for (size_t i = 0; i < getNumTextures(); i++) {
+        const gl::TextureObject::TextureDesc& desc     = _textures[i].getDesc();
+        const gl::TextureObject::TextureDesc& prevDesc = prevGL._textures[i].getDesc();
+        if (desc.width != prevDesc.width || desc.height != prevDesc.height || desc.depth != prevDesc.depth || desc.target != prevDesc.target) {
+            SNN_LOGE("Image sizes don't match: %s <> %s", getTextureInfo2().c_str(), prevGL.getTextureInfo2().c_str());
+            return false;
+        }
+        std::string shaderHeader = "#version 320 es \n"
+                                   "#define PRECISION highp\n"
+                                   "precision PRECISION float;\n";
+        if (desc.target == GL_TEXTURE_2D_ARRAY) {
+            shaderHeader += "#define INPUT_ARRAY\n";
+        }
+        shaderHeader += "#define WORK_X 8\n"
+                        "#define WORK_Y 8\n"
+                        "#define WORK_Z 1\n";
+        gl::SimpleGlslProgram* csProgram = getProgram(shaderHeader, BLOCK_DIFF_CS_ASSET_NAME);
+        if (!csProgram) {
+            return false;
+        }
+
+        if (!_nearestSampler) {
+            _nearestSampler.allocate();
+            GLCHK(glSamplerParameteri(_nearestSampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+            GLCHK(glSamplerParameteri(_nearestSampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+        }
+
+        csProgram->use();
+        _textures[i].bind(0);
+        prevGL._textures[i].bind(1);
+        _nearestSampler.bind(0);
+        _nearestSampler.bind(1);
+        _blockDiffs.bindBase(2);
+        glUniform3i(3, (GLint) desc.width, (GLint) desc.height, (GLint) desc.depth);
+        glUniform3i(4, (GLint) blockWidth, (GLint) blockHeight, (GLint) blocksX);
+        GLCHK(glDispatchCompute((desc.width + 7) / 8, (desc.height + 7) / 8, 1));
+    }
+
+    glBindSampler(0, 0);
+    glBindSampler(1, 0);
+
+    // Block maxima are needed on CPU, mapping the buffer waits for the pass
+    GLCHK(glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT));
+    _blockDiffs.getData(bits.data(), 0, numBlocks);
+    gl::BufferObject<GL_SHADER_STORAGE_BUFFER>::unbind();
+    maxDiffs.resize(numBlocks);
+    // Bits of non-negative floats are ordered as the floats, so the shader takes their maximum as integers
+    memcpy(maxDiffs.data(), bits.data(), numBlocks * sizeof(float));
+    return true;
+}
+
 // From device to host
 void ImageTextureGL::download() {
     _backend = Backend::Backend_CPU;
 
+    if (_buffer) {
+        // NC4HW4 buffer has the same layout as the layers of a texture on CPU
+        resetImages();
+        SNN_ASSERT(_images.size() <= _buffer->length);
+        GLCHK(glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT));
+        _buffer->getData(_images.data(), 0, _images.size());
+        gl::BufferObject<GL_SHADER_STORAGE_BUFFER>::unbind();
+        return;
+    }
+
     if (_dims[0] == 0 || _dims[1] == 0 || _dims[2] == 0 || _dims[3] == 0) {
         if (_textures.size() > 0) {
             _dims[0] = (GLuint) _textures[0].getDesc().width;
@@ -249,6 +500,7 @@ void ImageTextureGL::download() {
 // From host to device
 void ImageTextureGL::upload() {
     _backend = Backend::Backend_GPU;
+    _buffer.reset();
     _textures.allocate(planes());
     for (uint32_t i = 0; i < planes(); i++) {
         SNN_LOGD("index:%d format: %d w: %d h: %d depth: %d", i, (int) format(i), width(i), height(i), depth(i));
@@ -16,9 +16,15 @@
 #pragma once
 #include "snn/imageTexture.h"
 #include "glUtils.h"
+#include "framebuffer.h"
+#include <array>
+#include <map>
+#include <memory>
 
 static constexpr const char* RESIZE_NEAREST_CS_ASSET_NAME  = "shaders/3rdparty/shadertemplate_cs_upsampling2d_nearest.glsl";
 static constexpr const char* RESIZE_BILINEAR_CS_ASSET_NAME = "shaders/3rdparty/shadertemplate_cs_upsampling2d_bilinear.glsl";
+static constexpr const char* YUV_PREPROCESS_CS_ASSET_NAME  = "shaders/shadertemplate_cs_yuv_preprocess.glsl";
+static constexpr const char* BLOCK_DIFF_CS_ASSET_NAME      = "shaders/shadertemplate_cs_block_difference.glsl";
 
 namespace snn {
 
@@ -69,7 +75,7 @@ public:
     virtual bool isValid() const override {
         SNN_LOGV("OpenGL Texture:%zu, id: %d",
             _textures.size(), _textures.size() > 0 ? _textures[0].id() : 0);
-        return _textures.size() > 0 && _textures[0].id() > 0;
+        return (_buffer && !_buffer->empty()) || (_textures.size() > 0 && _textures[0].id() > 0);
     }
 
     // Allocates empty GPU texture with the same dimensions and color format
@@ -82,6 +88,13 @@ public:
     //  name - optional image name
     virtual void resetTexture(const std::array<uint32_t, 4>& dims, ColorFormat format, const std::string& name = "") override;
 
+    // Allocates empty GPU storage buffer in NC4HW4 layout instead of a texture
+    // params:
+    //  dims - dimensions
+    //  format - color format
+    //  name - optional image name
+    virtual void resetBuffer(const std::array<uint32_t, 4>& dims, ColorFormat format, const std::string& name = "") override;
+
     // Resizes the texture on GPU and optionally normalizes it.
     // params:
     //  xScale - horizontal scale factor
@@ -95,6 +108,45 @@ public:
     virtual bool resize(float xScale, float yScale, const std::array<float, 4>& means, const std::array<float, 4>& norms, bool linearFilter = true,
         ColorFormat cf = ColorFormat::NONE) override;
 
+    // Converts a YUV camera frame to RGBA, crops, resizes and normalizes it into the texture in a single compute pass.
+    // params:
+    //  yuv - NV12, NV21 or I420 frame
+    //  params - crop, resize and normalization parameters
+    // return:
+    //  true if preprocessing was successful; false if not.
+    virtual bool preprocessYuv(const RawImage& yuv, const YuvPreprocessParams& params) override;
+
+    // Copies a rectangular region of another image on GPU. All image layers are copied.
+    // params:
+    //  src - source image
+    //  srcX - horizontal offset of the region in the source image
+    //  srcY - vertical offset of the region in the source image
+    //  dstX - horizontal offset of the region in this image
+    //  dstY - vertical offset of the region in this image
+    //  regionWidth - width of the region
+    //  regionHeight - height of the region
+    // return:
+    //  true if copying was successful; false if not.
+    virtual bool copyRegionFrom(ImageTexture& src, uint32_t srcX, uint32_t srcY, uint32_t dstX, uint32_t dstY,
+        uint32_t regionWidth, uint32_t regionHeight) override;
+
+    // Converts another image into the color format of this one, blitting it layer by layer.
+    // params:
+    //  src - source image
+    // return:
+    //  true if conversion was successful; false if not.
+    virtual bool convertFrom(ImageTexture& src) override;
+
+    // Compares this image with another one block by block in a compute pass, and reads the block maxima back.
+    // params:
+    //  previous - image to compare with
+    //  blockWidth - width of a block in pixels
+    //  blockHeight - height of a block in pixels
+    //  maxDiffs - maximal absolute difference of every block, row by row
+    // return:
+    //  true if comparison was successful; false if not.
+    virtual bool computeBlockDifference(ImageTexture& previous, uint32_t blockWidth, uint32_t blockHeight, std::vector<float>& maxDiffs) override;
+
     // Downloads textures from device to host
     virtual void download() override;
 
@@ -119,6 +171,11 @@ public:
     //  Pointer to an object of gl::TextureObject class
     gl::TextureObject* texture(size_t index = 0);
 
+    // Returns the storage buffer of the image, if the image is kept in a buffer instead of a texture
+    // returns:
+    //  Pointer to the buffer object; nullptr if the image is a texture
+    const gl::BufferObject<GL_SHADER_STORAGE_BUFFER>* buffer() const { return _buffer.get(); }
+
 private:
     // Resizes a texture on GPU and optionally normalizes it.
     // params:
@@ -134,8 +191,34 @@ private:
     bool resizeTexture(gl::TextureObject& inputTex, gl::TextureObject& outputTex, float xScale, float yScale, const std::array<float, 4>& means,
                        const std::array<float, 4>& norms, bool linearFilter = true);
 
+    // Gets a compute shader program, compiling it at the first use
+    // params:
+    //  header - shader header with version, precision and defines
+    //  assetName - name of the shader asset, that follows the header
+    // returns:
+    //  pointer to the program; nullptr if the shader failed to compile
+    gl::SimpleGlslProgram* getProgram(const std::string& header, const char* assetName);
+
     // Array of texture objects
     FixedSizeArray<gl::TextureObject> _textures;
+
+    // Storage buffer of an NC4HW4 image. Shared with the images attached to this one.
+    std::shared_ptr<gl::BufferObject<GL_SHADER_STORAGE_BUFFER>> _buffer;
+
+    // Compiled programs, indexed by their assets and headers
+    std::map<std::string, std::unique_ptr<gl::SimpleGlslProgram>> _programs;
+
+    // Planes of the last preprocessed YUV frame
+    std::array<gl::TextureObject, 3> _yuvPlanes;
+
+    // Read and draw frame buffers of convertFrom(), created at the first use
+    std::array<std::unique_ptr<FrameBuffer2>, 2> _convertFramebuffers;
+
+    // Block maxima of computeBlockDifference(), as bits of non-negative floats
+    gl::BufferObject<GL_SHADER_STORAGE_BUFFER> _blockDiffs;
+
+    // Nearest sampler of computeBlockDifference(). Textures of 32-bit floats are incomplete with linear filtering on some devices.
+    gl::SamplerObject _nearestSampler;
 };
 
 typedef ImageTextureTypeCheck<GpuBackendType::GL> ImageTextureGLTypeCheck;
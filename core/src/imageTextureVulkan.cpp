@@ -154,7 +154,7 @@ bool ImageTextureVulkan::resize(float xScale, float yScale, const std::array<flo
     VkExtent3D destDimensions = {outputWidth, outputHeight, _dims[2]};
     auto vkFormat = getNativeColorVulkan(_format);
 
-    if (!_vulkanImageResizeOp) {
+    if (!_vulkanImageResizeOp || _vulkanImageResizeOp->isLinearFilter() != linearFilter) {
         _vulkanImageResizeOp = std::make_unique<VulkanImageResizeOp>();
         _vulkanImageResizeOp->init(_device, linearFilter);
     }
@@ -184,6 +184,155 @@ bool ImageTextureVulkan::resize(float xScale, float yScale, const std::array<flo
     return 0;
 }
 
+bool ImageTextureVulkan::preprocessYuv(const RawImage& yuv, const YuvPreprocessParams& params) {
+    if (!_device) {
+        SNN_RIP("Vulkan device was not assigned to ImageTexture");
+    }
+    YuvPreprocessUniforms uniforms;
+    if (!getYuvPreprocessUniforms(yuv, params, uniforms)) {
+        return false;
+    }
+    if (_vkImages.size() != 1) {
+        SNN_LOGE("Image for preprocessed frame is not allocated: %s", getTextureInfo2().c_str());
+        return false;
+    }
+
+    bool fp16 = _format == ColorFormat::RGBA16F;
+    if (!_vulkanImagePreprocessOp || _vulkanImagePreprocessOp->isLinearFilter() != params.linearFilter || _vulkanImagePreprocessOp->isFp16() != fp16) {
+        _vulkanImagePreprocessOp = std::make_unique<VulkanImagePreprocessOp>();
+        _vulkanImagePreprocessOp->init(_device, params.linearFilter, fp16);
+    }
+    VulkanImagePreprocessOp::PreprocessImageParams shaderParams = {
+        {_dims[0], _dims[1], uniforms.chromaPlanes, 0U},
+        uniforms.yuvToRgba,
+        uniforms.dstRect,
+        uniforms.srcRect,
+        uniforms.means,
+        uniforms.norms,
+        uniforms.padColor
+    };
+    _vulkanImagePreprocessOp->updateParams(shaderParams);
+
+    // Planes are uploaded as they are, the shader converts them to RGBA
+    size_t numPlanes = yuv.desc().planes.size();
+    _yuvPlanes.resize(numPlanes);
+    _yuvPlaneDescs.resize(numPlanes);
+    std::vector<uvkc::vulkan::Image*> srcImages;
+    for (size_t i = 0; i < numPlanes; i++) {
+        const ImagePlaneDesc& desc = yuv.desc(i);
+        VkExtent3D dimensions = {desc.width, desc.height, 1U};
+        if (!_yuvPlanes[i] || _yuvPlaneDescs[i].format != desc.format || _yuvPlaneDescs[i].width != desc.width || _yuvPlaneDescs[i].height != desc.height) {
+            BM_CHECK_OK_AND_ASSIGN(
+                _yuvPlanes[i],
+                _device->CreateImage(
+                    VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_TYPE_3D,
+                    getNativeColorVulkan(desc.format), dimensions, VK_IMAGE_TILING_OPTIMAL,
+                    VK_IMAGE_VIEW_TYPE_3D));
+            _yuvPlaneDescs[i] = desc;
+        }
+        size_t rowBytes = desc.width * getColorFormatDesc(desc.format).bytes();
+        BM_CHECK_OK(uvkc::benchmark::SetDeviceImageViaStagingBuffer(
+            _device, _yuvPlanes[i].get(), dimensions,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, rowBytes * desc.height,
+            [&](void *ptr, size_t) {
+                for (uint32_t y = 0; y < desc.height; y++) {
+                    memcpy((uint8_t*) ptr + y * rowBytes, yuv.row(i, y), rowBytes);
+                }
+            }));
+        srcImages.push_back(_yuvPlanes[i].get());
+    }
+    if (numPlanes == 2) {
+        // NV12 and NV21 frames bind their chroma plane to both chroma samplers of the shader
+        srcImages.push_back(_yuvPlanes[1].get());
+    }
+
+    _vulkanImagePreprocessOp->run(srcImages, _vkImages[0].get());
+
+    _backend = Backend::Backend_GPU;
+    return true;
+}
+
+bool ImageTextureVulkan::copyRegionFrom(ImageTexture& src, uint32_t srcX, uint32_t srcY, uint32_t dstX, uint32_t dstY,
+    uint32_t regionWidth, uint32_t regionHeight) {
+    if (!_device) {
+        SNN_RIP("Vulkan device was not assigned to ImageTexture");
+    }
+    ImageTextureVulkan& srcVulkan = ImageTextureVulkan::cast(src);
+    if (srcVulkan._backend != Backend::Backend_GPU) {
+        srcVulkan.upload();
+    }
+    const std::array<uint32_t, 4>& srcDims = srcVulkan.getDims();
+    if (srcX + regionWidth > srcDims[0] || srcY + regionHeight > srcDims[1] ||
+        dstX + regionWidth > _dims[0] || dstY + regionHeight > _dims[1]) {
+        SNN_LOGE("Region %ux%u is out of bounds: %s -> %s", regionWidth, regionHeight, srcVulkan.getTextureInfo2().c_str(), getTextureInfo2().c_str());
+        return false;
+    }
+    SNN_ASSERT(srcVulkan._vkImages.size() >= _vkImages.size());
+
+    BM_CHECK_OK_AND_ASSIGN(auto cmdBuffer, _device->AllocateCommandBuffer());
+    BM_CHECK_OK(cmdBuffer->Begin());
+    VkExtent3D extent = {regionWidth, regionHeight, std::min(srcDims[2], _dims[2])};
+    for (size_t i = 0; i < _vkImages.size(); i++) {
+        BM_CHECK_OK(cmdBuffer->TransitionImageLayout(*srcVulkan._vkImages[i], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL));
+        BM_CHECK_OK(cmdBuffer->TransitionImageLayout(*_vkImages[i], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
+        cmdBuffer->CopyImage(*srcVulkan._vkImages[i], {(int32_t) srcX, (int32_t) srcY, 0}, *_vkImages[i], {(int32_t) dstX, (int32_t) dstY, 0}, extent);
+    }
+    BM_CHECK_OK(cmdBuffer->End());
+    BM_CHECK_OK(_device->QueueSubmitAndWait(*cmdBuffer));
+    _backend = Backend::Backend_GPU;
+    return true;
+}
+
+bool ImageTextureVulkan::convertFrom(ImageTexture& src) {
+    if (!_device) {
+        SNN_RIP("Vulkan device was not assigned to ImageTexture");
+    }
+    ImageTextureVulkan& srcVulkan = ImageTextureVulkan::cast(src);
+    if (srcVulkan._backend != Backend::Backend_GPU) {
+        srcVulkan.upload();
+    }
+    const std::array<uint32_t, 4>& srcDims = srcVulkan.getDims();
+    if (srcDims[0] != _dims[0] || srcDims[1] != _dims[1] || srcDims[2] != _dims[2]) {
+        SNN_LOGE("Image sizes don't match: %s -> %s", srcVulkan.getTextureInfo2().c_str(), getTextureInfo2().c_str());
+        return false;
+    }
+    SNN_ASSERT(srcVulkan._vkImages.size() >= _vkImages.size());
+
+    // Images of the same format are copied, others are blitted, if the device can blit both formats
+    VkFormat srcFormat = getNativeColorVulkan(srcVulkan.getFormat());
+    VkFormat dstFormat = getNativeColorVulkan(_format);
+    bool sameFormat    = srcFormat == dstFormat;
+    if (!sameFormat) {
+        VkFormatProperties srcProperties, dstProperties;
+        vkGetPhysicalDeviceFormatProperties(_device->getDevice(), srcFormat, &srcProperties);
+        vkGetPhysicalDeviceFormatProperties(_device->getDevice(), dstFormat, &dstProperties);
+        if (srcFormat == VK_FORMAT_UNDEFINED || dstFormat == VK_FORMAT_UNDEFINED ||
+            !(srcProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT) ||
+            !(dstProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT)) {
+            SNN_LOGE("Color formats can't be converted by the device: %s -> %s", srcVulkan.getTextureInfo2().c_str(), getTextureInfo2().c_str());
+            return false;
+        }
+    }
+
+    BM_CHECK_OK_AND_ASSIGN(auto cmdBuffer, _device->AllocateCommandBuffer());
+    BM_CHECK_OK(cmdBuffer->Begin());
+    VkExtent3D extent = {_dims[0], _dims[1], _dims[2]};
+    for (size_t i = 0; i < _vkImages.size(); i++) {
+        BM_CHECK_OK(cmdBuffer->TransitionImageLayout(*srcVulkan._vkImages[i], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL));
+        BM_CHECK_OK(cmdBuffer->TransitionImageLayout(*_vkImages[i], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
+        if (sameFormat) {
+            cmdBuffer->CopyImage(*srcVulkan._vkImages[i], {0, 0, 0}, *_vkImages[i], {0, 0, 0}, extent);
+        } else {
+            cmdBuffer->BlitImage(*srcVulkan._vkImages[i], *_vkImages[i], extent);
+        }
+    }
+    BM_CHECK_OK(cmdBuffer->End());
+    BM_CHECK_OK(_device->QueueSubmitAndWait(*cmdBuffer));
+    _backend = Backend::Backend_GPU;
+    return true;
+}
+
 // From device to host
 void ImageTextureVulkan::download() {
     SNN_LOGD("%d:%d:%d:%d", _dims[0], _dims[1], _dims[2], _dims[3]);
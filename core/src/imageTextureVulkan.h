@@ -20,6 +20,7 @@
 #include "uvkc/vulkan/device.h"
 #include "uvkc/benchmark/status_util.h"
 #include "vulkanImageResizeOp.h"
+#include "vulkanImagePreprocessOp.h"
 
 #include <memory>
 
@@ -103,6 +104,37 @@ public:
     virtual bool resize(float xScale, float yScale, const std::array<float, 4>& means, const std::array<float, 4>& norms, bool linearFilter = true,
         ColorFormat cf = ColorFormat::NONE) override;
 
+    // Converts a YUV camera frame to RGBA, crops, resizes and normalizes it into the image in a single compute pass.
+    // params:
+    //  yuv - NV12, NV21 or I420 frame
+    //  params - crop, resize and normalization parameters
+    // return:
+    //  true if preprocessing was successful; false if not.
+    virtual bool preprocessYuv(const RawImage& yuv, const YuvPreprocessParams& params) override;
+
+    // Copies a rectangular region of another image on GPU. All image layers are copied.
+    // params:
+    //  src - source image
+    //  srcX - horizontal offset of the region in the source image
+    //  srcY - vertical offset of the region in the source image
+    //  dstX - horizontal offset of the region in this image
+    //  dstY - vertical offset of the region in this image
+    //  regionWidth - width of the region
+    //  regionHeight - height of the region
+    // return:
+    //  true if copying was successful; false if not.
+    virtual bool copyRegionFrom(ImageTexture& src, uint32_t srcX, uint32_t srcY, uint32_t dstX, uint32_t dstY,
+        uint32_t regionWidth, uint32_t regionHeight) override;
+
+    // Converts another image into the color format of this one. Images of the same format are copied, others are blitted.
+    // The images have to be created with VK_IMAGE_USAGE_TRANSFER_SRC_BIT and VK_IMAGE_USAGE_TRANSFER_DST_BIT respectively.
+    // Fails, if the device doesn't support blitting from the source format or into the destination format.
+    // params:
+    //  src - source image
+    // return:
+    //  true if conversion was successful; false if not.
+    virtual bool convertFrom(ImageTexture& src) override;
+
     // Downloads textures from device to host
     virtual void download() override;
 
@@ -133,6 +165,13 @@ private:
 
     // Vulkan resize op.
     std::unique_ptr<VulkanImageResizeOp> _vulkanImageResizeOp;
+
+    // Vulkan YUV preprocess op.
+    std::unique_ptr<VulkanImagePreprocessOp> _vulkanImagePreprocessOp;
+
+    // Planes of the last preprocessed YUV frame, and their descriptions
+    std::vector<std::unique_ptr<uvkc::vulkan::Image>> _yuvPlanes;
+    std::vector<ImagePlaneDesc> _yuvPlaneDescs;
 };
 
 // This structure holds GPU context
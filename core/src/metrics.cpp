@@ -0,0 +1,113 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pch.h"
+#include "snn/metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace snn;
+
+static constexpr uint64_t FIRST_BUCKET_UPPER_BOUND_NS = 50000;
+
+uint64_t snn::LatencyHistogram::getBucketUpperBoundNs(size_t bucket) {
+    if (bucket + 1 >= NUM_BUCKETS) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    return FIRST_BUCKET_UPPER_BOUND_NS << bucket;
+}
+
+void snn::LatencyHistogram::record(uint64_t ns) {
+    size_t bucket = 0;
+    while (bucket + 1 < NUM_BUCKETS && ns > getBucketUpperBoundNs(bucket)) {
+        ++bucket;
+    }
+    _buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+    _totalNs.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t maxNs = _maxNs.load(std::memory_order_relaxed);
+    while (ns > maxNs && !_maxNs.compare_exchange_weak(maxNs, ns, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogram::Snapshot snn::LatencyHistogram::snapshot() const {
+    // Fields are read one by one, so a snapshot taken during an update can be off by one sample
+    Snapshot s;
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+        s.buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+    }
+    s.count   = _count.load(std::memory_order_relaxed);
+    s.totalNs = _totalNs.load(std::memory_order_relaxed);
+    s.maxNs   = _maxNs.load(std::memory_order_relaxed);
+    return s;
+}
+
+double snn::LatencyHistogram::Snapshot::getPercentileMs(double p) const {
+    uint64_t total = 0;
+    for (auto b : buckets) {
+        total += b;
+    }
+    if (total == 0) {
+        return 0.0;
+    }
+    uint64_t rank       = (uint64_t) std::ceil(std::min(std::max(p, 0.0), 1.0) * total);
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+        cumulative += buckets[i];
+        if (cumulative >= std::max<uint64_t>(rank, 1)) {
+            // The last bucket has no upper bound, the maximum is the best estimate there
+            return std::min(getBucketUpperBoundNs(i), maxNs) / 1e6;
+        }
+    }
+    return maxNs / 1e6;
+}
+
+void snn::RuntimeMetrics::init(const std::vector<std::string>& stageNames) {
+    _stageNames = stageNames;
+    _stageGpuTime.reset(new LatencyHistogram[stageNames.size()]);
+}
+
+bool snn::RuntimeMetrics::beginRun() {
+    uint64_t run      = _numRuns.fetch_add(1, std::memory_order_relaxed);
+    uint32_t interval = _gpuSamplingInterval.load(std::memory_order_relaxed);
+    return interval > 0 && run % interval == 0;
+}
+
+void snn::RuntimeMetrics::recordStageGpuTime(size_t stage, uint64_t ns) {
+    if (stage < _stageNames.size() && !_stageNames[stage].empty()) {
+        _stageGpuTime[stage].record(ns);
+    }
+}
+
+InferenceMetrics snn::RuntimeMetrics::snapshot() const {
+    InferenceMetrics m;
+    m.numRuns             = _numRuns.load(std::memory_order_relaxed);
+    m.runTime             = _runTime.snapshot();
+    m.syncTime            = _syncTime.snapshot();
+    m.gpuSamplingInterval = _gpuSamplingInterval.load(std::memory_order_relaxed);
+    m.readbackBytes       = _readbackBytes.load(std::memory_order_relaxed);
+    m.textureBytes        = _textureBytes.load(std::memory_order_relaxed);
+    m.skippedStages       = _skippedStages.load(std::memory_order_relaxed);
+    m.gpuDispatches       = _gpuDispatches.load(std::memory_order_relaxed);
+    m.gpuBarriers         = _gpuBarriers.load(std::memory_order_relaxed);
+    m.glStateCalls        = _glStateCalls.load(std::memory_order_relaxed);
+    m.glStateCallsSkipped = _glStateCallsSkipped.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < _stageNames.size(); ++i) {
+        if (!_stageNames[i].empty()) {
+            m.stageGpuTime.push_back({_stageNames[i], _stageGpuTime[i].snapshot()});
+        }
+    }
+    return m;
+}
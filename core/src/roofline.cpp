@@ -0,0 +1,117 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pch.h"
+#include "snn/roofline.h"
+#include "snn/utils.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+using namespace snn;
+
+std::vector<RooflineEntry> snn::buildRooflineReport(const InferenceGraph& graph, const std::map<std::string, std::vector<double>>& timeStat) {
+    std::vector<RooflineEntry> entries;
+    for (const auto& layer : graph.layers) {
+        bool isShaderLayer = layer->layerLoc == InferenceGraph::LayerExecutionType::GPU_FS || layer->layerLoc == InferenceGraph::LayerExecutionType::GPU_CS ||
+                             layer->layerLoc == InferenceGraph::LayerExecutionType::GPU_VK;
+        if (isShaderLayer && !layer->isInputLayer && !layer->isNoOp) {
+            entries.push_back({layer->name, layer->cost, 0.0});
+        }
+    }
+    for (const auto& stat : timeStat) {
+        if (stat.second.empty()) {
+            continue;
+        }
+        // Profiling builds append the layer dimensions to the timer name.
+        // The longest matching name wins, so that "conv_1" does not take the times of "conv_1_1".
+        RooflineEntry* match = nullptr;
+        for (auto& entry : entries) {
+            const std::string& key = stat.first;
+            bool matches = key == entry.name || (key.size() > entry.name.size() && key.compare(0, entry.name.size(), entry.name) == 0 &&
+                                                  key[entry.name.size()] == '_');
+            if (matches && (!match || entry.name.size() > match->name.size())) {
+                match = &entry;
+            }
+        }
+        if (match) {
+            double sum = 0.0;
+            for (auto t : stat.second) {
+                sum += t;
+            }
+            match->timeMs = sum / stat.second.size();
+        }
+    }
+    return entries;
+}
+
+std::string snn::formatRooflineReport(const std::vector<RooflineEntry>& entries, const RooflinePeaks& peaks) {
+    size_t nameWidth = 5;
+    for (const auto& entry : entries) {
+        nameWidth = std::max(nameWidth, entry.name.size());
+    }
+    bool hasPeaks = peaks.gflops > 0.0 && peaks.gbps > 0.0;
+    double ridge  = hasPeaks ? peaks.gflops / peaks.gbps : 0.0;
+
+    std::ostringstream ss;
+    ss << std::fixed;
+    ss << "\n";
+    ss << "=================================  Roofline Report =================================\n";
+    if (hasPeaks) {
+        ss << std::setprecision(1) << "Peak: " << peaks.gflops << " GFLOP/s, " << peaks.gbps << " GB/s, ridge point: " << std::setprecision(2) << ridge
+           << " FLOP/B\n";
+    }
+    ss << std::left << std::setw(nameWidth) << "Layer" << std::right << std::setw(7) << "Passes" << std::setw(10) << "MMACs" << std::setw(10) << "MB"
+       << std::setw(9) << "FLOP/B" << std::setw(9) << "ms" << std::setw(10) << "GFLOP/s" << std::setw(9) << "GB/s";
+    if (hasPeaks) {
+        ss << std::setw(11) << "Bound" << std::setw(8) << "%roof";
+    }
+    ss << "\n";
+
+    InferenceGraph::LayerCost total;
+    double totalTime = 0.0;
+    for (const auto& entry : entries) {
+        const auto& cost = entry.cost;
+        ss << std::left << std::setw(nameWidth) << entry.name << std::right << std::setw(7) << cost.numPasses << std::setprecision(2) << std::setw(10)
+           << cost.macs / 1e6 << std::setw(10) << cost.getTotalBytes() / 1e6 << std::setw(9) << cost.getIntensity();
+        if (entry.timeMs > 0.0) {
+            ss << std::setprecision(3) << std::setw(9) << entry.timeMs << std::setprecision(1) << std::setw(10) << entry.getGflops() << std::setw(9)
+               << entry.getGbps();
+            if (hasPeaks) {
+                bool computeBound = cost.getIntensity() >= ridge;
+                double roof       = computeBound ? entry.getGflops() / peaks.gflops : entry.getGbps() / peaks.gbps;
+                ss << std::setw(11) << (computeBound ? "compute" : "bandwidth") << std::setw(8) << 100.0 * roof;
+            }
+        } else {
+            ss << std::setw(9) << "-" << std::setw(10) << "-" << std::setw(9) << "-";
+        }
+        ss << "\n";
+        total.macs += cost.macs;
+        total.bytesRead += cost.bytesRead;
+        total.weightBytes += cost.weightBytes;
+        total.bytesWritten += cost.bytesWritten;
+        total.numPasses += cost.numPasses;
+        totalTime += entry.timeMs;
+    }
+    RooflineEntry totalEntry {"Total", total, totalTime};
+    ss << std::left << std::setw(nameWidth) << totalEntry.name << std::right << std::setw(7) << total.numPasses << std::setprecision(2) << std::setw(10)
+       << total.macs / 1e6 << std::setw(10) << total.getTotalBytes() / 1e6 << std::setw(9) << total.getIntensity();
+    if (totalTime > 0.0) {
+        ss << std::setprecision(3) << std::setw(9) << totalTime << std::setprecision(1) << std::setw(10) << totalEntry.getGflops() << std::setw(9)
+           << totalEntry.getGbps();
+    }
+    ss << "\n";
+    ss << "====================================================================================\n";
+    return ss.str();
+}
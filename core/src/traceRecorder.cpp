@@ -0,0 +1,240 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pch.h"
+#include "snn/traceRecorder.h"
+#include "snn/utils.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <vector>
+
+using namespace snn;
+
+namespace {
+
+// Process ids of the trace
+constexpr uint32_t CPU_PID = 1;
+constexpr uint32_t GPU_PID = 2;
+
+struct TraceEvent {
+    std::string name;
+    uint32_t pid;
+    uint32_t tid;
+    int64_t beginNs;
+    int64_t durationNs;
+};
+
+struct TraceState {
+    std::mutex mutex;
+    std::string fileName;
+    uint32_t runsToSkip   = 0;
+    uint32_t runsToRecord = 0;
+    uint32_t runIndex     = 0; // index of the next run to begin
+    uint32_t endedRuns    = 0; // number of the selected runs, that have ended
+    int64_t startTime     = 0;
+    std::map<uint32_t, int64_t> runBegins; // begin time of the selected runs, that haven't ended yet
+    std::vector<TraceEvent> events;
+    std::vector<int64_t> gpuCursors;  // end of the last GPU event of every nesting level
+    std::map<uint32_t, std::string> threadNames;
+    std::atomic<uint32_t> gpuLevel {0};
+    std::atomic<uint32_t> threadCounter {0};
+    bool armed = false;
+};
+
+TraceState& getState() {
+    static TraceState state;
+    return state;
+}
+
+// Small sequential thread ids are easier to read in the trace viewer than native ones
+uint32_t getThreadId() {
+    thread_local uint32_t tid = getState().threadCounter++;
+    return tid;
+}
+
+std::string escapeJson(const std::string& s) {
+    std::string ret;
+    ret.reserve(s.size());
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            ret += '\\';
+            ret += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            ret += ' ';
+        } else {
+            ret += c;
+        }
+    }
+    return ret;
+}
+
+void writeMetadata(std::ostream& os, const char* type, uint32_t pid, uint32_t tid, const std::string& name, bool& first) {
+    os << (first ? "\n" : ",\n") << "{\"ph\": \"M\", \"name\": \"" << type << "\", \"pid\": " << pid << ", \"tid\": " << tid
+       << ", \"args\": {\"name\": \"" << escapeJson(name) << "\"}}";
+    first = false;
+}
+
+// Writes the recorded events and clears them. Must be called with the state mutex locked.
+void writeTrace(TraceState& state) {
+    if (state.fileName.empty()) {
+        return;
+    }
+    std::ofstream file(state.fileName);
+    if (!file.good()) {
+        SNN_LOGE("Failed to open trace file %s", state.fileName.c_str());
+        return;
+    }
+    bool first = true;
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    writeMetadata(file, "process_name", CPU_PID, 0, "CPU", first);
+    writeMetadata(file, "process_name", GPU_PID, 0, "GPU", first);
+    for (const auto& thread : state.threadNames) {
+        writeMetadata(file, "thread_name", CPU_PID, thread.first, thread.second, first);
+    }
+    for (size_t level = 0; level < state.gpuCursors.size(); ++level) {
+        writeMetadata(file, "thread_name", GPU_PID, (uint32_t) level, formatString("GPU queries, level %zu", level), first);
+    }
+    file.setf(std::ios::fixed);
+    file.precision(3);
+    for (const auto& e : state.events) {
+        // Chrome trace timestamps are in microseconds
+        file << ",\n{\"ph\": \"X\", \"name\": \"" << escapeJson(e.name) << "\", \"pid\": " << e.pid << ", \"tid\": " << e.tid
+             << ", \"ts\": " << (e.beginNs - state.startTime) / 1000.0 << ", \"dur\": " << e.durationNs / 1000.0 << "}";
+    }
+    file << "\n]}\n";
+    SNN_LOGI("Trace of %u runs with %zu events written to %s", state.endedRuns, state.events.size(), state.fileName.c_str());
+    state.events.clear();
+    state.gpuCursors.clear();
+    state.runBegins.clear();
+    state.fileName.clear();
+}
+
+} // namespace
+
+std::atomic<bool> snn::TraceRecorder::recording {false};
+
+bool snn::TraceRecorder::start(const std::string& fileName, uint32_t numRuns, uint32_t skipRuns) {
+    auto& state = getState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.armed) {
+        SNN_LOGW("Trace recording is already in progress");
+        return false;
+    }
+    state.fileName     = fileName;
+    state.runsToSkip   = skipRuns;
+    state.runsToRecord = std::max(numRuns, 1U);
+    state.runIndex     = 0;
+    state.endedRuns    = 0;
+    state.startTime    = now();
+    state.events.clear();
+    state.gpuCursors.clear();
+    state.runBegins.clear();
+    state.gpuLevel = 0;
+    state.armed    = true;
+    return true;
+}
+
+void snn::TraceRecorder::stop() {
+    auto& state = getState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!state.armed) {
+        return;
+    }
+    recording   = false;
+    state.armed = false;
+    writeTrace(state);
+}
+
+int64_t snn::TraceRecorder::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t snn::TraceRecorder::beginRun() {
+    auto& state = getState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!state.armed) {
+        return NO_RUN;
+    }
+    uint32_t run = state.runIndex++;
+    if (run < state.runsToSkip || run >= state.runsToSkip + state.runsToRecord) {
+        return NO_RUN;
+    }
+    recording            = true;
+    state.runBegins[run] = now();
+    return run;
+}
+
+void snn::TraceRecorder::endRun(uint32_t run) {
+    auto& state = getState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!state.armed || run == NO_RUN) {
+        return;
+    }
+    auto found = state.runBegins.find(run);
+    if (found == state.runBegins.end()) {
+        return;
+    }
+    state.events.push_back({formatString("run %u", run), CPU_PID, getThreadId(), found->second, now() - found->second});
+    state.runBegins.erase(found);
+    // Later runs may still be in flight, their events are recorded until then
+    if (++state.endedRuns >= state.runsToRecord) {
+        recording   = false;
+        state.armed = false;
+        writeTrace(state);
+    }
+}
+
+void snn::TraceRecorder::recordCpu(const std::string& name, int64_t beginNs, int64_t endNs) {
+    if (!isRecording()) {
+        return;
+    }
+    auto& state = getState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.events.push_back({name, CPU_PID, getThreadId(), beginNs, endNs - beginNs});
+}
+
+uint32_t snn::TraceRecorder::beginGpu() {
+    return getState().gpuLevel++;
+}
+
+void snn::TraceRecorder::endGpu() {
+    auto& state = getState();
+    if (state.gpuLevel > 0) {
+        --state.gpuLevel;
+    }
+}
+
+void snn::TraceRecorder::recordGpu(const std::string& name, int64_t submitNs, uint32_t level, uint64_t durationNs, int64_t beginNs) {
+    if (!isRecording()) {
+        return;
+    }
+    auto& state = getState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.gpuCursors.size() <= level) {
+        state.gpuCursors.resize(level + 1, 0);
+    }
+    // Without calibrated timestamps: GPU executes commands of one level in submission order, and not before they are submitted
+    int64_t begin           = beginNs >= 0 ? beginNs : std::max(submitNs, state.gpuCursors[level]);
+    state.gpuCursors[level] = begin + (int64_t) durationNs;
+    state.events.push_back({name, GPU_PID, level, begin, (int64_t) durationNs});
+}
+
+void snn::TraceRecorder::setThreadName(const std::string& name) {
+    auto& state = getState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.threadNames[getThreadId()] = name;
+}
@@ -17,6 +17,8 @@
 #include "snn/snn.h"
 #include "snn/colorUtils.h"
 #include "snn/image.h"
+#include "snn/fp16.h"
+#include "snn/traceRecorder.h"
 #include <stdarg.h>
 #include <algorithm>
 #include <functional>
@@ -124,87 +126,15 @@ public:
 #endif
 };
 
-float snn::convertToMediumPrecision(float in) {
-    union tmp {
-        unsigned int unsint;
-        float flt;
-    };
-
-    tmp _16to32, _32to16;
-
-    _32to16.flt = in;
+float snn::convertToMediumPrecision(float in) { return fp16::roundToHalf(in); }
 
-    unsigned short sign     = (_32to16.unsint & 0x80000000) >> 31;
-    unsigned short exponent = (_32to16.unsint & 0x7F800000) >> 23;
-    unsigned int mantissa   = _32to16.unsint & 0x7FFFFF;
-
-    short newexp = exponent + (-127 + 15);
-
-    unsigned int newMantissa;
-    if (newexp >= 31) {
-        newexp      = 31;
-        newMantissa = 0x00;
-    } else if (newexp <= 0) {
-        newexp      = 0;
-        newMantissa = 0;
-    } else {
-        newMantissa = mantissa >> 13;
-    }
+float snn::convertToHighPrecision(uint16_t in) { return fp16::halfToFloat(in); }
 
-    if (newexp == 0) {
-        if (newMantissa == 0) {
-            _16to32.unsint = sign << 31;
-        } else {
-            newexp = 0;
-            while ((newMantissa & 0x200) == 0) {
-                newMantissa <<= 1;
-                newexp++;
-            }
-            newMantissa <<= 1;
-            newMantissa &= 0x3FF;
-            _16to32.unsint = (sign << 31) | ((newexp + (-15 + 127)) << 23) | (newMantissa << 13);
-        }
-    } else if (newexp == 31) {
-        _16to32.unsint = (sign << 31) | (0xFF << 23) | (newMantissa << 13);
-    } else {
-        _16to32.unsint = (sign << 31) | ((newexp + (-15 + 127)) << 23) | (newMantissa << 13);
-    }
-
-    return _16to32.flt;
-}
-
-float snn::convertToHighPrecision(uint16_t in) {
-    union tmp {
-        unsigned int unsint;
-        float flt;
-    };
-
-    unsigned short sign     = (in & 0x8000) >> 15;
-    unsigned short exponent = (in & 0x7C00) >> 10;
-    unsigned int mantissa   = (in & 0x3FF);
-
-    tmp _16to32;
-
-    short newexp             = exponent + 127 - 15;
-    unsigned int newMantissa = mantissa;
-    if (newexp <= 0) {
-        newexp      = 0;
-        newMantissa = 0;
-    }
-
-    _16to32.unsint = (sign << 31) | (newexp << 23) | (newMantissa << 13);
-    return _16to32.flt;
-}
-
-void snn::convertToMediumPrecision(std::vector<float>& in) {
-    for (auto& val : in) {
-        val = convertToMediumPrecision(val);
-    }
-}
+void snn::convertToMediumPrecision(std::vector<float>& in) { fp16::roundToHalf(in); }
 
 void snn::convertToMediumPrecision(std::vector<double>& in) {
     for (auto& val : in) {
-        val = convertToMediumPrecision(val);
+        val = fp16::roundToHalf((float) val);
     }
 }
 
@@ -783,7 +713,8 @@ void snn::Timer::start() {
     }
     currentCall->begin = now;
     if (nestedLevel == 1) {
-        begin = now;
+        begin      = now;
+        traceBegin = TraceRecorder::isRecording() ? TraceRecorder::now() : -1;
     }
 }
 
@@ -802,6 +733,10 @@ void snn::Timer::stop() {
         // Updating global statistics
         auto duration = now - begin;
         ave.update(duration);
+        if (traceBegin >= 0) {
+            TraceRecorder::recordCpu(name, traceBegin, TraceRecorder::now());
+            traceBegin = -1;
+        }
     }
 
     --nestedLevel;
@@ -15,12 +15,73 @@
 #include "pch.h"
 #include "vkUtils.h"
 #include "uvkc/benchmark/status_util.h"
+#include <algorithm>
+#include <vector>
+
+vk::TraceClock::TraceClock(VkInstance instance, VkPhysicalDevice physicalDevice, uvkc::vulkan::Device* device)
+    : _device(device->getLogicalDevice())
+{
+#if defined(_WIN32)
+    // steady_clock doesn't use the host time domains of the extension on Windows
+    (void) instance;
+    (void) physicalDevice;
+#else
+    const auto& symbols = device->getSymbols();
+    auto getTimeDomains = reinterpret_cast<PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT>(
+        symbols.vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT"));
+    // Null, if the extension is not enabled on the device
+    auto getCalibratedTimestamps = reinterpret_cast<PFN_vkGetCalibratedTimestampsEXT>(
+        symbols.vkGetDeviceProcAddr(_device, "vkGetCalibratedTimestampsEXT"));
+    if (!getTimeDomains || !getCalibratedTimestamps) {
+        SNN_LOGD("VK_EXT_calibrated_timestamps is not available, GPU events of traces are placed at their submission time");
+        return;
+    }
+    uint32_t count = 0;
+    getTimeDomains(physicalDevice, &count, nullptr);
+    std::vector<VkTimeDomainEXT> domains(count);
+    getTimeDomains(physicalDevice, &count, domains.data());
+    bool hasDevice    = std::find(domains.begin(), domains.end(), VK_TIME_DOMAIN_DEVICE_EXT) != domains.end();
+    bool hasMonotonic = std::find(domains.begin(), domains.end(), VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT) != domains.end();
+    if (!hasDevice || !hasMonotonic) {
+        SNN_LOGD("Device timestamps can't be calibrated against CLOCK_MONOTONIC");
+        return;
+    }
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    _timestampPeriod         = properties.limits.timestampPeriod;
+    _getCalibratedTimestamps = getCalibratedTimestamps;
+#endif
+}
+
+bool vk::TraceClock::toTraceTime(uint64_t ticks, int64_t& ns) const {
+    if (!_getCalibratedTimestamps) {
+        return false;
+    }
+    // steady_clock uses CLOCK_MONOTONIC on Linux and Android
+    VkCalibratedTimestampInfoEXT infos[2] = {};
+    infos[0].sType      = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+    infos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+    infos[1].sType      = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+    infos[1].timeDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+    uint64_t timestamps[2] = {};
+    uint64_t maxDeviation  = 0;
+    if (_getCalibratedTimestamps(_device, 2, infos, timestamps, &maxDeviation) != VK_SUCCESS) {
+        return false;
+    }
+    // Both timestamps are taken at the same moment, so the device time is converted relative to it
+    ns = (int64_t) timestamps[1] + (int64_t) (((double) ticks - (double) timestamps[0]) * _timestampPeriod);
+    return true;
+}
 
 void vk::GpuTimeElapsedQuery::start() {
     if (started) {
         SNN_LOGD("gpu time already started");
         return;
     }
+    if (snn::TraceRecorder::isRecording()) {
+        _traceSubmit = snn::TraceRecorder::now();
+        _traceLevel  = snn::TraceRecorder::beginGpu();
+    }
     _cmdBuf->ResetQueryPool(*_tsQueryPool);
     _cmdBuf->WriteTimestamp(*_tsQueryPool, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
     started = true;
@@ -34,6 +95,9 @@ void vk::GpuTimeElapsedQuery::stop() {
     }
     _cmdBuf->WriteTimestamp(*_tsQueryPool, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
     started = false;
+    if (_traceSubmit >= 0) {
+        snn::TraceRecorder::endGpu();
+    }
 }
 
 void vk::GpuTimeElapsedQuery::getTime() {
@@ -41,6 +105,17 @@ void vk::GpuTimeElapsedQuery::getTime() {
         double timestampSeconds,
         _tsQueryPool->CalculateElapsedSecondsBetween(0, 1));
     _result = (uint64_t)(timestampSeconds * (1e9));
+    if (_traceSubmit >= 0) {
+        int64_t begin = -1;
+        if (_traceClock) {
+            auto ticks = _tsQueryPool->GetTimestamp(0);
+            if (!ticks.ok() || !_traceClock->toTraceTime(*ticks, begin)) {
+                begin = -1;
+            }
+        }
+        snn::TraceRecorder::recordGpu(getName(), _traceSubmit, _traceLevel, _result, begin);
+        _traceSubmit = -1;
+    }
 }
 
 // -----------------------------------------------------------------------------
@@ -14,6 +14,7 @@
  */
 #pragma once
 #include "snn/deviceTimer.h"
+#include "snn/traceRecorder.h"
 #include "uvkc/benchmark/status_util.h"
 #include "uvkc/benchmark/vulkan_context.h"
 #include <string>
@@ -21,14 +22,37 @@
 #include <memory>
 
 namespace vk {
+// -----------------------------------------------------------------------------
+// Converts device timestamps to the trace clock (snn::TraceRecorder::now()) with VK_EXT_calibrated_timestamps
+class TraceClock {
+public:
+    TraceClock(VkInstance instance, VkPhysicalDevice physicalDevice, uvkc::vulkan::Device* device);
+
+    // params:
+    //  ticks - raw timestamp, written by vkCmdWriteTimestamp
+    //  ns - the timestamp on the trace clock
+    // returns:
+    //  false, if the device can't calibrate its timestamps against the trace clock
+    bool toTraceTime(uint64_t ticks, int64_t& ns) const;
+
+private:
+    VkDevice _device = VK_NULL_HANDLE;
+    PFN_vkGetCalibratedTimestampsEXT _getCalibratedTimestamps = nullptr;
+    double _timestampPeriod = 1.0; // Nanoseconds per tick
+};
+
 // -----------------------------------------------------------------------------
 // For asynchronous timer (not time stamp) queries
 class GpuTimeElapsedQuery : public DeviceTimer {
 public:
-    GpuTimeElapsedQuery(const std::string& n, uvkc::vulkan::CommandBuffer* cmdBuf, uvkc::vulkan::Device* device)
+    // params:
+    //  traceClock - converts the begin time of the query for traces, null to place it at the submission time
+    GpuTimeElapsedQuery(const std::string& n, uvkc::vulkan::CommandBuffer* cmdBuf, uvkc::vulkan::Device* device,
+                        const TraceClock* traceClock = nullptr)
         : DeviceTimer(n)
         , _cmdBuf(cmdBuf)
         , _device(device)
+        , _traceClock(traceClock)
     {
         BM_CHECK_OK_AND_ASSIGN(_tsQueryPool, device->CreateTimestampQueryPool(2));
     }
@@ -56,8 +80,11 @@ private:
     uint64_t _result = 0;
     uvkc::vulkan::CommandBuffer* _cmdBuf;
     uvkc::vulkan::Device* _device;
+    const TraceClock* _traceClock;
     std::unique_ptr<::uvkc::vulkan::TimestampQueryPool> _tsQueryPool;
     bool started = false;
+    int64_t _traceSubmit = -1; // CPU time of start(), if trace recording is on
+    uint32_t _traceLevel = 0;
 };
 
 } // namespace vk
@@ -0,0 +1,65 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pch.h"
+#include "vulkanImagePreprocessOp.h"
+#include "snn/utils.h"
+#include "uvkc/base/status.h"
+#include "uvkc/vulkan/status_util.h"
+#include "uvkc/benchmark/status_util.h"
+#include <vector>
+
+#ifndef UP_DIV
+#define UP_DIV(x, y) (((x) + (y) - (1)) / (y))
+#endif
+
+static constexpr const char* YUV_PREPROCESS_VK_ASSET_NAME      = "shaders/shadertemplate_vk_yuv_preprocess.spv";
+static constexpr const char* YUV_PREPROCESS_VK_FP16_ASSET_NAME = "shaders/shadertemplate_vk_yuv_preprocess_fp16.spv";
+
+namespace snn {
+
+void VulkanImagePreprocessOp::init(uvkc::vulkan::Device *device, bool linearFilter, bool fp16) {
+    _linearFilter = linearFilter;
+    _fp16 = fp16;
+
+    std::vector<unsigned char> bytes = loadEmbeddedAsset(fp16 ? YUV_PREPROCESS_VK_FP16_ASSET_NAME : YUV_PREPROCESS_VK_ASSET_NAME);
+    const uint32_t *spirvData = reinterpret_cast<const uint32_t*>(bytes.data());
+    size_t spirvSize = bytes.size() / sizeof(uint32_t);
+
+    VulkanImageTransformShaderOp::init(device, spirvData, spirvSize, sizeof(PreprocessImageParams));
+}
+
+absl::StatusOr<std::unique_ptr<uvkc::vulkan::Sampler>> VulkanImagePreprocessOp::createSampler() {
+    if (!_linearFilter) {
+        return VulkanImageTransformShaderOp::createSampler();
+    }
+    else {
+        return createLinearSampler();
+    }
+}
+
+void VulkanImagePreprocessOp::updateParams(const PreprocessImageParams& params) {
+    std::array<uint32_t, 3> localSizes = {4U, 8U, 1U};
+    std::array<uint32_t, 3> workGroupSizes = {
+        UP_DIV(params.outputSize[0], localSizes[0]),
+        UP_DIV(params.outputSize[1], localSizes[1]),
+        1U
+    };
+
+    PreprocessImageParams shaderParams = params;
+    VulkanImageTransformShaderOp::updateParams(&shaderParams, workGroupSizes);
+}
+
+}
@@ -0,0 +1,55 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include "vulkanImageTransformShaderOp.h"
+#include <array>
+
+namespace snn {
+
+// This class provides a facility to convert a YUV frame to RGBA, resize and normalize it using a single shader.
+// Source images are the luma plane and one (NV12, NV21) or two (I420) chroma planes.
+class VulkanImagePreprocessOp : public VulkanImageTransformShaderOp {
+public:
+    virtual ~VulkanImagePreprocessOp() = default;
+
+    // These parameters are passed to preprocess shader uniform buffer
+    struct PreprocessImageParams {
+        std::array<uint32_t, 4> outputSize; // width, height, number of chroma planes, unused
+        std::array<float, 16> yuvToRgba;
+        std::array<float, 4> dstRect;
+        std::array<float, 4> srcRect;
+        std::array<float, 4> means;
+        std::array<float, 4> norms;
+        std::array<float, 4> padColor;
+    };
+
+    void init(uvkc::vulkan::Device *device, bool linearFilter = true, bool fp16 = false);
+
+    void updateParams(const PreprocessImageParams& params);
+
+    bool isLinearFilter() const { return _linearFilter; }
+
+    bool isFp16() const { return _fp16; }
+
+protected:
+    virtual absl::StatusOr<std::unique_ptr<uvkc::vulkan::Sampler>> createSampler() override;
+
+private:
+    bool _linearFilter = true;
+    bool _fp16 = false;
+};
+
+}
@@ -40,42 +40,12 @@ void VulkanImageResizeOp::init(uvkc::vulkan::Device *device, bool linearFilter)
     VulkanImageTransformShaderOp::init(device, spirvData, spirvSize, sizeof(ResizeImageParams));
 }
 
-static absl::StatusOr<std::unique_ptr<uvkc::vulkan::Sampler>> createLinearSampler(uvkc::vulkan::Device *device) {
-    SNN_ASSERT(device);
-
-    VkSamplerCreateInfo create_info = {};
-    create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-    create_info.pNext = nullptr;
-    create_info.flags = 0;
-    create_info.magFilter = VK_FILTER_LINEAR;
-    create_info.minFilter = VK_FILTER_LINEAR;
-    create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
-    create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    create_info.mipLodBias = 0.0f;
-    create_info.anisotropyEnable = VK_FALSE;
-    create_info.maxAnisotropy = 0.0f;
-    create_info.compareEnable = VK_TRUE;
-    create_info.compareOp = VK_COMPARE_OP_NEVER;
-    create_info.minLod = 0.0f;
-    create_info.maxLod = 0.0f;
-    create_info.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
-    create_info.unnormalizedCoordinates = VK_FALSE;
-
-    VkSampler sampler = VK_NULL_HANDLE;
-    UVKC_RETURN_IF_ERROR(uvkc::vulkan::VkResultToStatus(
-        device->getSymbols().vkCreateSampler(
-        device->getLogicalDevice(), &create_info, nullptr, &sampler)));
-    return std::make_unique<uvkc::vulkan::Sampler>(device->getLogicalDevice(), sampler, device->getSymbols());
-}
-
 absl::StatusOr<std::unique_ptr<uvkc::vulkan::Sampler>> VulkanImageResizeOp::createSampler() {
     if (!_linearFilter) {
         return VulkanImageTransformShaderOp::createSampler();
     }
     else {
-        return createLinearSampler(_device);
+        return createLinearSampler();
     }
 }
 
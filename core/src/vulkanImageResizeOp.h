@@ -35,6 +35,8 @@ public:
 
     void updateParams(VkExtent3D dstDimensions, const std::array<float, 4>& means, const std::array<float, 4>& norms);
 
+    bool isLinearFilter() const { return _linearFilter; }
+
 protected:
     virtual absl::StatusOr<std::unique_ptr<uvkc::vulkan::Sampler>> createSampler() override;
 
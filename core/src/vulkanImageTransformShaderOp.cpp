@@ -79,6 +79,36 @@ absl::StatusOr<std::unique_ptr<uvkc::vulkan::Sampler>> VulkanImageTransformShade
     return _device->CreateSampler();
 }
 
+absl::StatusOr<std::unique_ptr<uvkc::vulkan::Sampler>> VulkanImageTransformShaderOp::createLinearSampler() {
+    SNN_ASSERT(_device);
+
+    VkSamplerCreateInfo create_info = {};
+    create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    create_info.pNext = nullptr;
+    create_info.flags = 0;
+    create_info.magFilter = VK_FILTER_LINEAR;
+    create_info.minFilter = VK_FILTER_LINEAR;
+    create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    create_info.mipLodBias = 0.0f;
+    create_info.anisotropyEnable = VK_FALSE;
+    create_info.maxAnisotropy = 0.0f;
+    create_info.compareEnable = VK_TRUE;
+    create_info.compareOp = VK_COMPARE_OP_NEVER;
+    create_info.minLod = 0.0f;
+    create_info.maxLod = 0.0f;
+    create_info.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+    create_info.unnormalizedCoordinates = VK_FALSE;
+
+    VkSampler sampler = VK_NULL_HANDLE;
+    UVKC_RETURN_IF_ERROR(uvkc::vulkan::VkResultToStatus(
+        _device->getSymbols().vkCreateSampler(
+        _device->getLogicalDevice(), &create_info, nullptr, &sampler)));
+    return std::make_unique<uvkc::vulkan::Sampler>(_device->getLogicalDevice(), sampler, _device->getSymbols());
+}
+
 void VulkanImageTransformShaderOp::updateParams(void* params, const std::array<uint32_t, 3>& workGroupSizes) {
     SNN_ASSERT(params);
     // Using direct copy to buffer from memory
@@ -92,13 +122,22 @@ void VulkanImageTransformShaderOp::updateParams(void* params, const std::array<u
 }
 
 void  VulkanImageTransformShaderOp::run(uvkc::vulkan::Image *srcImage, uvkc::vulkan::Image *dstImage) {
-    SNN_ASSERT(srcImage);
+    run(std::vector<uvkc::vulkan::Image*> {srcImage}, dstImage);
+}
+
+void  VulkanImageTransformShaderOp::run(const std::vector<uvkc::vulkan::Image*>& srcImages, uvkc::vulkan::Image *dstImage) {
+    SNN_ASSERT(!srcImages.empty());
     SNN_ASSERT(dstImage);
+    uvkc::vulkan::Image *srcImage = srcImages[0];
 
     std::vector<uvkc::vulkan::Device::BoundImage> boundImages = {
         {dstImage, nullptr, /*set=*/0U, /*binding=*/0U},
-        {srcImage, _sampler.get(), /*set=*/0U, /*binding=*/1U}
     };
+    for (size_t i = 0; i < srcImages.size(); ++i) {
+        SNN_ASSERT(srcImages[i]);
+        uint32_t binding = i == 0 ? 1U : (uint32_t) (i + 2);
+        boundImages.push_back({srcImages[i], _sampler.get(), /*set=*/0U, binding});
+    }
     SNN_LOGD("boundImages (dst): VkImage: %p, VkImageView: %p", dstImage->image(), dstImage->image_view());
     SNN_LOGD("boundImages (src): VkImage: %p, VkImageView: %p", srcImage->image(), srcImage->image_view());
 
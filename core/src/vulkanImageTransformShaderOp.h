@@ -24,6 +24,7 @@
 #include <memory>
 #include <unordered_map>
 #include <array>
+#include <vector>
 
 namespace snn {
 
@@ -40,9 +41,16 @@ public:
 
     void run(uvkc::vulkan::Image *srcImage, uvkc::vulkan::Image *dstImage);
 
+    // Runs the shader with several source images. The first one is bound to binding 1, like in run() above,
+    // the others follow the parameters buffer from binding 3 on.
+    void run(const std::vector<uvkc::vulkan::Image*>& srcImages, uvkc::vulkan::Image *dstImage);
+
 protected:
     virtual absl::StatusOr<std::unique_ptr<uvkc::vulkan::Sampler>> createSampler();
 
+    // Creates a sampler with linear filtering, that clamps coordinates to edges
+    absl::StatusOr<std::unique_ptr<uvkc::vulkan::Sampler>> createLinearSampler();
+
     uvkc::vulkan::Device *_device;
     std::unique_ptr<uvkc::vulkan::ShaderModule> _shaderModule;
     std::vector<uvkc::vulkan::Pipeline::SpecConstant> _specConstants;
@@ -61,6 +61,8 @@ void snn::InferenceProcessor::initialize(const InitializationParameters& cp) {
         options.mrtMode             = cp.mrtMode;
         options.weightMode          = cp.weightMode;
         options.vulkan              = cp.useVulkanShader;
+        // Layer dumps need a separate output texture for every layer
+        options.zeroCopyConcat      = !cp.dumpOutputs;
 
         MixedInferenceCore::CreationParameters inferenceCP;
         (InferenceGraph &&) inferenceCP = snn::dp::generateInferenceGraph(dp, options);
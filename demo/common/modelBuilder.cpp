@@ -0,0 +1,281 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "modelBuilder.h"
+#include "snn/fp16.h"
+#include "snn/image.h"
+#include "snn/imageTextureFactory.h"
+#include "snn/utils.h"
+#include "ic2/layerFactory.h"
+#include "ic2/addlayer.h"
+#include "ic2/concatenation.h"
+#include "ic2/conv2d.h"
+#include "ic2/inputlayer.h"
+#include "ic2/maxpool2d.h"
+#include "ic2/separableconvolution.h"
+#include "ic2/upsampling2d.h"
+#include <cmath>
+#include <cstdio>
+#include <utility>
+
+ModelBuilder::Layer ModelBuilder::append(Layer layer, const std::vector<Layer>& prev, const std::string& type) {
+    char index[16];
+    snprintf(index, sizeof(index), "%02zu", layers.size());
+    layer->setName(modelName + ".json layer [" + index + "] " + type);
+    for (const auto& p : prev) {
+        layer->prevLayers.push_back(p);
+        p->nextLayers.push_back(layer);
+    }
+    layers.push_back(layer);
+    return layer;
+}
+
+std::vector<cv::Mat> ModelBuilder::randomWeights(size_t count, uint32_t kernel) {
+    std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+    std::vector<cv::Mat> weights;
+    for (size_t i = 0; i < count; ++i) {
+        cv::Mat w(kernel, kernel, CV_32FC1);
+        for (uint32_t k = 0; k < kernel * kernel; ++k) {
+            w.at<float>(k / kernel, k % kernel) = dist(rng);
+        }
+        weights.push_back(w);
+    }
+    return weights;
+}
+
+std::vector<double> ModelBuilder::randomBiases(size_t count) {
+    std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+    std::vector<double> biases;
+    for (size_t i = 0; i < count; ++i) {
+        biases.push_back(dist(rng));
+    }
+    return biases;
+}
+
+ModelBuilder::Layer ModelBuilder::input(uint32_t width, uint32_t height, uint32_t channels) {
+    snn::dp::InputLayerDesc desc;
+    desc.inputWidth      = width;
+    desc.inputHeight     = height;
+    desc.inputChannels   = channels;
+    desc.numInputPlanes  = channels;
+    desc.numOutputPlanes = channels;
+    desc.isInputLayer    = true;
+    desc.preferHp        = preferHp;
+    return append(Layer(new snn::dp::InputLayerLayer(std::move(desc))), {}, "InputLayer");
+}
+
+ModelBuilder::Layer ModelBuilder::conv2D(const Layer& prev, uint32_t outChannels, uint32_t kernel, uint32_t stride, const std::string& activation) {
+    uint32_t inChannels = prev->getDesc().numOutputPlanes;
+    std::string padding = std::to_string(kernel / 2);
+    snn::dp::Conv2DDesc desc;
+    desc.mrtMode               = snn::MRTMode::SINGLE_PLANE;
+    desc.isRange01             = 0;
+    desc.numOutputPlanes       = outChannels;
+    desc.numInputPlanes        = inChannels;
+    desc.weightsCvM            = randomWeights(outChannels * inChannels, kernel);
+    desc.biases                = randomBiases(outChannels);
+    desc.activation            = activation;
+    desc.kernelSize            = kernel;
+    desc.stride                = stride;
+    desc.useBatchNormalization = false;
+    desc.useMultiInputs        = false;
+    desc.padding               = "same";
+    desc.paddingT              = padding;
+    desc.paddingB              = padding;
+    desc.paddingL              = padding;
+    desc.paddingR              = padding;
+    desc.paddingMode           = "constant";
+    desc.preferHp              = preferHp;
+    desc.weightMode            = snn::WeightAccessMethod::TEXTURES;
+    return append(Layer(snn::dp::Conv2DCreator1(std::move(desc), useVulkan)), {prev}, "Conv2D");
+}
+
+ModelBuilder::Layer ModelBuilder::depthwiseConv2D(const Layer& prev, uint32_t kernel, uint32_t stride, const std::string& activation) {
+    uint32_t channels   = prev->getDesc().numOutputPlanes;
+    std::string padding = std::to_string(kernel / 2);
+    snn::dp::SeparableConv2DDesc desc;
+    desc.mrtMode               = snn::MRTMode::SINGLE_PLANE;
+    desc.isRange01             = 0;
+    desc.numOutputPlanes       = channels;
+    desc.numInputPlanes        = channels;
+    desc.weightsCvM            = randomWeights(channels, kernel);
+    desc.biases                = randomBiases(channels);
+    desc.activation            = activation;
+    desc.kernelSize            = kernel;
+    desc.stride                = stride;
+    desc.useBatchNormalization = false;
+    desc.leakyReluAlpha        = 0.0f;
+    desc.padding               = "same";
+    desc.paddingT              = padding;
+    desc.paddingB              = padding;
+    desc.paddingL              = padding;
+    desc.paddingR              = padding;
+    desc.preferHp              = preferHp;
+    desc.weightMode            = snn::WeightAccessMethod::TEXTURES;
+    return append(Layer(snn::dp::SeparableConv2DCreator1(std::move(desc), useVulkan)), {prev}, "DepthwiseConv2D");
+}
+
+ModelBuilder::Layer ModelBuilder::maxPooling2D(const Layer& prev, uint32_t kernel, uint32_t stride) {
+    uint32_t channels = prev->getDesc().numOutputPlanes;
+    snn::dp::MaxPooling2DDesc desc;
+    desc.mrtMode         = snn::MRTMode::SINGLE_PLANE;
+    desc.isRange01       = 0;
+    desc.numOutputPlanes = channels;
+    desc.numInputPlanes  = channels;
+    desc.activation      = "";
+    desc.kernelSize      = kernel;
+    desc.stride          = stride;
+    desc.padding         = "same";
+    desc.paddingValue    = "constant";
+    desc.paddingT        = "same";
+    desc.paddingB        = "same";
+    desc.paddingL        = "same";
+    desc.paddingR        = "same";
+    desc.preferHp        = preferHp;
+    return append(Layer(snn::dp::MaxPooling2DCreator1(std::move(desc), useVulkan)), {prev}, "MaxPooling2D");
+}
+
+ModelBuilder::Layer ModelBuilder::concatenate(const std::vector<Layer>& prev) {
+    snn::dp::ConcatenateDesc desc;
+    desc.mrtMode         = snn::MRTMode::SINGLE_PLANE;
+    desc.isRange01       = 0;
+    desc.numInputPlanes  = prev[0]->getDesc().numOutputPlanes;
+    desc.numOutputPlanes = 0;
+    for (const auto& p : prev) {
+        desc.numOutputPlanes += p->getDesc().numOutputPlanes;
+    }
+    desc.preferHp = preferHp;
+    return append(Layer(snn::dp::ConcatenateCreator1(std::move(desc), useVulkan)), prev, "Concatenate");
+}
+
+ModelBuilder::Layer ModelBuilder::add(const Layer& first, const Layer& second, const std::string& activation) {
+    snn::dp::AddDesc desc;
+    desc.mrtMode         = snn::MRTMode::SINGLE_PLANE;
+    desc.isRange01       = 0;
+    desc.numInputPlanes  = first->getDesc().numOutputPlanes;
+    desc.numOutputPlanes = first->getDesc().numOutputPlanes;
+    desc.activation      = activation;
+    desc.leakyReluAlpha  = 0.0f;
+    desc.preferHp        = preferHp;
+    return append(Layer(snn::dp::AddCreator1(std::move(desc), useVulkan)), {first, second}, "Add");
+}
+
+ModelBuilder::Layer ModelBuilder::upSampling2D(const Layer& prev, uint32_t scale, const std::string& interpolationType) {
+    uint32_t channels = prev->getDesc().numOutputPlanes;
+    snn::dp::UpSampling2DDesc desc;
+    desc.mrtMode           = snn::MRTMode::SINGLE_PLANE;
+    desc.isRange01         = 0;
+    desc.numOutputPlanes   = channels;
+    desc.numInputPlanes    = channels;
+    desc.scale             = (float) scale;
+    desc.interpolationType = interpolationType;
+    desc.preferHp          = preferHp;
+    return append(Layer(snn::dp::UpSampling2DCreator1(std::move(desc), useVulkan)), {prev}, "UpSampling2D");
+}
+
+snn::dp::ShaderGenOptions getModelOptions(uint32_t width, uint32_t height, uint32_t channels, bool useCompute, bool useVulkan, bool preferHp) {
+    auto format                   = preferHp ? snn::ColorFormat::RGBA16F : snn::ColorFormat::RGBA32F;
+    snn::dp::ShaderGenOptions sgo = {};
+    sgo.desiredInput.push_back({format, width, height, UP_DIV(channels, 4U), 4U});
+    sgo.desiredOutputFormat  = format;
+    sgo.preferrHalfPrecision = preferHp;
+    sgo.compute              = useCompute;
+    sgo.vulkan               = useVulkan;
+    return sgo;
+}
+
+std::vector<float> createModelInput(const snn::dp::ShaderGenOptions& options, uint32_t seed) {
+    const auto& desc = options.desiredInput[0];
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    std::vector<float> pixels((size_t) desc.width * desc.height * desc.depth * 4);
+    for (auto& v : pixels) {
+        v = dist(rng);
+    }
+    return pixels;
+}
+
+bool runModel(snn::GpuContext* context, snn::dp::InferenceModel& layers, const snn::dp::ShaderGenOptions& options, const std::vector<float>& pixels,
+              ModelOutput& output) {
+    const auto& desc = options.desiredInput[0];
+    std::vector<uint16_t> halfPixels;
+    const void* data = pixels.data();
+    if (options.preferrHalfPrecision) {
+        halfPixels.resize(pixels.size());
+        snn::fp16::floatToHalf(pixels.data(), halfPixels.data(), pixels.size());
+        data = halfPixels.data();
+    }
+    auto input = snn::ImageTextureFactory::createImageTexture(context, std::array<uint32_t, 4> {desc.width, desc.height, desc.depth, 1U}, desc.format,
+                                                              data);
+    input->upload();
+    snn::ImageTextureArray inputs {input, snn::ImageTextureAllocator(context)};
+
+    snn::MixedInferenceCore::CreationParameters graph;
+    (snn::InferenceGraph &&) graph = snn::dp::generateInferenceGraph(layers, options);
+    graph.dumpOutputs              = false;
+    output.numEliminatedConcats    = graph.numEliminatedConcats;
+    output.numFusedBlocks          = graph.numFusedBlocks;
+    output.numFusedUpsamplings     = graph.numFusedUpsamplings;
+    output.numBufferActivations    = graph.numBufferActivations;
+    auto core                      = snn::MixedInferenceCore::create(context, graph);
+    if (!core) {
+        return false;
+    }
+    auto outVec = std::vector<std::vector<std::vector<float>>>();
+    auto inVec  = std::vector<std::vector<std::vector<float>>>();
+    snn::SNNModelOutput modelOutput;
+    snn::MixedInferenceCore::RunParameters rp = {inputs, {}, inVec, outVec, modelOutput};
+    core->run(rp);
+
+    snn::ManagedImage<snn::Rgba32f> image = snn::toRgba32f(core->getOutputImage().getRawImage());
+    const auto& imageDesc                 = image.desc();
+    output.dims                           = {imageDesc.planes[0].width, imageDesc.planes[0].height, 0U};
+    output.values.clear();
+    for (size_t p = 0; p < imageDesc.planes.size(); ++p) {
+        const auto& plane = imageDesc.planes[p];
+        for (uint32_t z = 0; z < plane.depth; ++z) {
+            for (uint32_t y = 0; y < plane.height; ++y) {
+                for (uint32_t x = 0; x < plane.width; ++x) {
+                    const snn::Rgba32f& pixel = image.at(p, x, y, z);
+                    output.values.insert(output.values.end(), pixel.f32, pixel.f32 + 4);
+                }
+            }
+            output.dims[2]++;
+        }
+    }
+    return true;
+}
+
+int compareModelOutputs(const ModelOutput& expected, const ModelOutput& actual, float tolerance, bool printMismatch) {
+    if (expected.dims != actual.dims || expected.values.size() != actual.values.size()) {
+        printf("Output size mismatch: %ux%ux%u vs %ux%ux%u\n", expected.dims[0], expected.dims[1], expected.dims[2], actual.dims[0], actual.dims[1],
+               actual.dims[2]);
+        return -1;
+    }
+    size_t mismatches = 0;
+    for (size_t i = 0; i < expected.values.size(); ++i) {
+        if (!(std::fabs(expected.values[i] - actual.values[i]) <= tolerance)) {
+            if (printMismatch && mismatches < 32) {
+                size_t pixel = i / 4;
+                printf("Mismatch at x=%zu, y=%zu, plane=%zu, channel=%zu: %f vs %f\n", pixel % expected.dims[0], pixel / expected.dims[0] % expected.dims[1],
+                       pixel / expected.dims[0] / expected.dims[1], i % 4, expected.values[i], actual.values[i]);
+            }
+            mismatches++;
+        }
+    }
+    if (mismatches) {
+        printf("%zu of %zu values differ by more than %g\n", mismatches, expected.values.size(), tolerance);
+    }
+    return mismatches ? -1 : 0;
+}
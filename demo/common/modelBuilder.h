@@ -0,0 +1,111 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+#include "snn/snn.h"
+#include "snn/core.h"
+#include "ic2/dp.h"
+#include <opencv2/core.hpp>
+#include <array>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// This class builds small models in code, layer by layer, for the unit tests, that compare
+// an optimized graph with the same model without the optimization.
+// Graph generation changes the layers, so every compared run needs its own builder with the same seed.
+class ModelBuilder {
+public:
+    typedef std::shared_ptr<snn::dp::GenericModelLayer> Layer;
+
+    // params:
+    //  modelName - model name, used for the layer names "<modelName>.json layer [<index>] <type>"
+    //  useVulkan - create Vulkan layers
+    //  preferHp - create FP16 layers
+    //  seed - seed of the random weights
+    ModelBuilder(const std::string& modelName, bool useVulkan, bool preferHp = false, uint32_t seed = 7767517)
+        : modelName(modelName), useVulkan(useVulkan), preferHp(preferHp), rng(seed) {}
+
+    Layer input(uint32_t width, uint32_t height, uint32_t channels);
+
+    // Convolution with random weights and "same" padding
+    Layer conv2D(const Layer& prev, uint32_t outChannels, uint32_t kernel, uint32_t stride = 1, const std::string& activation = "");
+
+    // Depthwise convolution with random weights and "same" padding
+    Layer depthwiseConv2D(const Layer& prev, uint32_t kernel, uint32_t stride = 1, const std::string& activation = "");
+
+    // Max pooling with "same" padding
+    Layer maxPooling2D(const Layer& prev, uint32_t kernel, uint32_t stride = 1);
+
+    Layer concatenate(const std::vector<Layer>& prev);
+
+    Layer add(const Layer& first, const Layer& second, const std::string& activation = "");
+
+    // interpolationType - "nearest" or "bilinear"
+    Layer upSampling2D(const Layer& prev, uint32_t scale, const std::string& interpolationType);
+
+    snn::dp::InferenceModel& getLayers() { return layers; }
+
+private:
+    // Names the layer and connects it to its inputs
+    Layer append(Layer layer, const std::vector<Layer>& prev, const std::string& type);
+
+    std::vector<cv::Mat> randomWeights(size_t count, uint32_t kernel);
+
+    std::vector<double> randomBiases(size_t count);
+
+    std::string modelName;
+    bool useVulkan;
+    bool preferHp;
+    std::mt19937 rng;
+    snn::dp::InferenceModel layers;
+};
+
+// Output of a model and the graph optimizations, applied to the model
+struct ModelOutput {
+    std::array<uint32_t, 3> dims = {}; // width, height and number of 4-channel planes
+    std::vector<float> values;         // RGBA pixels, plane by plane
+    uint32_t numEliminatedConcats = 0;
+    uint32_t numFusedBlocks       = 0;
+    uint32_t numFusedUpsamplings  = 0;
+    uint32_t numBufferActivations = 0;
+};
+
+// Gets the options for a model with one input
+// params:
+//  preferHp - FP16 input, the layers have to be built with the same precision
+snn::dp::ShaderGenOptions getModelOptions(uint32_t width, uint32_t height, uint32_t channels, bool useCompute, bool useVulkan, bool preferHp = false);
+
+// Gets random RGBA pixels in [0, 1] for the input, described by the options
+std::vector<float> createModelInput(const snn::dp::ShaderGenOptions& options, uint32_t seed = 1);
+
+// Generates the inference graph of the model, runs it once and reads the output of the last layer
+// params:
+//  layers - model layers, changed by the graph generation
+//  options - shader generating options, the first input describes the input image
+//  pixels - input pixels, see createModelInput()
+//  output - model output
+// returns:
+//  true on success, false if the inference core can't be created
+bool runModel(snn::GpuContext* context, snn::dp::InferenceModel& layers, const snn::dp::ShaderGenOptions& options, const std::vector<float>& pixels,
+              ModelOutput& output);
+
+// Compares two outputs of the same model
+// params:
+//  tolerance - max absolute difference of a value
+//  printMismatch - print the first mismatched values
+// returns:
+//  0 if the outputs match, -1 if not
+int compareModelOutputs(const ModelOutput& expected, const ModelOutput& actual, float tolerance, bool printMismatch);
@@ -22,6 +22,7 @@
 #include "ic2/dp.h"
 #include "ic2/layerFactory.h"
 #include "ic2/activation.h"
+#include "ic2/adaptiveavgpool2d.h"
 #include "ic2/addlayer.h"
 #include "ic2/avgpool2d.h"
 #include "ic2/batchnorm.h"
@@ -372,6 +373,11 @@ std::string ShaderUnitTest::snnPoolingTestWithLayer(cv::Mat& inputMat, int width
     int paddingSize = (int) std::floor(kernel / 2);
     int outWidth    = (width - kernel + 2 * paddingSize) / stride + 1;
     int outHeight   = (height - kernel + 2 * paddingSize) / stride + 1;
+    if (poolingType == 2) {
+        // Adaptive pooling: kernel is the output size
+        outWidth  = kernel;
+        outHeight = kernel;
+    }
     int outChannels = inChannels;
 
     // Create single layer from Layer class
@@ -425,6 +431,15 @@ std::string ShaderUnitTest::snnPoolingTestWithLayer(cv::Mat& inputMat, int width
         desc.preferHp = preferrHalfPrecision;
         desc.mrtMode  = snn::MRTMode::SINGLE_PLANE;
         layer = NEW_LAYER(AveragePooling2D, desc);
+    } else if (poolingType == 2) {
+        snn::dp::AdaptiveAvgPool2dDesc desc;
+        desc.numOutputPlanes = outChannels;
+        desc.numInputPlanes  = inChannels;
+        desc.activation      = "";
+        desc.targetSize      = kernel;
+        desc.preferHp        = preferrHalfPrecision;
+        desc.mrtMode         = snn::MRTMode::SINGLE_PLANE;
+        layer = NEW_LAYER(AdaptiveAvgPool2d, desc);
     }
 
     std::vector<std::shared_ptr<snn::dp::GenericModelLayer>> layers;
@@ -60,6 +60,7 @@ public:
     std::string snnDenseTestWithLayer(cv::Mat& inputMat, std::vector<std::vector<float>>& inputWeights, std::vector<float>& inputBias, int w, int h, int c,
         int outch, bool dumpOutput = true);
 
+    // poolingType: 0 - max, 1 - average, 2 - adaptive average with kernel x kernel output
     std::string snnPoolingTestWithLayer(cv::Mat& inputMat, int width, int height, int inChannels, int kernel, int stride, int poolingType, int padMode,
         bool dumpOutput = true);
 
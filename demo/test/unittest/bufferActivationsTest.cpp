@@ -0,0 +1,100 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Runs a convolution, pooling and concatenation model with intermediate activations in storage buffers
+// and in textures, and checks, that both outputs are the same. FP32 and FP16 (packed by packHalf2x16) buffers
+// are tested, and the model has single-plane activations, that are image2D (INPUT_TEXTURE_2D) with textures.
+// Buffer activations are used by GL compute shaders only, other backends have to ignore the option.
+#include "snn/snn.h"
+#include "snn/contextFactory.h"
+#include "snn/utils.h"
+#include "testutil.h"
+#include "modelBuilder.h"
+
+// Global namespace is polluted somewhere
+#ifdef Success
+    #undef Success
+#endif
+#include "CLI/CLI.hpp"
+
+// Number of layer outputs of createModel(), that can be buffers: all except the input and the last layer
+static constexpr uint32_t NUM_BUFFER_OUTPUTS = 6;
+
+// Builds
+//  input -> 3x3 conv (4 channels) -> 3x3 max pooling ----> concat -> 3x3 conv (4 channels) -> 3x3 max pooling with stride 2 -> 3x3 conv
+//  input -> 3x3 conv (8 channels) -----------------------/
+// The single-plane layers and the input are declared as image2D with textures.
+static void createModel(ModelBuilder& builder, uint32_t width, uint32_t height) {
+    auto input  = builder.input(width, height, 4);
+    auto conv0  = builder.conv2D(input, 4, 3, 1, "relu");
+    auto pool0  = builder.maxPooling2D(conv0, 3);
+    auto conv1  = builder.conv2D(input, 8, 3, 1, "relu");
+    auto concat = builder.concatenate({pool0, conv1});
+    auto conv2  = builder.conv2D(concat, 4, 3, 1, "relu");
+    auto pool1  = builder.maxPooling2D(conv2, 3, 2);
+    builder.conv2D(pool1, 4, 3);
+}
+
+static int testBufferActivations(snn::GpuContext* context, uint32_t width, uint32_t height, bool preferHp, bool useCompute, bool useVulkan,
+                                 bool printMismatch) {
+    auto options = getModelOptions(width, height, 4, useCompute, useVulkan, preferHp);
+    auto pixels  = createModelInput(options);
+
+    ModelOutput textures, buffers;
+    options.bufferActivations = false;
+    ModelBuilder textureModel("buffer_activations_test", useVulkan, preferHp);
+    createModel(textureModel, width, height);
+    SNN_CHK(runModel(context, textureModel.getLayers(), options, pixels, textures));
+
+    options.bufferActivations = true;
+    ModelBuilder bufferModel("buffer_activations_test", useVulkan, preferHp);
+    createModel(bufferModel, width, height);
+    SNN_CHK(runModel(context, bufferModel.getLayers(), options, pixels, buffers));
+
+    // FP16 textures and packHalf2x16 may round differently
+    int ret                        = compareModelOutputs(textures, buffers, preferHp ? 2e-2f : 1e-5f, printMismatch);
+    uint32_t expectedBufferOutputs = useCompute && !useVulkan ? NUM_BUFFER_OUTPUTS : 0;
+    if (textures.numBufferActivations != 0 || buffers.numBufferActivations != expectedBufferOutputs) {
+        printf("Buffer outputs: %u without and %u with buffer activations, expected 0 and %u\n", textures.numBufferActivations,
+               buffers.numBufferActivations, expectedBufferOutputs);
+        ret = -1;
+    }
+    printf("buffer activations test res: %s for w=%u, h=%u, %s\n", ret ? "FAILED" : "succeeded", width, height, preferHp ? "fp16" : "fp32");
+    return ret;
+}
+
+int main(int argc, char** argv) {
+    uint32_t width     = 23;
+    uint32_t height    = 17;
+    bool useCompute    = false;
+    bool useVulkan     = false;
+    bool printMismatch = false;
+
+    CLI::App app;
+    app.add_option("-W", width, "width");
+    app.add_option("-H", height, "height");
+    app.add_flag("--use_compute", useCompute, "Use compute shader");
+    app.add_flag("--use_vulkan", useVulkan, "Use Vulkan");
+    app.add_flag("--print_mismatch", printMismatch, "Print results mismatch");
+    CLI11_PARSE(app, argc, argv);
+    CHECK_PLATFORM_SUPPORT(useVulkan)
+
+    printf("Using %s shader\n", useCompute ? "COMPUTE" : "FRAGMENT");
+    printf("Using %s backend\n", useVulkan ? "Vulkan" : "OpenGL");
+
+    snn::GpuContext* context = snn::createDefaultContext(useVulkan);
+    int ret = testBufferActivations(context, width, height, false, useCompute, useVulkan, printMismatch);
+    ret     = testBufferActivations(context, width, height, true, useCompute, useVulkan, printMismatch) || ret;
+    return ret ? 1 : 0;
+}
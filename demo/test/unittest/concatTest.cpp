@@ -31,6 +31,8 @@
 #include "testutil.h"
 #include "matutil.h"
 #include "shaderUnitTest.h"
+#include "modelBuilder.h"
+#include "snn/contextFactory.h"
 
 // Global namespace is polluted somewhere
 #ifdef Success
@@ -91,6 +93,52 @@ static int test_concate(int w, int h, int c, const std::string& activation, snn:
     return ret;
 }
 
+// Builds input -> two 3x3 convolutions -> concatenation -> 3x3 convolution.
+// params:
+//  firstChannels - output channels of the first convolution, i.e. the channel offset of the second one
+//  sharedProducer - the first convolution is added to the model output too, so it has two consumers
+static void createConcatModel(ModelBuilder& builder, uint32_t width, uint32_t height, uint32_t firstChannels, bool sharedProducer) {
+    auto input  = builder.input(width, height, 4);
+    auto first  = builder.conv2D(input, firstChannels, 3);
+    auto second = builder.conv2D(input, 4, 3);
+    auto concat = builder.concatenate({first, second});
+    auto conv   = builder.conv2D(concat, firstChannels, 3);
+    if (sharedProducer) {
+        builder.add(conv, first);
+    }
+}
+
+// Runs the model with and without zero-copy concatenation and checks, that both outputs are exactly the same,
+// and that the concatenation is eliminated only when the planner can alias the producer outputs:
+// on the fragment shader path, with 4-channel aligned inputs, that have no other consumers.
+static int test_zeroCopyConcat(uint32_t w, uint32_t h, uint32_t firstChannels, bool sharedProducer, bool useVulkan, bool printMismatch) {
+    snn::GpuContext* context = snn::createDefaultContext(useVulkan);
+    auto options             = getModelOptions(w, h, 4, false, useVulkan);
+    auto pixels              = createModelInput(options);
+
+    ModelOutput copied, aliased;
+    options.zeroCopyConcat = false;
+    ModelBuilder copyModel("concat_test", useVulkan);
+    createConcatModel(copyModel, w, h, firstChannels, sharedProducer);
+    SNN_CHK(runModel(context, copyModel.getLayers(), options, pixels, copied));
+
+    options.zeroCopyConcat = true;
+    ModelBuilder aliasModel("concat_test", useVulkan);
+    createConcatModel(aliasModel, w, h, firstChannels, sharedProducer);
+    SNN_CHK(runModel(context, aliasModel.getLayers(), options, pixels, aliased));
+
+    uint32_t expectedEliminated = !useVulkan && firstChannels % 4 == 0 && !sharedProducer ? 1 : 0;
+    int ret                     = compareModelOutputs(copied, aliased, 0.0f, printMismatch);
+    if (copied.numEliminatedConcats != 0 || aliased.numEliminatedConcats != expectedEliminated) {
+        printf("Eliminated concatenations: %u without and %u with zero-copy concatenation, expected 0 and %u\n", copied.numEliminatedConcats,
+               aliased.numEliminatedConcats, expectedEliminated);
+        ret = -1;
+    }
+    printf("zero-copy concat test res: %s for w=%u, h=%u, channel offset=%u, shared producer=%d\n", ret ? "FAILED" : "succeeded", w, h, firstChannels,
+           (int) sharedProducer);
+    return ret;
+}
+
 int main(int argc, char **argv) {
     SRAND(7767517);
 
@@ -107,5 +155,10 @@ int main(int argc, char **argv) {
 
     test_concate(5, 7, 4, "relu", backend, printMismatch);
 
-    return 0;
+    int ret = test_zeroCopyConcat(17, 9, 4, false, useVulkan, printMismatch);
+    ret     = test_zeroCopyConcat(17, 9, 8, false, useVulkan, printMismatch) || ret;
+    ret     = test_zeroCopyConcat(17, 9, 3, false, useVulkan, printMismatch) || ret;
+    ret     = test_zeroCopyConcat(17, 9, 4, true, useVulkan, printMismatch) || ret;
+
+    return ret ? 1 : 0;
 }
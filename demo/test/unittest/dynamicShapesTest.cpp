@@ -0,0 +1,115 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Runs a model, generated with dynamic shapes, at two input resolutions and checks, that the outputs are the same
+// as the outputs of the model, generated for each resolution. On OpenGL, the program binary cache is enabled,
+// and the model at the second resolution has to load its programs from the binaries, cached for the first one.
+#include "snn/snn.h"
+#include "snn/contextFactory.h"
+#include "snn/utils.h"
+#include "testutil.h"
+#include "modelBuilder.h"
+#ifdef SUPPORT_GL
+    #include "glUtils.h"
+#endif
+#include <array>
+#include <vector>
+
+// Global namespace is polluted somewhere
+#ifdef Success
+    #undef Success
+#endif
+#include "CLI/CLI.hpp"
+
+// Builds input -> 3x3 conv -> 3x3 conv with stride 2 -> nearest upsampling x2 -> 3x3 conv
+static void createModel(ModelBuilder& builder, uint32_t width, uint32_t height) {
+    auto input = builder.input(width, height, 4);
+    auto conv  = builder.conv2D(input, 8, 3, 1, "relu");
+    auto down  = builder.conv2D(conv, 8, 3, 2, "relu");
+    auto up    = builder.upSampling2D(down, 2, "nearest");
+    builder.conv2D(up, 4, 3);
+}
+
+static int testDynamicShapes(snn::GpuContext* context, const std::vector<std::array<uint32_t, 2>>& sizes, bool useCompute, bool useVulkan,
+                             bool printMismatch) {
+#ifdef SUPPORT_GL
+    if (!useVulkan) {
+        gl::clearProgramBinaryCache();
+        gl::setProgramBinaryCacheLimit(64 * 1024 * 1024);
+    }
+#endif
+    int ret = 0;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        uint32_t width  = sizes[i][0];
+        uint32_t height = sizes[i][1];
+        auto options    = getModelOptions(width, height, 4, useCompute, useVulkan);
+        auto pixels     = createModelInput(options, (uint32_t) i + 1);
+
+        ModelOutput dynamicOutput, staticOutput;
+        options.dynamicShapes = true;
+        ModelBuilder dynamicModel("dynamic_shapes_test", useVulkan);
+        createModel(dynamicModel, width, height);
+#ifdef SUPPORT_GL
+        auto before = gl::getProgramBinaryCacheStats();
+#endif
+        SNN_CHK(runModel(context, dynamicModel.getLayers(), options, pixels, dynamicOutput));
+#ifdef SUPPORT_GL
+        if (!useVulkan) {
+            auto after = gl::getProgramBinaryCacheStats();
+            printf("Resolution %ux%u: %llu programs loaded from cached binaries, %llu compiled\n", width, height,
+                   (unsigned long long) (after.hits - before.hits), (unsigned long long) (after.misses - before.misses));
+            // Programs of the first resolution are compiled, the next resolutions reuse them
+            if (i > 0 && after.hits == before.hits) {
+                printf("Resolution %ux%u didn't reuse cached program binaries\n", width, height);
+                ret = -1;
+            }
+        }
+#endif
+
+        options.dynamicShapes = false;
+        ModelBuilder staticModel("dynamic_shapes_test", useVulkan);
+        createModel(staticModel, width, height);
+        SNN_CHK(runModel(context, staticModel.getLayers(), options, pixels, staticOutput));
+
+        int res = compareModelOutputs(staticOutput, dynamicOutput, 1e-4f, printMismatch);
+        printf("dynamic shapes test res: %s for w=%u, h=%u\n", res ? "FAILED" : "succeeded", width, height);
+        ret = res || ret;
+    }
+#ifdef SUPPORT_GL
+    if (!useVulkan) {
+        gl::setProgramBinaryCacheLimit(0);
+    }
+#endif
+    return ret;
+}
+
+int main(int argc, char** argv) {
+    bool useCompute    = false;
+    bool useVulkan     = false;
+    bool printMismatch = false;
+
+    CLI::App app;
+    app.add_flag("--use_compute", useCompute, "Use compute shader");
+    app.add_flag("--use_vulkan", useVulkan, "Use Vulkan");
+    app.add_flag("--print_mismatch", printMismatch, "Print results mismatch");
+    CLI11_PARSE(app, argc, argv);
+    CHECK_PLATFORM_SUPPORT(useVulkan)
+
+    printf("Using %s shader\n", useCompute ? "COMPUTE" : "FRAGMENT");
+    printf("Using %s backend\n", useVulkan ? "Vulkan" : "OpenGL");
+
+    snn::GpuContext* context = snn::createDefaultContext(useVulkan);
+    int ret = testDynamicShapes(context, {{32, 24}, {20, 36}}, useCompute, useVulkan, printMismatch);
+    return ret ? 1 : 0;
+}
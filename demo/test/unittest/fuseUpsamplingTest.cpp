@@ -0,0 +1,97 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Runs models with nearest and bilinear upsampling, that feeds 3x3 and 1x1 convolutions, with fuseUpsampling on and off,
+// and checks, that the convolutions, sampling the low resolution input, produce the outputs of the unfused layers.
+// The 3x3 convolution reads the zero padding around the upsampled tensor at every image edge, and the odd input size
+// makes the last upsampled rows and columns depend on the edge pixels of the input.
+#include "snn/snn.h"
+#include "snn/contextFactory.h"
+#include "snn/utils.h"
+#include "testutil.h"
+#include "modelBuilder.h"
+#include <string>
+
+// Global namespace is polluted somewhere
+#ifdef Success
+    #undef Success
+#endif
+#include "CLI/CLI.hpp"
+
+// Builds
+//  input -> 3x3 conv -> upsampling -> 3x3 conv -> add
+//                                 \-> 1x1 conv -/
+static void createModel(ModelBuilder& builder, uint32_t width, uint32_t height, uint32_t channels, uint32_t scale, const std::string& type) {
+    auto input = builder.input(width, height, 4);
+    auto conv  = builder.conv2D(input, channels, 3, 1, "relu");
+    auto up    = builder.upSampling2D(conv, scale, type);
+    auto conv3 = builder.conv2D(up, 4, 3);
+    auto conv1 = builder.conv2D(up, 4, 1);
+    builder.add(conv3, conv1);
+}
+
+static int testFuseUpsampling(snn::GpuContext* context, uint32_t width, uint32_t height, uint32_t channels, uint32_t scale, const std::string& type,
+                              bool useCompute, bool useVulkan, bool printMismatch) {
+    auto options = getModelOptions(width, height, 4, useCompute, useVulkan);
+    auto pixels  = createModelInput(options);
+
+    ModelOutput unfused, fused;
+    options.fuseUpsampling = false;
+    ModelBuilder unfusedModel("fuse_upsampling_test", useVulkan);
+    createModel(unfusedModel, width, height, channels, scale, type);
+    SNN_CHK(runModel(context, unfusedModel.getLayers(), options, pixels, unfused));
+
+    options.fuseUpsampling = true;
+    ModelBuilder fusedModel("fuse_upsampling_test", useVulkan);
+    createModel(fusedModel, width, height, channels, scale, type);
+    SNN_CHK(runModel(context, fusedModel.getLayers(), options, pixels, fused));
+
+    // Bilinear weights are computed from other coordinates by the upsampling layer and the convolution
+    int ret = compareModelOutputs(unfused, fused, type == "bilinear" ? 1e-3f : 1e-4f, printMismatch);
+    if (unfused.numFusedUpsamplings != 0 || fused.numFusedUpsamplings != 1) {
+        printf("Fused upsamplings: %u without and %u with fusion, expected 0 and 1\n", unfused.numFusedUpsamplings, fused.numFusedUpsamplings);
+        ret = -1;
+    }
+    printf("fuse upsampling test res: %s for w=%u, h=%u, channels=%u, %s x%u\n", ret ? "FAILED" : "succeeded", width, height, channels, type.c_str(),
+           scale);
+    return ret;
+}
+
+int main(int argc, char** argv) {
+    uint32_t width     = 13;
+    uint32_t height    = 10;
+    bool useCompute    = false;
+    bool useVulkan     = false;
+    bool printMismatch = false;
+
+    CLI::App app;
+    app.add_option("-W", width, "width");
+    app.add_option("-H", height, "height");
+    app.add_flag("--use_compute", useCompute, "Use compute shader");
+    app.add_flag("--use_vulkan", useVulkan, "Use Vulkan");
+    app.add_flag("--print_mismatch", printMismatch, "Print results mismatch");
+    CLI11_PARSE(app, argc, argv);
+    CHECK_PLATFORM_SUPPORT(useVulkan)
+
+    printf("Using %s shader\n", useCompute ? "COMPUTE" : "FRAGMENT");
+    printf("Using %s backend\n", useVulkan ? "Vulkan" : "OpenGL");
+
+    snn::GpuContext* context = snn::createDefaultContext(useVulkan);
+    int ret = testFuseUpsampling(context, width, height, 8, 2, "nearest", useCompute, useVulkan, printMismatch);
+    ret     = testFuseUpsampling(context, width, height, 8, 2, "bilinear", useCompute, useVulkan, printMismatch) || ret;
+    // Single-plane input of the convolutions
+    ret = testFuseUpsampling(context, width, height, 4, 3, "nearest", useCompute, useVulkan, printMismatch) || ret;
+    ret = testFuseUpsampling(context, width, height, 4, 3, "bilinear", useCompute, useVulkan, printMismatch) || ret;
+    return ret ? 1 : 0;
+}
@@ -0,0 +1,400 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Runs snn::InferenceServer on the default (headless) context: checks, that served requests give the same output
+// as a direct run, that a full queue rejects or blocks requests depending on the backpressure, that every request,
+// pending or submitted during stop(), completes, and that a model, whose shaders don't compile, isn't served.
+#include "snn/snn.h"
+#include "snn/contextFactory.h"
+#include "snn/imageTextureFactory.h"
+#include "snn/inferenceServer.h"
+#include "snn/utils.h"
+#include "testutil.h"
+#include "ic2/dp.h"
+#include "ic2/layerFactory.h"
+#include "ic2/conv2d.h"
+#include "ic2/inputlayer.h"
+#ifdef SUPPORT_GL
+    #include "ic2/conv2dGL.h"
+    #include "ic2/inferencepassGL.h"
+#endif
+#include <opencv2/core.hpp>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Global namespace is polluted somewhere
+#ifdef Success
+    #undef Success
+#endif
+#include "CLI/CLI.hpp"
+
+using Server = snn::InferenceServer;
+
+// Futures, that don't complete in this time, are reported as hangs
+static constexpr auto COMPLETION_TIMEOUT = std::chrono::seconds(30);
+
+#ifdef SUPPORT_GL
+// OpenGL convolution, whose shaders don't compile
+class BrokenConv2DLayerGl : public snn::dp::Conv2DLayerGl {
+public:
+    BrokenConv2DLayerGl(snn::dp::Conv2DDesc&& d): Conv2DLayerGl(std::move(d)) {}
+
+protected:
+    snn::InferencePassesSptr createFS(const LayerGenOptions& options) const override { return breakShaders(Conv2DLayerGl::createFS(options)); }
+    snn::InferencePassesSptr createCS(const LayerGenOptions& options) const override { return breakShaders(Conv2DLayerGl::createCS(options)); }
+
+private:
+    static snn::InferencePassesSptr breakShaders(snn::InferencePassesSptr passes) {
+        for (auto& pass : snn::InferencePassesGl::cast(passes.get())->passes) {
+            pass.source += "\nnot a GLSL statement\n";
+        }
+        return passes;
+    }
+};
+#endif
+
+// Builds input -> 3x3 conv
+// params:
+//  brokenShaders - the convolution shaders don't compile, OpenGL only
+static snn::dp::InferenceModel createModel(uint32_t width, uint32_t height, uint32_t channels, bool useVulkan, bool brokenShaders = false) {
+    std::mt19937 rng(7767517);
+    std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+
+    snn::dp::InputLayerDesc inputDesc;
+    inputDesc.inputWidth      = width;
+    inputDesc.inputHeight     = height;
+    inputDesc.inputChannels   = channels;
+    inputDesc.numInputPlanes  = channels;
+    inputDesc.numOutputPlanes = channels;
+    inputDesc.isInputLayer    = true;
+    std::shared_ptr<snn::dp::GenericModelLayer> input(new snn::dp::InputLayerLayer(std::move(inputDesc)));
+    input->setName("server_test.json layer [00] InputLayer");
+
+    snn::dp::Conv2DDesc desc;
+    desc.mrtMode         = snn::MRTMode::SINGLE_PLANE;
+    desc.isRange01       = 0;
+    desc.numOutputPlanes = channels;
+    desc.numInputPlanes  = channels;
+    for (uint32_t i = 0; i < channels * channels; ++i) {
+        cv::Mat weights(3, 3, CV_32FC1);
+        for (int k = 0; k < 9; ++k) {
+            weights.at<float>(k / 3, k % 3) = dist(rng);
+        }
+        desc.weightsCvM.push_back(weights);
+    }
+    for (uint32_t i = 0; i < channels; ++i) {
+        desc.biases.push_back(dist(rng));
+    }
+    desc.activation            = "";
+    desc.kernelSize            = 3;
+    desc.stride                = 1;
+    desc.useBatchNormalization = false;
+    desc.useMultiInputs        = false;
+    desc.padding               = "same";
+    desc.paddingT              = "1";
+    desc.paddingB              = "1";
+    desc.paddingL              = "1";
+    desc.paddingR              = "1";
+    desc.paddingMode           = "constant";
+    desc.preferHp              = false;
+    desc.weightMode            = snn::WeightAccessMethod::TEXTURES;
+    std::shared_ptr<snn::dp::GenericModelLayer> conv;
+#ifdef SUPPORT_GL
+    if (brokenShaders) {
+        conv.reset(new BrokenConv2DLayerGl(std::move(desc)));
+    }
+#endif
+    if (!conv) {
+        conv.reset(snn::dp::Conv2DCreator1(std::move(desc), useVulkan));
+    }
+    conv->setName("server_test.json layer [01] Conv2D");
+
+    conv->prevLayers.push_back(input);
+    input->nextLayers.push_back(conv);
+    return {input, conv};
+}
+
+// Random RGBA32F pixels of one request
+static std::vector<uint8_t> createInput(uint32_t width, uint32_t height, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    std::vector<float> pixels(width * height * 4);
+    for (auto& v : pixels) {
+        v = dist(rng);
+    }
+    std::vector<uint8_t> bytes(pixels.size() * sizeof(float));
+    memcpy(bytes.data(), pixels.data(), bytes.size());
+    return bytes;
+}
+
+struct TestSetup {
+    snn::GpuContext* context;
+    std::shared_ptr<const snn::CompiledModel> model;
+    snn::dp::ShaderGenOptions options;
+    uint32_t width;
+    uint32_t height;
+};
+
+static Server::CreationParameters getServerParameters(const TestSetup& setup, uint32_t numWorkers, uint32_t maxBatch, uint32_t maxQueueDepth,
+                                                      Server::Backpressure backpressure) {
+    Server::CreationParameters cp;
+    cp.model          = setup.model;
+    cp.options        = setup.options;
+    cp.numWorkers     = numWorkers;
+    cp.maxBatch       = maxBatch;
+    cp.maxQueueDepth  = maxQueueDepth;
+    cp.batchTimeoutMs = 1.0;
+    cp.backpressure   = backpressure;
+    return cp;
+}
+
+// Waits for all responses
+// returns:
+//  false, if a response didn't complete in time
+static bool waitAll(std::vector<std::future<Server::Response>>& futures, std::vector<Server::Response>& responses) {
+    auto deadline = std::chrono::steady_clock::now() + COMPLETION_TIMEOUT;
+    for (auto& future : futures) {
+        if (future.wait_until(deadline) != std::future_status::ready) {
+            printf("Request didn't complete in %lld seconds\n", (long long) COMPLETION_TIMEOUT.count());
+            return false;
+        }
+        responses.push_back(future.get());
+    }
+    return true;
+}
+
+// Served requests give the same outputs as the model, run directly
+static int testOutputs(const TestSetup& setup, bool printMismatch) {
+    const uint32_t numRequests = 16;
+    auto server = Server::create(setup.context, getServerParameters(setup, 2, 4, numRequests, Server::Backpressure::BLOCK));
+    SNN_CHK(server);
+    std::vector<std::future<Server::Response>> futures;
+    for (uint32_t i = 0; i < numRequests; ++i) {
+        futures.push_back(server->submit({{createInput(setup.width, setup.height, i)}}));
+    }
+    std::vector<Server::Response> responses;
+    if (!waitAll(futures, responses)) {
+        return -1;
+    }
+    server->stop();
+
+    auto core = snn::MixedInferenceCore::create(setup.model);
+    SNN_CHK(core);
+    int ret = 0;
+    for (uint32_t i = 0; i < numRequests; ++i) {
+        auto pixels = createInput(setup.width, setup.height, i);
+        auto input  = snn::ImageTextureFactory::createImageTexture(setup.context, std::array<uint32_t, 4> {setup.width, setup.height, 1U, 1U},
+                                                                  snn::ColorFormat::RGBA32F, pixels.data());
+        input->upload();
+        snn::ImageTextureArray inputs {input, snn::ImageTextureAllocator(setup.context)};
+        auto outVec = std::vector<std::vector<std::vector<float>>>();
+        auto inVec  = std::vector<std::vector<std::vector<float>>>();
+        snn::SNNModelOutput modelOutput;
+        snn::MixedInferenceCore::RunParameters rp = {inputs, {}, inVec, outVec, modelOutput};
+        core->run(rp);
+        const auto& expected = core->getOutputImage().getRawImage();
+        const auto& actual   = responses[i].outputImage;
+        if (!responses[i].ok || actual.size() != expected.size() || memcmp(actual.data(), expected.data(), actual.size())) {
+            if (printMismatch) {
+                printf("Request %u: ok=%d, output size %zu vs %zu\n", i, responses[i].ok, actual.size(), (size_t) expected.size());
+            }
+            ret = -1;
+        }
+    }
+    auto stats = server->getStats();
+    printf("\nserver outputs test res: %s, %llu requests in %llu batches\n", ret ? "FAILED" : "succeeded", (unsigned long long) stats.completed,
+           (unsigned long long) stats.batches);
+    return ret;
+}
+
+// With REJECT, requests beyond the queue depth complete at once with ok = false
+static int testReject(const TestSetup& setup) {
+    const uint32_t numRequests = 64;
+    auto server = Server::create(setup.context, getServerParameters(setup, 1, 1, 2, Server::Backpressure::REJECT));
+    SNN_CHK(server);
+    // Inputs are created up front, so that requests come much faster, than one worker runs them
+    std::vector<Server::Request> requests(numRequests);
+    for (uint32_t i = 0; i < numRequests; ++i) {
+        requests[i].inputs.push_back(createInput(setup.width, setup.height, i));
+    }
+    std::vector<std::future<Server::Response>> futures;
+    for (auto& request : requests) {
+        futures.push_back(server->submit(std::move(request)));
+    }
+    std::vector<Server::Response> responses;
+    if (!waitAll(futures, responses)) {
+        return -1;
+    }
+    uint64_t completed = 0;
+    for (const auto& response : responses) {
+        completed += response.ok ? 1 : 0;
+    }
+    auto stats = server->getStats();
+    bool ok    = completed > 0 && completed < numRequests && stats.completed == completed && stats.rejected == numRequests - completed;
+    printf("\nserver reject test res: %s, %llu of %u requests completed\n", ok ? "succeeded" : "FAILED", (unsigned long long) completed,
+           numRequests);
+    return ok ? 0 : -1;
+}
+
+// With BLOCK, submit() waits for a free slot, so every request completes
+static int testBlock(const TestSetup& setup) {
+    const uint32_t numThreads  = 2;
+    const uint32_t numRequests = 16; // Per thread
+    auto server = Server::create(setup.context, getServerParameters(setup, 1, 1, 2, Server::Backpressure::BLOCK));
+    SNN_CHK(server);
+    std::vector<std::vector<std::future<Server::Response>>> futures(numThreads);
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&, t] {
+            for (uint32_t i = 0; i < numRequests; ++i) {
+                futures[t].push_back(server->submit({{createInput(setup.width, setup.height, t * numRequests + i)}}));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    uint64_t completed = 0;
+    for (auto& threadFutures : futures) {
+        std::vector<Server::Response> responses;
+        if (!waitAll(threadFutures, responses)) {
+            return -1;
+        }
+        for (const auto& response : responses) {
+            completed += response.ok ? 1 : 0;
+        }
+    }
+    auto stats = server->getStats();
+    bool ok    = completed == numThreads * numRequests && stats.rejected == 0;
+    printf("\nserver block test res: %s, %llu of %u requests completed\n", ok ? "succeeded" : "FAILED", (unsigned long long) completed,
+           numThreads * numRequests);
+    return ok ? 0 : -1;
+}
+
+// stop() completes pending requests and the ones, submitted concurrently, with ok = false
+static int testStop(const TestSetup& setup) {
+    const uint32_t numRequests = 256;
+    auto server = Server::create(setup.context, getServerParameters(setup, 1, 1, 64, Server::Backpressure::BLOCK));
+    SNN_CHK(server);
+    std::vector<Server::Request> requests(numRequests);
+    for (uint32_t i = 0; i < numRequests; ++i) {
+        requests[i].inputs.push_back(createInput(setup.width, setup.height, i));
+    }
+    std::vector<std::future<Server::Response>> futures;
+    std::atomic<uint32_t> numSubmitted {0};
+    std::thread submitter([&] {
+        for (auto& request : requests) {
+            futures.push_back(server->submit(std::move(request)));
+            numSubmitted++;
+        }
+    });
+    // Stop, while requests are pending and submitted
+    while (numSubmitted < numRequests / 4) {
+        std::this_thread::yield();
+    }
+    server->stop();
+    submitter.join();
+
+    std::vector<Server::Response> responses;
+    if (!waitAll(futures, responses)) {
+        return -1;
+    }
+    uint64_t completed = 0;
+    for (const auto& response : responses) {
+        completed += response.ok ? 1 : 0;
+    }
+    auto late  = server->submit({{createInput(setup.width, setup.height, 0)}});
+    bool ok    = late.wait_for(COMPLETION_TIMEOUT) == std::future_status::ready && !late.get().ok;
+    auto stats = server->getStats();
+    ok         = ok && stats.submitted == numRequests + 1 && stats.completed == completed && stats.completed + stats.rejected == stats.submitted;
+    printf("\nserver stop test res: %s, %llu of %u requests completed before stop\n", ok ? "succeeded" : "FAILED", (unsigned long long) completed,
+           numRequests);
+    return ok ? 0 : -1;
+}
+
+// A model, whose shaders don't compile, isn't compiled, so neither an inference core nor a server can be created
+static int testCompileError(const TestSetup& setup, bool useVulkan) {
+    if (useVulkan) {
+        // Vulkan layers create their pipelines, when the inference core is initialized
+        printf("\nserver compile error test skipped for Vulkan\n");
+        return 0;
+    }
+    auto layers = createModel(setup.width, setup.height, 4, useVulkan, true);
+    snn::MixedInferenceCore::CreationParameters graph;
+    (snn::InferenceGraph &&) graph = snn::dp::generateInferenceGraph(layers, setup.options);
+    graph.dumpOutputs = false;
+    auto model        = snn::CompiledModel::create(setup.context, graph);
+    auto core         = snn::MixedInferenceCore::create(setup.context, graph);
+
+    // The model is null, so the server has nothing to serve
+    TestSetup brokenSetup = setup;
+    brokenSetup.model     = model;
+    auto server           = Server::create(setup.context, getServerParameters(brokenSetup, 1, 1, 2, Server::Backpressure::BLOCK));
+    bool ok               = !model && !core && !server;
+    printf("\nserver compile error test res: %s\n", ok ? "succeeded" : "FAILED");
+    return ok ? 0 : -1;
+}
+
+int main(int argc, char** argv) {
+    uint32_t width     = 128;
+    uint32_t height    = 128;
+    bool useCompute    = false;
+    bool useVulkan     = false;
+    bool printMismatch = false;
+
+    CLI::App app;
+    app.add_option("-W", width, "width");
+    app.add_option("-H", height, "height");
+    app.add_flag("--use_compute", useCompute, "Use compute shader");
+    app.add_flag("--use_vulkan", useVulkan, "Use Vulkan");
+    app.add_flag("--print_mismatch", printMismatch, "Print results mismatch");
+    CLI11_PARSE(app, argc, argv);
+    CHECK_PLATFORM_SUPPORT(useVulkan)
+
+    printf("Using %s shader\n", useCompute ? "COMPUTE" : "FRAGMENT");
+    printf("Using %s backend\n", useVulkan ? "Vulkan" : "OpenGL");
+
+    const uint32_t channels = 4;
+    TestSetup setup;
+    setup.context = snn::createDefaultContext(useVulkan);
+    setup.width   = width;
+    setup.height  = height;
+    setup.options.desiredInput.push_back({snn::ColorFormat::RGBA32F, width, height, UP_DIV(channels, 4U), 4U});
+    setup.options.desiredOutputFormat  = snn::ColorFormat::RGBA32F;
+    setup.options.preferrHalfPrecision = false;
+    setup.options.compute              = useCompute;
+    setup.options.vulkan               = useVulkan;
+
+    auto layers = createModel(width, height, channels, useVulkan);
+    snn::MixedInferenceCore::CreationParameters graph;
+    (snn::InferenceGraph &&) graph = snn::dp::generateInferenceGraph(layers, setup.options);
+    graph.dumpOutputs = false;
+    setup.model       = snn::CompiledModel::create(setup.context, graph);
+    SNN_CHK(setup.model);
+
+    int ret = testOutputs(setup, printMismatch);
+    ret     = testReject(setup) || ret;
+    ret     = testBlock(setup) || ret;
+    ret     = testStop(setup) || ret;
+    ret     = testCompileError(setup, useVulkan) || ret;
+    return ret ? 1 : 0;
+}
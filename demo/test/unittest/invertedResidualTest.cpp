@@ -0,0 +1,97 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Runs a MobileNetV2 style inverted residual block (expand 1x1 conv -> depthwise 3x3 conv -> project 1x1 conv,
+// with or without the residual add) with fuseInvertedResidual on and off, and checks, that the fused block
+// produces the outputs of the unfused layer chain. Blocks are fused by compute shader backends only.
+#include "snn/snn.h"
+#include "snn/contextFactory.h"
+#include "snn/utils.h"
+#include "testutil.h"
+#include "modelBuilder.h"
+
+// Global namespace is polluted somewhere
+#ifdef Success
+    #undef Success
+#endif
+#include "CLI/CLI.hpp"
+
+// Builds input -> 3x3 conv -> inverted residual block -> 3x3 conv
+static void createModel(ModelBuilder& builder, uint32_t width, uint32_t height, uint32_t stride, bool residual) {
+    const uint32_t channels         = 8;
+    const uint32_t expandedChannels = 24;
+    auto input                      = builder.input(width, height, 4);
+    auto blockInput                 = builder.conv2D(input, channels, 3, 1, "relu");
+    auto expand                     = builder.conv2D(blockInput, expandedChannels, 1, 1, "relu6");
+    auto depthwise                  = builder.depthwiseConv2D(expand, 3, stride, "relu6");
+    auto blockOutput                = builder.conv2D(depthwise, channels, 1);
+    if (residual) {
+        blockOutput = builder.add(blockOutput, blockInput);
+    }
+    builder.conv2D(blockOutput, 4, 3);
+}
+
+static int testInvertedResidual(snn::GpuContext* context, uint32_t width, uint32_t height, uint32_t stride, bool residual, bool useCompute,
+                                bool useVulkan, bool printMismatch) {
+    auto options = getModelOptions(width, height, 4, useCompute, useVulkan);
+    auto pixels  = createModelInput(options);
+
+    ModelOutput unfused, fused;
+    options.fuseInvertedResidual = false;
+    ModelBuilder unfusedModel("inverted_residual_test", useVulkan);
+    createModel(unfusedModel, width, height, stride, residual);
+    SNN_CHK(runModel(context, unfusedModel.getLayers(), options, pixels, unfused));
+
+    options.fuseInvertedResidual = true;
+    ModelBuilder fusedModel("inverted_residual_test", useVulkan);
+    createModel(fusedModel, width, height, stride, residual);
+    SNN_CHK(runModel(context, fusedModel.getLayers(), options, pixels, fused));
+
+    // The fused kernel accumulates in another order
+    int ret                      = compareModelOutputs(unfused, fused, 1e-3f, printMismatch);
+    uint32_t expectedFusedBlocks = useCompute || useVulkan ? 1 : 0;
+    if (unfused.numFusedBlocks != 0 || fused.numFusedBlocks != expectedFusedBlocks) {
+        printf("Fused blocks: %u without and %u with fusion, expected 0 and %u\n", unfused.numFusedBlocks, fused.numFusedBlocks, expectedFusedBlocks);
+        ret = -1;
+    }
+    printf("inverted residual test res: %s for w=%u, h=%u, stride=%u, residual=%d\n", ret ? "FAILED" : "succeeded", width, height, stride,
+           (int) residual);
+    return ret;
+}
+
+int main(int argc, char** argv) {
+    uint32_t width     = 19;
+    uint32_t height    = 14;
+    bool useCompute    = false;
+    bool useVulkan     = false;
+    bool printMismatch = false;
+
+    CLI::App app;
+    app.add_option("-W", width, "width");
+    app.add_option("-H", height, "height");
+    app.add_flag("--use_compute", useCompute, "Use compute shader");
+    app.add_flag("--use_vulkan", useVulkan, "Use Vulkan");
+    app.add_flag("--print_mismatch", printMismatch, "Print results mismatch");
+    CLI11_PARSE(app, argc, argv);
+    CHECK_PLATFORM_SUPPORT(useVulkan)
+
+    printf("Using %s shader\n", useCompute ? "COMPUTE" : "FRAGMENT");
+    printf("Using %s backend\n", useVulkan ? "Vulkan" : "OpenGL");
+
+    snn::GpuContext* context = snn::createDefaultContext(useVulkan);
+    int ret = testInvertedResidual(context, width, height, 1, true, useCompute, useVulkan, printMismatch);
+    ret     = testInvertedResidual(context, width, height, 1, false, useCompute, useVulkan, printMismatch) || ret;
+    ret     = testInvertedResidual(context, width, height, 2, false, useCompute, useVulkan, printMismatch) || ret;
+    return ret ? 1 : 0;
+}
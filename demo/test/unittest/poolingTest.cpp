@@ -73,7 +73,9 @@ static int test_pooling2(int w, int h, int c, int pooling_type, int kernel, int
 
     cv::Mat inputMat = NCNNMat2CVMat(padA);
 
-    auto outFile = test.snnPoolingTestWithLayer(inputMat, w, h, c, kernel, stride, pooling_type, pad_mode);
+    // Adaptive average pooling is pooling type 2 with the output size as the kernel
+    auto outFile = adaptive_pooling ? test.snnPoolingTestWithLayer(inputMat, w, h, c, out_w, 1, 2, pad_mode)
+                                    : test.snnPoolingTestWithLayer(inputMat, w, h, c, kernel, stride, pooling_type, pad_mode);
     printf("Output file:%s\n", formatString("%s/%s", DUMP_DIR, outFile.c_str()).c_str());
     auto snnOutput = getSNNLayer(formatString("%s/%s", DUMP_DIR, outFile.c_str()).c_str(), false, c);
 
@@ -102,5 +104,10 @@ int main(int argc, char **argv) {
     snn::GpuBackendType backend = useVulkan ? snn::GpuBackendType::VULKAN : snn::GpuBackendType::GL;
 
     test_pooling2(9, 9, 4, 1, 2, 3, 0, 0, 3 /*padding*/, 1, 0, 13, backend, printMismatch);
+    // Adaptive average pooling: global, evenly divided and overlapping regions
+    test_pooling2(7, 7, 4, 1, 0, 1, 0, 0, 0, 1, 1 /*adaptive*/, 1, backend, printMismatch);
+    test_pooling2(28, 28, 8, 1, 0, 1, 0, 0, 0, 1, 1 /*adaptive*/, 1, backend, printMismatch);
+    test_pooling2(9, 9, 4, 1, 0, 1, 0, 0, 0, 1, 1 /*adaptive*/, 3, backend, printMismatch);
+    test_pooling2(13, 13, 4, 1, 0, 1, 0, 0, 0, 1, 1 /*adaptive*/, 5, backend, printMismatch);
     return 0;
 }
@@ -0,0 +1,301 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Runs a model, that downsamples by a strided convolution and upsamples back, over the whole image
+// and tile by tile with snn::TiledInferenceCore, and checks that both outputs are exactly the same.
+// In the incremental mode, checks that a static frame skips every tile, and that a one pixel change
+// recomputes exactly the tiles, which input windows contain the pixel.
+#include "snn/snn.h"
+#include "snn/contextFactory.h"
+#include "snn/imageTextureFactory.h"
+#include "snn/tiledcore.h"
+#include "snn/utils.h"
+#include "testutil.h"
+#include "ic2/dp.h"
+#include "ic2/layerFactory.h"
+#include "ic2/conv2d.h"
+#include "ic2/inputlayer.h"
+#include "ic2/upsampling2d.h"
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Global namespace is polluted somewhere
+#ifdef Success
+    #undef Success
+#endif
+#include "CLI/CLI.hpp"
+
+static std::shared_ptr<snn::dp::GenericModelLayer> createConv2D(int channels, int stride, std::mt19937& rng, bool useVulkan) {
+    std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+    snn::dp::Conv2DDesc desc;
+    desc.mrtMode         = snn::MRTMode::SINGLE_PLANE;
+    desc.isRange01       = 0;
+    desc.numOutputPlanes = channels;
+    desc.numInputPlanes  = channels;
+    for (int i = 0; i < channels * channels; ++i) {
+        cv::Mat weights(3, 3, CV_32FC1);
+        for (int k = 0; k < 9; ++k) {
+            weights.at<float>(k / 3, k % 3) = dist(rng);
+        }
+        desc.weightsCvM.push_back(weights);
+    }
+    for (int i = 0; i < channels; ++i) {
+        desc.biases.push_back(dist(rng));
+    }
+    desc.activation            = "";
+    desc.kernelSize            = 3;
+    desc.stride                = stride;
+    desc.useBatchNormalization = false;
+    desc.useMultiInputs        = false;
+    desc.padding               = "same";
+    desc.paddingT              = "1";
+    desc.paddingB              = "1";
+    desc.paddingL              = "1";
+    desc.paddingR              = "1";
+    desc.paddingMode           = "constant";
+    desc.preferHp              = false;
+    desc.weightMode            = snn::WeightAccessMethod::TEXTURES;
+    return std::shared_ptr<snn::dp::GenericModelLayer>(snn::dp::Conv2DCreator1(std::move(desc), useVulkan));
+}
+
+// Builds input -> 3x3 conv with stride 2 -> nearest upsampling x2 -> 3x3 conv.
+// Graph generation changes the layers, so every core gets its own model with the same weights.
+static snn::dp::InferenceModel createDownUpModel(int width, int height, int channels, bool useVulkan) {
+    std::mt19937 rng(7767517);
+
+    snn::dp::InputLayerDesc inputDesc;
+    inputDesc.inputWidth      = width;
+    inputDesc.inputHeight     = height;
+    inputDesc.inputChannels   = channels;
+    inputDesc.numInputPlanes  = channels;
+    inputDesc.numOutputPlanes = channels;
+    inputDesc.isInputLayer    = true;
+    std::shared_ptr<snn::dp::GenericModelLayer> input(new snn::dp::InputLayerLayer(std::move(inputDesc)));
+    input->setName("tiled_test.json layer [00] InputLayer");
+
+    auto down = createConv2D(channels, 2, rng, useVulkan);
+    down->setName("tiled_test.json layer [01] Conv2D");
+
+    snn::dp::UpSampling2DDesc upDesc;
+    upDesc.numOutputPlanes   = channels;
+    upDesc.numInputPlanes    = channels;
+    upDesc.scale             = 2;
+    upDesc.interpolationType = "nearest";
+    upDesc.preferHp          = false;
+    std::shared_ptr<snn::dp::GenericModelLayer> up(snn::dp::UpSampling2DCreator1(std::move(upDesc), useVulkan));
+    up->setName("tiled_test.json layer [02] UpSampling2D");
+
+    auto conv = createConv2D(channels, 1, rng, useVulkan);
+    conv->setName("tiled_test.json layer [03] Conv2D");
+
+    snn::dp::InferenceModel layers = {input, down, up, conv};
+    for (size_t i = 1; i < layers.size(); ++i) {
+        layers[i]->prevLayers.push_back(layers[i - 1]);
+        layers[i - 1]->nextLayers.push_back(layers[i]);
+    }
+    return layers;
+}
+
+static snn::dp::ShaderGenOptions getOptions(uint32_t width, uint32_t height, uint32_t channels, bool useCompute, bool useVulkan) {
+    snn::dp::ShaderGenOptions sgo = {};
+    sgo.desiredInput.push_back({snn::ColorFormat::RGBA32F, width, height, UP_DIV(channels, 4U), 4U});
+    sgo.desiredOutputFormat  = snn::ColorFormat::RGBA32F;
+    sgo.preferrHalfPrecision = false;
+    sgo.compute              = useCompute;
+    sgo.vulkan               = useVulkan;
+    return sgo;
+}
+
+static int compareOutputs(snn::ImageTexture& expected, snn::ImageTexture& actual, bool printMismatch) {
+    const auto& expectedDims = expected.getDims();
+    const auto& actualDims   = actual.getDims();
+    if (expectedDims[0] != actualDims[0] || expectedDims[1] != actualDims[1] || expectedDims[2] != actualDims[2]) {
+        printf("Output size mismatch: %ux%ux%u vs %ux%ux%u\n", expectedDims[0], expectedDims[1], expectedDims[2], actualDims[0], actualDims[1],
+               actualDims[2]);
+        return -1;
+    }
+    const auto& expectedImage = expected.getRawImage();
+    const auto& actualImage   = actual.getRawImage();
+    const float* e            = reinterpret_cast<const float*>(expectedImage.data());
+    const float* a            = reinterpret_cast<const float*>(actualImage.data());
+    size_t count              = expectedImage.size() / sizeof(float);
+    int mismatches            = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (e[i] != a[i]) {
+            if (printMismatch && mismatches < 32) {
+                size_t pixel = i / 4;
+                printf("Mismatch at x=%zu, y=%zu, plane=%zu, channel=%zu: %f vs %f\n", pixel % expectedDims[0], pixel / expectedDims[0] % expectedDims[1],
+                       pixel / expectedDims[0] / expectedDims[1], i % 4, e[i], a[i]);
+            }
+            mismatches++;
+        }
+    }
+    return mismatches ? -1 : 0;
+}
+
+static int testTiled(snn::GpuContext* context, uint32_t width, uint32_t height, uint32_t tile, bool useCompute, bool useVulkan, bool printMismatch) {
+    const uint32_t channels = 4;
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    std::vector<float> pixels(width * height * channels);
+    for (auto& v : pixels) {
+        v = dist(rng);
+    }
+    auto input = snn::ImageTextureFactory::createImageTexture(context, std::array<uint32_t, 4> {width, height, 1U, 1U}, snn::ColorFormat::RGBA32F,
+                                                              pixels.data());
+    input->upload();
+    snn::ImageTextureArray inputs {input, snn::ImageTextureAllocator(context)};
+
+    // Whole image at once
+    auto layers = createDownUpModel(width, height, channels, useVulkan);
+    snn::MixedInferenceCore::CreationParameters graph;
+    (snn::InferenceGraph &&) graph = snn::dp::generateInferenceGraph(layers, getOptions(width, height, channels, useCompute, useVulkan));
+    graph.dumpOutputs = false;
+    auto full         = snn::MixedInferenceCore::create(context, graph);
+    SNN_CHK(full);
+    auto outVec = std::vector<std::vector<std::vector<float>>>();
+    auto inVec  = std::vector<std::vector<std::vector<float>>>();
+    snn::SNNModelOutput modelOutput;
+    snn::MixedInferenceCore::RunParameters rp = {inputs, {}, inVec, outVec, modelOutput};
+    full->run(rp);
+
+    // Tile by tile
+    snn::TiledInferenceCore::CreationParameters cp;
+    cp.options    = getOptions(width, height, channels, useCompute, useVulkan);
+    cp.tileWidth  = tile;
+    cp.tileHeight = tile;
+    auto tiled    = snn::TiledInferenceCore::create(context, cp, createDownUpModel(width, height, channels, useVulkan));
+    SNN_CHK(tiled);
+    snn::ImageTextureArray outputs {snn::ImageTextureAllocator(context)};
+    outputs.allocate(1);
+    SNN_CHK(tiled->run(*input, outputs[0]));
+
+    int ret = compareOutputs(full->getOutputImage(), outputs[0], printMismatch);
+    printf("\ntiled inference test res: %s for w=%u, h=%u, tile=%u, halo=%u, alignment=%u\n", ret ? "FAILED" : "succeeded", width, height, tile,
+           tiled->getHalo(), tiled->getAlignment());
+    return ret;
+}
+
+static std::shared_ptr<snn::ImageTexture> createInput(snn::GpuContext* context, uint32_t width, uint32_t height, const std::vector<float>& pixels) {
+    auto input = snn::ImageTextureFactory::createImageTexture(context, std::array<uint32_t, 4> {width, height, 1U, 1U}, snn::ColorFormat::RGBA32F,
+                                                              pixels.data());
+    input->upload();
+    return input;
+}
+
+static int testIncremental(snn::GpuContext* context, uint32_t width, uint32_t height, uint32_t tile, bool useCompute, bool useVulkan,
+                           bool printMismatch) {
+    const uint32_t channels = 4;
+
+    snn::TiledInferenceCore::CreationParameters cp;
+    cp.options     = getOptions(width, height, channels, useCompute, useVulkan);
+    cp.tileWidth   = tile;
+    cp.tileHeight  = tile;
+    cp.incremental = true;
+    auto tiled     = snn::TiledInferenceCore::create(context, cp, createDownUpModel(width, height, channels, useVulkan));
+    if (useVulkan) {
+        // Vulkan can't compare images on GPU, so the incremental mode is rejected
+        printf("\nincremental tiled inference test res: %s for Vulkan\n", tiled ? "FAILED" : "succeeded");
+        return tiled ? -1 : 0;
+    }
+    SNN_CHK(tiled);
+    cp.incremental = false;
+    auto reference = snn::TiledInferenceCore::create(context, cp, createDownUpModel(width, height, channels, useVulkan));
+    SNN_CHK(reference);
+
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    std::vector<float> pixels(width * height * channels);
+    for (auto& v : pixels) {
+        v = dist(rng);
+    }
+    snn::ImageTextureArray outputs {snn::ImageTextureAllocator(context)};
+    outputs.allocate(2);
+    auto first = createInput(context, width, height, pixels);
+    SNN_CHK(tiled->run(*first, outputs[0]));
+
+    // Same frame again
+    auto second = createInput(context, width, height, pixels);
+    tiled->resetStats();
+    SNN_CHK(tiled->run(*second, outputs[0]));
+    int ret = tiled->getStats().tilesComputed == 0 && tiled->getStats().tilesSkipped > 0 ? 0 : -1;
+    if (ret) {
+        printf("Static frame computed %llu tiles\n", (unsigned long long) tiled->getStats().tilesComputed);
+    }
+
+    // One pixel changes. The windows are the ones of snn::TiledInferenceCore: border tiles are shifted inside the image.
+    uint32_t pixelX = std::min(width - 1, tile);
+    uint32_t pixelY = std::min(height - 1, tile);
+    pixels[(pixelY * width + pixelX) * channels] += 1.0f;
+    auto third = createInput(context, width, height, pixels);
+    SNN_CHK(tiled->run(*third, outputs[0]));
+    uint32_t halo        = tiled->getHalo();
+    uint32_t inputWidth  = tile + 2 * halo;
+    uint32_t inputHeight = tile + 2 * halo;
+    std::vector<bool> expected;
+    for (uint32_t tileY = 0; tileY < height; tileY += tile) {
+        uint32_t srcY = std::min(tileY > halo ? tileY - halo : 0, height - inputHeight);
+        for (uint32_t tileX = 0; tileX < width; tileX += tile) {
+            uint32_t srcX = std::min(tileX > halo ? tileX - halo : 0, width - inputWidth);
+            expected.push_back(pixelX >= srcX && pixelX < srcX + inputWidth && pixelY >= srcY && pixelY < srcY + inputHeight);
+        }
+    }
+    const auto& computed = tiled->getComputedTiles();
+    if (computed != expected) {
+        for (size_t i = 0; printMismatch && i < std::min(computed.size(), expected.size()); ++i) {
+            printf("Tile %zu: computed %d, expected %d\n", i, (int) computed[i], (int) expected[i]);
+        }
+        ret = -1;
+    }
+
+    // Skipped tiles keep outputs, that are exactly the ones of computing all tiles
+    SNN_CHK(reference->run(*third, outputs[1]));
+    ret = compareOutputs(outputs[1], outputs[0], printMismatch) || ret;
+    printf("\nincremental tiled inference test res: %s for w=%u, h=%u, tile=%u, halo=%u, pixel %u,%u\n", ret ? "FAILED" : "succeeded", width, height,
+           tile, halo, pixelX, pixelY);
+    return ret;
+}
+
+int main(int argc, char** argv) {
+    uint32_t width     = 64;
+    uint32_t height    = 48;
+    uint32_t tile      = 16;
+    bool useCompute    = false;
+    bool useVulkan     = false;
+    bool printMismatch = false;
+
+    CLI::App app;
+    app.add_option("-W", width, "width");
+    app.add_option("-H", height, "height");
+    app.add_option("-T", tile, "tile size");
+    app.add_flag("--use_compute", useCompute, "Use compute shader");
+    app.add_flag("--use_vulkan", useVulkan, "Use Vulkan");
+    app.add_flag("--print_mismatch", printMismatch, "Print results mismatch");
+    CLI11_PARSE(app, argc, argv);
+    CHECK_PLATFORM_SUPPORT(useVulkan)
+
+    printf("Using %s shader\n", useCompute ? "COMPUTE" : "FRAGMENT");
+    printf("Using %s backend\n", useVulkan ? "Vulkan" : "OpenGL");
+
+    snn::GpuContext* context = snn::createDefaultContext(useVulkan);
+    int ret = testTiled(context, width, height, tile, useCompute, useVulkan, printMismatch);
+    ret     = testIncremental(context, width, height, tile, useCompute, useVulkan, printMismatch) || ret;
+    return ret ? 1 : 0;
+}
@@ -61,4 +61,23 @@ rm -rf ../../../../core/inferenceCoreDump/*;
 ./imageTextureTest
 ./imageTextureResizeTest
 
+./tiledInferenceTest
+./tiledInferenceTest --use_compute
+./tiledInferenceTest --use_vulkan
+./inferenceServerTest
+./inferenceServerTest --use_compute
+./inferenceServerTest --use_vulkan
+./dynamicShapesTest
+./dynamicShapesTest --use_compute
+./dynamicShapesTest --use_vulkan
+./invertedResidualTest
+./invertedResidualTest --use_compute
+./invertedResidualTest --use_vulkan
+./bufferActivationsTest
+./bufferActivationsTest --use_compute
+./bufferActivationsTest --use_vulkan
+./fuseUpsamplingTest
+./fuseUpsamplingTest --use_compute
+./fuseUpsamplingTest --use_vulkan
+
 cd ../../../
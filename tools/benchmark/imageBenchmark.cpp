@@ -0,0 +1,225 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Measures the CPU image conversions of snn/image.h, that prepare model inputs and read model outputs,
+// and the bulk half float conversions of snn/fp16.h, that pack FP16 weights,
+// against per-value references, and checks that both produce the same results.
+#include "snn/snn.h"
+#include "snn/image.h"
+#include "snn/colorUtils.h"
+#include "snn/fp16.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+// Global namespace is polluted somewhere
+#ifdef Success
+    #undef Success
+#endif
+#include "CLI/CLI.hpp"
+
+namespace {
+
+// Fills the image with random values in [0, 1] range
+void fillRandom(snn::RawImage& image, std::mt19937& rng) {
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    auto format = image.format();
+    auto type   = snn::getColorFormatType(format);
+    size_t size = image.size();
+    if (type == snn::ColorFormatType::FLOAT32) {
+        auto values = (float*) image.data();
+        for (size_t i = 0; i < size / sizeof(float); ++i) {
+            values[i] = dist(rng);
+        }
+    } else if (type == snn::ColorFormatType::FLOAT16) {
+        auto values = (uint16_t*) image.data();
+        for (size_t i = 0; i < size / sizeof(uint16_t); ++i) {
+            values[i] = snn::FP32::toHalf(dist(rng));
+        }
+    } else {
+        for (size_t i = 0; i < size; ++i) {
+            image.data()[i] = (uint8_t) (dist(rng) * 255.0f);
+        }
+    }
+}
+
+// Mean time of a conversion in milliseconds
+double measureMs(uint32_t runs, const std::function<void()>& convert) {
+    convert(); // Warm up caches and page mappings
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < runs; ++i) {
+        convert();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / runs;
+}
+
+// Largest difference between two float images of the same size
+float maxDiff(const snn::RawImage& a, const snn::RawImage& b) {
+    SNN_ASSERT(a.size() == b.size());
+    float diff = 0.0f;
+    auto fa    = (const float*) a.data();
+    auto fb    = (const float*) b.data();
+    for (size_t i = 0; i < a.size() / sizeof(float); ++i) {
+        diff = std::max(diff, std::fabs(fa[i] - fb[i]));
+    }
+    return diff;
+}
+
+void printRow(const char* name, double baseMs, double ms, float diff) {
+    if (baseMs > 0.0) {
+        printf("%-24s %10.3f %10.3f %8.2fx %10.2e\n", name, baseMs, ms, baseMs / ms, diff);
+    } else {
+        printf("%-24s %10s %10.3f %9s %10s\n", name, "-", ms, "-", "-");
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint32_t width  = 1920;
+    uint32_t height = 1080;
+    uint32_t runs   = 20;
+
+    CLI::App app {"ShaderNN image conversion benchmark"};
+    app.add_option("--width", width, "Image width");
+    app.add_option("--height", height, "Image height");
+    app.add_option("--runs", runs, "Number of measured runs per conversion");
+    CLI11_PARSE(app, argc, argv);
+    runs = std::max(1U, runs);
+
+    const std::vector<snn::ColorFormat> formats = {snn::ColorFormat::RGBA8,   snn::ColorFormat::RGB8,    snn::ColorFormat::R8,
+                                                   snn::ColorFormat::RGBA16F, snn::ColorFormat::RGBA32F, snn::ColorFormat::RGB32F};
+    const std::vector<float> means = {0.5f, 0.5f, 0.5f, 0.5f};
+    const std::vector<float> norms = {2.0f, 2.0f, 2.0f, 2.0f};
+
+    std::mt19937 rng(1234);
+    bool ok = true;
+    printf("%ux%u, %u runs\n", width, height, runs);
+    printf("%-24s %10s %10s %9s %10s\n", "conversion", "pixel ms", "ms", "speedup", "max diff");
+    for (auto format : formats) {
+        auto src = snn::ManagedRawImage(snn::ImageDesc(format, width, height));
+        fillRandom(src, rng);
+        std::string name = snn::getColorFormatDesc(format).name;
+
+        // -> RGBA32F
+        {
+            snn::ManagedImage<snn::Rgba32f> ref(width, height), dst(width, height);
+            double baseMs = measureMs(runs, [&]() {
+                for (uint32_t y = 0; y < height; ++y) {
+                    for (uint32_t x = 0; x < width; ++x) {
+                        snn::toRgba32f(ref.at(0, x, y), src.at(0, x, y), format);
+                    }
+                }
+            });
+            double ms  = measureMs(runs, [&]() { snn::toRgba32f(src, dst); });
+            float diff = maxDiff(ref, dst);
+            ok         = ok && diff <= 1e-6f;
+            printRow((name + " -> RGBA32F").c_str(), baseMs, ms, diff);
+        }
+
+        // -> RGBA16F
+        if (format != snn::ColorFormat::R8) {
+            snn::ManagedImage<snn::Rgba16f> ref(width, height), dst(width, height);
+            double baseMs = measureMs(runs, [&]() {
+                for (uint32_t y = 0; y < height; ++y) {
+                    for (uint32_t x = 0; x < width; ++x) {
+                        snn::toRgba16f(ref.at(0, x, y), src.at(0, x, y), format);
+                    }
+                }
+            });
+            double ms  = measureMs(runs, [&]() { snn::toRgba16f(src, dst); });
+            float diff = maxDiff(snn::toRgba32f(ref), snn::toRgba32f(dst));
+            ok         = ok && diff <= 1e-3f;
+            printRow((name + " -> RGBA16F").c_str(), baseMs, ms, diff);
+        }
+
+        // -> R32F
+        if (format == snn::ColorFormat::RGBA8 || format == snn::ColorFormat::R8) {
+            snn::ManagedImage<snn::R32f> ref(width, height), dst(width, height);
+            double baseMs = measureMs(runs, [&]() {
+                for (uint32_t y = 0; y < height; ++y) {
+                    for (uint32_t x = 0; x < width; ++x) {
+                        snn::toR32f(ref.at(0, x, y), src.at(0, x, y), format);
+                    }
+                }
+            });
+            double ms  = measureMs(runs, [&]() { snn::toR32f(src, dst); });
+            float diff = maxDiff(ref, dst);
+            ok         = ok && diff <= 1e-6f;
+            printRow((name + " -> R32F").c_str(), baseMs, ms, diff);
+        }
+
+        // Normalization and clamping have no public per-pixel functions
+        {
+            snn::ManagedImage<snn::Rgba32f> dst(width, height);
+            printRow((name + " normalize").c_str(), 0.0, measureMs(runs, [&]() { snn::normalize(src, dst, means, norms); }), 0.0f);
+        }
+        {
+            auto dst = snn::ManagedRawImage(snn::ImageDesc(format, width, height));
+            printRow((name + " clamp").c_str(), 0.0, measureMs(runs, [&]() { snn::clamp(src, dst); }), 0.0f);
+        }
+    }
+
+    // Half float conversions of as many values as the RGBA image has
+    {
+        size_t count = (size_t) width * height * 4;
+        std::vector<float> values(count), ref(count), dst(count);
+        std::vector<uint16_t> halfRef(count), halfDst(count);
+        std::uniform_real_distribution<float> dist(-8.0f, 8.0f);
+        for (auto& value : values) {
+            value = dist(rng);
+        }
+
+        double baseMs = measureMs(runs, [&]() {
+            for (size_t i = 0; i < count; ++i) {
+                halfRef[i] = snn::fp16::floatToHalf(values[i]);
+            }
+        });
+        double ms = measureMs(runs, [&]() { snn::fp16::floatToHalf(values.data(), halfDst.data(), count); });
+        bool same = halfRef == halfDst;
+        ok        = ok && same;
+        printRow("fp16 floatToHalf", baseMs, ms, same ? 0.0f : INFINITY);
+
+        baseMs = measureMs(runs, [&]() {
+            for (size_t i = 0; i < count; ++i) {
+                ref[i] = snn::fp16::halfToFloat(halfRef[i]);
+            }
+        });
+        ms = measureMs(runs, [&]() { snn::fp16::halfToFloat(halfRef.data(), dst.data(), count); });
+        same = ref == dst;
+        ok   = ok && same;
+        printRow("fp16 halfToFloat", baseMs, ms, same ? 0.0f : INFINITY);
+
+        baseMs = measureMs(runs, [&]() {
+            for (size_t i = 0; i < count; ++i) {
+                ref[i] = snn::fp16::roundToHalf(values[i]);
+            }
+        });
+        ms = measureMs(runs, [&]() { snn::fp16::roundToHalf(values.data(), dst.data(), count); });
+        same = ref == dst;
+        ok   = ok && same;
+        printRow("fp16 roundToHalf", baseMs, ms, same ? 0.0f : INFINITY);
+    }
+
+    if (!ok) {
+        printf("FAILED: fast conversions differ from the per-pixel conversions\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,220 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Load generator for snn::InferenceServer: client threads submit requests at a fixed total rate,
+// or as fast as the server accepts them, and the throughput and the latency percentiles are reported.
+#include "snn/snn.h"
+#include "snn/utils.h"
+#include "snn/contextFactory.h"
+#include "snn/inferenceServer.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Global namespace is polluted somewhere
+#ifdef Success
+    #undef Success
+#endif
+#include "CLI/CLI.hpp"
+
+namespace {
+
+struct Percentiles {
+    double p50  = 0.0;
+    double p90  = 0.0;
+    double p99  = 0.0;
+    double mean = 0.0;
+};
+
+// Calculates nearest-rank percentiles
+Percentiles calcPercentiles(std::vector<double> values) {
+    Percentiles ret;
+    if (values.empty()) {
+        return ret;
+    }
+    std::sort(values.begin(), values.end());
+    auto rank = [&](double p) {
+        size_t idx = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+        return values[std::min(values.size(), std::max<size_t>(idx, 1)) - 1];
+    };
+    ret.p50 = rank(50.0);
+    ret.p90 = rank(90.0);
+    ret.p99 = rank(99.0);
+    double sum = 0.0;
+    for (auto v : values) {
+        sum += v;
+    }
+    ret.mean = sum / values.size();
+    return ret;
+}
+
+void writePercentilesJson(std::ostream& os, const Percentiles& p) {
+    os << "{\"p50\": " << p.p50 << ", \"p90\": " << p.p90 << ", \"p99\": " << p.p99 << ", \"mean\": " << p.mean << "}";
+}
+
+// Submits requests of one client
+// params:
+//  interval - time between requests, zero to submit them back to back
+void runClient(snn::InferenceServer& server, const std::vector<uint8_t>& input, uint32_t numRequests, std::chrono::steady_clock::time_point start,
+               std::chrono::steady_clock::duration interval, std::vector<std::future<snn::InferenceServer::Response>>& futures) {
+    for (uint32_t i = 0; i < numRequests; ++i) {
+        if (interval.count() > 0) {
+            std::this_thread::sleep_until(start + interval * i);
+        }
+        snn::InferenceServer::Request request;
+        request.inputs.push_back(input);
+        futures.push_back(server.submit(std::move(request)));
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string modelFileName;
+    std::vector<uint32_t> inputSize = {224, 224, 1};
+    std::string backend  = "gl_fs";
+    bool useHalf         = false;
+    uint32_t workers     = 2;
+    uint32_t maxBatch    = 4;
+    uint32_t queueDepth  = 64;
+    double batchTimeout  = 1.0;
+    bool reject          = false;
+    uint32_t clients     = 4;
+    uint32_t requests    = 1000;
+    double rate          = 0.0;
+    uint32_t warmup      = 10;
+    std::string outputFile;
+
+    CLI::App app {"ShaderNN inference server load generator"};
+    app.add_option("model", modelFileName, "Model file in JSON format, relative to the model directory")->required();
+    app.add_option("--input", inputSize, "Input width, height and number of 4-channel planes")->expected(3);
+    app.add_option("--backend", backend, "Backend: gl_fs | gl_cs | vulkan");
+    app.add_flag("--use_half", useHalf, "Use half-precision floating point values (fp16)");
+    app.add_option("--workers", workers, "Number of server workers (execution contexts)");
+    app.add_option("--max_batch", maxBatch, "Maximal number of requests in a batch");
+    app.add_option("--queue_depth", queueDepth, "Maximal number of queued requests");
+    app.add_option("--batch_timeout", batchTimeout, "Time in ms, a worker waits for more requests after the first one of a batch");
+    app.add_flag("--reject", reject, "Reject requests, when the queue is full, instead of blocking the clients");
+    app.add_option("--clients", clients, "Number of client threads");
+    app.add_option("--requests", requests, "Total number of measured requests");
+    app.add_option("--rate", rate, "Total request rate per second, 0 to submit as fast as the server accepts them");
+    app.add_option("--warmup", warmup, "Number of warmup requests, excluded from statistics");
+    app.add_option("--output", outputFile, "Output JSON file. Standard output, if not set");
+    CLI11_PARSE(app, argc, argv);
+
+    if (backend != "gl_fs" && backend != "gl_cs" && backend != "vulkan") {
+        SNN_LOGE("Invalid option value");
+        return 1;
+    }
+    bool useVulkan = backend == "vulkan";
+    clients        = std::max(1U, clients);
+    requests       = std::max(clients, requests);
+    std::array<uint32_t, 3> inputDims = {inputSize[0], inputSize[1], std::max(1U, inputSize[2])};
+
+    auto context = snn::createDefaultContext(useVulkan);
+    snn::InferenceServer::CreationParameters cp;
+    cp.modelFileName = modelFileName;
+    cp.options.desiredInput.push_back({snn::ColorFormat::RGBA32F, inputDims[0], inputDims[1], inputDims[2], 4 * inputDims[2]});
+    cp.options.desiredOutputFormat  = snn::ColorFormat::RGBA32F;
+    cp.options.compute              = backend == "gl_cs";
+    cp.options.vulkan               = useVulkan;
+    cp.options.preferrHalfPrecision = useHalf;
+    cp.numWorkers                   = workers;
+    cp.maxBatch                     = maxBatch;
+    cp.maxQueueDepth                = queueDepth;
+    cp.batchTimeoutMs               = batchTimeout;
+    cp.backpressure = reject ? snn::InferenceServer::Backpressure::REJECT : snn::InferenceServer::Backpressure::BLOCK;
+    auto server     = snn::InferenceServer::create(context, cp);
+    if (!server) {
+        return 1;
+    }
+
+    std::vector<uint8_t> input(inputDims[0] * inputDims[1] * inputDims[2] * 4 * sizeof(float));
+    std::vector<float> pixels(input.size() / sizeof(float), 0.5f);
+    memcpy(input.data(), pixels.data(), input.size());
+
+    // Workers create their execution contexts at start, warmup requests run the first inferences on them
+    for (uint32_t i = 0; i < warmup; ++i) {
+        snn::InferenceServer::Request request;
+        request.inputs.push_back(input);
+        server->submit(std::move(request)).wait();
+    }
+
+    auto interval = rate > 0.0 ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(clients / rate))
+                               : std::chrono::steady_clock::duration::zero();
+    std::vector<std::vector<std::future<snn::InferenceServer::Response>>> futures(clients);
+    std::vector<std::thread> clientThreads;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t c = 0; c < clients; ++c) {
+        uint32_t numRequests = requests / clients + (c < requests % clients ? 1 : 0);
+        clientThreads.emplace_back(runClient, std::ref(*server), std::cref(input), numRequests, start, interval, std::ref(futures[c]));
+    }
+    for (auto& thread : clientThreads) {
+        thread.join();
+    }
+
+    std::vector<double> latencies;
+    std::vector<double> queueTimes;
+    uint64_t rejected   = 0;
+    uint64_t batchTotal = 0;
+    for (auto& clientFutures : futures) {
+        for (auto& future : clientFutures) {
+            auto response = future.get();
+            if (!response.ok) {
+                ++rejected;
+                continue;
+            }
+            latencies.push_back(response.latency);
+            queueTimes.push_back(response.queueTime);
+            batchTotal += response.batchSize;
+        }
+    }
+    auto end        = std::chrono::steady_clock::now();
+    double duration = std::chrono::duration<double, std::milli>(end - start).count();
+    server->stop();
+
+    std::ofstream file;
+    if (!outputFile.empty()) {
+        file.open(outputFile);
+        if (!file.good()) {
+            SNN_LOGE("Failed to open %s", outputFile.c_str());
+            return 1;
+        }
+    }
+    std::ostream& os = outputFile.empty() ? std::cout : file;
+    os << "{\n  \"model\": \"" << modelFileName << "\",\n";
+    os << "  \"backend\": \"" << backend << "\", \"precision\": \"" << (useHalf ? "fp16" : "fp32") << "\",\n";
+    os << "  \"workers\": " << cp.numWorkers << ", \"max_batch\": " << maxBatch << ", \"queue_depth\": " << queueDepth
+       << ", \"batch_timeout_ms\": " << batchTimeout << ", \"backpressure\": \"" << (reject ? "reject" : "block") << "\",\n";
+    os << "  \"clients\": " << clients << ", \"rate\": " << rate << ", \"requests\": " << requests << ",\n";
+    os << "  \"completed\": " << latencies.size() << ", \"rejected\": " << rejected << ", \"duration_ms\": " << duration << ",\n";
+    os << "  \"throughput_ips\": " << latencies.size() * 1000.0 / duration << ",\n";
+    // Every request reports the size of its batch, so the mean over requests is weighted by the batch size
+    os << "  \"mean_batch\": " << (latencies.empty() ? 0.0 : (double) batchTotal / latencies.size()) << ",\n";
+    os << "  \"latency_ms\": ";
+    writePercentilesJson(os, calcPercentiles(latencies));
+    os << ",\n  \"queue_ms\": ";
+    writePercentilesJson(os, calcPercentiles(queueTimes));
+    os << "\n}\n";
+    return 0;
+}
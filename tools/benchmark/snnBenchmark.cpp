@@ -0,0 +1,719 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "snn/snn.h"
+#include "snn/utils.h"
+#include "snn/core.h"
+#include "snn/contextFactory.h"
+#include "snn/imageTexture.h"
+#include "snn/traceRecorder.h"
+#include "snn/roofline.h"
+#include "snn/precisionPlanner.h"
+#ifdef SUPPORT_GL
+    #include "snn/shaderPlacement.h"
+    #include "glUtils.h"
+#endif
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Global namespace is polluted somewhere
+#ifdef Success
+    #undef Success
+#endif
+#include "CLI/CLI.hpp"
+
+namespace {
+
+enum class BackendKind { GL_FS, GL_CS, VULKAN };
+
+// One benchmarked configuration
+struct Config {
+    BackendKind backend               = BackendKind::GL_FS;
+    bool useHalf                      = false;
+    snn::MRTMode mrtMode              = snn::MRTMode::SINGLE_PLANE;
+    snn::WeightAccessMethod weightMode = snn::WeightAccessMethod::TEXTURES;
+    bool fuseLayers                    = true; // Inverted residual block fusion
+    bool bufferActivations             = false; // NC4HW4 storage buffer activations of GL compute shaders
+    bool fuseUpsampling                = false; // Upsampling fusion into convolutions, opt-in as in ShaderGenOptions
+    std::map<uint32_t, bool> layerHalfPrecision; // Per-layer precision overrides, see snn/precisionPlanner.h
+    std::map<std::string, bool> layerCompute;    // Per-layer shader kind overrides, see snn/shaderPlacement.h
+};
+
+struct Percentiles {
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double mean = 0.0;
+};
+
+// Result of one benchmarked configuration
+struct Result {
+    Config config;
+    bool ok            = false;
+    double initTime    = 0.0; // Model loading, graph generation and shader compilation, ms
+    Percentiles total;        // End-to-end run time, ms
+    std::vector<std::pair<std::string, Percentiles>> layers; // Per-layer GPU time, ms. Single-threaded runs only.
+    uint64_t peakMemoryKb = 0; // Peak resident memory of the process during this configuration, 0 if not available
+    int64_t rssDeltaKb    = 0; // Growth of resident memory from before model creation to the end of the runs
+    uint32_t threads      = 1;   // Number of execution contexts, running the model concurrently
+    double throughput     = 0.0; // Inferences per second over all threads
+};
+
+const char* backendName(BackendKind backend) {
+    switch (backend) {
+    case BackendKind::GL_FS:
+        return "gl_fs";
+    case BackendKind::GL_CS:
+        return "gl_cs";
+    case BackendKind::VULKAN:
+        return "vulkan";
+    }
+    return "";
+}
+
+const char* weightModeName(snn::WeightAccessMethod weightMode) {
+    switch (weightMode) {
+    case snn::WeightAccessMethod::CONSTANTS:
+        return "constants";
+    case snn::WeightAccessMethod::TEXTURES:
+        return "textures";
+    case snn::WeightAccessMethod::UNIFORM_BUFFER:
+        return "ubo";
+    case snn::WeightAccessMethod::SSBO_BUFFER:
+        return "ssbo";
+    }
+    return "";
+}
+
+// Calculates nearest-rank percentiles
+Percentiles calcPercentiles(std::vector<double> values) {
+    Percentiles ret;
+    if (values.empty()) {
+        return ret;
+    }
+    std::sort(values.begin(), values.end());
+    auto rank = [&](double p) {
+        size_t idx = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+        return values[std::min(values.size(), std::max<size_t>(idx, 1)) - 1];
+    };
+    ret.p50 = rank(50.0);
+    ret.p90 = rank(90.0);
+    ret.p99 = rank(99.0);
+    double sum = 0.0;
+    for (auto v : values) {
+        sum += v;
+    }
+    ret.mean = sum / values.size();
+    return ret;
+}
+
+// Gets a memory field of the process in kilobytes, 0 if not available
+// params:
+//  field - field of /proc/self/status with the colon, like "VmRSS:"
+uint64_t getMemoryKb(const std::string& field) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, field.size(), field) == 0) {
+            return std::stoull(line.substr(field.size()));
+        }
+    }
+    return 0;
+}
+
+// Resets the peak resident memory (VmHWM) to the current resident memory, so that every configuration
+// reports its own peak instead of the largest one so far. Needs Linux 4.0 or newer.
+// returns:
+//  false, if the peak can't be reset
+bool resetPeakMemory() {
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+    clearRefs.flush();
+    return clearRefs.good();
+}
+
+// Tracks memory of the process during one benchmarked configuration
+class MemoryTracker {
+public:
+    MemoryTracker()
+        : _baselineKb(getMemoryKb("VmRSS:")) {
+        _peakReset = resetPeakMemory();
+        if (!_peakReset) {
+            SNN_LOGW("Failed to reset peak memory with /proc/self/clear_refs, peak_memory_kb isn't reported");
+        }
+    }
+
+    void finish(Result& result) const {
+        result.peakMemoryKb = _peakReset ? getMemoryKb("VmHWM:") : 0;
+        result.rssDeltaKb   = static_cast<int64_t>(getMemoryKb("VmRSS:")) - static_cast<int64_t>(_baselineKb);
+    }
+
+private:
+    uint64_t _baselineKb;
+    bool _peakReset;
+};
+
+// Converts stage GPU time histograms of the runtime metrics to percentiles of the runs between two snapshots.
+// Percentiles are upper bounds of the histogram buckets, the mean is exact.
+std::vector<std::pair<std::string, Percentiles>> getStagePercentiles(const snn::InferenceMetrics& before, const snn::InferenceMetrics& after) {
+    std::vector<std::pair<std::string, Percentiles>> ret;
+    for (size_t i = 0; i < after.stageGpuTime.size(); ++i) {
+        auto time = after.stageGpuTime[i].time;
+        if (i < before.stageGpuTime.size()) {
+            const auto& prev = before.stageGpuTime[i].time;
+            time.count -= prev.count;
+            time.totalNs -= prev.totalNs;
+            for (size_t b = 0; b < time.buckets.size(); ++b) {
+                time.buckets[b] -= prev.buckets[b];
+            }
+        }
+        if (!time.count) {
+            continue;
+        }
+        Percentiles p;
+        p.p50  = time.getPercentileMs(0.5);
+        p.p90  = time.getPercentileMs(0.9);
+        p.p99  = time.getPercentileMs(0.99);
+        p.mean = time.getMeanMs();
+        ret.push_back({after.stageGpuTime[i].name, p});
+    }
+    return ret;
+}
+
+snn::GpuContext* getContext(bool useVulkan) {
+    static snn::GpuContext* contexts[2] = {};
+    auto& context = contexts[useVulkan ? 1 : 0];
+    if (!context) {
+        context = snn::createDefaultContext(useVulkan);
+    }
+    return context;
+}
+
+snn::dp::ShaderGenOptions getOptions(const std::array<uint32_t, 3>& inputDims, const Config& config) {
+    snn::dp::ShaderGenOptions options = {};
+    options.desiredInput.push_back({snn::ColorFormat::RGBA32F, inputDims[0], inputDims[1], inputDims[2], 4 * inputDims[2]});
+    options.desiredOutputFormat  = snn::ColorFormat::RGBA32F;
+    options.compute              = config.backend == BackendKind::GL_CS;
+    options.vulkan               = config.backend == BackendKind::VULKAN;
+    options.preferrHalfPrecision = config.useHalf;
+    options.mrtMode              = config.mrtMode;
+    options.weightMode           = config.weightMode;
+    options.fuseInvertedResidual = config.fuseLayers;
+    options.fuseUpsampling       = config.fuseUpsampling;
+    options.bufferActivations    = config.bufferActivations;
+    options.layerHalfPrecision   = config.layerHalfPrecision;
+    options.layerCompute         = config.layerCompute;
+    return options;
+}
+
+// Makes a precision plan for the configuration with random calibration inputs
+bool planPrecision(const std::string& modelFileName, const std::array<uint32_t, 3>& inputDims, const Config& config, double errorBudget,
+                   uint32_t numSamples, snn::PrecisionPlan& plan) {
+    auto context = getContext(config.backend == BackendKind::VULKAN);
+    // Fixed seed, so that plans are reproducible
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    std::vector<std::unique_ptr<snn::ImageTextureArray>> samples;
+    std::vector<snn::ImageTextureArrayAccessor> calibrationInputs;
+    for (uint32_t i = 0; i < std::max(1U, numSamples); ++i) {
+        std::vector<float> pixels(inputDims[0] * inputDims[1] * inputDims[2] * 4);
+        for (auto& v : pixels) {
+            v = dist(rng);
+        }
+        samples.emplace_back(new snn::ImageTextureArray(snn::ImageTextureAllocator(context)));
+        auto& inputTexs = *samples.back();
+        inputTexs.allocate(1);
+        inputTexs[0].reset({inputDims[0], inputDims[1], inputDims[2], 1}, snn::ColorFormat::RGBA32F, pixels.data());
+        inputTexs[0].upload();
+        calibrationInputs.push_back(inputTexs);
+    }
+    snn::PrecisionPlanner::CreationParameters cp;
+    cp.modelFileName = modelFileName;
+    cp.options       = getOptions(inputDims, config);
+    cp.errorBudget   = errorBudget;
+    return snn::PrecisionPlanner::plan(context, cp, calibrationInputs, plan);
+}
+
+#ifdef SUPPORT_GL
+// Measures fragment and compute shader times of every layer
+bool measurePlacement(const std::string& modelFileName, const std::array<uint32_t, 3>& inputDims, const Config& config,
+                      snn::ShaderPlacementTable& table) {
+    auto context = getContext(false);
+    snn::ImageTextureArray inputTexs {snn::ImageTextureAllocator(context)};
+    inputTexs.allocate(1);
+    std::vector<float> pixels(inputDims[0] * inputDims[1] * inputDims[2] * 4, 0.5f);
+    inputTexs[0].reset({inputDims[0], inputDims[1], inputDims[2], 1}, snn::ColorFormat::RGBA32F, pixels.data());
+    inputTexs[0].upload();
+    snn::ShaderPlacement::CreationParameters cp;
+    cp.modelFileName = modelFileName;
+    cp.options       = getOptions(inputDims, config);
+    return snn::ShaderPlacement::measure(context, cp, inputTexs, table);
+}
+#endif
+
+#ifdef SUPPORT_GL
+// Waits until all worker threads have finished their warmup runs
+class StartBarrier {
+public:
+    explicit StartBarrier(uint32_t count): _count(count) {}
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (--_count == 0) {
+            _cv.notify_all();
+        } else {
+            _cv.wait(lock, [this] { return _count == 0; });
+        }
+    }
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    uint32_t _count;
+};
+
+// Runs one execution context of a compiled model on a worker thread
+// params:
+//  renderContext - OpenGL context of the thread, sharing objects with the context, the model was compiled on
+//  times - run times of the measured runs, ms
+void runWorker(std::unique_ptr<gl::RenderContext> renderContext, std::shared_ptr<const snn::CompiledModel> model,
+               const std::array<uint32_t, 3>& inputDims, uint32_t warmupRuns, uint32_t runs, StartBarrier& barrier, std::vector<double>& times) {
+    renderContext->makeCurrent();
+    {
+        auto core = snn::MixedInferenceCore::create(model);
+
+        snn::ImageTextureArray inputTexs {snn::ImageTextureAllocator(model->getContext())};
+        inputTexs.allocate(1);
+        std::vector<float> pixels(inputDims[0] * inputDims[1] * inputDims[2] * 4, 0.5f);
+        inputTexs[0].reset({inputDims[0], inputDims[1], inputDims[2], 1}, snn::ColorFormat::RGBA32F, pixels.data());
+        inputTexs[0].upload();
+
+        auto outVec = std::vector<std::vector<std::vector<float>>>();
+        auto inVec  = std::vector<std::vector<std::vector<float>>>();
+        snn::SNNModelOutput modelOutput;
+        snn::MixedInferenceCore::RunParameters rp = {inputTexs, {}, inVec, outVec, modelOutput};
+
+        for (uint32_t i = 0; i < warmupRuns; ++i) {
+            core->run(rp);
+        }
+        barrier.wait();
+        for (uint32_t i = 0; i < runs; ++i) {
+            auto start = std::chrono::high_resolution_clock::now();
+            core->run(rp);
+            auto end = std::chrono::high_resolution_clock::now();
+            times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+    }
+    // Objects of the thread are deleted, while its context is current
+    renderContext.reset();
+}
+
+// Measures throughput of several execution contexts of one compiled model, running on their own threads.
+// Programs and weights are compiled once and shared by the contexts.
+Result runConcurrentBenchmark(const std::string& modelFileName, const std::array<uint32_t, 3>& inputDims, const Config& config,
+                              uint32_t warmupRuns, uint32_t runs, uint32_t threads) {
+    Result result;
+    result.config  = config;
+    result.threads = threads;
+    auto context   = getContext(false);
+    auto options   = getOptions(inputDims, config);
+    MemoryTracker memory;
+
+    auto initStart = std::chrono::high_resolution_clock::now();
+    auto model     = snn::CompiledModel::create(context, modelFileName, options);
+    auto initEnd   = std::chrono::high_resolution_clock::now();
+    result.initTime = std::chrono::duration<double, std::milli>(initEnd - initStart).count();
+
+    // Shared contexts are created on this thread, while the context of the model is current
+    std::vector<std::unique_ptr<gl::RenderContext>> renderContexts;
+    for (uint32_t i = 0; i < threads; ++i) {
+        renderContexts.emplace_back(new gl::RenderContext(gl::RenderContext::SHARED));
+    }
+
+    StartBarrier barrier(threads + 1);
+    std::vector<std::vector<double>> threadTimes(threads);
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < threads; ++i) {
+        workers.emplace_back(runWorker, std::move(renderContexts[i]), model, std::cref(inputDims), warmupRuns, runs, std::ref(barrier),
+                             std::ref(threadTimes[i]));
+    }
+    barrier.wait();
+    auto start = std::chrono::high_resolution_clock::now();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::vector<double> totalTimes;
+    for (const auto& times : threadTimes) {
+        totalTimes.insert(totalTimes.end(), times.begin(), times.end());
+    }
+    result.total      = calcPercentiles(totalTimes);
+    result.throughput = totalTimes.size() * 1000.0 / std::chrono::duration<double, std::milli>(end - start).count();
+    memory.finish(result);
+    result.ok = true;
+    return result;
+}
+#endif
+
+Result runBenchmark(const std::string& modelFileName, const std::array<uint32_t, 3>& inputDims, const Config& config, uint32_t warmupRuns,
+                    uint32_t runs, uint32_t threads, const std::string& traceFile, uint32_t traceRuns, const std::string& rooflineFile,
+                    const snn::RooflinePeaks& peaks) {
+    Result result;
+    result.config = config;
+    bool useVulkan = config.backend == BackendKind::VULKAN;
+#ifndef SUPPORT_VULKAN
+    if (useVulkan) {
+        SNN_LOGW("Vulkan is not supported, skipping");
+        return result;
+    }
+#endif
+#ifndef SUPPORT_GL
+    if (!useVulkan) {
+        SNN_LOGW("OpenGL is not supported, skipping");
+        return result;
+    }
+#endif
+    if (threads > 1) {
+#ifdef SUPPORT_GL
+        if (!useVulkan) {
+            return runConcurrentBenchmark(modelFileName, inputDims, config, warmupRuns, runs, threads);
+        }
+#endif
+        // Execution contexts of one Vulkan device share its command pool and queue
+        SNN_LOGW("Concurrent execution needs OpenGL, running one thread");
+    }
+    auto context = getContext(useVulkan);
+    auto options = getOptions(inputDims, config);
+    MemoryTracker memory;
+
+    auto initStart = std::chrono::high_resolution_clock::now();
+    auto core      = snn::MixedInferenceCore::create(context, modelFileName, options);
+    auto initEnd   = std::chrono::high_resolution_clock::now();
+    if (!core) {
+        return result;
+    }
+    result.initTime = std::chrono::duration<double, std::milli>(initEnd - initStart).count();
+
+    snn::ImageTextureArray inputTexs {snn::ImageTextureAllocator(context)};
+    inputTexs.allocate(1);
+    std::vector<float> pixels(inputDims[0] * inputDims[1] * inputDims[2] * 4, 0.5f);
+    inputTexs[0].reset({inputDims[0], inputDims[1], inputDims[2], 1}, snn::ColorFormat::RGBA32F, pixels.data());
+    inputTexs[0].upload();
+
+    auto outVec = std::vector<std::vector<std::vector<float>>>();
+    auto inVec  = std::vector<std::vector<std::vector<float>>>();
+    snn::SNNModelOutput modelOutput;
+    snn::MixedInferenceCore::RunParameters rp = {inputTexs, {}, inVec, outVec, modelOutput};
+
+    for (uint32_t i = 0; i < warmupRuns; ++i) {
+        core->run(rp);
+    }
+
+#ifndef PROFILING
+    // Without profiling, stage times come from the runtime metrics, sampled in every measured run
+    core->setGpuSamplingInterval(1);
+    auto metricsBefore = core->getMetrics();
+#endif
+    if (!traceFile.empty()) {
+        // Trace the first measured runs
+        snn::TraceRecorder::start(traceFile, std::min(traceRuns, runs));
+    }
+    std::vector<double> totalTimes;
+    std::map<std::string, std::vector<double>> layerTimes;
+    for (uint32_t i = 0; i < runs; ++i) {
+        auto start = std::chrono::high_resolution_clock::now();
+        // run() waits for the GPU at the end, so wall clock time covers GPU execution
+        core->run(rp);
+        auto end = std::chrono::high_resolution_clock::now();
+        totalTimes.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+#ifdef PROFILING
+        core->writeTimeStat(layerTimes);
+#endif
+    }
+    snn::TraceRecorder::stop();
+    result.total = calcPercentiles(totalTimes);
+    result.throughput = 1000.0 / result.total.mean;
+#ifdef PROFILING
+    for (auto& layer : layerTimes) {
+        result.layers.push_back({layer.first, calcPercentiles(layer.second)});
+    }
+#else
+    result.layers = getStagePercentiles(metricsBefore, core->getMetrics());
+    for (const auto& layer : result.layers) {
+        layerTimes[layer.first].push_back(layer.second.mean);
+    }
+#endif
+    if (!rooflineFile.empty()) {
+        std::ofstream rooflineStream(rooflineFile);
+        rooflineStream << snn::formatRooflineReport(snn::buildRooflineReport(core->getInferenceGraph(), layerTimes), peaks);
+        if (!rooflineStream.good()) {
+            SNN_LOGE("Failed to write %s", rooflineFile.c_str());
+        }
+    }
+    memory.finish(result);
+    result.ok = true;
+    return result;
+}
+
+std::string escapeJson(const std::string& s) {
+    std::string ret;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            ret += '\\';
+        }
+        ret += c;
+    }
+    return ret;
+}
+
+void writePercentilesJson(std::ostream& os, const Percentiles& p) {
+    os << "{\"p50\": " << p.p50 << ", \"p90\": " << p.p90 << ", \"p99\": " << p.p99 << ", \"mean\": " << p.mean << "}";
+}
+
+void writeJson(std::ostream& os, const std::string& modelFileName, const std::array<uint32_t, 3>& inputDims, const std::vector<Result>& results) {
+    os << "{\n  \"model\": \"" << escapeJson(modelFileName) << "\",\n";
+    os << "  \"input\": [" << inputDims[0] << ", " << inputDims[1] << ", " << inputDims[2] << "],\n";
+    os << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        os << "    {\"backend\": \"" << backendName(r.config.backend) << "\", \"precision\": \"" << (r.config.useHalf ? "fp16" : "fp32")
+           << "\", \"mrt\": " << static_cast<int>(r.config.mrtMode) / 4 << ", \"weights\": \"" << weightModeName(r.config.weightMode)
+           << "\", \"fused\": " << (r.config.fuseLayers ? "true" : "false")
+           << ", \"fused_upsampling\": " << (r.config.fuseUpsampling ? "true" : "false")
+           << ", \"buffers\": " << (r.config.bufferActivations ? "true" : "false") << ", \"ok\": " << (r.ok ? "true" : "false")
+           << ", \"init_ms\": " << r.initTime << ", \"peak_memory_kb\": " << r.peakMemoryKb
+           << ", \"rss_delta_kb\": " << r.rssDeltaKb << ", \"threads\": " << r.threads
+           << ", \"throughput_ips\": " << r.throughput
+           << ",\n     \"total_ms\": ";
+        writePercentilesJson(os, r.total);
+        os << ",\n     \"layers_ms\": {";
+        for (size_t j = 0; j < r.layers.size(); ++j) {
+            os << (j ? ",\n       " : "\n       ") << "\"" << escapeJson(r.layers[j].first) << "\": ";
+            writePercentilesJson(os, r.layers[j].second);
+        }
+        os << "}}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+std::string escapeCsv(const std::string& s) {
+    std::string ret = "\"";
+    for (char c : s) {
+        if (c == '"') {
+            ret += '"';
+        }
+        ret += c;
+    }
+    return ret + "\"";
+}
+
+// One row per configuration and layer. The end-to-end time uses the "total" layer name.
+void writeCsv(std::ostream& os, const std::string& modelFileName, const std::vector<Result>& results) {
+    os << "model,backend,precision,mrt,weights,fused,fused_upsampling,buffers,ok,init_ms,peak_memory_kb,rss_delta_kb,threads,throughput_ips,layer,p50_ms,p90_ms,p99_ms,mean_ms\n";
+    for (const auto& r : results) {
+        std::ostringstream prefix;
+        prefix << escapeCsv(modelFileName) << "," << backendName(r.config.backend) << "," << (r.config.useHalf ? "fp16" : "fp32") << ","
+               << static_cast<int>(r.config.mrtMode) / 4 << "," << weightModeName(r.config.weightMode) << ","
+               << (r.config.fuseLayers ? 1 : 0) << "," << (r.config.fuseUpsampling ? 1 : 0) << "," << (r.config.bufferActivations ? 1 : 0) << "," << (r.ok ? 1 : 0) << "," << r.initTime
+               << "," << r.peakMemoryKb << "," << r.rssDeltaKb << "," << r.threads << "," << r.throughput << ",";
+        os << prefix.str() << "total," << r.total.p50 << "," << r.total.p90 << "," << r.total.p99 << "," << r.total.mean << "\n";
+        for (const auto& layer : r.layers) {
+            os << prefix.str() << escapeCsv(layer.first) << "," << layer.second.p50 << "," << layer.second.p90 << "," << layer.second.p99 << ","
+               << layer.second.mean << "\n";
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string modelFileName;
+    std::vector<uint32_t> inputSize = {224, 224, 1};
+    std::string backend    = "gl_fs";
+    bool useHalf           = false;
+    uint32_t mrt           = 1;
+    std::string weights    = "textures";
+    uint32_t warmupRuns    = 5;
+    uint32_t runs          = 100;
+    uint32_t threads       = 1;
+    bool sweep             = false;
+    bool noFusion          = false;
+    bool fuseUpsampling    = false;
+    bool bufferActivations = false;
+    std::string format     = "json";
+    std::string outputFile;
+    std::string traceFile;
+    uint32_t traceRuns     = 3;
+    std::string rooflineFile;
+    snn::RooflinePeaks peaks;
+    std::string precisionFile;
+    std::string planPrecisionFile;
+    double errorBudget          = 1e-3;
+    uint32_t calibrationSamples = 4;
+    std::string placementFile;
+
+    const std::map<std::string, BackendKind> BACKENDS = {
+        {"gl_fs", BackendKind::GL_FS}, {"gl_cs", BackendKind::GL_CS}, {"vulkan", BackendKind::VULKAN}};
+    const std::map<uint32_t, snn::MRTMode> MRT_MODES = {
+        {1, snn::MRTMode::SINGLE_PLANE}, {2, snn::MRTMode::DOUBLE_PLANE}, {4, snn::MRTMode::QUAD_PLANE}};
+    const std::map<std::string, snn::WeightAccessMethod> WEIGHT_MODES = {{"constants", snn::WeightAccessMethod::CONSTANTS},
+                                                                         {"textures", snn::WeightAccessMethod::TEXTURES},
+                                                                         {"ubo", snn::WeightAccessMethod::UNIFORM_BUFFER},
+                                                                         {"ssbo", snn::WeightAccessMethod::SSBO_BUFFER}};
+
+    CLI::App app {"ShaderNN model benchmark"};
+    app.add_option("model", modelFileName, "Model file in JSON format, relative to the model directory")->required();
+    app.add_option("--input", inputSize, "Input width, height and number of 4-channel planes")->expected(3);
+    app.add_option("--backend", backend, "Backend: gl_fs | gl_cs | vulkan");
+    app.add_flag("--use_half", useHalf, "Use half-precision floating point values (fp16)");
+    app.add_option("--mrt", mrt, "Number of render target planes per fragment shader pass: 1 | 2 | 4");
+    app.add_option("--weights", weights, "Weight access method: constants | textures | ubo | ssbo");
+    app.add_option("--warmup", warmupRuns, "Number of warmup runs, excluded from statistics");
+    app.add_option("--runs", runs, "Number of measured runs");
+    app.add_option("--threads", threads, "Number of threads, running the measured runs concurrently with one compiled model (OpenGL only)");
+    app.add_flag("--no_fusion", noFusion, "Don't fuse inverted residual blocks, to compare per-layer times with the fused kernels");
+    app.add_flag("--fuse_upsampling", fuseUpsampling, "Fuse upsampling layers into the convolutions, that consume them");
+    app.add_flag("--buffer_activations", bufferActivations, "Keep intermediate activations of gl_cs in NC4HW4 storage buffers instead of textures");
+    app.add_flag("--sweep", sweep, "Benchmark all backends, precisions and MRT modes, and both activation storages of gl_cs");
+    app.add_option("--format", format, "Output format: json | csv");
+    app.add_option("--output", outputFile, "Output file. Standard output, if not set");
+    app.add_option("--trace", traceFile, "Chrome trace_event JSON file with the timeline of the first measured runs");
+    app.add_option("--trace_runs", traceRuns, "Number of runs in the trace");
+    app.add_option("--roofline", rooflineFile, "Text file with per-layer MACs, bytes, achieved GFLOP/s and GB/s");
+    app.add_option("--peak_gflops", peaks.gflops, "Device peak GFLOP/s, used to classify layers in the roofline report");
+    app.add_option("--peak_gbps", peaks.gbps, "Device peak memory bandwidth in GB/s, used to classify layers in the roofline report");
+    app.add_option("--precision_map", precisionFile, "Precision plan file, written by --plan_precision, with per-layer fp16/fp32 selection");
+    app.add_option("--plan_precision", planPrecisionFile, "Selects per-layer precision under --error_budget, writes the plan and benchmarks with it");
+    app.add_option("--error_budget", errorBudget, "Maximal relative RMS error of the outputs for --plan_precision");
+    app.add_option("--calibration_samples", calibrationSamples, "Number of random calibration inputs for --plan_precision");
+    app.add_option("--placement", placementFile,
+                   "Per-layer fragment/compute shader placement table of OpenGL backends. Measured and written, if the file does not exist");
+    CLI11_PARSE(app, argc, argv);
+
+    if (!BACKENDS.count(backend) || !MRT_MODES.count(mrt) || !WEIGHT_MODES.count(weights) || (format != "json" && format != "csv")) {
+        SNN_LOGE("Invalid option value");
+        return 1;
+    }
+    std::array<uint32_t, 3> inputDims = {inputSize[0], inputSize[1], std::max(1U, inputSize[2])};
+    runs    = std::max(1U, runs);
+    threads = std::max(1U, threads);
+
+    std::vector<Config> configs;
+    if (sweep) {
+        for (auto backendKind : {BackendKind::GL_FS, BackendKind::GL_CS, BackendKind::VULKAN}) {
+            for (bool half : {false, true}) {
+                // MRT mode only affects fragment shaders
+                std::vector<snn::MRTMode> mrtModes = {snn::MRTMode::SINGLE_PLANE};
+                if (backendKind == BackendKind::GL_FS) {
+                    mrtModes.push_back(snn::MRTMode::DOUBLE_PLANE);
+                }
+                // Activation storage only affects compute shaders
+                std::vector<bool> bufferModes = {false};
+                if (backendKind == BackendKind::GL_CS) {
+                    bufferModes.push_back(true);
+                }
+                for (auto mrtMode : mrtModes) {
+                    for (bool buffers : bufferModes) {
+                        configs.push_back({backendKind, half, mrtMode, WEIGHT_MODES.at(weights), !noFusion, buffers, fuseUpsampling});
+                    }
+                }
+            }
+        }
+    } else {
+        configs.push_back({BACKENDS.at(backend), useHalf, MRT_MODES.at(mrt), WEIGHT_MODES.at(weights), !noFusion, bufferActivations, fuseUpsampling});
+    }
+
+    snn::PrecisionPlan plan;
+    if (!planPrecisionFile.empty()) {
+        if (!planPrecision(modelFileName, inputDims, configs[0], errorBudget, calibrationSamples, plan) || !plan.save(planPrecisionFile)) {
+            return 1;
+        }
+    } else if (!precisionFile.empty() && !plan.load(precisionFile)) {
+        return 1;
+    }
+    for (auto& config : configs) {
+        config.layerHalfPrecision = plan.layerHalfPrecision;
+    }
+
+    if (!placementFile.empty()) {
+#ifdef SUPPORT_GL
+        snn::ShaderPlacementTable table;
+        if (!std::ifstream(placementFile).good()) {
+            // Layer signatures include precision, so the table is measured with the precision plan applied
+            auto glConfig = std::find_if(configs.begin(), configs.end(), [](const Config& c) { return c.backend != BackendKind::VULKAN; });
+            if (glConfig == configs.end() || !measurePlacement(modelFileName, inputDims, *glConfig, table) || !table.save(placementFile)) {
+                return 1;
+            }
+        } else if (!table.load(placementFile)) {
+            return 1;
+        } else if (table.device != snn::ShaderPlacement::getDeviceName(getContext(false))) {
+            SNN_LOGW("Shader placement table %s was measured on %s", placementFile.c_str(), table.device.c_str());
+        }
+        for (auto& config : configs) {
+            if (config.backend != BackendKind::VULKAN) {
+                config.layerCompute = table.getLayerCompute(0.05, config.backend == BackendKind::GL_CS);
+            }
+        }
+#else
+        SNN_LOGW("Shader placement needs OpenGL, ignoring %s", placementFile.c_str());
+#endif
+    }
+
+    std::vector<Result> results;
+    for (const auto& config : configs) {
+        SNN_LOGI("Benchmarking %s: %s, %s, MRT %d, weights %s", modelFileName.c_str(), backendName(config.backend), config.useHalf ? "fp16" : "fp32",
+                 static_cast<int>(config.mrtMode) / 4, weightModeName(config.weightMode));
+        // Every configuration gets its own trace file
+        std::string configTraceFile = traceFile;
+        if (!traceFile.empty() && configs.size() > 1) {
+            configTraceFile = snn::formatString("%s.%zu.json", traceFile.c_str(), results.size());
+        }
+        std::string configRooflineFile = rooflineFile;
+        if (!rooflineFile.empty() && configs.size() > 1) {
+            configRooflineFile = snn::formatString("%s.%zu.txt", rooflineFile.c_str(), results.size());
+        }
+        results.push_back(
+            runBenchmark(modelFileName, inputDims, config, warmupRuns, runs, threads, configTraceFile, traceRuns, configRooflineFile, peaks));
+    }
+
+    std::ofstream file;
+    if (!outputFile.empty()) {
+        file.open(outputFile);
+        if (!file.good()) {
+            SNN_LOGE("Failed to open %s", outputFile.c_str());
+            return 1;
+        }
+    }
+    std::ostream& os = outputFile.empty() ? std::cout : file;
+    if (format == "json") {
+        writeJson(os, modelFileName, inputDims, results);
+    } else {
+        writeCsv(os, modelFileName, results);
+    }
+    return 0;
+}
@@ -0,0 +1,239 @@
+/* Copyright (C) 2020 - 2022 OPPO. All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Measures the incremental mode of snn::TiledInferenceCore on synthetic video sequences:
+// every sequence runs once with all tiles computed and once incrementally, and frame times, skipped tiles
+// and the largest difference of the last output frame are reported.
+#include "snn/snn.h"
+#include "snn/utils.h"
+#include "snn/contextFactory.h"
+#include "snn/imageTexture.h"
+#include "snn/tiledcore.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Global namespace is polluted somewhere
+#ifdef Success
+    #undef Success
+#endif
+#include "CLI/CLI.hpp"
+
+namespace {
+
+// Synthetic sequence of RGBA32F frames
+struct Sequence {
+    std::string kind; // static | object | pan
+    uint32_t width  = 0;
+    uint32_t height = 0;
+    uint32_t planes = 1;
+    uint32_t speed  = 4;    // Object or pan offset between frames in pixels
+    uint32_t object = 64;   // Size of the moving object in pixels
+    float noise     = 0.0f; // Amplitude of per-frame noise, added to every value
+    std::vector<float> background; // Twice as wide as the frame, so that panning doesn't wrap too often
+
+    void init(uint32_t seed) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+        background.resize((size_t) 2 * width * height * planes * 4);
+        for (auto& v : background) {
+            v = dist(rng);
+        }
+    }
+
+    void makeFrame(uint32_t index, std::mt19937& rng, std::vector<float>& pixels) const {
+        std::uniform_real_distribution<float> dist(-noise, noise);
+        uint32_t panX    = kind == "pan" ? (index * speed) % width : 0;
+        uint32_t objectX = (index * speed) % std::max(1U, width - std::min(width, object));
+        uint32_t objectY = (height - std::min(height, object)) / 2;
+        pixels.resize((size_t) width * height * planes * 4);
+        // Layers of 4 channels follow each other, as in ImageTexture
+        for (uint32_t p = 0; p < planes; ++p) {
+            for (uint32_t y = 0; y < height; ++y) {
+                for (uint32_t x = 0; x < width; ++x) {
+                    bool inObject  = kind == "object" && x >= objectX && x < objectX + object && y >= objectY && y < objectY + object;
+                    const float* s = &background[(((size_t) p * height + y) * 2 * width + x + panX) * 4];
+                    float* d       = &pixels[(((size_t) p * height + y) * width + x) * 4];
+                    for (uint32_t c = 0; c < 4; ++c) {
+                        d[c] = (inObject ? 1.0f - s[c] : s[c]) + (noise > 0.0f ? dist(rng) : 0.0f);
+                    }
+                }
+            }
+        }
+    }
+};
+
+struct Result {
+    bool ok             = false;
+    double meanFrameMs  = 0.0; // Mean run() time of the measured frames
+    double skippedRatio = 0.0; // Ratio of the tiles, reused from previous frames
+    std::vector<float> lastOutput;
+};
+
+// Runs the model over the whole sequence
+Result runSequence(snn::GpuContext* context, const snn::TiledInferenceCore::CreationParameters& cp, const Sequence& sequence, uint32_t frames,
+                   uint32_t warmup) {
+    Result result;
+    auto core = snn::TiledInferenceCore::create(context, cp);
+    if (!core) {
+        return result;
+    }
+    snn::ImageTextureArray inputs {snn::ImageTextureAllocator(context)};
+    snn::ImageTextureArray outputs {snn::ImageTextureAllocator(context)};
+    inputs.allocate(1);
+    outputs.allocate(1);
+
+    // Noise is the same in both runs of a sequence
+    std::mt19937 rng(1);
+    std::vector<float> pixels;
+    double total = 0.0;
+    for (uint32_t i = 0; i < warmup + frames; ++i) {
+        sequence.makeFrame(i, rng, pixels);
+        inputs[0].reset({sequence.width, sequence.height, sequence.planes, 1}, snn::ColorFormat::RGBA32F, pixels.data());
+        inputs[0].upload();
+        if (i == warmup) {
+            // The first measured frame is compared with the last warmup frame
+            core->resetStats();
+        }
+        auto start = std::chrono::high_resolution_clock::now();
+        if (!core->run(inputs[0], outputs[0])) {
+            return result;
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        if (i >= warmup) {
+            total += std::chrono::duration<double, std::milli>(end - start).count();
+        }
+    }
+    result.meanFrameMs  = total / frames;
+    result.skippedRatio = core->getStats().getSkippedRatio();
+    if (outputs[0].getFormat() == snn::ColorFormat::RGBA32F) {
+        const auto& image = outputs[0].getRawImage();
+        const float* data = reinterpret_cast<const float*>(image.data());
+        result.lastOutput.assign(data, data + image.size() / sizeof(float));
+    }
+    result.ok = true;
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string modelFileName;
+    std::vector<uint32_t> inputSize = {1280, 720, 1};
+    std::vector<uint32_t> tileSize  = {256, 256};
+    std::vector<std::string> kinds  = {"static", "object", "pan"};
+    std::string backend = "gl_fs";
+    bool useHalf        = false;
+    uint32_t frames     = 60;
+    uint32_t warmup     = 3;
+    uint32_t speed      = 4;
+    uint32_t object     = 64;
+    float noise         = 0.0f;
+    float threshold     = 0.0f;
+    std::string outputFile;
+
+    CLI::App app {"ShaderNN incremental tiled inference benchmark"};
+    app.add_option("model", modelFileName, "Model file in JSON format, relative to the model directory")->required();
+    app.add_option("--input", inputSize, "Frame width, height and number of 4-channel planes")->expected(3);
+    app.add_option("--backend", backend, "Backend: gl_fs | gl_cs | vulkan");
+    app.add_flag("--use_half", useHalf, "Use half-precision floating point values (fp16)");
+    app.add_option("--tile", tileSize, "Tile width and height")->expected(2);
+    app.add_option("--sequence", kinds, "Synthetic sequences: static | object | pan");
+    app.add_option("--frames", frames, "Number of measured frames of every sequence");
+    app.add_option("--warmup", warmup, "Number of warmup frames, excluded from statistics");
+    app.add_option("--speed", speed, "Moving object or panning offset between frames in pixels");
+    app.add_option("--object", object, "Size of the moving object in pixels");
+    app.add_option("--noise", noise, "Amplitude of the per-frame noise, added to all input values");
+    app.add_option("--threshold", threshold, "Change threshold of the incremental mode");
+    app.add_option("--output", outputFile, "Output JSON file. Standard output, if not set");
+    CLI11_PARSE(app, argc, argv);
+
+    if (backend != "gl_fs" && backend != "gl_cs" && backend != "vulkan") {
+        SNN_LOGE("Invalid option value");
+        return 1;
+    }
+    for (const auto& kind : kinds) {
+        if (kind != "static" && kind != "object" && kind != "pan") {
+            SNN_LOGE("Invalid sequence %s", kind.c_str());
+            return 1;
+        }
+    }
+    bool useVulkan = backend == "vulkan";
+    frames         = std::max(1U, frames);
+    warmup         = std::max(1U, warmup);
+
+    auto context = snn::createDefaultContext(useVulkan);
+    snn::TiledInferenceCore::CreationParameters cp;
+    cp.modelFileName = modelFileName;
+    cp.options.desiredInput.push_back({snn::ColorFormat::RGBA32F, inputSize[0], inputSize[1], std::max(1U, inputSize[2]), 4 * std::max(1U, inputSize[2])});
+    cp.options.desiredOutputFormat  = snn::ColorFormat::RGBA32F;
+    cp.options.compute              = backend == "gl_cs";
+    cp.options.vulkan               = useVulkan;
+    cp.options.preferrHalfPrecision = useHalf;
+    cp.tileWidth                    = tileSize[0];
+    cp.tileHeight                   = tileSize[1];
+    cp.changeThreshold              = threshold;
+
+    std::ofstream file;
+    if (!outputFile.empty()) {
+        file.open(outputFile);
+        if (!file.good()) {
+            SNN_LOGE("Failed to open %s", outputFile.c_str());
+            return 1;
+        }
+    }
+    std::ostream& os = outputFile.empty() ? std::cout : file;
+    os << "{\n  \"model\": \"" << modelFileName << "\",\n";
+    os << "  \"backend\": \"" << backend << "\", \"precision\": \"" << (useHalf ? "fp16" : "fp32") << "\",\n";
+    os << "  \"input\": [" << inputSize[0] << ", " << inputSize[1] << ", " << std::max(1U, inputSize[2]) << "], \"tile\": [" << tileSize[0] << ", "
+       << tileSize[1] << "], \"threshold\": " << threshold << ", \"noise\": " << noise << ",\n";
+    os << "  \"sequences\": [\n";
+    for (size_t k = 0; k < kinds.size(); ++k) {
+        Sequence sequence;
+        sequence.kind   = kinds[k];
+        sequence.width  = inputSize[0];
+        sequence.height = inputSize[1];
+        sequence.planes = std::max(1U, inputSize[2]);
+        sequence.speed  = speed;
+        sequence.object = object;
+        sequence.noise  = noise;
+        sequence.init(0);
+
+        cp.incremental = false;
+        auto full      = runSequence(context, cp, sequence, frames, warmup);
+        cp.incremental = true;
+        auto partial   = runSequence(context, cp, sequence, frames, warmup);
+
+        // Skipped tiles differ from the full run by changes below the threshold only
+        float maxError = 0.0f;
+        if (full.lastOutput.size() == partial.lastOutput.size()) {
+            for (size_t i = 0; i < full.lastOutput.size(); ++i) {
+                maxError = std::max(maxError, std::abs(full.lastOutput[i] - partial.lastOutput[i]));
+            }
+        }
+        os << "    {\"sequence\": \"" << sequence.kind << "\", \"ok\": " << (full.ok && partial.ok ? "true" : "false")
+           << ", \"full_ms\": " << full.meanFrameMs << ", \"incremental_ms\": " << partial.meanFrameMs
+           << ", \"speedup\": " << (partial.meanFrameMs > 0.0 ? full.meanFrameMs / partial.meanFrameMs : 0.0)
+           << ", \"skipped_tiles\": " << partial.skippedRatio << ", \"max_error\": " << maxError << "}" << (k + 1 < kinds.size() ? "," : "")
+           << "\n";
+    }
+    os << "  ]\n}\n";
+    return 0;
+}